@@ -0,0 +1,528 @@
+// 捕获路径中CPU部分的基准测试，按分辨率×场景×消费者数量的矩阵运行。
+// 每个场景取多个样本，以自助法（bootstrap）估计中位数的置信区间，与同一台机器上记录的JSON基线比较：
+// 新结果的置信区间下限超过基线的置信区间上限加上容差时判定为退化，进程以非0退出。
+// 基线文件不存在时，本次结果被记录为基线
+
+#include "FastCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../source/FastCaptureInjectDll/DepthConvert.h"
+#include "../source/Utils/PixelPipeline.hpp"
+#include "../source/Utils/StreamingCopy.hpp"
+#include "../test/MockFastCaptureClient.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+
+    constexpr int EXIT_REGRESSED = 1;
+    constexpr int EXIT_USAGE = 2;
+
+    constexpr std::uint32_t DEFAULT_SAMPLE_COUNT = 20;
+    constexpr double DEFAULT_TOLERANCE = 0.20;
+    /**
+     * @brief 每个样本至少持续这么久，较快的场景在一个样本中重复多次，减小计时本身的误差
+     *
+     */
+    constexpr auto MIN_SAMPLE_DURATION = std::chrono::milliseconds{2};
+    constexpr std::uint32_t WARMUP_ITERATION_COUNT = 2;
+    constexpr std::uint32_t BOOTSTRAP_RESAMPLE_COUNT = 2000;
+    constexpr double CONFIDENCE_LEVEL = 0.95;
+    /**
+     * @brief 固定随机种子，同一组样本总是得到同一个置信区间
+     *
+     */
+    constexpr std::uint64_t BOOTSTRAP_SEED = 0x46617374u;
+
+    struct Resolution
+    {
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+    constexpr Resolution RESOLUTIONS[] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    constexpr std::uint32_t CONSUMER_COUNTS[] = {1, 2, 4};
+
+    struct Options
+    {
+        std::string baseline_path{};
+        std::string output_path{};
+        std::string filter{};
+        bool is_update_baseline{false};
+        std::uint32_t sample_count{DEFAULT_SAMPLE_COUNT};
+        double tolerance{DEFAULT_TOLERANCE};
+    };
+
+    struct Scenario
+    {
+        std::string name;
+        /**
+         * @brief 每次迭代处理的字节数，只用于显示吞吐量
+         *
+         */
+        std::uint64_t byte_count;
+        std::function<void()> run;
+    };
+
+    struct Statistics
+    {
+        double median_ns{0};
+        double ci_low_ns{0};
+        double ci_high_ns{0};
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::uint64_t byte_count;
+        std::uint32_t sample_count;
+        Statistics statistics;
+    };
+
+    /**
+     * @brief 读取输出中的一个字节，防止编译器认为结果没有被使用而删除整个场景
+     *
+     */
+    volatile std::byte g_sink{};
+
+    void Consume(const void* p_data) noexcept
+    {
+        g_sink = *static_cast<const std::byte*>(p_data);
+    }
+
+    double GetMedian(std::vector<double>& values)
+    {
+        const auto middle = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+        std::nth_element(values.begin(), middle, values.end());
+        if (values.size() % 2 != 0)
+        {
+            return *middle;
+        }
+        return (*middle + *std::max_element(values.begin(), middle)) / 2;
+    }
+
+    double GetQuantile(std::vector<double>& sorted_values, const double quantile)
+    {
+        const auto index = static_cast<std::size_t>(quantile * static_cast<double>(sorted_values.size() - 1) + 0.5);
+        return sorted_values[index];
+    }
+
+    Statistics Bootstrap(std::vector<double> samples)
+    {
+        std::mt19937_64 random{BOOTSTRAP_SEED};
+        std::uniform_int_distribution<std::size_t> distribution{0, samples.size() - 1};
+        std::vector<double> resample(samples.size());
+        std::vector<double> medians(BOOTSTRAP_RESAMPLE_COUNT);
+        for (auto& median : medians)
+        {
+            for (auto& value : resample)
+            {
+                value = samples[distribution(random)];
+            }
+            median = GetMedian(resample);
+        }
+        std::sort(medians.begin(), medians.end());
+        const auto tail = (1 - CONFIDENCE_LEVEL) / 2;
+        return {GetMedian(samples), GetQuantile(medians, tail), GetQuantile(medians, 1 - tail)};
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 预热后以一次迭代的耗时估计每个样本需要的迭代次数
+     *
+     */
+    std::uint32_t Calibrate(const Scenario& scenario)
+    {
+        for (std::uint32_t i = 0; i < WARMUP_ITERATION_COUNT; ++i)
+        {
+            scenario.run();
+        }
+        const auto begin = Clock::now();
+        scenario.run();
+        const auto duration = (std::max)(Clock::now() - begin, Clock::duration{1});
+        return static_cast<std::uint32_t>((std::max)(Clock::duration::rep{1}, MIN_SAMPLE_DURATION / duration));
+    }
+
+    /**
+     * @brief 返回一个样本中平均每次迭代的纳秒数
+     *
+     */
+    double MeasureSample(const Scenario& scenario, const std::uint32_t iteration_count)
+    {
+        const auto begin = Clock::now();
+        for (std::uint32_t i = 0; i < iteration_count; ++i)
+        {
+            scenario.run();
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / iteration_count;
+    }
+
+    /**
+     * @brief 按轮次交错测量：每一轮中每个场景取一个样本。
+        机器的频率和其它进程的干扰随时间漂移，交错后每个场景的样本分布在整个测量期间，
+        置信区间包含了这种漂移，而不是只反映连续几毫秒内的波动
+     *
+     */
+    void MeasureInterleaved(const std::vector<Scenario>& scenarios, const std::uint32_t sample_count, std::vector<Result>& results)
+    {
+        std::vector<std::uint32_t> iteration_counts{};
+        for (const auto& scenario : scenarios)
+        {
+            iteration_counts.push_back(Calibrate(scenario));
+        }
+        std::vector<std::vector<double>> samples(scenarios.size(), std::vector<double>(sample_count));
+        for (std::uint32_t round = 0; round < sample_count; ++round)
+        {
+            for (std::size_t i = 0; i < scenarios.size(); ++i)
+            {
+                samples[i][round] = MeasureSample(scenarios[i], iteration_counts[i]);
+            }
+        }
+        for (std::size_t i = 0; i < scenarios.size(); ++i)
+        {
+            results.push_back({scenarios[i].name, scenarios[i].byte_count, sample_count, Bootstrap(std::move(samples[i]))});
+        }
+    }
+
+    std::string MakeName(const char* group, const Resolution& resolution, const std::string& variant)
+    {
+        return std::string{group} + "/" + std::to_string(resolution.width) + "x" + std::to_string(resolution.height) + "/" + variant;
+    }
+
+    /**
+     * @brief 一个分辨率下所有场景共用的缓冲区，场景只在测量期间引用它们
+     *
+     */
+    struct Buffers
+    {
+        std::vector<std::byte> color_source;
+        std::vector<std::byte> color_destination;
+        std::vector<std::uint32_t> depth_24;
+        std::vector<float> depth_float;
+        std::vector<float> linear_depth;
+        std::vector<std::uint8_t> stencil;
+        std::vector<std::unique_ptr<Test::MockFastCaptureClient>> clients;
+        std::vector<std::vector<char>> batch_destinations;
+        std::vector<FastCaptureCopyRequest> batch_requests;
+
+        explicit Buffers(const Resolution& resolution)
+        {
+            const auto pixel_count = static_cast<std::size_t>(resolution.width) * resolution.height;
+            color_source.resize(pixel_count * 4);
+            color_destination.resize(pixel_count * 4);
+            depth_24.resize(pixel_count);
+            depth_float.resize(pixel_count);
+            linear_depth.resize(pixel_count);
+            stencil.resize(pixel_count);
+            for (std::size_t i = 0; i < pixel_count; ++i)
+            {
+                color_source[i * 4] = static_cast<std::byte>(i);
+                depth_24[i] = static_cast<std::uint32_t>(i * 2654435761u);
+                depth_float[i] = static_cast<float>(i) / static_cast<float>(pixel_count);
+            }
+        }
+    };
+
+    std::vector<Scenario> MakeScenarios(const Resolution& resolution, Buffers& buffers)
+    {
+        using namespace Utils::PixelPipeline;
+        const auto pixel_count = static_cast<std::size_t>(resolution.width) * resolution.height;
+        const auto color_size = pixel_count * 4;
+        const Frame source_frame{buffers.color_source.data(), resolution.width * 4u, resolution.width, resolution.height};
+        std::vector<Scenario> result{};
+
+        result.push_back({MakeName("Copy", resolution, "memcpy"), color_size, [&buffers, color_size]()
+                          {
+                              std::memcpy(buffers.color_destination.data(), buffers.color_source.data(), color_size);
+                              Consume(buffers.color_destination.data());
+                          }});
+        result.push_back({MakeName("Copy", resolution, "StreamingCopy"), color_size, [&buffers, color_size]()
+                          {
+                              Utils::StreamingCopy(buffers.color_destination.data(), buffers.color_source.data(), color_size);
+                              Consume(buffers.color_destination.data());
+                          }});
+
+        result.push_back({MakeName("DepthConvert", resolution, "Depth24ToLinear"), pixel_count * sizeof(std::uint32_t), [&buffers, pixel_count]()
+                          {
+                              ConvertDepth24ToLinear(buffers.depth_24.data(), buffers.linear_depth.data(), pixel_count, 0.1f, 1000.0f);
+                              Consume(buffers.linear_depth.data());
+                          }});
+        result.push_back({MakeName("DepthConvert", resolution, "DepthFloatToLinear"), pixel_count * sizeof(float), [&buffers, pixel_count]()
+                          {
+                              ConvertDepthFloatToLinear(buffers.depth_float.data(), buffers.linear_depth.data(), pixel_count, 0.1f, 1000.0f);
+                              Consume(buffers.linear_depth.data());
+                          }});
+        result.push_back({MakeName("DepthConvert", resolution, "ExtractStencil"), pixel_count * sizeof(std::uint32_t), [&buffers, pixel_count]()
+                          {
+                              ExtractStencilFromDepth24(buffers.depth_24.data(), buffers.stencil.data(), pixel_count);
+                              Consume(buffers.stencil.data());
+                          }});
+
+        struct PipelineVariant
+        {
+            const char* name;
+            PixelFormat destination;
+            bool is_reversed;
+            bool is_window;
+        };
+        constexpr PipelineVariant PIPELINE_VARIANTS[] = {
+            {"Rgba8Reversed", PixelFormat::Rgba8, true, false},
+            {"Bgra8", PixelFormat::Bgra8, false, false},
+            {"Rgb8HalfWindow", PixelFormat::Rgb8, false, true},
+        };
+        for (const auto& variant : PIPELINE_VARIANTS)
+        {
+            const auto convert_frame = SelectConvertFrame(PixelFormat::Rgba8, variant.destination, variant.is_reversed, variant.is_window);
+            const Region region{resolution.width / 4, resolution.height / 4, resolution.width / 2, resolution.height / 2};
+            const auto output_pixel_count = variant.is_window ? static_cast<std::size_t>(region.width) * region.height : pixel_count;
+            result.push_back({MakeName("PixelPipeline", resolution, variant.name), output_pixel_count * 4, [&buffers, convert_frame, source_frame, region]()
+                              {
+                                  convert_frame(source_frame, region, buffers.color_destination.data());
+                                  Consume(buffers.color_destination.data());
+                              }});
+        }
+
+        // 每个消费者是一个独立的客户端，由CopyLatestCaptures在工作线程池中并行复制
+        const auto max_consumer_count = *std::max_element(std::begin(CONSUMER_COUNTS), std::end(CONSUMER_COUNTS));
+        const std::vector<char> frame(color_size, 'F');
+        for (std::uint32_t i = 0; i < max_consumer_count; ++i)
+        {
+            buffers.clients.push_back(std::make_unique<Test::MockFastCaptureClient>());
+            buffers.clients.back()->PublishFrame(1, 0, frame);
+            buffers.batch_destinations.emplace_back(color_size);
+        }
+        buffers.batch_requests.resize(max_consumer_count);
+        for (const auto consumer_count : CONSUMER_COUNTS)
+        {
+            result.push_back({MakeName("BatchCopy", resolution, "consumers=" + std::to_string(consumer_count)), color_size * consumer_count, [&buffers, consumer_count]()
+                              {
+                                  for (std::uint32_t i = 0; i < consumer_count; ++i)
+                                  {
+                                      auto& destination = buffers.batch_destinations[i];
+                                      buffers.batch_requests[i] = {buffers.clients[i].get(), FAST_CAPTURE_PLANE_COLOR, destination.data(), destination.size(), 0, {}, {}};
+                                  }
+                                  CopyLatestCaptures(buffers.batch_requests.data(), consumer_count);
+                                  Consume(buffers.batch_destinations[0].data());
+                              }});
+        }
+        return result;
+    }
+
+    std::string ToJson(const std::vector<Result>& results)
+    {
+        std::ostringstream stream{};
+        stream.precision(1);
+        stream << std::fixed << "{\n  \"version\": 1,\n  \"scenarios\": [\n";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& result = results[i];
+            stream << "    {\"name\": \"" << result.name << "\", \"bytes\": " << result.byte_count
+                   << ", \"samples\": " << result.sample_count
+                   << ", \"median_ns\": " << result.statistics.median_ns
+                   << ", \"ci_low_ns\": " << result.statistics.ci_low_ns
+                   << ", \"ci_high_ns\": " << result.statistics.ci_high_ns << "}"
+                   << (i + 1 == results.size() ? "\n" : ",\n");
+        }
+        stream << "  ]\n}\n";
+        return stream.str();
+    }
+
+    bool FindNumber(const std::string& line, const char* key, double& value)
+    {
+        const auto key_position = line.find(std::string{"\""} + key + "\":");
+        if (key_position == std::string::npos)
+        {
+            return false;
+        }
+        value = std::strtod(line.c_str() + key_position + std::strlen(key) + 3, nullptr);
+        return true;
+    }
+
+    /**
+     * @brief 只读取ToJson写出的格式：每个场景占一行
+     *
+     */
+    bool ReadBaseline(const std::string& path, std::map<std::string, Statistics>& baseline)
+    {
+        std::ifstream file{path};
+        if (!file)
+        {
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line))
+        {
+            constexpr std::string_view NAME_KEY = "\"name\": \"";
+            const auto name_position = line.find(NAME_KEY);
+            if (name_position == std::string::npos)
+            {
+                continue;
+            }
+            const auto name_begin = name_position + NAME_KEY.size();
+            const auto name_end = line.find('"', name_begin);
+            Statistics statistics{};
+            if (name_end == std::string::npos
+                || !FindNumber(line, "median_ns", statistics.median_ns)
+                || !FindNumber(line, "ci_low_ns", statistics.ci_low_ns)
+                || !FindNumber(line, "ci_high_ns", statistics.ci_high_ns))
+            {
+                continue;
+            }
+            baseline[line.substr(name_begin, name_end - name_begin)] = statistics;
+        }
+        return true;
+    }
+
+    bool WriteFile(const std::string& path, const std::string& content)
+    {
+        std::ofstream file{path, std::ios::trunc};
+        file << content;
+        return static_cast<bool>(file);
+    }
+
+    bool ParseOptions(const int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string argument{argv[i]};
+            const auto has_value = i + 1 < argc;
+            if (argument == "--update-baseline")
+            {
+                options.is_update_baseline = true;
+            }
+            else if (argument == "--baseline" && has_value)
+            {
+                options.baseline_path = argv[++i];
+            }
+            else if (argument == "--output" && has_value)
+            {
+                options.output_path = argv[++i];
+            }
+            else if (argument == "--filter" && has_value)
+            {
+                options.filter = argv[++i];
+            }
+            else if (argument == "--samples" && has_value)
+            {
+                options.sample_count = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (argument == "--tolerance" && has_value)
+            {
+                options.tolerance = std::strtod(argv[++i], nullptr);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return options.sample_count >= 3 && options.tolerance >= 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options{};
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::fprintf(
+            stderr,
+            "usage: %s [--baseline <file>] [--update-baseline] [--output <file>]\n"
+            "          [--filter <substring>] [--samples <n>] [--tolerance <ratio>]\n",
+            argv[0]);
+        return EXIT_USAGE;
+    }
+
+    std::vector<Result> results{};
+    for (const auto& resolution : RESOLUTIONS)
+    {
+        Buffers buffers{resolution};
+        auto scenarios = MakeScenarios(resolution, buffers);
+        std::erase_if(
+            scenarios,
+            [&options](const Scenario& scenario)
+            { return !options.filter.empty() && scenario.name.find(options.filter) == std::string::npos; });
+        MeasureInterleaved(scenarios, options.sample_count, results);
+    }
+
+    const auto json = ToJson(results);
+    if (!options.output_path.empty() && !WriteFile(options.output_path, json))
+    {
+        std::fprintf(stderr, "failed to write %s\n", options.output_path.c_str());
+        return EXIT_USAGE;
+    }
+    // 不同机器之间的结果没有可比性，第一次运行时记录本机的基线，而不是与别处记录的基线比较
+    const auto is_baseline_missing = !options.baseline_path.empty() && !std::filesystem::exists(options.baseline_path);
+    if (is_baseline_missing && !options.is_update_baseline)
+    {
+        std::printf("no baseline at %s, recording this run as the baseline\n", options.baseline_path.c_str());
+        options.is_update_baseline = true;
+    }
+    if (options.is_update_baseline)
+    {
+        if (options.baseline_path.empty() || !WriteFile(options.baseline_path, json))
+        {
+            std::fprintf(stderr, "failed to write baseline %s\n", options.baseline_path.c_str());
+            return EXIT_USAGE;
+        }
+        std::printf("baseline written to %s\n", options.baseline_path.c_str());
+    }
+
+    std::map<std::string, Statistics> baseline{};
+    const auto has_baseline =
+        !options.is_update_baseline && !options.baseline_path.empty() && ReadBaseline(options.baseline_path, baseline);
+    if (!options.is_update_baseline && !options.baseline_path.empty() && !has_baseline)
+    {
+        std::printf("cannot read baseline %s, run with --update-baseline to record a new one\n", options.baseline_path.c_str());
+    }
+
+    auto regressed_count = 0;
+    std::printf("%-42s %12s %25s %9s %12s  %s\n", "scenario", "median(us)", "95% CI(us)", "GB/s", "vs baseline", "status");
+    for (const auto& result : results)
+    {
+        const auto& statistics = result.statistics;
+        const auto throughput = static_cast<double>(result.byte_count) / statistics.median_ns;
+        char interval[32];
+        std::snprintf(interval, sizeof(interval), "[%.1f, %.1f]", statistics.ci_low_ns / 1000, statistics.ci_high_ns / 1000);
+        const auto it = baseline.find(result.name);
+        if (it == baseline.end())
+        {
+            std::printf("%-42s %12.1f %25s %9.2f %12s  %s\n", result.name.c_str(), statistics.median_ns / 1000, interval, throughput, "-", has_baseline ? "new" : "");
+            continue;
+        }
+        const auto& base = it->second;
+        const auto change = statistics.median_ns / base.median_ns - 1;
+        // 两次运行的置信区间必须在扣除容差后仍然不重叠，单次的波动不会被判定为退化
+        const auto is_regressed = statistics.ci_low_ns > base.ci_high_ns * (1 + options.tolerance);
+        const auto is_improved = statistics.ci_high_ns * (1 + options.tolerance) < base.ci_low_ns;
+        regressed_count += is_regressed;
+        std::printf(
+            "%-42s %12.1f %25s %9.2f %+11.1f%%  %s\n",
+            result.name.c_str(),
+            statistics.median_ns / 1000,
+            interval,
+            throughput,
+            change * 100,
+            is_regressed ? "REGRESSED" : (is_improved ? "improved" : "ok"));
+    }
+    if (regressed_count != 0)
+    {
+        std::printf("%d scenario(s) regressed beyond %.0f%% tolerance\n", regressed_count, options.tolerance * 100);
+        return EXIT_REGRESSED;
+    }
+    return 0;
+}
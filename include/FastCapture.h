@@ -1,6 +1,7 @@
 #ifndef FAST_CAPTURE_H
 #define FAST_CAPTURE_H
 #include <FastCaptureDef.h>
+#include <stddef.h>
 
 struct IFastCaptureClient
 {
@@ -8,11 +9,378 @@ struct IFastCaptureClient
     RequestLatestCaptureSize(size_t* size) FAST_CAPTURE_NOEXCEPT = 0;
     virtual FastCaptureErrorCode FAST_CAPTURE_CALL
     CopyLatestCapture(char* p_memory, size_t memory_size) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 设置此客户端需要的FAST_CAPTURE_FLAG_*，注入DLL按所有客户端需要的并集捕获。
+        深度平面只有一种格式，其它客户端需要的格式与此不同时，复制深度平面返回FAST_CAPTURE_E_DEPTH_FORMAT_CONFLICT
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetCaptureFlags(uint32_t capture_flags) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 设置FAST_CAPTURE_FLAG_LINEAR_DEPTH使用的近、远裁剪面，应与目标程序的投影矩阵一致
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetDepthRange(float near_plane, float far_plane) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 获得最新一帧中某个FAST_CAPTURE_PLANE_*的字节数，平面未启用时返回FAST_CAPTURE_E_CAPTURE_PLANE_NOT_ENABLED
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestLatestCapturePlaneSize(uint32_t plane, size_t* size) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 复制最新一帧的某个FAST_CAPTURE_PLANE_*。
+        此客户端设置了深度标志、而发布的深度格式与之不同时，复制深度平面返回FAST_CAPTURE_E_DEPTH_FORMAT_CONFLICT
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    CopyLatestCapturePlane(uint32_t plane, char* p_memory, size_t memory_size) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 获得最新一帧中某个平面的宽、高、像素大小和格式，
+        例如FAST_CAPTURE_PLANE_COLOR_MIP_1的宽高为颜色平面的一半
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestLatestCapturePlaneInfo(uint32_t plane, FastCapturePlaneInfo* info) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 获得最新一帧的序号和重复次数，只读取原子变量，不复制图像。
+        frame_index没有变化时说明画面没有变化，可以跳过复制和后续处理
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestLatestCaptureFrameInfo(FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 与CopyLatestCapturePlane相同，同时返回复制的字节数和复制出的数据所属的帧，copied_size和info都可以为NULL。
+        两者与数据在同一次读取中确定，不会属于另一帧。info->repeat_count总是为0
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    CopyLatestCapturePlaneEx(uint32_t plane, char* p_memory, size_t memory_size, size_t* copied_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 设置FAST_CAPTURE_COPY_FLAG_*，只影响此客户端之后的复制
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetCopyFlags(uint32_t copy_flags) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 等待注入DLL发布新帧，超时返回FAST_CAPTURE_E_WAIT_NEW_FRAME_TIMEOUT。
+        等待代理或注入DLL为此客户端设置的事件，旧的注入DLL没有事件时轮询frame_index。可能提前返回，返回后应检查frame_index
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    WaitForNewFrame(uint32_t timeout_ms) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 取出此客户端还没有取出的事件，按sequence递增排列。每个客户端有自己的读取位置，
+        不影响注入DLL和其它客户端。第一次调用时从日志中最旧的事件开始
+     *
+     * @param count 取出的事件数，小于capacity时说明已经取完
+     * @param lost_count 可以为nullptr，取出前已被覆盖而丢失的事件数
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    DrainCaptureEvents(FastCaptureEvent* events, size_t capacity, size_t* count, uint64_t* lost_count) FAST_CAPTURE_NOEXCEPT = 0;
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestCaptureCounters(FastCaptureCounters* counters) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 协商CopyLatestColorOutput输出的像素格式、行序和区域。
+        对应的转换函数在这里选出一次，之后的每次复制不再判断这些选项。默认输出整帧的RGBA，第一行在底部
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetColorOutput(const FastCaptureColorOutputDesc* desc) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 按协商的输出计算最新一帧需要的字节数，区域超出画面时返回FAST_CAPTURE_E_COLOR_OUTPUT_REGION_OUT_OF_FRAME
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestLatestColorOutputSize(size_t* size) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 按协商的输出复制最新一帧的颜色平面，行紧密排列，info可以为NULL
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    CopyLatestColorOutput(char* p_memory, size_t memory_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 设置注入DLL每帧用于映射、转换和发布的CPU时间（微秒），这些工作只在目标程序交换之后的空闲窗口中进行，
+        放不下的帧被推迟，推迟的帧过多时丢弃较旧的帧。0表示使用默认值，
+        FAST_CAPTURE_FRAME_CPU_BUDGET_UNLIMITED表示不限制。对所有客户端生效，以最后一次设置为准
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetFrameCpuBudget(uint32_t cpu_budget_us) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 设置注入DLL读回线程的亲和性、优先级和与渲染线程的隔离，应在创建客户端后立即调用。
+        读回线程在下一次唤醒时应用，应用的结果记录为FAST_CAPTURE_EVENT_THREAD_SCHEDULING_APPLIED事件，
+        计数中的scheduling_generation随之变化。对所有客户端生效，以最后一次设置为准
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetCaptureThreadScheduling(const FastCaptureThreadSchedulingDesc* desc) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 获得发布新帧时被设置的AUTO_RESET事件的HANDLE，可以交给asio的object_handle、IOCP事件循环等等待，
+        不需要轮询也不占用线程。句柄属于客户端，不能关闭，在客户端销毁之前一直有效且不会变化。
+        事件可能由已经看到的帧设置，被唤醒后应检查frame_index
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestFrameEventHandle(void** handle) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 有frame_index不等于last_frame_index的帧或超时后，在系统线程池中调用一次callback，等待期间不占用任何线程。
+        调用时已经有这样的帧也在线程池中调用，不会在此函数中直接调用。
+        同一时刻只能有一个等待中的通知，否则返回FAST_CAPTURE_E_FRAME_NOTIFICATION_PENDING；
+        callback中可以再次调用此函数。销毁客户端时，等待中的通知以FAST_CAPTURE_E_FRAME_NOTIFICATION_CANCELLED调用
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    NotifyNewFrame(uint64_t last_frame_index, uint32_t timeout_ms, FastCaptureNewFrameCallback callback, void* context) FAST_CAPTURE_NOEXCEPT = 0;
+};
+
+/**
+ * @brief 由后台线程不断从客户端复制新帧，保留最近的若干帧。
+    帧按frame_index排序，被淘汰或被跳过的帧返回FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND
+ *
+ */
+struct IFastCaptureHistory
+{
+    /**
+     * @brief 获得当前保留的最旧和最新一帧的frame_index
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestFrameRange(uint64_t* first_frame_index, uint64_t* last_frame_index) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 获得某一帧的字节数
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestFrameSize(uint64_t frame_index, size_t* size) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 复制某一帧，info可以为NULL
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    CopyFrame(uint64_t frame_index, char* p_memory, size_t memory_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 查找timestamp_us不晚于指定时刻的最新一帧
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    FindFrameByTime(uint64_t timestamp_us, uint64_t* frame_index) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 按顺序获得timestamp_us位于[begin_us, end_us]之间的帧，
+        frame_indexes为NULL时只通过count返回帧数
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestFramesInTimeRange(
+        uint64_t begin_us,
+        uint64_t end_us,
+        uint64_t* frame_indexes,
+        size_t capacity,
+        size_t* count) FAST_CAPTURE_NOEXCEPT = 0;
+};
+
+/**
+ * @brief 在FastCaptureHub的工作线程中被调用，p_frame只在回调期间有效。
+    同一个目标的回调不会并发执行
+ *
+ */
+typedef void(FAST_CAPTURE_CALL* FastCaptureFrameCallback)(
+    void* user_data,
+    uint32_t target_id,
+    const char* p_frame,
+    size_t frame_size,
+    const FastCaptureFrameInfo* info);
+
+typedef struct FastCaptureHubTargetDesc1__
+{
+    IFastCaptureClient* client;
+    /// 需要分发的FAST_CAPTURE_PLANE_*
+    uint32_t plane;
+    /// 多个目标同时有新帧时，优先分发priority较大的目标
+    int32_t priority;
+    /// 每秒最多分发的帧数，为0表示不限制
+    uint32_t max_fps;
+    /// 为此目标预分配的帧缓冲区的字节数，大于它的帧会被跳过
+    uint64_t max_frame_size;
+    FastCaptureFrameCallback callback;
+    void* user_data;
+} FastCaptureHubTargetDesc;
+
+/**
+ * @brief 用一个调度线程检查所有目标的新帧，并把新帧分发到共享的工作线程池中。
+    每个目标同时最多只有一帧在处理，处理期间到达的帧会合并为最新的一帧
+ *
+ */
+struct IFastCaptureHub
+{
+    /**
+     * @brief client在目标被移除之前必须保持有效
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    AddTarget(const FastCaptureHubTargetDesc* desc, uint32_t* target_id) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 返回后不会再有此目标的回调，因此不能在此目标的回调中调用
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RemoveTarget(uint32_t target_id) FAST_CAPTURE_NOEXCEPT = 0;
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetTargetPriority(uint32_t target_id, int32_t priority) FAST_CAPTURE_NOEXCEPT = 0;
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    SetTargetMaxFps(uint32_t target_id, uint32_t max_fps) FAST_CAPTURE_NOEXCEPT = 0;
+};
+
+typedef struct FastCaptureCopyRequest1__
+{
+    /// 输入：同一个客户端可以出现多次
+    IFastCaptureClient* client;
+    uint32_t plane;
+    char* p_memory;
+    size_t memory_size;
+    /// 输出：result成功时有效
+    size_t copied_size;
+    FastCaptureFrameInfo info;
+    FastCaptureErrorCode result;
+} FastCaptureCopyRequest;
+
+/**
+ * @brief 由后台线程把新帧写入文件，写入不会阻塞复制新帧
+ *
+ */
+struct IFastCaptureRecorder
+{
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestStatistics(FastCaptureRecorderStatistics* statistics) FAST_CAPTURE_NOEXCEPT = 0;
 };
 
+/**
+ * @brief 代理替不能打开注入DLL的命名共享内存的客户端（例如在容器或沙盒中）注入目标进程，
+    并通过命名管道把共享内存和新帧通知的句柄复制到客户端进程中，客户端仍然直接读取共享内存。
+    管道只允许SYSTEM、管理员和交互式登录的用户连接。客户端只能附加到它自己能以PROCESS_VM_READ打开的进程，
+    或者由代理的宿主以AllowTargetProcess允许的进程
+ *
+ */
+struct IFastCaptureBroker
+{
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RequestConnectionCount(size_t* count) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 允许任何连接的客户端附加到process_id，用于自己不能打开目标进程的沙盒中的客户端
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    AllowTargetProcess(uint32_t process_id) FAST_CAPTURE_NOEXCEPT = 0;
+};
+
+/**
+ * @brief 以Prometheus的文本格式导出各个客户端的FastCaptureCounters，每个客户端以target标签区分
+ *
+ */
+struct IFastCaptureMetricsExporter
+{
+    /**
+     * @brief 客户端在RemoveClient返回前必须保持有效
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    AddClient(IFastCaptureClient* client, const char* target_label) FAST_CAPTURE_NOEXCEPT = 0;
+    /**
+     * @brief 返回后导出器不会再访问此客户端
+     *
+     */
+    virtual FastCaptureErrorCode FAST_CAPTURE_CALL
+    RemoveClient(IFastCaptureClient* client) FAST_CAPTURE_NOEXCEPT = 0;
+};
+
+/**
+ * @brief 按可执行文件名查找目标进程并注入。有多个同名进程时失败，
+    此时应先用FindFastCaptureProcesses确定进程ID，再调用CreateFastCaptureInstanceByProcessId
+ *
+ */
 FAST_CAPTURE_EXPORT
 IFastCaptureClient* CreateFastCaptureInstance(const wchar_t* const w_process_name) FAST_CAPTURE_NOEXCEPT;
 FAST_CAPTURE_EXPORT
+IFastCaptureClient* CreateFastCaptureInstanceByProcessId(uint32_t process_id) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 通过名为pipe_name的代理连接到目标进程，不需要打开命名共享内存
+ *
+ */
+FAST_CAPTURE_EXPORT
+IFastCaptureClient* CreateFastCaptureInstanceFromBroker(const wchar_t* pipe_name, uint32_t process_id) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 在缓存的进程索引中查找匹配的进程，索引过期或没有匹配时才重新扫描系统进程。
+    process_ids为NULL时只通过count返回匹配的进程数
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode FindFastCaptureProcesses(
+    const FastCaptureProcessQuery* query,
+    uint32_t* process_ids,
+    size_t capacity,
+    size_t* count) FAST_CAPTURE_NOEXCEPT;
+FAST_CAPTURE_EXPORT
 FastCaptureErrorCode DestroyFastCaptureInstance(IFastCaptureClient* client) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 预分配(desc->max_frame_count + 1) * desc->max_frame_size字节并启动后台线程。
+    client在历史记录销毁之前必须保持有效，client可以同时被其它线程使用
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode CreateFastCaptureHistory(
+    IFastCaptureClient* client,
+    const FastCaptureHistoryDesc* desc,
+    IFastCaptureHistory** history) FAST_CAPTURE_NOEXCEPT;
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode DestroyFastCaptureHistory(IFastCaptureHistory* history) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 在一次调用中复制多个目标的最新一帧，各个请求在共享的线程池中并行执行。
+    每个请求只在一个线程中复制，客户端的FAST_CAPTURE_COPY_FLAG_PARALLEL在这里不生效，
+    并行度不超过请求数量。每个请求的结果写入各自的result，有请求失败时返回FAST_CAPTURE_E_BATCH_COPY_PARTIALLY_FAILED
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode CopyLatestCaptures(FastCaptureCopyRequest* requests, size_t request_count) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief client在录制器销毁之前必须保持有效
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode CreateFastCaptureRecorder(
+    IFastCaptureClient* client,
+    const FastCaptureRecorderDesc* desc,
+    IFastCaptureRecorder** recorder) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 等待进行中的写入完成后关闭文件
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode DestroyFastCaptureRecorder(IFastCaptureRecorder* recorder) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 在\\.\pipe\<pipe_name>上启动代理
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode CreateFastCaptureBroker(const wchar_t* pipe_name, IFastCaptureBroker** broker) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 断开所有连接，已经复制到客户端的句柄仍然有效
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode DestroyFastCaptureBroker(IFastCaptureBroker* broker) FAST_CAPTURE_NOEXCEPT;
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode CreateFastCaptureMetricsExporter(
+    const FastCaptureMetricsExporterDesc* desc,
+    IFastCaptureMetricsExporter** exporter) FAST_CAPTURE_NOEXCEPT;
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode DestroyFastCaptureMetricsExporter(IFastCaptureMetricsExporter* exporter) FAST_CAPTURE_NOEXCEPT;
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode CreateFastCaptureHub(const FastCaptureHubDesc* desc, IFastCaptureHub** hub) FAST_CAPTURE_NOEXCEPT;
+/**
+ * @brief 停止所有线程，尚未处理的帧被丢弃
+ *
+ */
+FAST_CAPTURE_EXPORT
+FastCaptureErrorCode DestroyFastCaptureHub(IFastCaptureHub* hub) FAST_CAPTURE_NOEXCEPT;
 
 #endif
@@ -0,0 +1,183 @@
+#ifndef FAST_CAPTURE_ASYNC_HPP
+#define FAST_CAPTURE_ASYNC_HPP
+
+// 基于IFastCaptureClient::NotifyNewFrame的C++20协程接口，只有头文件。
+// 协程帧不跨越DLL边界：FastCapture.dll只在线程池中调用C回调，恢复协程的线程由调用者的执行器决定
+
+#include <FastCapture.h>
+#include <concepts>
+#include <coroutine>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Async
+    {
+        struct FrameResult
+        {
+            FastCaptureErrorCode error;
+            FastCaptureFrameInfo info;
+        };
+
+        /**
+         * @brief 执行器以协程句柄调用，负责在合适的线程中恢复协程，例如投递到asio的strand或UI线程的消息队列
+         *
+         */
+        template <class T>
+        concept is_executor = std::invocable<T&, std::coroutine_handle<>>;
+
+        /**
+         * @brief 直接在系统线程池的线程中恢复协程，协程在恢复后应尽快完成或切换到自己的线程
+         *
+         */
+        struct InlineExecutor
+        {
+            void operator()(std::coroutine_handle<> handle) const noexcept
+            {
+                handle.resume();
+            }
+        };
+
+        /**
+         * @brief 不拥有IFastCaptureClient，客户端必须比所有等待中的协程活得更久。
+            同一个Client同一时刻只能有一个等待中的NextFrame
+         *
+         */
+        template <is_executor Executor = InlineExecutor>
+        class Client
+        {
+        private:
+            IFastCaptureClient* p_client_;
+            Executor executor_;
+            std::uint64_t last_frame_index_{0};
+
+            class NextFrameAwaiter
+            {
+            private:
+                Client* p_owner_;
+                std::uint32_t timeout_ms_;
+                std::coroutine_handle<> handle_{};
+                FrameResult result_{};
+
+                static void FAST_CAPTURE_CALL OnNewFrame(void* context, FastCaptureErrorCode result)
+                {
+                    auto const p_this = static_cast<NextFrameAwaiter*>(context);
+                    p_this->result_.error = result;
+                    p_this->p_owner_->executor_(p_this->handle_);
+                }
+
+                bool TryTakeFrame() noexcept
+                {
+                    result_.error = p_owner_->p_client_->RequestLatestCaptureFrameInfo(&result_.info);
+                    if (result_.error.error_code != FAST_CAPTURE_S_OK)
+                    {
+                        return true;
+                    }
+                    return result_.info.frame_index != p_owner_->last_frame_index_;
+                }
+
+            public:
+                NextFrameAwaiter(Client* p_owner, const std::uint32_t timeout_ms) noexcept
+                    : p_owner_{p_owner}, timeout_ms_{timeout_ms}
+                {
+                }
+
+                bool await_ready() noexcept
+                {
+                    return TryTakeFrame();
+                }
+                bool await_suspend(std::coroutine_handle<> handle) noexcept
+                {
+                    handle_ = handle;
+                    const auto result = p_owner_->p_client_->NotifyNewFrame(
+                        p_owner_->last_frame_index_,
+                        timeout_ms_,
+                        &OnNewFrame,
+                        this);
+                    // 成功后回调可能已经在其它线程中恢复并销毁了协程，不能再访问this
+                    if (result.error_code == FAST_CAPTURE_S_OK)
+                    {
+                        return true;
+                    }
+                    result_.error = result;
+                    return false;
+                }
+                FrameResult await_resume() noexcept
+                {
+                    if (result_.error.error_code == FAST_CAPTURE_S_OK)
+                    {
+                        TryTakeFrame();
+                    }
+                    if (result_.error.error_code == FAST_CAPTURE_S_OK)
+                    {
+                        p_owner_->last_frame_index_ = result_.info.frame_index;
+                    }
+                    return result_;
+                }
+            };
+
+            class CopyIntoAwaiter
+            {
+            private:
+                IFastCaptureClient* p_client_;
+                std::span<char> buffer_;
+
+            public:
+                CopyIntoAwaiter(IFastCaptureClient* p_client, const std::span<char> buffer) noexcept
+                    : p_client_{p_client}, buffer_{buffer}
+                {
+                }
+
+                constexpr bool await_ready() const noexcept
+                {
+                    return true;
+                }
+                constexpr void await_suspend(std::coroutine_handle<>) const noexcept
+                {
+                }
+                FrameResult await_resume() noexcept
+                {
+                    FrameResult result{};
+                    result.error = p_client_->CopyLatestColorOutput(buffer_.data(), buffer_.size(), &result.info);
+                    return result;
+                }
+            };
+
+        public:
+            explicit Client(IFastCaptureClient* p_client, Executor executor = Executor{}) noexcept(std::is_nothrow_move_constructible_v<Executor>)
+                : p_client_{p_client}, executor_{std::move(executor)}
+            {
+            }
+            Client(const Client&) = delete;
+            Client& operator=(const Client&) = delete;
+
+            /**
+             * @brief 等待frame_index与上一次NextFrame返回的不同的帧，已经有这样的帧时不挂起。
+                挂起期间没有线程在等待，新帧发布后由执行器恢复协程
+             *
+             */
+            [[nodiscard]] NextFrameAwaiter NextFrame(const std::uint32_t timeout_ms = FAST_CAPTURE_TIMEOUT_INFINITE) noexcept
+            {
+                return NextFrameAwaiter{this, timeout_ms};
+            }
+            /**
+             * @brief 按SetColorOutput协商的输出复制最新一帧。复制不需要等待，因此不挂起，
+                在恢复协程的执行器的线程中同步完成
+             *
+             */
+            [[nodiscard]] CopyIntoAwaiter CopyInto(const std::span<char> buffer) const noexcept
+            {
+                return CopyIntoAwaiter{p_client_, buffer};
+            }
+            IFastCaptureClient* GetClient() const noexcept
+            {
+                return p_client_;
+            }
+        };
+    }
+}
+
+#endif // FAST_CAPTURE_ASYNC_HPP
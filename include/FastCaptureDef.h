@@ -4,7 +4,11 @@
 #include <stdint.h>
 
 #define FAST_CAPTURE_NOEXCEPT noexcept
+#ifdef _WIN32
 #define FAST_CAPTURE_CALL __stdcall
+#else
+#define FAST_CAPTURE_CALL
+#endif
 #ifdef _MSC_VER
 #define FAST_CAPTURE_EXPORT __declspec(dllexport)
 #else
@@ -23,6 +27,8 @@
 #define FAST_CAPTURE_ERROR_TYPE_DEFAULT 1
 #define FAST_CAPTURE_ERROR_TYPE_WIN32 2
 #define FAST_CAPTURE_ERROR_TYPE_GLEW 3
+#define FAST_CAPTURE_ERROR_TYPE_VULKAN 4
+#define FAST_CAPTURE_ERROR_TYPE_EGL 5
 
 typedef struct FastCaptureErrorCode1__
 {
@@ -33,6 +39,365 @@ typedef struct FastCaptureErrorCode1__
 
 #define FAST_CAPTURE_S_OK 0
 
+/**
+ * @brief 一帧截图中的各个平面，颜色平面总是存在，其余平面需要通过捕获标志启用
+ *
+ */
+#define FAST_CAPTURE_PLANE_COLOR 0
+#define FAST_CAPTURE_PLANE_DEPTH 1
+#define FAST_CAPTURE_PLANE_STENCIL 2
+/// 颜色的1/2、1/4、1/8分辨率缩小图，由注入DLL在读回前用glGenerateMipmap生成
+#define FAST_CAPTURE_PLANE_COLOR_MIP_1 3
+#define FAST_CAPTURE_PLANE_COLOR_MIP_2 4
+#define FAST_CAPTURE_PLANE_COLOR_MIP_3 5
+#define FAST_CAPTURE_PLANE_COUNT 6
+#define FAST_CAPTURE_MAX_COLOR_MIP_LEVEL 3
+
+typedef struct FastCaptureFrameInfo1__
+{
+    /// 每发布一个内容不同的帧加1，为0表示还没有任何帧
+    uint64_t frame_index;
+    /// 最新一帧之后，内容与其完全相同而没有被重新写入的帧数
+    uint64_t repeat_count;
+    /// 被Hook的函数复制此帧的时刻，单位为微秒，同一台机器上的各个进程之间可以比较
+    uint64_t timestamp_us;
+} FastCaptureFrameInfo;
+
+/// 传给WaitForNewFrame和NotifyNewFrame，一直等待
+#define FAST_CAPTURE_TIMEOUT_INFINITE 0xFFFFFFFFu
+
+/**
+ * @brief NotifyNewFrame的回调，在系统线程池的线程中调用，result为成功时有新的帧
+ *
+ */
+typedef void(FAST_CAPTURE_CALL* FastCaptureNewFrameCallback)(void* context, FastCaptureErrorCode result);
+
+/**
+ * @brief 平面中像素的格式，写入FastCapturePlaneInfo::format
+ *
+ */
+#define FAST_CAPTURE_PLANE_FORMAT_UNKNOWN 0u
+/// 每个像素4字节，R在最低字节
+#define FAST_CAPTURE_PLANE_FORMAT_RGBA8 1u
+/// GL_UNSIGNED_INT_24_8，高24位为深度，低8位为模板
+#define FAST_CAPTURE_PLANE_FORMAT_DEPTH_24_STENCIL_8 2u
+/// [0, 1]范围的float深度
+#define FAST_CAPTURE_PLANE_FORMAT_DEPTH_FLOAT 3u
+/// 按SetDepthRange转换后的线性视空间距离（float）
+#define FAST_CAPTURE_PLANE_FORMAT_LINEAR_DEPTH_FLOAT 4u
+/// 每个像素1字节
+#define FAST_CAPTURE_PLANE_FORMAT_STENCIL_8 5u
+
+typedef struct FastCapturePlaneInfo1__
+{
+    int32_t width;
+    int32_t height;
+    uint32_t pixel_size;
+    uint64_t size;
+    /// FAST_CAPTURE_PLANE_FORMAT_*。深度平面的格式由所有客户端设置的捕获标志共同决定，可能与自己设置的不同
+    uint32_t format;
+} FastCapturePlaneInfo;
+
+/**
+ * @brief FastCaptureProcessQuery的匹配方式
+ *
+ */
+/// pattern与进程的可执行文件名完全相同
+#define FAST_CAPTURE_PROCESS_MATCH_NAME 0u
+/// process_id与进程ID相同，忽略pattern
+#define FAST_CAPTURE_PROCESS_MATCH_PROCESS_ID 1u
+/// pattern是ECMAScript正则表达式，在进程的命令行中搜索
+#define FAST_CAPTURE_PROCESS_MATCH_COMMAND_LINE 2u
+
+/**
+ * @brief 客户端复制帧数据的方式，可以按位或组合。默认按大小选择：不小于末级缓存的平面绕过缓存复制
+ *
+ */
+#define FAST_CAPTURE_COPY_FLAG_NONE 0x0u
+/// 总是经过缓存复制，适用于复制后立即处理整帧的情况
+#define FAST_CAPTURE_COPY_FLAG_CACHED 0x1u
+/// 大的平面分块后在多个线程中复制。在CopyLatestCaptures中不分块，每个请求仍在一个线程中复制
+#define FAST_CAPTURE_COPY_FLAG_PARALLEL 0x2u
+
+/**
+ * @brief FastCaptureColorOutputDesc的像素格式
+ *
+ */
+#define FAST_CAPTURE_PIXEL_FORMAT_RGBA 0u
+#define FAST_CAPTURE_PIXEL_FORMAT_BGRA 1u
+/// 每个像素3字节，没有alpha
+#define FAST_CAPTURE_PIXEL_FORMAT_RGB 2u
+
+/**
+ * @brief FastCaptureColorOutputDesc的行序
+ *
+ */
+/// 第一行在画面底部，与OpenGL和共享内存中的颜色平面相同
+#define FAST_CAPTURE_ORIENTATION_BOTTOM_UP 0u
+/// 第一行在画面顶部
+#define FAST_CAPTURE_ORIENTATION_TOP_DOWN 1u
+
+typedef struct FastCaptureColorOutputDesc1__
+{
+    uint32_t pixel_format;
+    uint32_t orientation;
+    /// 以画面左上角为原点的区域，width或height为0时输出整帧
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} FastCaptureColorOutputDesc;
+
+typedef struct FastCaptureProcessQuery1__
+{
+    uint32_t match_type;
+    uint32_t process_id;
+    const wchar_t* pattern;
+} FastCaptureProcessQuery;
+
+typedef struct FastCaptureHubDesc1__
+{
+    /// 处理帧的工作线程数，为0时使用硬件线程数
+    uint32_t worker_count;
+    /// 目标没有新帧时再次检查的间隔
+    uint32_t poll_interval_ms;
+} FastCaptureHubDesc;
+
+/// 不使用异步无缓冲写入，而是逐帧同步写入
+#define FAST_CAPTURE_RECORDER_FLAG_SYNCHRONOUS 0x1u
+
+typedef struct FastCaptureRecorderDesc1__
+{
+    const wchar_t* file_path;
+    /// 需要录制的FAST_CAPTURE_PLANE_*
+    uint32_t plane;
+    /// 检查新帧的间隔
+    uint32_t poll_interval_ms;
+    /// 同时进行中的写入数量的上限，达到上限后到达的帧被丢弃
+    uint32_t max_in_flight_write_count;
+    /// FAST_CAPTURE_RECORDER_FLAG_*
+    uint32_t flags;
+    /// 大于此值的帧被丢弃
+    uint64_t max_frame_size;
+} FastCaptureRecorderDesc;
+
+typedef struct FastCaptureRecorderStatistics1__
+{
+    uint64_t written_frame_count;
+    /// 因写入跟不上而丢弃的帧数，持续增长时应降低捕获帧率
+    uint64_t dropped_frame_count;
+    uint64_t written_bytes;
+    uint32_t in_flight_write_count;
+    /// 打开文件时不支持无缓冲异步写入，或指定了FAST_CAPTURE_RECORDER_FLAG_SYNCHRONOUS
+    uint32_t is_synchronous;
+    /// 最近一次写入失败的原因
+    FastCaptureErrorCode last_error;
+} FastCaptureRecorderStatistics;
+
+#define FAST_CAPTURE_RECORD_MAGIC 0x52434346u
+#define FAST_CAPTURE_RECORD_ALIGNMENT 4096u
+
+/**
+ * @brief 录制文件由连续的记录组成，每个记录是此头部加帧数据，
+    并补齐到FAST_CAPTURE_RECORD_ALIGNMENT的整数倍
+ *
+ */
+typedef struct FastCaptureRecordHeader1__
+{
+    uint32_t magic;
+    uint32_t plane;
+    uint64_t frame_index;
+    uint64_t timestamp_us;
+    int32_t width;
+    int32_t height;
+    uint32_t pixel_size;
+    uint32_t reserved;
+    uint64_t frame_size;
+    /// 包括头部和补齐的字节数，下一个记录从当前记录的开头偏移record_size处开始
+    uint64_t record_size;
+} FastCaptureRecordHeader;
+
+typedef struct FastCaptureHistoryDesc1__
+{
+    /// 最多保留的帧数，也是预分配的槽位数
+    uint32_t max_frame_count;
+    /// 最新一帧与最旧一帧的时间差超过此值时淘汰旧帧，为0表示只按帧数淘汰
+    uint32_t max_duration_ms;
+    /// 需要保留的FAST_CAPTURE_PLANE_*
+    uint32_t plane;
+    /// 后台线程检查新帧的间隔
+    uint32_t poll_interval_ms;
+    /// 每个槽位的字节数，大于它的帧会被跳过
+    uint64_t max_frame_size;
+} FastCaptureHistoryDesc;
+
+/**
+ * @brief 注入DLL记录的事件，写入FastCaptureEvent::code
+ *
+ */
+/// 被Hook的函数提交的帧在读回前被更新的帧覆盖，context[0]为本次丢弃的帧数
+#define FAST_CAPTURE_EVENT_FRAME_DROPPED 1u
+/// PBO环形队列的所有槽位都在等待GPU，此帧被丢弃，context[0]、context[1]为帧的宽和高
+#define FAST_CAPTURE_EVENT_PBO_RING_FULL 2u
+/// 图像共享内存被扩大，context[0]为新的代数，context[1]为新的容量
+#define FAST_CAPTURE_EVENT_CAPTURE_IMAGE_REMAPPED 3u
+/// 心跳超时的客户端的槽位被回收，context[0]为该客户端的进程ID
+#define FAST_CAPTURE_EVENT_SUBSCRIBER_REAPED 4u
+/// 被Hook的上下文变化，读回线程在下一次读回时重新创建共享的上下文
+#define FAST_CAPTURE_EVENT_SHARED_CONTEXT_CHANGED 5u
+/// 读回线程因error中的错误退出，此后不会再有新的帧
+#define FAST_CAPTURE_EVENT_READ_PIXELS_THREAD_FAILED 6u
+/// 出现了第一个客户端，注入DLL从休眠中恢复，开始捕获
+#define FAST_CAPTURE_EVENT_CAPTURE_ACTIVATED 7u
+/// 没有客户端的时间超过了空闲超时，注入DLL释放了OpenGL资源并进入休眠，context[0]为空闲的毫秒数
+#define FAST_CAPTURE_EVENT_CAPTURE_DEACTIVATED 8u
+
+/// 客户端设置的读回线程调度已经应用，context[0]为实际的亲和性掩码，context[1]低32位为优先级、高32位为标志。
+/// error不为成功时部分设置没有生效。此事件之后的阶段延迟对应新的调度
+#define FAST_CAPTURE_EVENT_THREAD_SCHEDULING_APPLIED 9u
+
+typedef struct FastCaptureEvent1__
+{
+    /// 事件在日志中的序号，从0开始连续递增，不连续说明中间的事件已被覆盖
+    uint64_t sequence;
+    /// 与FastCaptureFrameInfo::timestamp_us使用相同的时钟
+    uint64_t timestamp_us;
+    /// FAST_CAPTURE_EVENT_*
+    uint32_t code;
+    FastCaptureErrorCode error;
+    /// 含义由code决定
+    uint64_t context[2];
+} FastCaptureEvent;
+
+/**
+ * @brief 延迟直方图的桶数。第i个桶（i小于FAST_CAPTURE_LATENCY_BUCKET_COUNT-1）统计超过上一个桶的上界、
+    且不超过(1000<<i)微秒的样本，最后一个桶统计其余样本
+ *
+ */
+#define FAST_CAPTURE_LATENCY_BUCKET_COUNT 8u
+
+/**
+ * @brief 开销直方图的桶数。第i个桶（i小于FAST_CAPTURE_COST_BUCKET_COUNT-1）统计超过上一个桶的上界、
+    且不超过(10<<i)微秒的样本，最后一个桶统计其余样本
+ *
+ */
+#define FAST_CAPTURE_COST_BUCKET_COUNT 8u
+
+/**
+ * @brief 传给SetFrameCpuBudget，不限制读回线程每帧的CPU时间，也不避让目标程序的下一帧
+ *
+ */
+#define FAST_CAPTURE_FRAME_CPU_BUDGET_UNLIMITED 0xFFFFFFFFu
+
+/**
+ * @brief FastCaptureThreadSchedulingDesc的标志，可以按位或组合
+ *
+ */
+/// 读回线程不在最近一次提交帧的线程（通常是目标程序的渲染线程）所在的逻辑处理器上运行，
+/// 渲染线程迁移后重新设置。亲和性掩码中只有这一个处理器时不生效
+#define FAST_CAPTURE_SCHEDULING_FLAG_AVOID_RENDER_PROCESSOR 0x1u
+/// 关闭系统对读回线程的动态优先级提升，唤醒延迟只由priority决定
+#define FAST_CAPTURE_SCHEDULING_FLAG_DISABLE_PRIORITY_BOOST 0x2u
+#define FAST_CAPTURE_SCHEDULING_FLAG_MASK 0x3u
+
+typedef struct FastCaptureThreadSchedulingDesc1__
+{
+    /// 读回线程可以运行的逻辑处理器，位i对应目标进程所在处理器组中的第i个处理器，为0时使用进程的亲和性掩码
+    uint64_t affinity_mask;
+    /// Windows线程优先级THREAD_PRIORITY_*，只能是-15（IDLE）、-2到2、15（TIME_CRITICAL）
+    int32_t priority;
+    /// FAST_CAPTURE_SCHEDULING_FLAG_*
+    uint32_t flags;
+} FastCaptureThreadSchedulingDesc;
+
+/**
+ * @brief 注入DLL的累计计数，从注入开始累加，不会被清零
+ *
+ */
+typedef struct FastCaptureCounters1__
+{
+    /// 写入共享内存的帧数
+    uint64_t published_frame_count;
+    /// 与上一帧内容相同而没有写入的帧数
+    uint64_t repeated_frame_count;
+    /// 读回前被更新的帧覆盖的帧数
+    uint64_t dropped_frame_count;
+    /// 因PBO环形队列已满而丢弃的帧数
+    uint64_t pbo_ring_full_count;
+    uint64_t capture_image_remap_count;
+    uint64_t reaped_subscriber_count;
+    /// 写入事件日志的事件总数
+    uint64_t event_count;
+    /// 读回线程中已经提交、还在等待GPU的帧数，不是累计值
+    uint64_t pbo_ring_occupancy;
+    /// 因超出每帧的CPU预算或不在空闲窗口中而推迟发布的帧数，同一帧被推迟多次只计一次
+    uint64_t deferred_frame_count;
+    /// 推迟发布的帧被更新的帧挤出PBO环形队列而丢弃的帧数
+    uint64_t budget_dropped_frame_count;
+    /// 目标程序交换间隔的移动平均，不是累计值
+    uint64_t swap_interval_us;
+    /// 读回线程取走之前被新的读回命令合并的读回命令数，每一次合并都少唤醒一次读回线程
+    uint64_t coalesced_read_pixels_count;
+    /// 从被Hook的函数复制帧到写入共享内存的延迟
+    uint64_t publish_latency_us_sum;
+    uint64_t publish_latency_buckets[FAST_CAPTURE_LATENCY_BUCKET_COUNT];
+    /// 被Hook的函数中捕获工作占用目标程序线程的CPU时间
+    uint64_t hook_cpu_cost_ns_sum;
+    uint64_t hook_cpu_cost_buckets[FAST_CAPTURE_COST_BUCKET_COUNT];
+    /// 被Hook的函数提交的复制命令的GPU时间，由GL_TIME_ELAPSED计时查询测得，上下文不支持计时查询时没有样本
+    uint64_t hook_gpu_cost_ns_sum;
+    uint64_t hook_gpu_cost_buckets[FAST_CAPTURE_COST_BUCKET_COUNT];
+    /// 读回线程提交的生成mipmap和读回命令的GPU时间
+    uint64_t pack_gpu_cost_ns_sum;
+    uint64_t pack_gpu_cost_buckets[FAST_CAPTURE_COST_BUCKET_COUNT];
+    /// 读回线程当前使用的调度设置的代数，每次应用SetCaptureThreadScheduling的设置时加1，不是累计值
+    uint64_t scheduling_generation;
+    /// 阶段延迟：从被Hook的函数提交帧到读回线程取走它，反映读回线程被唤醒和调度的延迟
+    uint64_t pickup_latency_ns_sum;
+    uint64_t pickup_latency_buckets[FAST_CAPTURE_COST_BUCKET_COUNT];
+    /// 阶段延迟：从提交读回命令到读回的帧被取出，包括GPU执行和因预算推迟的时间
+    uint64_t readback_latency_us_sum;
+    uint64_t readback_latency_buckets[FAST_CAPTURE_LATENCY_BUCKET_COUNT];
+    /// 阶段延迟：读回线程把一帧写入共享内存所用的时间，包括被其它线程抢占的时间
+    uint64_t publish_duration_ns_sum;
+    uint64_t publish_duration_buckets[FAST_CAPTURE_COST_BUCKET_COUNT];
+    /// 以下是此客户端自己的统计
+    uint64_t copied_frame_count;
+    uint64_t copied_bytes;
+    /// 从被Hook的函数复制帧到此客户端复制完成的延迟
+    uint64_t delivery_latency_us_sum;
+    uint64_t delivery_latency_buckets[FAST_CAPTURE_LATENCY_BUCKET_COUNT];
+} FastCaptureCounters;
+
+typedef struct FastCaptureMetricsExporterDesc1__
+{
+    /// 在127.0.0.1的此端口上以HTTP提供OpenMetrics文本，为0时不监听
+    uint16_t port;
+    /// 供node_exporter的textfile收集器读取的文件，为nullptr时不写入。先写入临时文件再替换，读者不会读到一半的内容
+    const wchar_t* text_file_path;
+    /// 写入文本文件的间隔
+    uint32_t text_file_interval_ms;
+} FastCaptureMetricsExporterDesc;
+
+/**
+ * @brief 捕获标志，可以按位或组合。默认只捕获颜色
+ *
+ */
+#define FAST_CAPTURE_FLAG_NONE 0x0u
+/// 以GL_UNSIGNED_INT_24_8读回深度，每个像素4字节，高24位为深度
+#define FAST_CAPTURE_FLAG_DEPTH_24 0x1u
+/// 以GL_FLOAT读回深度，每个像素4字节
+#define FAST_CAPTURE_FLAG_DEPTH_FLOAT 0x2u
+/// 读回模板，每个像素1字节
+#define FAST_CAPTURE_FLAG_STENCIL 0x4u
+/// 把深度转换为线性的视空间距离（float），需要同时设置FAST_CAPTURE_FLAG_DEPTH_24或FAST_CAPTURE_FLAG_DEPTH_FLOAT
+#define FAST_CAPTURE_FLAG_LINEAR_DEPTH 0x8u
+/// 捕获对应的FAST_CAPTURE_PLANE_COLOR_MIP_*，所有启用的层级通过同一次PBO读回
+#define FAST_CAPTURE_FLAG_COLOR_MIP_1 0x10u
+#define FAST_CAPTURE_FLAG_COLOR_MIP_2 0x20u
+#define FAST_CAPTURE_FLAG_COLOR_MIP_3 0x40u
+#define FAST_CAPTURE_FLAG_COLOR_MIP_MASK 0x70u
+
 inline FastCaptureErrorCode FastCaptureMakeSuccessValue()
 {
     return FastCaptureErrorCode{
@@ -76,7 +441,68 @@ inline FastCaptureErrorCode FastCaptureMakeSuccessValue()
 #define FAST_CAPTURE_E_GL_BASIC_WINDOW_CREATE_THREAD_INIT_EVENT_FAILED 34
 #define FAST_CAPTURE_E_GL_BASIC_WINDOW_CREATE_INIT_THREAD_FAILED 35
 #define FAST_CAPTURE_E_READ_PIXELS_THREAD_INVOKE_FAILED 36
+#define FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_DESCRIPTOR_FAILED 37
+#define FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_DESCRIPTOR_MAP_OF_VIEW_FAILED 38
+#define FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_IMAGE_FAILED 39
+#define FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_IMAGE_MAP_OF_VIEW_FAILED 40
+#define FAST_CAPTURE_E_NO_FREE_SUBSCRIBER_SLOT 41
+#define FAST_CAPTURE_E_PRODUCER_NOT_RESPONDING 42
+/// 顺序锁超时时生产者仍有心跳，说明写者一直在写入；生产者失去心跳时返回FAST_CAPTURE_E_PRODUCER_NOT_RESPONDING
+#define FAST_CAPTURE_E_READ_CAPTURE_DESCRIPTOR_TIMEOUT 43
+#define FAST_CAPTURE_E_READ_CAPTURE_IMAGE_TIMEOUT 44
+#define FAST_CAPTURE_E_CAPTURE_IMAGE_NOT_READY 45
+#define FAST_CAPTURE_E_BUFFER_TOO_SMALL 46
+#define FAST_CAPTURE_E_CAPTURE_PLANE_NOT_ENABLED 47
+#define FAST_CAPTURE_E_READ_PIXELS_THREAD_MAP_PBO_FAILED 48
+#define FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND 49
+#define FAST_CAPTURE_E_ALLOCATE_HISTORY_POOL_FAILED 50
+#define FAST_CAPTURE_E_CREATE_HISTORY_THREAD_FAILED 51
+#define FAST_CAPTURE_E_CREATE_PROCESS_SNAPSHOT_FAILED 52
+#define FAST_CAPTURE_E_PROCESS_NOT_FOUND 53
+#define FAST_CAPTURE_E_PROCESS_NAME_AMBIGUOUS 54
+#define FAST_CAPTURE_E_INVALID_PROCESS_PATTERN 55
+#define FAST_CAPTURE_E_OPEN_TARGET_PROCESS_FAILED 56
+#define FAST_CAPTURE_E_HUB_TARGET_NOT_FOUND 57
+#define FAST_CAPTURE_E_CREATE_HUB_THREAD_FAILED 58
+#define FAST_CAPTURE_E_ALLOCATE_FRAME_BUFFER_FAILED 59
+#define FAST_CAPTURE_E_BATCH_COPY_PARTIALLY_FAILED 60
+#define FAST_CAPTURE_E_CREATE_RECORDING_FILE_FAILED 61
+#define FAST_CAPTURE_E_ALLOCATE_RECORDING_BUFFER_FAILED 62
+#define FAST_CAPTURE_E_CREATE_RECORDER_EVENT_FAILED 63
+#define FAST_CAPTURE_E_CREATE_RECORDER_THREAD_FAILED 64
+#define FAST_CAPTURE_E_WRITE_RECORDING_FILE_FAILED 65
+#define FAST_CAPTURE_E_CONNECT_BROKER_FAILED 66
+#define FAST_CAPTURE_E_BROKER_REQUEST_FAILED 67
+#define FAST_CAPTURE_E_CREATE_BROKER_PIPE_FAILED 68
+#define FAST_CAPTURE_E_CREATE_BROKER_THREAD_FAILED 69
+#define FAST_CAPTURE_E_DUPLICATE_HANDLE_FAILED 70
+#define FAST_CAPTURE_E_BROKER_TARGET_NOT_ATTACHED 71
+#define FAST_CAPTURE_E_WAIT_NEW_FRAME_TIMEOUT 72
+#define FAST_CAPTURE_E_CREATE_METRICS_SOCKET_FAILED 73
+#define FAST_CAPTURE_E_CREATE_METRICS_EXPORTER_THREAD_FAILED 74
+#define FAST_CAPTURE_E_METRICS_TARGET_NOT_FOUND 75
+#define FAST_CAPTURE_E_VULKAN_SWAPCHAIN_NOT_CAPTURABLE 76
+#define FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED 77
+#define FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_THREAD_FAILED 78
+#define FAST_CAPTURE_E_LOAD_GL_FUNCTIONS_FAILED 79
+#define FAST_CAPTURE_E_GLES_VERSION_NOT_SUPPORTED 80
+#define FAST_CAPTURE_E_LOAD_EGL_FAILED 81
+#define FAST_CAPTURE_E_CREATE_EGL_CONTEXT_FAILED 82
+#define FAST_CAPTURE_E_EGL_MAKE_CURRENT_FAILED 83
+#define FAST_CAPTURE_E_COLOR_OUTPUT_REGION_OUT_OF_FRAME 84
+#define FAST_CAPTURE_E_CREATE_ATTACH_EVENT_FAILED 85
+#define FAST_CAPTURE_E_SET_READ_PIXELS_THREAD_SCHEDULING_FAILED 86
 #define FAST_CAPTURE_E_INVALID_ARGUMENT 87
+#define FAST_CAPTURE_E_READ_PIXELS_THREAD_COMMAND_QUEUE_FULL 88
+#define FAST_CAPTURE_E_CREATE_FRAME_EVENT_FAILED 89
+#define FAST_CAPTURE_E_FRAME_EVENT_NOT_AVAILABLE 90
+#define FAST_CAPTURE_E_FRAME_NOTIFICATION_PENDING 91
+#define FAST_CAPTURE_E_FRAME_NOTIFICATION_CANCELLED 92
+#define FAST_CAPTURE_E_CREATE_FRAME_NOTIFICATION_FAILED 93
+/// 其它客户端需要的深度格式与此客户端设置的捕获标志冲突，当前发布的深度平面不是此客户端需要的格式
+#define FAST_CAPTURE_E_DEPTH_FORMAT_CONFLICT 94
+/// 连接到代理的客户端自己不能读取目标进程的内存，目标也没有被代理的宿主允许
+#define FAST_CAPTURE_E_BROKER_TARGET_ACCESS_DENIED 95
 // 259(STILL_ACTIVE)是保留的
 
 #endif
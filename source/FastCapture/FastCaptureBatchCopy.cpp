@@ -0,0 +1,39 @@
+#include "FastCapture.h"
+#include <functional>
+#include "WorkerPool.h"
+#include "../Utils/Utils.hpp"
+
+FastCaptureErrorCode CopyLatestCaptures(FastCaptureCopyRequest* requests, size_t request_count) FAST_CAPTURE_NOEXCEPT
+{
+    if (requests == nullptr && request_count != 0)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    const std::function<void(std::size_t)> copy_task =
+        [requests](std::size_t i)
+    {
+        auto& request = requests[i];
+        request.copied_size = 0;
+        if (request.client == nullptr || request.p_memory == nullptr)
+        {
+            request.result = FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+            return;
+        }
+        request.result = request.client->CopyLatestCapturePlaneEx(
+            request.plane,
+            request.p_memory,
+            request.memory_size,
+            &request.copied_size,
+            &request.info);
+    };
+    FAST_CAPTURE::WorkerPool::GetInstance().Run(request_count, copy_task);
+
+    for (size_t i = 0; i < request_count; ++i)
+    {
+        if (!FAST_CAPTURE::Utils::IsOk(requests[i].result))
+        {
+            return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_BATCH_COPY_PARTIALLY_FAILED);
+        }
+    }
+    return FastCaptureMakeSuccessValue();
+}
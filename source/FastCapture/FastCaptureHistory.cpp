@@ -0,0 +1,319 @@
+#include "FastCaptureHistory.h"
+#include <cstring>
+#include <new>
+#include <limits>
+#include <chrono>
+#include <system_error>
+#include <utility>
+#include "../Utils/Utils.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    FastCaptureHistory::~FastCaptureHistory()
+    {
+        {
+            std::lock_guard lock{drain_thread_lock_};
+            is_stop_requested_ = true;
+        }
+        drain_thread_condition_.notify_all();
+        if (drain_thread_.joinable())
+        {
+            drain_thread_.join();
+        }
+    }
+
+    FastCaptureErrorCode FastCaptureHistory::Initialize(IFastCaptureClient* p_client, const FastCaptureHistoryDesc& desc) noexcept
+    {
+        p_client_ = p_client;
+        desc_ = desc;
+        // 比max_frame_count多一块，用作p_spare_data_
+        const auto buffer_count = std::size_t{desc_.max_frame_count} + 1;
+        if (desc_.max_frame_size > std::numeric_limits<std::size_t>::max() / buffer_count)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_ALLOCATE_HISTORY_POOL_FAILED);
+        }
+        const auto frame_size = static_cast<std::size_t>(desc_.max_frame_size);
+        p_pool_.reset(new (std::nothrow) std::byte[frame_size * buffer_count]);
+        if (p_pool_ == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_ALLOCATE_HISTORY_POOL_FAILED);
+        }
+        try
+        {
+            slots_.resize(desc_.max_frame_count);
+            for (std::size_t i = 0; i < slots_.size(); ++i)
+            {
+                slots_[i].p_data = p_pool_.get() + i * frame_size;
+            }
+            p_spare_data_ = p_pool_.get() + slots_.size() * frame_size;
+            drain_thread_ = std::thread{&FastCaptureHistory::Drain, this};
+        }
+        catch (const std::bad_alloc&)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_ALLOCATE_HISTORY_POOL_FAILED);
+        }
+        catch (const std::system_error&)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_CREATE_HISTORY_THREAD_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    auto FastCaptureHistory::FindFrame(const std::uint64_t frame_index) noexcept
+        -> FrameSlot*
+    {
+        std::size_t low = 0;
+        std::size_t high = frame_count_;
+        while (low < high)
+        {
+            const auto middle = low + (high - low) / 2;
+            if (GetFrame(middle).frame_index < frame_index)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        if (low == frame_count_ || GetFrame(low).frame_index != frame_index)
+        {
+            return nullptr;
+        }
+        return &GetFrame(low);
+    }
+
+    std::size_t FastCaptureHistory::UpperBoundByTime(const std::uint64_t timestamp_us) noexcept
+    {
+        std::size_t low = 0;
+        std::size_t high = frame_count_;
+        while (low < high)
+        {
+            const auto middle = low + (high - low) / 2;
+            if (GetFrame(middle).timestamp_us <= timestamp_us)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    void FastCaptureHistory::DrainLatestFrame() noexcept
+    {
+        FastCaptureFrameInfo latest_info;
+        if (!Utils::IsOk(p_client_->RequestLatestCaptureFrameInfo(&latest_info)) || latest_info.frame_index == 0)
+        {
+            return;
+        }
+        {
+            std::lock_guard lock{frames_lock_};
+            if (frame_count_ != 0 && GetFrame(frame_count_ - 1).frame_index >= latest_info.frame_index)
+                [[likely]]
+            {
+                return;
+            }
+        }
+        // 只有后台线程使用p_spare_data_
+        size_t frame_size;
+        FastCaptureFrameInfo frame_info;
+        if (!Utils::IsOk(p_client_->CopyLatestCapturePlaneEx(
+                desc_.plane,
+                reinterpret_cast<char*>(p_spare_data_),
+                static_cast<size_t>(desc_.max_frame_size),
+                &frame_size,
+                &frame_info)))
+        {
+            return;
+        }
+
+        std::lock_guard lock{frames_lock_};
+        if (frame_count_ != 0 && GetFrame(frame_count_ - 1).frame_index >= frame_info.frame_index)
+        {
+            return;
+        }
+        if (frame_count_ == slots_.size())
+        {
+            PopFrontFrame();
+        }
+        auto& slot = GetFrame(frame_count_);
+        std::swap(slot.p_data, p_spare_data_);
+        slot.size = frame_size;
+        slot.frame_index = frame_info.frame_index;
+        slot.timestamp_us = frame_info.timestamp_us;
+        ++frame_count_;
+        if (desc_.max_duration_ms == 0)
+        {
+            return;
+        }
+        const auto max_duration_us = static_cast<std::uint64_t>(desc_.max_duration_ms) * 1000;
+        // 时间戳可能不单调，例如注入DLL重新启动后，此时不按时长淘汰，避免无符号减法回绕
+        while (frame_count_ > 1
+               && frame_info.timestamp_us >= GetFrame(0).timestamp_us
+               && frame_info.timestamp_us - GetFrame(0).timestamp_us > max_duration_us)
+        {
+            PopFrontFrame();
+        }
+    }
+
+    void FastCaptureHistory::Drain() noexcept
+    {
+        const auto poll_interval = std::chrono::milliseconds{desc_.poll_interval_ms};
+        std::unique_lock lock{drain_thread_lock_};
+        while (!drain_thread_condition_.wait_for(
+            lock,
+            poll_interval,
+            [this]()
+            { return is_stop_requested_; }))
+        {
+            lock.unlock();
+            DrainLatestFrame();
+            lock.lock();
+        }
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHistory::RequestFrameRange(uint64_t* first_frame_index, uint64_t* last_frame_index) FAST_CAPTURE_NOEXCEPT
+    {
+        if (first_frame_index == nullptr || last_frame_index == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{frames_lock_};
+        if (frame_count_ == 0)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        }
+        *first_frame_index = GetFrame(0).frame_index;
+        *last_frame_index = GetFrame(frame_count_ - 1).frame_index;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHistory::RequestFrameSize(uint64_t frame_index, size_t* size) FAST_CAPTURE_NOEXCEPT
+    {
+        if (size == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{frames_lock_};
+        const auto p_frame = FindFrame(frame_index);
+        if (p_frame == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        }
+        *size = p_frame->size;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHistory::CopyFrame(uint64_t frame_index, char* p_memory, size_t memory_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT
+    {
+        if (p_memory == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{frames_lock_};
+        const auto p_frame = FindFrame(frame_index);
+        if (p_frame == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        }
+        if (memory_size < p_frame->size)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+        }
+        std::memcpy(p_memory, p_frame->p_data, p_frame->size);
+        if (info != nullptr)
+        {
+            *info = FastCaptureFrameInfo{p_frame->frame_index, 0, p_frame->timestamp_us};
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHistory::FindFrameByTime(uint64_t timestamp_us, uint64_t* frame_index) FAST_CAPTURE_NOEXCEPT
+    {
+        if (frame_index == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{frames_lock_};
+        const auto upper_bound = UpperBoundByTime(timestamp_us);
+        if (upper_bound == 0)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        }
+        *frame_index = GetFrame(upper_bound - 1).frame_index;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHistory::RequestFramesInTimeRange(
+        uint64_t begin_us,
+        uint64_t end_us,
+        uint64_t* frame_indexes,
+        size_t capacity,
+        size_t* count) FAST_CAPTURE_NOEXCEPT
+    {
+        if (count == nullptr || begin_us > end_us)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{frames_lock_};
+        const auto first = begin_us == 0 ? 0 : UpperBoundByTime(begin_us - 1);
+        const auto last = UpperBoundByTime(end_us);
+        *count = last - first;
+        if (frame_indexes == nullptr)
+        {
+            return FastCaptureMakeSuccessValue();
+        }
+        if (capacity < *count)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+        }
+        for (std::size_t i = first; i < last; ++i)
+        {
+            frame_indexes[i - first] = GetFrame(i).frame_index;
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+}
+
+FastCaptureErrorCode CreateFastCaptureHistory(
+    IFastCaptureClient* client,
+    const FastCaptureHistoryDesc* desc,
+    IFastCaptureHistory** history) FAST_CAPTURE_NOEXCEPT
+{
+    if (client == nullptr || desc == nullptr || history == nullptr ||
+        desc->max_frame_count == 0 || desc->max_frame_size == 0 ||
+        desc->poll_interval_ms == 0 || desc->plane >= FAST_CAPTURE_PLANE_COUNT)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    auto p_history = new (std::nothrow) FAST_CAPTURE::FastCaptureHistory{};
+    if (p_history == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_ALLOCATE_HISTORY_POOL_FAILED);
+    }
+    if (auto result = p_history->Initialize(client, *desc); !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        delete p_history;
+        return result;
+    }
+    *history = p_history;
+    return FastCaptureMakeSuccessValue();
+}
+
+FastCaptureErrorCode DestroyFastCaptureHistory(IFastCaptureHistory* history) FAST_CAPTURE_NOEXCEPT
+{
+    if (history == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    delete static_cast<FAST_CAPTURE::FastCaptureHistory*>(history);
+    return FastCaptureMakeSuccessValue();
+}
@@ -0,0 +1,104 @@
+#ifndef FAST_CAPTURE_FAST_CAPTURE_HISTORY_H
+#define FAST_CAPTURE_FAST_CAPTURE_HISTORY_H
+
+#include "FastCapture.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+FAST_CAPTURE_NAMESPACE
+{
+    class FastCaptureHistory final : public IFastCaptureHistory
+    {
+        /**
+         * @brief 预分配的池中的一个槽位，p_data指向的内存大小为max_frame_size
+         *
+         */
+        struct FrameSlot
+        {
+            std::byte* p_data{nullptr};
+            std::size_t size{0};
+            std::uint64_t frame_index{0};
+            std::uint64_t timestamp_us{0};
+        };
+
+        IFastCaptureClient* p_client_{nullptr};
+        FastCaptureHistoryDesc desc_{};
+        std::unique_ptr<std::byte[]> p_pool_{};
+        /**
+         * @brief 环形缓冲区，从first_slot_开始的frame_count_个槽位按frame_index递增排列
+         *
+         */
+        std::vector<FrameSlot> slots_{};
+        /**
+         * @brief 不在环形缓冲区内的一块内存，新帧先复制到这里，成功后才在frames_lock_下与被淘汰的槽位交换
+         *
+         */
+        std::byte* p_spare_data_{nullptr};
+        std::size_t first_slot_{0};
+        std::size_t frame_count_{0};
+        std::mutex frames_lock_{};
+
+        std::mutex drain_thread_lock_{};
+        std::condition_variable drain_thread_condition_{};
+        bool is_stop_requested_{false};
+        std::thread drain_thread_{};
+
+        FrameSlot& GetFrame(const std::size_t n) noexcept
+        {
+            return slots_[(first_slot_ + n) % slots_.size()];
+        }
+        void PopFrontFrame() noexcept
+        {
+            first_slot_ = (first_slot_ + 1) % slots_.size();
+            --frame_count_;
+        }
+        /**
+         * @brief 需要持有frames_lock_，找不到时返回nullptr
+         *
+         */
+        FrameSlot* FindFrame(const std::uint64_t frame_index) noexcept;
+        /**
+         * @brief 返回第一个timestamp_us大于指定时刻的帧的序号，需要持有frames_lock_
+         *
+         */
+        std::size_t UpperBoundByTime(const std::uint64_t timestamp_us) noexcept;
+        /**
+         * @brief 若客户端有新帧，则复制到p_spare_data_中。复制期间不需要持有frames_lock_，
+            复制失败时环形缓冲区中的帧不受影响
+         *
+         */
+        void DrainLatestFrame() noexcept;
+        void Drain() noexcept;
+
+    public:
+        FastCaptureHistory() = default;
+        ~FastCaptureHistory();
+        FastCaptureHistory(const FastCaptureHistory&) = delete;
+        FastCaptureHistory& operator=(const FastCaptureHistory&) = delete;
+
+        FastCaptureErrorCode Initialize(IFastCaptureClient* p_client, const FastCaptureHistoryDesc& desc) noexcept;
+
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestFrameRange(uint64_t* first_frame_index, uint64_t* last_frame_index) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestFrameSize(uint64_t frame_index, size_t* size) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        CopyFrame(uint64_t frame_index, char* p_memory, size_t memory_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        FindFrameByTime(uint64_t timestamp_us, uint64_t* frame_index) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestFramesInTimeRange(
+            uint64_t begin_us,
+            uint64_t end_us,
+            uint64_t* frame_indexes,
+            size_t capacity,
+            size_t* count) FAST_CAPTURE_NOEXCEPT override;
+    };
+}
+
+#endif // FAST_CAPTURE_FAST_CAPTURE_HISTORY_H
@@ -0,0 +1,303 @@
+#include "FastCaptureHub.h"
+#include <new>
+#include <limits>
+#include <algorithm>
+#include <system_error>
+#include "../Utils/Utils.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    FastCaptureHub::~FastCaptureHub()
+    {
+        {
+            std::lock_guard lock{lock_};
+            is_stop_requested_ = true;
+        }
+        scheduler_condition_.notify_all();
+        worker_condition_.notify_all();
+        if (scheduler_thread_.joinable())
+        {
+            scheduler_thread_.join();
+        }
+        for (auto& worker_thread : worker_threads_)
+        {
+            worker_thread.join();
+        }
+    }
+
+    FastCaptureErrorCode FastCaptureHub::Initialize(const FastCaptureHubDesc& desc) noexcept
+    {
+        poll_interval_ = std::chrono::milliseconds{desc.poll_interval_ms};
+        auto worker_count = desc.worker_count;
+        if (worker_count == 0)
+        {
+            worker_count = (std::max)(std::thread::hardware_concurrency(), 1u);
+        }
+        try
+        {
+            worker_threads_.reserve(worker_count);
+            for (std::uint32_t i = 0; i < worker_count; ++i)
+            {
+                worker_threads_.emplace_back(&FastCaptureHub::RunWorker, this);
+            }
+            scheduler_thread_ = std::thread{&FastCaptureHub::RunScheduler, this};
+        }
+        catch (const std::bad_alloc&)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_CREATE_HUB_THREAD_FAILED);
+        }
+        catch (const std::system_error&)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_CREATE_HUB_THREAD_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    auto FastCaptureHub::GetFrameInterval(const Target& target) const noexcept
+        -> Clock::duration
+    {
+        if (target.desc.max_fps == 0)
+        {
+            return Clock::duration::zero();
+        }
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::seconds{1}) / target.desc.max_fps;
+    }
+
+    auto FastCaptureHub::PollTargets(
+        std::unique_lock<std::mutex>& lock,
+        std::vector<std::shared_ptr<Target>>& polling_targets) noexcept
+        -> Clock::time_point
+    {
+        const auto now = Clock::now();
+        auto next_wake_time = now + poll_interval_;
+        polling_targets.clear();
+        for (auto& [target_id, p_target] : targets_)
+        {
+            auto& target = *p_target;
+            // 处理完成时工作线程会唤醒调度线程
+            if (target.is_in_flight)
+            {
+                continue;
+            }
+            if (now < target.next_poll_time)
+            {
+                next_wake_time = (std::min)(next_wake_time, target.next_poll_time);
+                continue;
+            }
+            // 检查期间RemoveTarget会等待，因此客户端在检查完成前不会被销毁
+            target.is_in_flight = true;
+            polling_targets.push_back(p_target);
+        }
+        if (polling_targets.empty())
+        {
+            return next_wake_time;
+        }
+
+        // 客户端可能正在被工作线程或用户的线程复制，查询会等待复制完成，不能阻塞其它目标
+        lock.unlock();
+        for (const auto& p_target : polling_targets)
+        {
+            FastCaptureFrameInfo info;
+            p_target->polled_frame_index =
+                Utils::IsOk(p_target->desc.client->RequestLatestCaptureFrameInfo(&info)) ? info.frame_index : 0;
+        }
+        lock.lock();
+
+        for (const auto& p_target : polling_targets)
+        {
+            auto& target = *p_target;
+            target.is_in_flight = false;
+            if (!target.is_removed && target.polled_frame_index != 0 && target.polled_frame_index != target.last_frame_index)
+            {
+                target.is_in_flight = true;
+                target.next_poll_time = now + (std::max)(GetFrameInterval(target), poll_interval_);
+                jobs_.push(Job{target.desc.priority, next_job_sequence_++, p_target});
+                worker_condition_.notify_one();
+                continue;
+            }
+            target.next_poll_time = now + poll_interval_;
+            next_wake_time = (std::min)(next_wake_time, target.next_poll_time);
+        }
+        target_idle_condition_.notify_all();
+        return next_wake_time;
+    }
+
+    void FastCaptureHub::RunScheduler() noexcept
+    {
+        std::unique_lock lock{lock_};
+        std::vector<std::shared_ptr<Target>> polling_targets;
+        while (!is_stop_requested_)
+        {
+            is_scheduler_wakeup_requested_ = false;
+            const auto next_wake_time = PollTargets(lock, polling_targets);
+            scheduler_condition_.wait_until(
+                lock,
+                next_wake_time,
+                [this]()
+                { return is_stop_requested_ || is_scheduler_wakeup_requested_; });
+        }
+    }
+
+    void FastCaptureHub::RunWorker() noexcept
+    {
+        std::unique_lock lock{lock_};
+        while (true)
+        {
+            worker_condition_.wait(
+                lock,
+                [this]()
+                { return is_stop_requested_ || !jobs_.empty(); });
+            if (is_stop_requested_)
+            {
+                return;
+            }
+            const auto p_target = jobs_.top().p_target;
+            jobs_.pop();
+            auto& target = *p_target;
+            const auto desc = target.desc;
+
+            FastCaptureFrameInfo info{};
+            bool is_copied = false;
+            if (!target.is_removed)
+                [[likely]]
+            {
+                lock.unlock();
+                size_t frame_size;
+                const auto p_frame = reinterpret_cast<char*>(target.p_frame_buffer.get());
+                is_copied = Utils::IsOk(desc.client->CopyLatestCapturePlaneEx(
+                    desc.plane,
+                    p_frame,
+                    static_cast<size_t>(desc.max_frame_size),
+                    &frame_size,
+                    &info));
+                if (is_copied)
+                    [[likely]]
+                {
+                    desc.callback(desc.user_data, target.target_id, p_frame, frame_size, &info);
+                }
+                lock.lock();
+            }
+            if (is_copied)
+            {
+                target.last_frame_index = info.frame_index;
+            }
+            target.is_in_flight = false;
+            is_scheduler_wakeup_requested_ = true;
+            target_idle_condition_.notify_all();
+            scheduler_condition_.notify_one();
+        }
+    }
+
+    FastCaptureErrorCode FastCaptureHub::FindTarget(const std::uint32_t target_id, Target** pp_out_target) noexcept
+    {
+        const auto it = targets_.find(target_id);
+        if (it == targets_.end())
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_HUB_TARGET_NOT_FOUND);
+        }
+        *pp_out_target = it->second.get();
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHub::AddTarget(const FastCaptureHubTargetDesc* desc, uint32_t* target_id) FAST_CAPTURE_NOEXCEPT
+    {
+        if (desc == nullptr || target_id == nullptr || desc->client == nullptr || desc->callback == nullptr ||
+            desc->plane >= FAST_CAPTURE_PLANE_COUNT || desc->max_frame_size == 0 ||
+            desc->max_frame_size > std::numeric_limits<std::size_t>::max())
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        auto p_target = std::make_shared<Target>();
+        p_target->desc = *desc;
+        p_target->p_frame_buffer.reset(new (std::nothrow) std::byte[static_cast<std::size_t>(desc->max_frame_size)]);
+        if (p_target->p_frame_buffer == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_ALLOCATE_FRAME_BUFFER_FAILED);
+        }
+        {
+            std::lock_guard lock{lock_};
+            p_target->target_id = next_target_id_++;
+            *target_id = p_target->target_id;
+            targets_.emplace(p_target->target_id, std::move(p_target));
+            is_scheduler_wakeup_requested_ = true;
+        }
+        scheduler_condition_.notify_one();
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHub::RemoveTarget(uint32_t target_id) FAST_CAPTURE_NOEXCEPT
+    {
+        std::unique_lock lock{lock_};
+        const auto it = targets_.find(target_id);
+        if (it == targets_.end())
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_HUB_TARGET_NOT_FOUND);
+        }
+        const auto p_target = std::move(it->second);
+        targets_.erase(it);
+        p_target->is_removed = true;
+        target_idle_condition_.wait(
+            lock,
+            [&p_target, this]()
+            { return !p_target->is_in_flight || is_stop_requested_; });
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHub::SetTargetPriority(uint32_t target_id, int32_t priority) FAST_CAPTURE_NOEXCEPT
+    {
+        std::lock_guard lock{lock_};
+        Target* p_target;
+        if (auto result = FindTarget(target_id, &p_target); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        p_target->desc.priority = priority;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureHub::SetTargetMaxFps(uint32_t target_id, uint32_t max_fps) FAST_CAPTURE_NOEXCEPT
+    {
+        std::lock_guard lock{lock_};
+        Target* p_target;
+        if (auto result = FindTarget(target_id, &p_target); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        p_target->desc.max_fps = max_fps;
+        return FastCaptureMakeSuccessValue();
+    }
+}
+
+FastCaptureErrorCode CreateFastCaptureHub(const FastCaptureHubDesc* desc, IFastCaptureHub** hub) FAST_CAPTURE_NOEXCEPT
+{
+    if (desc == nullptr || hub == nullptr || desc->poll_interval_ms == 0)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    auto p_hub = new (std::nothrow) FAST_CAPTURE::FastCaptureHub{};
+    if (p_hub == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_CREATE_HUB_THREAD_FAILED);
+    }
+    if (auto result = p_hub->Initialize(*desc); !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        delete p_hub;
+        return result;
+    }
+    *hub = p_hub;
+    return FastCaptureMakeSuccessValue();
+}
+
+FastCaptureErrorCode DestroyFastCaptureHub(IFastCaptureHub* hub) FAST_CAPTURE_NOEXCEPT
+{
+    if (hub == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    delete static_cast<FAST_CAPTURE::FastCaptureHub*>(hub);
+    return FastCaptureMakeSuccessValue();
+}
@@ -0,0 +1,116 @@
+#ifndef FAST_CAPTURE_FAST_CAPTURE_HUB_H
+#define FAST_CAPTURE_FAST_CAPTURE_HUB_H
+
+#include "FastCapture.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+FAST_CAPTURE_NAMESPACE
+{
+    class FastCaptureHub final : public IFastCaptureHub
+    {
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief 除p_frame_buffer和polled_frame_index外，所有成员都由lock_保护。
+            is_in_flight为true时目标正在被调度线程检查或被工作线程处理，
+            此时只有检查它的调度线程会访问polled_frame_index，只有处理它的工作线程会访问p_frame_buffer
+         *
+         */
+        struct Target
+        {
+            std::uint32_t target_id{0};
+            FastCaptureHubTargetDesc desc{};
+            std::unique_ptr<std::byte[]> p_frame_buffer{};
+            Clock::time_point next_poll_time{};
+            std::uint64_t last_frame_index{0};
+            std::uint64_t polled_frame_index{0};
+            bool is_in_flight{false};
+            bool is_removed{false};
+        };
+        struct Job
+        {
+            std::int32_t priority{0};
+            std::uint64_t sequence{0};
+            std::shared_ptr<Target> p_target{};
+        };
+        /**
+         * @brief priority较大的先出队，相同时先入队的先出队
+         *
+         */
+        struct JobCompare
+        {
+            bool operator()(const Job& lhs, const Job& rhs) const noexcept
+            {
+                if (lhs.priority != rhs.priority)
+                {
+                    return lhs.priority < rhs.priority;
+                }
+                return lhs.sequence > rhs.sequence;
+            }
+        };
+
+        Clock::duration poll_interval_{};
+        std::mutex lock_{};
+        std::condition_variable scheduler_condition_{};
+        std::condition_variable worker_condition_{};
+        std::condition_variable target_idle_condition_{};
+        std::unordered_map<std::uint32_t, std::shared_ptr<Target>> targets_{};
+        std::uint32_t next_target_id_{1};
+        std::priority_queue<Job, std::vector<Job>, JobCompare> jobs_{};
+        std::uint64_t next_job_sequence_{0};
+        bool is_stop_requested_{false};
+        /**
+         * @brief 调度线程查询客户端时不持有lock_，此时的唤醒记录在这里，避免丢失
+         *
+         */
+        bool is_scheduler_wakeup_requested_{false};
+        std::thread scheduler_thread_{};
+        std::vector<std::thread> worker_threads_{};
+
+        /**
+         * @brief 按max_fps计算出的两次分发之间的最小间隔，需要持有lock_
+         *
+         */
+        Clock::duration GetFrameInterval(const Target& target) const noexcept;
+        /**
+         * @brief 检查到期的目标，有新帧时加入任务队列，返回下一次需要检查的时刻。
+            调用时需要持有lock_，查询客户端期间释放lock_，因为查询可能等待正在复制的同一客户端
+         *
+         * @param polling_targets 只用于复用内存
+         */
+        Clock::time_point PollTargets(
+            std::unique_lock<std::mutex>& lock,
+            std::vector<std::shared_ptr<Target>>& polling_targets) noexcept;
+        void RunScheduler() noexcept;
+        void RunWorker() noexcept;
+        FastCaptureErrorCode FindTarget(const std::uint32_t target_id, Target** pp_out_target) noexcept;
+
+    public:
+        FastCaptureHub() = default;
+        ~FastCaptureHub();
+        FastCaptureHub(const FastCaptureHub&) = delete;
+        FastCaptureHub& operator=(const FastCaptureHub&) = delete;
+
+        FastCaptureErrorCode Initialize(const FastCaptureHubDesc& desc) noexcept;
+
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        AddTarget(const FastCaptureHubTargetDesc* desc, uint32_t* target_id) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RemoveTarget(uint32_t target_id) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetTargetPriority(uint32_t target_id, int32_t priority) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetTargetMaxFps(uint32_t target_id, uint32_t max_fps) FAST_CAPTURE_NOEXCEPT override;
+    };
+}
+
+#endif // FAST_CAPTURE_FAST_CAPTURE_HUB_H
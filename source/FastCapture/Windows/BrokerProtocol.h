@@ -0,0 +1,69 @@
+#ifndef FAST_CAPTURE_WINDOWS_BROKER_PROTOCOL_H
+#define FAST_CAPTURE_WINDOWS_BROKER_PROTOCOL_H
+
+#include "FastCaptureDef.h"
+#include <cstdint>
+#include <string>
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Windows
+    {
+        /**
+         * @brief 代理与客户端之间的消息，管道为消息模式，每个请求对应一个回复
+         *
+         */
+        namespace Broker
+        {
+            enum class RequestType : std::uint32_t
+            {
+                /**
+                 * @brief 注入process_id指定的进程，回复描述信息共享内存和新帧通知事件的句柄
+                 *
+                 */
+                Attach = 1,
+                /**
+                 * @brief 回复代数为capture_image_generation的图像共享内存的只读句柄
+                 *
+                 */
+                OpenCaptureImage = 2
+            };
+
+            struct Request
+            {
+                RequestType type{RequestType::Attach};
+                std::uint32_t process_id{0};
+                std::uint32_t capture_image_generation{0};
+            };
+
+            /**
+             * @brief 句柄已经被复制到客户端进程中，由客户端负责关闭
+             *
+             */
+            struct Response
+            {
+                FastCaptureErrorCode result{FastCaptureMakeSuccessValue()};
+                std::uint64_t handle{0};
+                std::uint64_t frame_event_handle{0};
+            };
+
+            inline std::wstring MakePipePath(const wchar_t* pipe_name)
+            {
+                return std::wstring(L"\\\\.\\pipe\\") + pipe_name;
+            }
+
+            inline HANDLE ToHandle(const std::uint64_t handle) noexcept
+            {
+                return reinterpret_cast<HANDLE>(static_cast<std::uintptr_t>(handle));
+            }
+
+            inline std::uint64_t FromHandle(const HANDLE handle) noexcept
+            {
+                return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(handle));
+            }
+        }
+    }
+}
+
+#endif // FAST_CAPTURE_WINDOWS_BROKER_PROTOCOL_H
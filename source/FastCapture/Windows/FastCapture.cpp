@@ -1,23 +1,104 @@
 #include "FastCapture.h"
+#include <new>
+#include <vector>
 #include "Impl.h"
+#include "FastCaptureClient.h"
+#include "ProcessIndex.h"
 #include "../../Utils/Utils.hpp"
 
-FAST_CAPTURE_NAMESPACE
+IFastCaptureClient* CreateFastCaptureInstance(const wchar_t* const w_process_name) FAST_CAPTURE_NOEXCEPT
 {
-    FastCaptureErrorCode InjectProcess(const wchar_t* const w_process_name, const wchar_t* const w_pipe_name) FAST_CAPTURE_NOEXCEPT
+    if (w_process_name == nullptr)
     {
-        if (w_process_name == nullptr || w_process_name == nullptr)
-        {
-            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
-        }
-        std::wstring pipe_name{w_pipe_name};
-        return Windows::InjectProcessImpl(*w_process_name, pipe_name);
+        return nullptr;
     }
+    DWORD process_id;
+    if (!FAST_CAPTURE::Utils::IsOk(
+            FAST_CAPTURE::Windows::ProcessIndex::GetInstance().FindUnique(w_process_name, &process_id)))
+    {
+        return nullptr;
+    }
+    return CreateFastCaptureInstanceByProcessId(process_id);
+}
+
+IFastCaptureClient* CreateFastCaptureInstanceByProcessId(uint32_t process_id) FAST_CAPTURE_NOEXCEPT
+{
+    const auto shared_memory_name_prefix = FAST_CAPTURE::Windows::MakeSharedMemoryNamePrefix(static_cast<DWORD>(process_id));
+    if (!FAST_CAPTURE::Utils::IsOk(
+            FAST_CAPTURE::Windows::InjectProcessImpl(static_cast<DWORD>(process_id), shared_memory_name_prefix)))
+    {
+        return nullptr;
+    }
+    auto p_client = new (std::nothrow) FAST_CAPTURE::FastCaptureClient{};
+    if (p_client == nullptr)
+    {
+        return nullptr;
+    }
+    if (!FAST_CAPTURE::Utils::IsOk(p_client->Initialize(shared_memory_name_prefix)))
+    {
+        delete p_client;
+        return nullptr;
+    }
+    return p_client;
+}
+
+IFastCaptureClient* CreateFastCaptureInstanceFromBroker(const wchar_t* pipe_name, uint32_t process_id) FAST_CAPTURE_NOEXCEPT
+{
+    if (pipe_name == nullptr)
+    {
+        return nullptr;
+    }
+    auto p_client = new (std::nothrow) FAST_CAPTURE::FastCaptureClient{};
+    if (p_client == nullptr)
+    {
+        return nullptr;
+    }
+    if (!FAST_CAPTURE::Utils::IsOk(p_client->InitializeFromBroker(pipe_name, static_cast<DWORD>(process_id))))
+    {
+        delete p_client;
+        return nullptr;
+    }
+    return p_client;
+}
+
+FastCaptureErrorCode DestroyFastCaptureInstance(IFastCaptureClient* client) FAST_CAPTURE_NOEXCEPT
+{
+    if (client == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    delete static_cast<FAST_CAPTURE::FastCaptureClient*>(client);
+    return FastCaptureMakeSuccessValue();
+}
 
-    class FastCaptureClient : public IFastCaptureClient
+FastCaptureErrorCode FindFastCaptureProcesses(
+    const FastCaptureProcessQuery* query,
+    uint32_t* process_ids,
+    size_t capacity,
+    size_t* count) FAST_CAPTURE_NOEXCEPT
+{
+    if (query == nullptr || count == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    std::vector<DWORD> found_process_ids;
+    if (auto result = FAST_CAPTURE::Windows::ProcessIndex::GetInstance().Find(*query, &found_process_ids);
+        !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        return result;
+    }
+    *count = found_process_ids.size();
+    if (process_ids == nullptr)
+    {
+        return FastCaptureMakeSuccessValue();
+    }
+    if (capacity < found_process_ids.size())
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+    }
+    for (std::size_t i = 0; i < found_process_ids.size(); ++i)
     {
-    public:
-        FastCaptureClient();
-        ~FastCaptureClient();
-    };
-};
+        process_ids[i] = static_cast<uint32_t>(found_process_ids[i]);
+    }
+    return FastCaptureMakeSuccessValue();
+}
@@ -0,0 +1,574 @@
+#include "FastCaptureBroker.h"
+#include <algorithm>
+#include <new>
+#include <sddl.h>
+#include "Impl.h"
+#include "FastCaptureClient.h"
+
+FAST_CAPTURE_NAMESPACE
+{
+    FastCaptureBroker::~FastCaptureBroker()
+    {
+        if (!h_stop_event_.IsInvalid())
+        {
+            ::SetEvent(h_stop_event_.Get());
+        }
+        for (const auto h_thread : {h_accept_thread_.Get(), h_keep_alive_thread_.Get()})
+        {
+            if (h_thread != nullptr)
+            {
+                ::WaitForSingleObject(h_thread, INFINITE);
+            }
+        }
+        // 此时不会再有新连接，连接线程只在退出前短暂持有lock_
+        for (const auto& p_connection : connections_)
+        {
+            ::WaitForSingleObject(p_connection->h_thread.Get(), INFINITE);
+        }
+    }
+
+    HANDLE FastCaptureBroker::CreatePipeInstance(const bool is_first) const noexcept
+    {
+        SECURITY_ATTRIBUTES security_attributes{sizeof(SECURITY_ATTRIBUTES), p_pipe_security_descriptor_.Get(), FALSE};
+        return ::CreateNamedPipeW(
+            pipe_path_.c_str(),
+            PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (is_first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES,
+            sizeof(Windows::Broker::Response),
+            sizeof(Windows::Broker::Request),
+            0,
+            &security_attributes);
+    }
+
+    FastCaptureErrorCode FastCaptureBroker::Initialize(const wchar_t* pipe_name) noexcept
+    {
+        pipe_path_ = Windows::Broker::MakePipePath(pipe_name);
+        PSECURITY_DESCRIPTOR p_security_descriptor = nullptr;
+        if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(
+                PIPE_SECURITY_DESCRIPTOR,
+                SDDL_REVISION_1,
+                &p_security_descriptor,
+                nullptr))
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_BROKER_PIPE_FAILED);
+        }
+        p_pipe_security_descriptor_ = p_security_descriptor;
+        h_stop_event_ = ::CreateEventW(
+            nullptr,
+            TRUE,
+            FALSE,
+            nullptr);
+        h_connect_event_ = ::CreateEventW(
+            nullptr,
+            TRUE,
+            FALSE,
+            nullptr);
+        if (h_stop_event_.IsInvalid() || h_connect_event_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_BROKER_THREAD_FAILED);
+        }
+        // 第一个管道实例在此创建，保证返回后客户端就可以连接，且管道名没有被其它进程抢先占用
+        h_next_pipe_ = CreatePipeInstance(true);
+        if (h_next_pipe_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_BROKER_PIPE_FAILED);
+        }
+        h_accept_thread_ = ::CreateThread(
+            nullptr,
+            0,
+            &AcceptConnections,
+            this,
+            0,
+            nullptr);
+        if (h_accept_thread_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_BROKER_THREAD_FAILED);
+        }
+        h_keep_alive_thread_ = ::CreateThread(
+            nullptr,
+            0,
+            &KeepTargetsAlive,
+            this,
+            0,
+            nullptr);
+        if (h_keep_alive_thread_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_BROKER_THREAD_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    void FastCaptureBroker::ReapFinishedConnections() noexcept
+    {
+        std::erase_if(
+            connections_,
+            [](const std::unique_ptr<Connection>& p_connection)
+            {
+                if (!p_connection->is_finished.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                ::WaitForSingleObject(p_connection->h_thread.Get(), INFINITE);
+                return true;
+            });
+    }
+
+    DWORD WINAPI FastCaptureBroker::AcceptConnections(LPVOID lpThreadParameter)
+    {
+        auto p_this = static_cast<FastCaptureBroker*>(lpThreadParameter);
+        const HANDLE wait_handles[] = {p_this->h_connect_event_.Get(), p_this->h_stop_event_.Get()};
+        while (true)
+        {
+            if (p_this->h_next_pipe_.IsInvalid())
+            {
+                p_this->h_next_pipe_ = p_this->CreatePipeInstance(false);
+                if (p_this->h_next_pipe_.IsInvalid())
+                {
+                    if (::WaitForSingleObject(p_this->h_stop_event_.Get(), 100) != WAIT_TIMEOUT)
+                    {
+                        return 0;
+                    }
+                    continue;
+                }
+            }
+            const auto h_pipe = p_this->h_next_pipe_.Get();
+            OVERLAPPED overlapped{};
+            overlapped.hEvent = p_this->h_connect_event_.Get();
+            bool is_connected = ::ConnectNamedPipe(h_pipe, &overlapped);
+            if (!is_connected)
+            {
+                switch (::GetLastError())
+                {
+                case ERROR_PIPE_CONNECTED:
+                    is_connected = true;
+                    break;
+                case ERROR_IO_PENDING:
+                {
+                    if (::WaitForMultipleObjects(
+                            static_cast<DWORD>(std::size(wait_handles)),
+                            wait_handles,
+                            FALSE,
+                            INFINITE)
+                        != WAIT_OBJECT_0)
+                    {
+                        ::CancelIo(h_pipe);
+                        return 0;
+                    }
+                    DWORD transferred_size;
+                    is_connected = ::GetOverlappedResult(h_pipe, &overlapped, &transferred_size, FALSE);
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+            if (!is_connected)
+            {
+                p_this->h_next_pipe_ = INVALID_HANDLE_VALUE;
+                continue;
+            }
+
+            auto p_connection = std::unique_ptr<Connection>(new (std::nothrow) Connection{});
+            if (p_connection == nullptr)
+            {
+                p_this->h_next_pipe_ = INVALID_HANDLE_VALUE;
+                continue;
+            }
+            p_connection->p_broker = p_this;
+            p_connection->h_pipe = std::move(p_this->h_next_pipe_);
+            p_connection->h_frame_event = ::CreateEventW(
+                nullptr,
+                FALSE,
+                FALSE,
+                nullptr);
+            p_connection->h_io_event = ::CreateEventW(
+                nullptr,
+                TRUE,
+                FALSE,
+                nullptr);
+            if (p_connection->h_frame_event.IsInvalid() || p_connection->h_io_event.IsInvalid())
+            {
+                continue;
+            }
+            std::lock_guard lock{p_this->lock_};
+            p_this->ReapFinishedConnections();
+            p_connection->h_thread = ::CreateThread(
+                nullptr,
+                0,
+                &ServeConnection,
+                p_connection.get(),
+                0,
+                nullptr);
+            if (!p_connection->h_thread.IsInvalid())
+                [[likely]]
+            {
+                p_this->connections_.push_back(std::move(p_connection));
+            }
+        }
+    }
+
+    bool FastCaptureBroker::TransferMessage(Connection& connection, const bool is_write, void* p_message, const DWORD message_size) noexcept
+    {
+        const auto h_pipe = connection.h_pipe.Get();
+        OVERLAPPED overlapped{};
+        overlapped.hEvent = connection.h_io_event.Get();
+        const auto is_finished = is_write
+                                     ? ::WriteFile(h_pipe, p_message, message_size, nullptr, &overlapped)
+                                     : ::ReadFile(h_pipe, p_message, message_size, nullptr, &overlapped);
+        if (!is_finished && ::GetLastError() != ERROR_IO_PENDING)
+        {
+            return false;
+        }
+        const HANDLE wait_handles[] = {overlapped.hEvent, h_stop_event_.Get()};
+        DWORD transferred_size;
+        if (::WaitForMultipleObjects(static_cast<DWORD>(std::size(wait_handles)), wait_handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+        {
+            ::CancelIo(h_pipe);
+            ::GetOverlappedResult(h_pipe, &overlapped, &transferred_size, TRUE);
+            return false;
+        }
+        // 消息比预期的大时返回ERROR_MORE_DATA，按协议错误处理
+        return ::GetOverlappedResult(h_pipe, &overlapped, &transferred_size, FALSE) && transferred_size == message_size;
+    }
+
+    bool FastCaptureBroker::CanClientReadProcess(const Connection& connection, const DWORD process_id) noexcept
+    {
+        if (!::ImpersonateNamedPipeClient(connection.h_pipe.Get()))
+        {
+            return false;
+        }
+        Windows::UniqueHandleInvalidNULL h_process = ::OpenProcess(
+            PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_VM_READ,
+            FALSE,
+            process_id);
+        // 无法恢复自己的身份时不能继续以客户端的身份服务其它请求
+        if (!::RevertToSelf())
+        {
+            std::terminate();
+        }
+        return !h_process.IsInvalid();
+    }
+
+    FastCaptureErrorCode FastCaptureBroker::DuplicateToClient(const Connection& connection, HANDLE handle, std::uint64_t* p_out_handle) noexcept
+    {
+        HANDLE h_remote = nullptr;
+        if (!::DuplicateHandle(
+                ::GetCurrentProcess(),
+                handle,
+                connection.h_client_process.Get(),
+                &h_remote,
+                0,
+                FALSE,
+                DUPLICATE_SAME_ACCESS))
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_DUPLICATE_HANDLE_FAILED);
+        }
+        *p_out_handle = Windows::Broker::FromHandle(h_remote);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    void FastCaptureBroker::DetachConnection(Connection& connection) noexcept
+    {
+        if (connection.target_process_id == 0)
+        {
+            return;
+        }
+        if (auto it = targets_.find(connection.target_process_id); it != targets_.end())
+        {
+            auto& target = *it->second;
+            std::lock_guard frame_events_lock{target.frame_events_lock};
+            std::erase(target.frame_events, connection.h_frame_event.Get());
+        }
+        connection.target_process_id = 0;
+    }
+
+    FastCaptureErrorCode FastCaptureBroker::CreateTarget(const DWORD process_id, std::unique_ptr<Target>* p_out_target) noexcept
+    {
+        const auto shared_memory_name_prefix = Windows::MakeSharedMemoryNamePrefix(process_id);
+        if (auto result = Windows::InjectProcessImpl(process_id, shared_memory_name_prefix); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        auto p_target = std::unique_ptr<Target>(new (std::nothrow) Target{});
+        if (p_target == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_BROKER_TARGET_NOT_ATTACHED);
+        }
+        auto p_client = new (std::nothrow) FastCaptureClient{};
+        p_target->p_client.reset(p_client);
+        if (p_client == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_BROKER_TARGET_NOT_ATTACHED);
+        }
+        if (auto result = p_client->Initialize(shared_memory_name_prefix); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto capture_descriptor_shared_name =
+            std::wstring(L"Global\\") + shared_memory_name_prefix + std::wstring(L"Descriptor");
+        p_target->h_capture_descriptor = ::OpenFileMappingW(
+            FILE_MAP_ALL_ACCESS,
+            FALSE,
+            capture_descriptor_shared_name.c_str());
+        if (p_target->h_capture_descriptor.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_DESCRIPTOR_FAILED);
+        }
+        void* h_client_frame_event = nullptr;
+        if (auto result = p_client->RequestFrameEventHandle(&h_client_frame_event); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        // 回调只设置各个连接的事件，在等待线程中执行即可
+        HANDLE h_wait = nullptr;
+        if (!::RegisterWaitForSingleObject(
+                &h_wait,
+                static_cast<HANDLE>(h_client_frame_event),
+                &OnTargetFrame,
+                p_target.get(),
+                INFINITE,
+                WT_EXECUTEINWAITTHREAD))
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_FRAME_NOTIFICATION_FAILED);
+        }
+        p_target->h_frame_wait = h_wait;
+        *p_out_target = std::move(p_target);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureBroker::AttachTarget(const DWORD process_id, Target** pp_out_target) noexcept
+    {
+        {
+            std::unique_lock lock{lock_};
+            attach_condition_.wait(lock, [this, process_id]()
+                                   { return !attaching_process_ids_.contains(process_id); });
+            if (auto it = targets_.find(process_id); it != targets_.end())
+            {
+                *pp_out_target = it->second.get();
+                return FastCaptureMakeSuccessValue();
+            }
+            attaching_process_ids_.insert(process_id);
+        }
+        std::unique_ptr<Target> p_target;
+        const auto result = CreateTarget(process_id, &p_target);
+        {
+            std::lock_guard lock{lock_};
+            attaching_process_ids_.erase(process_id);
+            if (Utils::IsOk(result))
+            {
+                *pp_out_target = targets_.emplace(process_id, std::move(p_target)).first->second.get();
+            }
+        }
+        attach_condition_.notify_all();
+        return result;
+    }
+
+    Windows::Broker::Response FastCaptureBroker::HandleRequest(Connection& connection, const Windows::Broker::Request& request) noexcept
+    {
+        Windows::Broker::Response response{};
+        switch (request.type)
+        {
+        case Windows::Broker::RequestType::Attach:
+        {
+            bool is_allowed;
+            {
+                std::lock_guard lock{lock_};
+                DetachConnection(connection);
+                is_allowed = allowed_target_process_ids_.contains(request.process_id);
+            }
+            // 代理可能以更高的权限运行，只替客户端注入它自己就能读取的进程
+            if (!is_allowed && !CanClientReadProcess(connection, request.process_id))
+            {
+                response.result = Utils::MakeError(FAST_CAPTURE_E_BROKER_TARGET_ACCESS_DENIED);
+                break;
+            }
+            Target* p_target;
+            if (response.result = AttachTarget(request.process_id, &p_target); !Utils::IsOk(response.result))
+            {
+                break;
+            }
+            if (response.result = DuplicateToClient(connection, p_target->h_capture_descriptor.Get(), &response.handle);
+                !Utils::IsOk(response.result))
+            {
+                break;
+            }
+            if (response.result = DuplicateToClient(connection, connection.h_frame_event.Get(), &response.frame_event_handle);
+                !Utils::IsOk(response.result))
+            {
+                ::DuplicateHandle(
+                    connection.h_client_process.Get(),
+                    Windows::Broker::ToHandle(response.handle),
+                    nullptr,
+                    nullptr,
+                    0,
+                    FALSE,
+                    DUPLICATE_CLOSE_SOURCE);
+                response.handle = 0;
+                break;
+            }
+            std::lock_guard lock{lock_};
+            {
+                std::lock_guard frame_events_lock{p_target->frame_events_lock};
+                p_target->frame_events.push_back(connection.h_frame_event.Get());
+            }
+            connection.target_process_id = request.process_id;
+            break;
+        }
+        case Windows::Broker::RequestType::OpenCaptureImage:
+        {
+            DWORD target_process_id;
+            {
+                std::lock_guard lock{lock_};
+                target_process_id = connection.target_process_id;
+            }
+            if (target_process_id == 0)
+            {
+                response.result = Utils::MakeError(FAST_CAPTURE_E_BROKER_TARGET_NOT_ATTACHED);
+                break;
+            }
+            const auto capture_image_shared_name =
+                std::wstring(L"Global\\") + Windows::MakeSharedMemoryNamePrefix(target_process_id) +
+                std::to_wstring(request.capture_image_generation);
+            Windows::UniqueHandleInvalidNULL h_capture_image = ::OpenFileMappingW(
+                FILE_MAP_READ,
+                FALSE,
+                capture_image_shared_name.c_str());
+            if (h_capture_image.IsInvalid())
+            {
+                response.result = Windows::MakeError(FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_IMAGE_FAILED);
+                break;
+            }
+            response.result = DuplicateToClient(connection, h_capture_image.Get(), &response.handle);
+            break;
+        }
+        default:
+            response.result = Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+            break;
+        }
+        return response;
+    }
+
+    DWORD WINAPI FastCaptureBroker::ServeConnection(LPVOID lpThreadParameter)
+    {
+        auto& connection = *static_cast<Connection*>(lpThreadParameter);
+        auto& broker = *connection.p_broker;
+        ULONG client_process_id;
+        if (::GetNamedPipeClientProcessId(connection.h_pipe.Get(), &client_process_id))
+        {
+            connection.h_client_process = ::OpenProcess(PROCESS_DUP_HANDLE, FALSE, client_process_id);
+        }
+        while (!connection.h_client_process.IsInvalid())
+        {
+            Windows::Broker::Request request;
+            if (!broker.TransferMessage(connection, false, &request, sizeof(request)))
+            {
+                break;
+            }
+            auto response = broker.HandleRequest(connection, request);
+            if (!broker.TransferMessage(connection, true, &response, sizeof(response)))
+            {
+                break;
+            }
+        }
+        {
+            std::lock_guard lock{broker.lock_};
+            broker.DetachConnection(connection);
+        }
+        ::DisconnectNamedPipe(connection.h_pipe.Get());
+        connection.is_finished.store(true, std::memory_order_release);
+        return 0;
+    }
+
+    VOID CALLBACK FastCaptureBroker::OnTargetFrame(PVOID context, BOOLEAN)
+    {
+        auto& target = *static_cast<Target*>(context);
+        std::lock_guard frame_events_lock{target.frame_events_lock};
+        for (const auto h_frame_event : target.frame_events)
+        {
+            ::SetEvent(h_frame_event);
+        }
+    }
+
+    DWORD WINAPI FastCaptureBroker::KeepTargetsAlive(LPVOID lpThreadParameter)
+    {
+        auto p_this = static_cast<FastCaptureBroker*>(lpThreadParameter);
+        std::vector<IFastCaptureClient*> clients;
+        while (::WaitForSingleObject(p_this->h_stop_event_.Get(), KEEP_ALIVE_INTERVAL_MS) == WAIT_TIMEOUT)
+        {
+            clients.clear();
+            {
+                std::lock_guard lock{p_this->lock_};
+                for (const auto& [process_id, p_target] : p_this->targets_)
+                {
+                    clients.push_back(p_target->p_client.get());
+                }
+            }
+            // 每个客户端有自己的锁，刷新心跳时不阻塞其它连接的请求
+            for (const auto p_client : clients)
+            {
+                FastCaptureFrameInfo info;
+                p_client->RequestLatestCaptureFrameInfo(&info);
+            }
+        }
+        return 0;
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureBroker::RequestConnectionCount(size_t* count) FAST_CAPTURE_NOEXCEPT
+    {
+        if (count == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{lock_};
+        *count = static_cast<size_t>(std::count_if(
+            connections_.begin(),
+            connections_.end(),
+            [](const std::unique_ptr<Connection>& p_connection)
+            { return !p_connection->is_finished.load(std::memory_order_acquire); }));
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureBroker::AllowTargetProcess(uint32_t process_id) FAST_CAPTURE_NOEXCEPT
+    {
+        if (process_id == 0)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{lock_};
+        allowed_target_process_ids_.insert(static_cast<DWORD>(process_id));
+        return FastCaptureMakeSuccessValue();
+    }
+}
+
+FastCaptureErrorCode CreateFastCaptureBroker(const wchar_t* pipe_name, IFastCaptureBroker** broker) FAST_CAPTURE_NOEXCEPT
+{
+    if (pipe_name == nullptr || broker == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    auto p_broker = new (std::nothrow) FAST_CAPTURE::FastCaptureBroker{};
+    if (p_broker == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_CREATE_BROKER_THREAD_FAILED);
+    }
+    if (auto result = p_broker->Initialize(pipe_name); !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        delete p_broker;
+        return result;
+    }
+    *broker = p_broker;
+    return FastCaptureMakeSuccessValue();
+}
+
+FastCaptureErrorCode DestroyFastCaptureBroker(IFastCaptureBroker* broker) FAST_CAPTURE_NOEXCEPT
+{
+    if (broker == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    delete static_cast<FAST_CAPTURE::FastCaptureBroker*>(broker);
+    return FastCaptureMakeSuccessValue();
+}
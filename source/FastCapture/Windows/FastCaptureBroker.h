@@ -0,0 +1,180 @@
+#ifndef FAST_CAPTURE_WINDOWS_FAST_CAPTURE_BROKER_H
+#define FAST_CAPTURE_WINDOWS_FAST_CAPTURE_BROKER_H
+
+#include "FastCapture.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "BrokerProtocol.h"
+#include "../../FastCaptureInjectDll/FastCaptureInjectDllDef.h"
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    class FastCaptureBroker final : public IFastCaptureBroker
+    {
+        struct ClientDeleter
+        {
+            void operator()(IFastCaptureClient* p_client) const noexcept
+            {
+                ::DestroyFastCaptureInstance(p_client);
+            }
+        };
+
+        /**
+         * @brief 代理自己也是目标的一个客户端，以此保持注入DLL的订阅者槽位，并接收新帧事件
+         *
+         */
+        struct Target
+        {
+            std::unique_ptr<IFastCaptureClient, ClientDeleter> p_client{};
+            Windows::UniqueHandleInvalidNULL h_capture_descriptor{nullptr};
+            /**
+             * @brief 保护frame_events。转发新帧的回调只持有此锁，不会等待代理的lock_
+             *
+             */
+            std::mutex frame_events_lock{};
+            /**
+             * @brief 连接到此目标的各个连接的h_frame_event
+             *
+             */
+            std::vector<HANDLE> frame_events{};
+            /**
+             * @brief 等待p_client的新帧事件并转发到frame_events，声明在最后，先于其它成员被注销
+             *
+             */
+            Windows::UniqueRegisteredWait h_frame_wait{nullptr};
+        };
+
+        struct Connection
+        {
+            FastCaptureBroker* p_broker{nullptr};
+            Windows::UniqueHandleInvalidMinusOne h_pipe{INVALID_HANDLE_VALUE};
+            /**
+             * @brief 以PROCESS_DUP_HANDLE打开的客户端进程
+             *
+             */
+            Windows::UniqueHandleInvalidNULL h_client_process{nullptr};
+            Windows::UniqueHandleInvalidNULL h_frame_event{nullptr};
+            Windows::UniqueHandleInvalidNULL h_io_event{nullptr};
+            Windows::UniqueHandleInvalidNULL h_thread{nullptr};
+            /**
+             * @brief 由lock_保护，为0表示尚未Attach
+             *
+             */
+            DWORD target_process_id{0};
+            std::atomic<bool> is_finished{false};
+        };
+
+        /**
+         * @brief 新帧由事件转发，此间隔只用于刷新代理自己的订阅者心跳
+         *
+         */
+        constexpr static DWORD KEEP_ALIVE_INTERVAL_MS = static_cast<DWORD>(SUBSCRIBER_HEARTBEAT_TIMEOUT_MS / 3);
+        /**
+         * @brief 管道的DACL。SYSTEM、管理员和管道的所有者有完全访问权限，交互式登录的用户(IU)可以读写，
+            但没有FILE_CREATE_PIPE_INSTANCE(0x4)，不能创建同名的管道实例冒充代理
+         *
+         */
+        constexpr static wchar_t PIPE_SECURITY_DESCRIPTOR[] =
+            L"D:P(A;;GA;;;SY)(A;;GA;;;BA)(A;;GA;;;OW)(A;;0x12019b;;;IU)";
+
+        std::wstring pipe_path_{};
+        Windows::UniqueLocalMemory<PSECURITY_DESCRIPTOR> p_pipe_security_descriptor_{nullptr};
+        std::mutex lock_{};
+        /**
+         * @brief 目标在代理销毁之前不会被移除，因此在lock_之外也可以使用取出的指针
+         *
+         */
+        std::unordered_map<DWORD, std::unique_ptr<Target>> targets_{};
+        /**
+         * @brief 正在lock_之外注入的目标，同一目标的其它Attach等待attach_condition_
+         *
+         */
+        std::unordered_set<DWORD> attaching_process_ids_{};
+        std::condition_variable attach_condition_{};
+        /**
+         * @brief 宿主以AllowTargetProcess允许的目标，由lock_保护
+         *
+         */
+        std::unordered_set<DWORD> allowed_target_process_ids_{};
+        std::vector<std::unique_ptr<Connection>> connections_{};
+        /**
+         * @brief 下一个等待连接的管道实例，只由接受连接的线程使用
+         *
+         */
+        Windows::UniqueHandleInvalidMinusOne h_next_pipe_{INVALID_HANDLE_VALUE};
+        Windows::UniqueHandleInvalidNULL h_connect_event_{nullptr};
+        /**
+         * @brief MANUAL_RESET，变为1时所有线程退出
+         *
+         */
+        Windows::UniqueHandleInvalidNULL h_stop_event_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_accept_thread_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_keep_alive_thread_{nullptr};
+
+        /**
+         * @brief is_first为true时以FILE_FLAG_FIRST_PIPE_INSTANCE创建，管道名已被占用时失败
+         *
+         */
+        HANDLE CreatePipeInstance(const bool is_first) const noexcept;
+        /**
+         * @brief 回收已经断开的连接，需要持有lock_
+         *
+         */
+        void ReapFinishedConnections() noexcept;
+        /**
+         * @brief 在管道上完成一次读或写，代理停止时返回false
+         *
+         */
+        bool TransferMessage(Connection& connection, const bool is_write, void* p_message, const DWORD message_size) noexcept;
+        /**
+         * @brief 模拟管道的客户端打开目标进程，客户端自己能读取目标的内存时才允许代理替它注入
+         *
+         */
+        static bool CanClientReadProcess(const Connection& connection, const DWORD process_id) noexcept;
+        FastCaptureErrorCode DuplicateToClient(const Connection& connection, HANDLE handle, std::uint64_t* p_out_handle) noexcept;
+        /**
+         * @brief 需要持有lock_
+         *
+         */
+        void DetachConnection(Connection& connection) noexcept;
+        /**
+         * @brief 注入目标进程并开始转发它的新帧事件，需要数秒，不持有lock_
+         *
+         */
+        static FastCaptureErrorCode CreateTarget(const DWORD process_id, std::unique_ptr<Target>* p_out_target) noexcept;
+        /**
+         * @brief 不能持有lock_，注入期间其它连接的请求不受影响
+         *
+         */
+        FastCaptureErrorCode AttachTarget(const DWORD process_id, Target** pp_out_target) noexcept;
+        Windows::Broker::Response HandleRequest(Connection& connection, const Windows::Broker::Request& request) noexcept;
+
+        static DWORD WINAPI AcceptConnections(LPVOID lpThreadParameter);
+        static DWORD WINAPI ServeConnection(LPVOID lpThreadParameter);
+        static DWORD WINAPI KeepTargetsAlive(LPVOID lpThreadParameter);
+        static VOID CALLBACK OnTargetFrame(PVOID context, BOOLEAN);
+
+    public:
+        FastCaptureBroker() = default;
+        ~FastCaptureBroker();
+        FastCaptureBroker(const FastCaptureBroker&) = delete;
+        FastCaptureBroker& operator=(const FastCaptureBroker&) = delete;
+
+        FastCaptureErrorCode Initialize(const wchar_t* pipe_name) noexcept;
+
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestConnectionCount(size_t* count) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        AllowTargetProcess(uint32_t process_id) FAST_CAPTURE_NOEXCEPT override;
+    };
+}
+
+#endif // FAST_CAPTURE_WINDOWS_FAST_CAPTURE_BROKER_H
@@ -0,0 +1,984 @@
+#include "FastCaptureClient.h"
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include "../WorkerPool.h"
+#include "../../Utils/StreamingCopy.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    FastCaptureClient::~FastCaptureClient()
+    {
+        if (p_frame_wait_ != nullptr)
+        {
+            // 先让正在执行的回调结束，之后回调中再次调用NotifyNewFrame会因为is_closing_而失败，不会重新开始等待
+            is_closing_.store(true, std::memory_order_release);
+            ::WaitForThreadpoolWaitCallbacks(p_frame_wait_, FALSE);
+            ::SetThreadpoolWait(p_frame_wait_, nullptr, nullptr);
+            ::WaitForThreadpoolWaitCallbacks(p_frame_wait_, TRUE);
+            ::CloseThreadpoolWait(p_frame_wait_);
+            if (is_frame_notification_pending_.load(std::memory_order_acquire))
+            {
+                CompleteFrameNotification(Utils::MakeError(FAST_CAPTURE_E_FRAME_NOTIFICATION_CANCELLED));
+            }
+        }
+        if (!p_capture_descriptor_.IsInvalid())
+        {
+            p_capture_descriptor_.Get()->UnregisterSubscriber(subscriber_index_, subscriber_owner_);
+        }
+    }
+
+    FastCaptureErrorCode FastCaptureClient::Initialize(const std::wstring& shared_memory_name_prefix) noexcept
+    {
+        shared_memory_name_prefix_ = shared_memory_name_prefix;
+        auto capture_descriptor_shared_name =
+            std::wstring(L"Global\\") + shared_memory_name_prefix_ + std::wstring(L"Descriptor");
+        h_capture_descriptor_ = ::OpenFileMappingW(
+            FILE_MAP_ALL_ACCESS,
+            FALSE,
+            capture_descriptor_shared_name.c_str());
+        if (h_capture_descriptor_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_DESCRIPTOR_FAILED);
+        }
+        auto attach_event_shared_name =
+            std::wstring(L"Global\\") + shared_memory_name_prefix_ + std::wstring(L"Attach");
+        h_attach_event_ = ::OpenEventW(
+            EVENT_MODIFY_STATE,
+            FALSE,
+            attach_event_shared_name.c_str());
+        h_frame_event_ = ::CreateEventW(
+            nullptr,
+            FALSE,
+            FALSE,
+            nullptr);
+        if (h_frame_event_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_FRAME_EVENT_FAILED);
+        }
+        return MapCaptureDescriptor();
+    }
+
+    FastCaptureErrorCode FastCaptureClient::InitializeFromBroker(const wchar_t* pipe_name, const DWORD process_id) noexcept
+    {
+        const auto pipe_path = Windows::Broker::MakePipePath(pipe_name);
+        // 管道的DACL不授予FILE_CREATE_PIPE_INSTANCE，因此不能以GENERIC_WRITE打开。
+        // 代理需要模拟客户端检查它能否读取目标进程，因此允许模拟
+        h_broker_pipe_ = ::CreateFileW(
+            pipe_path.c_str(),
+            GENERIC_READ | FILE_WRITE_DATA | FILE_WRITE_ATTRIBUTES,
+            0,
+            nullptr,
+            OPEN_EXISTING,
+            SECURITY_SQOS_PRESENT | SECURITY_IMPERSONATION,
+            nullptr);
+        if (h_broker_pipe_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CONNECT_BROKER_FAILED);
+        }
+        DWORD pipe_mode = PIPE_READMODE_MESSAGE;
+        if (!::SetNamedPipeHandleState(h_broker_pipe_.Get(), &pipe_mode, nullptr, nullptr))
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CONNECT_BROKER_FAILED);
+        }
+        Windows::Broker::Response response;
+        if (auto result = TransactBroker({Windows::Broker::RequestType::Attach, process_id, 0}, &response);
+            !Utils::IsOk(result))
+        {
+            return result;
+        }
+        h_capture_descriptor_ = Windows::Broker::ToHandle(response.handle);
+        h_frame_event_ = Windows::Broker::ToHandle(response.frame_event_handle);
+        is_frame_event_available_.store(true, std::memory_order_release);
+        return MapCaptureDescriptor();
+    }
+
+    FastCaptureErrorCode FastCaptureClient::TransactBroker(
+        const Windows::Broker::Request& request,
+        Windows::Broker::Response* p_out_response) noexcept
+    {
+        DWORD transferred_size;
+        if (!::WriteFile(h_broker_pipe_.Get(), &request, sizeof(request), &transferred_size, nullptr) ||
+            !::ReadFile(h_broker_pipe_.Get(), p_out_response, sizeof(*p_out_response), &transferred_size, nullptr) ||
+            transferred_size != sizeof(*p_out_response))
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_BROKER_REQUEST_FAILED);
+        }
+        return p_out_response->result;
+    }
+
+    FastCaptureErrorCode FastCaptureClient::MapCaptureDescriptor() noexcept
+    {
+        p_capture_descriptor_ = reinterpret_cast<CaptureDescriptor*>(
+            ::MapViewOfFile(
+                h_capture_descriptor_.Get(),
+                FILE_MAP_ALL_ACCESS,
+                0,
+                0,
+                sizeof(CaptureDescriptor)));
+        if (p_capture_descriptor_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_DESCRIPTOR_MAP_OF_VIEW_FAILED);
+        }
+        // 从日志中仍然保留的最旧的事件开始读取
+        const auto event_write_position =
+            p_capture_descriptor_.Get()->event_log.write_position.load(std::memory_order_acquire);
+        event_read_position_ = event_write_position > CAPTURE_EVENT_LOG_CAPACITY
+                                   ? event_write_position - CAPTURE_EVENT_LOG_CAPACITY
+                                   : 0;
+        return KeepAlive();
+    }
+
+    FastCaptureErrorCode FastCaptureClient::KeepAlive() noexcept
+    {
+        auto p_capture_descriptor = p_capture_descriptor_.Get();
+        const auto process_id = static_cast<std::uint32_t>(::GetCurrentProcessId());
+        const auto now_ms = ::GetTickCount64();
+        if (p_capture_descriptor->RefreshSubscriber(subscriber_index_, subscriber_owner_, now_ms))
+            [[likely]]
+        {
+            return FastCaptureMakeSuccessValue();
+        }
+        subscriber_index_ = p_capture_descriptor->RegisterSubscriber(process_id, now_ms, capture_flags_, &subscriber_owner_);
+        if (subscriber_index_ == MAX_SUBSCRIBER_COUNT)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_NO_FREE_SUBSCRIBER_SLOT);
+        }
+        if (h_broker_pipe_.IsInvalid())
+        {
+            ForwardSubscriberFrameEvent();
+        }
+        if (!h_attach_event_.IsInvalid())
+        {
+            ::SetEvent(h_attach_event_.Get());
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    void FastCaptureClient::ForwardSubscriberFrameEvent() noexcept
+    {
+        // 先注销转发，之后才能关闭旧槽位的事件
+        h_subscriber_frame_wait_ = nullptr;
+        h_subscriber_frame_event_ = ::OpenEventW(
+            SYNCHRONIZE,
+            FALSE,
+            MakeFrameEventName(shared_memory_name_prefix_, subscriber_index_).c_str());
+        if (h_subscriber_frame_event_.IsInvalid())
+        {
+            return;
+        }
+        // 回调只设置事件，在等待线程中执行即可。槽位的事件是AUTO_RESET的，等待会自动重新开始
+        HANDLE h_wait = nullptr;
+        if (::RegisterWaitForSingleObject(
+                &h_wait,
+                h_subscriber_frame_event_.Get(),
+                &OnSubscriberFrameEvent,
+                h_frame_event_.Get(),
+                INFINITE,
+                WT_EXECUTEINWAITTHREAD))
+        {
+            h_subscriber_frame_wait_ = h_wait;
+            is_frame_event_available_.store(true, std::memory_order_release);
+        }
+    }
+
+    VOID CALLBACK FastCaptureClient::OnSubscriberFrameEvent(PVOID context, BOOLEAN)
+    {
+        ::SetEvent(static_cast<HANDLE>(context));
+    }
+
+    HANDLE FastCaptureClient::GetFrameEvent() const noexcept
+    {
+        return is_frame_event_available_.load(std::memory_order_acquire) ? h_frame_event_.Get() : nullptr;
+    }
+
+    FastCaptureErrorCode FastCaptureClient::CheckProducerAlive() const noexcept
+    {
+        const auto producer_heartbeat_ms =
+            p_capture_descriptor_.Get()->producer_heartbeat_ms.load(std::memory_order_acquire);
+        if (::GetTickCount64() - producer_heartbeat_ms > PRODUCER_HEARTBEAT_TIMEOUT_MS)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_PRODUCER_NOT_RESPONDING);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureClient::ReadLatestCaptureLayout(CaptureLayout* p_out_layout) const noexcept
+    {
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        if (auto result = ReadSharedWithSeqLock(
+                p_capture_descriptor->seq_lock,
+                FAST_CAPTURE_E_READ_CAPTURE_DESCRIPTOR_TIMEOUT,
+                [p_capture_descriptor, p_out_layout]()
+                {
+                    p_out_layout->capture_image_generation = p_capture_descriptor->capture_image_generation;
+                    std::memcpy(p_out_layout->planes, p_capture_descriptor->planes, sizeof(p_out_layout->planes));
+                });
+            !Utils::IsOk(result))
+        {
+            return result;
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureClient::OpenCaptureImage(const std::uint32_t capture_image_generation) noexcept
+    {
+        if (!h_broker_pipe_.IsInvalid())
+        {
+            Windows::Broker::Response response;
+            if (auto result = TransactBroker(
+                    {Windows::Broker::RequestType::OpenCaptureImage, 0, capture_image_generation},
+                    &response);
+                !Utils::IsOk(result))
+            {
+                return result;
+            }
+            h_capture_image_ = Windows::Broker::ToHandle(response.handle);
+            return FastCaptureMakeSuccessValue();
+        }
+        auto capture_image_shared_name =
+            std::wstring(L"Global\\") + shared_memory_name_prefix_ + std::to_wstring(capture_image_generation);
+        h_capture_image_ = ::OpenFileMappingW(
+            FILE_MAP_READ,
+            FALSE,
+            capture_image_shared_name.c_str());
+        if (h_capture_image_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_IMAGE_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureClient::MapCaptureImageIfNecessary(const CaptureLayout& layout) noexcept
+    {
+        if (layout.capture_image_generation == 0)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_CAPTURE_IMAGE_NOT_READY);
+        }
+        if (layout.capture_image_generation == capture_image_mapped_generation_)
+            [[likely]]
+        {
+            return FastCaptureMakeSuccessValue();
+        }
+        p_capture_image_ = nullptr;
+        h_capture_image_ = nullptr;
+        capture_image_mapped_generation_ = 0;
+        capture_image_mapped_data_size_ = 0;
+
+        if (auto result = OpenCaptureImage(layout.capture_image_generation); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        p_capture_image_ = reinterpret_cast<CaptureImage*>(
+            ::MapViewOfFile(
+                h_capture_image_.Get(),
+                FILE_MAP_READ,
+                0,
+                0,
+                0));
+        if (p_capture_image_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_IMAGE_MAP_OF_VIEW_FAILED);
+        }
+        MEMORY_BASIC_INFORMATION memory_info;
+        if (::VirtualQuery(p_capture_image_.Get(), &memory_info, sizeof(memory_info)) == 0
+            || memory_info.RegionSize < sizeof(CaptureImage))
+        {
+            p_capture_image_ = nullptr;
+            return Windows::MakeError(FAST_CAPTURE_E_OPEN_SHARED_CAPTURE_IMAGE_MAP_OF_VIEW_FAILED);
+        }
+        capture_image_mapped_data_size_ = memory_info.RegionSize - sizeof(CaptureImage);
+        capture_image_mapped_generation_ = layout.capture_image_generation;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    bool FastCaptureClient::IsPlaneMapped(const CapturePlane& capture_plane) const noexcept
+    {
+        return capture_plane.offset <= capture_image_mapped_data_size_
+               && capture_plane.size <= capture_image_mapped_data_size_ - capture_plane.offset;
+    }
+
+    FastCaptureErrorCode FastCaptureClient::BeginRequest(CaptureLayout* p_out_layout) noexcept
+    {
+        if (auto result = KeepAlive(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        if (auto result = CheckProducerAlive(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        return ReadLatestCaptureLayout(p_out_layout);
+    }
+
+    void FastCaptureClient::CopyPlaneData(char* p_destination, const std::byte* p_source, const std::size_t size) const noexcept
+    {
+        const auto copy_flags = copy_flags_.load(std::memory_order_relaxed);
+        const bool is_cached = copy_flags & FAST_CAPTURE_COPY_FLAG_CACHED;
+        const auto copy = [is_cached](char* p_to, const std::byte* p_from, std::size_t n)
+        {
+            if (is_cached)
+            {
+                std::memcpy(p_to, p_from, n);
+                return;
+            }
+            Utils::CopyFrameData(p_to, p_from, n);
+        };
+        if (!(copy_flags & FAST_CAPTURE_COPY_FLAG_PARALLEL) || size < 2 * PARALLEL_COPY_MIN_CHUNK_SIZE)
+            [[likely]]
+        {
+            copy(p_destination, p_source, size);
+            return;
+        }
+        // 在CopyLatestCaptures的任务中Run直接在当前线程中依次复制各块，效果与不分块相同，
+        // 此时并行来自同一批中的其他请求
+        auto& worker_pool = WorkerPool::GetInstance();
+        const auto chunk_count = (std::min)(
+            size / PARALLEL_COPY_MIN_CHUNK_SIZE,
+            static_cast<std::size_t>(worker_pool.GetWorkerCount()) + 1);
+        // 分块大小取缓存行的整数倍，目标按缓存行对齐时相邻的块不会写同一个缓存行
+        const auto chunk_size = (size / chunk_count + 63) & ~std::size_t{63};
+        worker_pool.Run(
+            chunk_count,
+            [copy, p_destination, p_source, size, chunk_size](std::size_t i)
+            {
+                const auto offset = i * chunk_size;
+                if (offset < size)
+                {
+                    copy(p_destination + offset, p_source + offset, (std::min)(chunk_size, size - offset));
+                }
+            });
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::WaitForNewFrame(uint32_t timeout_ms) FAST_CAPTURE_NOEXCEPT
+    {
+        if (const auto h_wait_frame_event = GetFrameEvent(); h_wait_frame_event != nullptr)
+        {
+            switch (::WaitForSingleObject(h_wait_frame_event, timeout_ms))
+            {
+            case WAIT_OBJECT_0:
+                return FastCaptureMakeSuccessValue();
+            case WAIT_TIMEOUT:
+                return Utils::MakeError(FAST_CAPTURE_E_WAIT_NEW_FRAME_TIMEOUT);
+            default:
+                return Windows::MakeError(FAST_CAPTURE_E_WAIT_RESULT_UNEXPECTED);
+            }
+        }
+        constexpr DWORD POLL_INTERVAL_MS = 1;
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        const auto frame_index = p_capture_descriptor->frame_index.load(std::memory_order_acquire);
+        const auto begin_ms = ::GetTickCount64();
+        while (p_capture_descriptor->frame_index.load(std::memory_order_acquire) == frame_index)
+        {
+            if (::GetTickCount64() - begin_ms >= timeout_ms)
+            {
+                return Utils::MakeError(FAST_CAPTURE_E_WAIT_NEW_FRAME_TIMEOUT);
+            }
+            ::Sleep(POLL_INTERVAL_MS);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::DrainCaptureEvents(FastCaptureEvent* events, size_t capacity, size_t* count, uint64_t* lost_count) FAST_CAPTURE_NOEXCEPT
+    {
+        if ((events == nullptr && capacity != 0) || count == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        // 注入DLL崩溃后事件日志仍然可读，因此不检查心跳
+        std::lock_guard lock{request_lock_};
+        const auto& event_log = p_capture_descriptor_.Get()->event_log;
+        std::uint64_t total_lost_count = 0;
+        size_t drained_count = 0;
+        while (drained_count < capacity)
+        {
+            const auto write_position = event_log.write_position.load(std::memory_order_acquire);
+            if (event_read_position_ > write_position)
+                [[unlikely]]
+            {
+                // 注入DLL被重新注入，日志从头开始
+                event_read_position_ = 0;
+            }
+            if (event_read_position_ == write_position)
+            {
+                break;
+            }
+            if (write_position - event_read_position_ > CAPTURE_EVENT_LOG_CAPACITY)
+            {
+                const auto oldest_position = write_position - CAPTURE_EVENT_LOG_CAPACITY;
+                total_lost_count += oldest_position - event_read_position_;
+                event_read_position_ = oldest_position;
+            }
+            const auto& slot = event_log.slots[event_read_position_ % CAPTURE_EVENT_LOG_CAPACITY];
+            FastCaptureEvent event;
+            if (auto result = ReadSharedWithSeqLock(
+                    slot.seq_lock,
+                    FAST_CAPTURE_E_READ_CAPTURE_DESCRIPTOR_TIMEOUT,
+                    [&slot, &event]()
+                    { event = slot.event; });
+                !Utils::IsOk(result))
+            {
+                return result;
+            }
+            if (event.sequence != event_read_position_)
+            {
+                // 读取前此槽位已被覆盖，下一轮按新的写入位置跳过丢失的事件
+                continue;
+            }
+            events[drained_count++] = event;
+            ++event_read_position_;
+        }
+        *count = drained_count;
+        if (lost_count != nullptr)
+        {
+            *lost_count = total_lost_count;
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::RequestCaptureCounters(FastCaptureCounters* counters) FAST_CAPTURE_NOEXCEPT
+    {
+        if (counters == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        const auto& shared_counters = p_capture_descriptor->counters;
+        counters->published_frame_count = shared_counters.published_frame_count.load(std::memory_order_relaxed);
+        counters->repeated_frame_count = shared_counters.repeated_frame_count.load(std::memory_order_relaxed);
+        counters->dropped_frame_count = shared_counters.dropped_frame_count.load(std::memory_order_relaxed);
+        counters->pbo_ring_full_count = shared_counters.pbo_ring_full_count.load(std::memory_order_relaxed);
+        counters->capture_image_remap_count = shared_counters.capture_image_remap_count.load(std::memory_order_relaxed);
+        counters->reaped_subscriber_count = shared_counters.reaped_subscriber_count.load(std::memory_order_relaxed);
+        counters->event_count = p_capture_descriptor->event_log.write_position.load(std::memory_order_relaxed);
+        counters->pbo_ring_occupancy = shared_counters.pbo_ring_occupancy.load(std::memory_order_relaxed);
+        counters->deferred_frame_count = shared_counters.deferred_frame_count.load(std::memory_order_relaxed);
+        counters->budget_dropped_frame_count = shared_counters.budget_dropped_frame_count.load(std::memory_order_relaxed);
+        counters->swap_interval_us = shared_counters.swap_interval_us.load(std::memory_order_relaxed);
+        counters->coalesced_read_pixels_count = shared_counters.coalesced_read_pixels_count.load(std::memory_order_relaxed);
+        shared_counters.publish_latency.Load(&counters->publish_latency_us_sum, counters->publish_latency_buckets);
+        shared_counters.hook_cpu_cost.Load(&counters->hook_cpu_cost_ns_sum, counters->hook_cpu_cost_buckets);
+        shared_counters.hook_gpu_cost.Load(&counters->hook_gpu_cost_ns_sum, counters->hook_gpu_cost_buckets);
+        shared_counters.pack_gpu_cost.Load(&counters->pack_gpu_cost_ns_sum, counters->pack_gpu_cost_buckets);
+        counters->scheduling_generation = shared_counters.scheduling_generation.load(std::memory_order_relaxed);
+        shared_counters.pickup_latency.Load(&counters->pickup_latency_ns_sum, counters->pickup_latency_buckets);
+        shared_counters.readback_latency.Load(&counters->readback_latency_us_sum, counters->readback_latency_buckets);
+        shared_counters.publish_duration.Load(&counters->publish_duration_ns_sum, counters->publish_duration_buckets);
+        counters->copied_frame_count = copied_frame_count_.load(std::memory_order_relaxed);
+        counters->copied_bytes = copied_bytes_.load(std::memory_order_relaxed);
+        delivery_latency_.Load(&counters->delivery_latency_us_sum, counters->delivery_latency_buckets);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::SetCopyFlags(uint32_t copy_flags) FAST_CAPTURE_NOEXCEPT
+    {
+        copy_flags_.store(copy_flags, std::memory_order_relaxed);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    static_assert(static_cast<std::uint32_t>(Utils::PixelPipeline::PixelFormat::Rgba8) == FAST_CAPTURE_PIXEL_FORMAT_RGBA);
+    static_assert(static_cast<std::uint32_t>(Utils::PixelPipeline::PixelFormat::Bgra8) == FAST_CAPTURE_PIXEL_FORMAT_BGRA);
+    static_assert(static_cast<std::uint32_t>(Utils::PixelPipeline::PixelFormat::Rgb8) == FAST_CAPTURE_PIXEL_FORMAT_RGB);
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::SetColorOutput(const FastCaptureColorOutputDesc* desc) FAST_CAPTURE_NOEXCEPT
+    {
+        if (desc == nullptr
+            || desc->pixel_format > FAST_CAPTURE_PIXEL_FORMAT_RGB
+            || desc->orientation > FAST_CAPTURE_ORIENTATION_TOP_DOWN)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        // 颜色平面总是RGBA且第一行在底部，因此从上到下输出就是反转行序
+        const auto convert_color_output = Utils::PixelPipeline::SelectConvertFrame(
+            Utils::PixelPipeline::PixelFormat::Rgba8,
+            static_cast<Utils::PixelPipeline::PixelFormat>(desc->pixel_format),
+            desc->orientation == FAST_CAPTURE_ORIENTATION_TOP_DOWN,
+            desc->width != 0 && desc->height != 0);
+        std::lock_guard lock{request_lock_};
+        color_output_ = *desc;
+        convert_color_output_ = convert_color_output;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureClient::ResolveColorOutputRegion(
+        const CapturePlane& color_plane,
+        Utils::PixelPipeline::Region* p_out_region) const noexcept
+    {
+        const auto plane_width = static_cast<std::uint32_t>(color_plane.width);
+        const auto plane_height = static_cast<std::uint32_t>(color_plane.height);
+        if (color_output_.width == 0 || color_output_.height == 0)
+        {
+            *p_out_region = {0, 0, plane_width, plane_height};
+            return FastCaptureMakeSuccessValue();
+        }
+        // 用减法比较，x + width不会溢出
+        if (color_output_.x > plane_width || color_output_.width > plane_width - color_output_.x
+            || color_output_.y > plane_height || color_output_.height > plane_height - color_output_.y)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_COLOR_OUTPUT_REGION_OUT_OF_FRAME);
+        }
+        *p_out_region = {
+            color_output_.x,
+            plane_height - color_output_.y - color_output_.height,
+            color_output_.width,
+            color_output_.height};
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::RequestLatestColorOutputSize(size_t* size) FAST_CAPTURE_NOEXCEPT
+    {
+        if (size == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{request_lock_};
+        CaptureLayout layout;
+        if (auto result = BeginRequest(&layout); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto& color_plane = layout.planes[FAST_CAPTURE_PLANE_COLOR];
+        if (color_plane.size == 0)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_CAPTURE_IMAGE_NOT_READY);
+        }
+        Utils::PixelPipeline::Region region;
+        if (auto result = ResolveColorOutputRegion(color_plane, &region); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        *size = static_cast<std::size_t>(region.width) * region.height
+                * Utils::PixelPipeline::GetPixelSize(static_cast<Utils::PixelPipeline::PixelFormat>(color_output_.pixel_format));
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::CopyLatestColorOutput(char* p_memory, size_t memory_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT
+    {
+        if (p_memory == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{request_lock_};
+        CaptureLayout layout;
+        if (auto result = BeginRequest(&layout); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        if (auto result = MapCaptureImageIfNecessary(layout); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto p_capture_image = p_capture_image_.Get();
+        const auto convert_color_output = convert_color_output_;
+        const auto output_pixel_size =
+            Utils::PixelPipeline::GetPixelSize(static_cast<Utils::PixelPipeline::PixelFormat>(color_output_.pixel_format));
+        FastCaptureFrameInfo frame_info{};
+        FastCaptureErrorCode read_result{};
+        std::size_t read_output_size = 0;
+        // 描述信息中的布局可能已经属于下一帧，以图像头部中与数据一起写入的布局为准
+        if (auto result = ReadSharedWithSeqLock(
+                p_capture_image->seq_lock,
+                FAST_CAPTURE_E_READ_CAPTURE_IMAGE_TIMEOUT,
+                [this, p_capture_image, convert_color_output, output_pixel_size, p_memory, memory_size, &frame_info, &read_result, &read_output_size]()
+                {
+                    const auto image_color_plane = p_capture_image->planes[FAST_CAPTURE_PLANE_COLOR];
+                    if (image_color_plane.size == 0 || !IsPlaneMapped(image_color_plane))
+                    {
+                        read_result = Utils::MakeError(FAST_CAPTURE_E_CAPTURE_IMAGE_NOT_READY);
+                        return;
+                    }
+                    Utils::PixelPipeline::Region image_region;
+                    read_result = ResolveColorOutputRegion(image_color_plane, &image_region);
+                    if (!Utils::IsOk(read_result))
+                    {
+                        return;
+                    }
+                    read_output_size = static_cast<std::size_t>(image_region.width) * image_region.height * output_pixel_size;
+                    if (memory_size < read_output_size)
+                    {
+                        read_result = Utils::MakeError(FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+                        return;
+                    }
+                    frame_info.frame_index = p_capture_image->frame_index;
+                    frame_info.timestamp_us = p_capture_image->timestamp_us;
+                    convert_color_output(
+                        {p_capture_image->GetDataPointer() + image_color_plane.offset,
+                         static_cast<std::size_t>(image_color_plane.width) * image_color_plane.pixel_size,
+                         static_cast<std::uint32_t>(image_color_plane.width),
+                         static_cast<std::uint32_t>(image_color_plane.height)},
+                        image_region,
+                        reinterpret_cast<std::byte*>(p_memory));
+                });
+            !Utils::IsOk(result))
+        {
+            return result;
+        }
+        if (!Utils::IsOk(read_result))
+        {
+            return read_result;
+        }
+        copied_frame_count_.fetch_add(1, std::memory_order_relaxed);
+        copied_bytes_.fetch_add(read_output_size, std::memory_order_relaxed);
+        if (const auto now_us = Windows::GetTimestampUs(); now_us >= frame_info.timestamp_us)
+            [[likely]]
+        {
+            delivery_latency_.Record(now_us - frame_info.timestamp_us);
+        }
+        if (info != nullptr)
+        {
+            *info = frame_info;
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::RequestLatestCaptureSize(size_t* size) FAST_CAPTURE_NOEXCEPT
+    {
+        return RequestLatestCapturePlaneSize(FAST_CAPTURE_PLANE_COLOR, size);
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::CopyLatestCapture(char* p_memory, size_t memory_size) FAST_CAPTURE_NOEXCEPT
+    {
+        return CopyLatestCapturePlane(FAST_CAPTURE_PLANE_COLOR, p_memory, memory_size);
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::SetCaptureFlags(uint32_t capture_flags) FAST_CAPTURE_NOEXCEPT
+    {
+        std::lock_guard lock{request_lock_};
+        capture_flags_ = capture_flags;
+        if (auto result = KeepAlive(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        p_capture_descriptor_.Get()->subscribers[subscriber_index_].capture_flags.store(
+            capture_flags_,
+            std::memory_order_relaxed);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::SetDepthRange(float near_plane, float far_plane) FAST_CAPTURE_NOEXCEPT
+    {
+        if (!(near_plane > 0.0f) || !(far_plane > near_plane))
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        p_capture_descriptor->depth_near_plane.store(near_plane, std::memory_order_relaxed);
+        p_capture_descriptor->depth_far_plane.store(far_plane, std::memory_order_relaxed);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::RequestLatestCapturePlaneSize(uint32_t plane, size_t* size) FAST_CAPTURE_NOEXCEPT
+    {
+        if (size == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        FastCapturePlaneInfo info;
+        if (auto result = RequestLatestCapturePlaneInfo(plane, &info); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        *size = static_cast<size_t>(info.size);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::RequestLatestCapturePlaneInfo(uint32_t plane, FastCapturePlaneInfo* info) FAST_CAPTURE_NOEXCEPT
+    {
+        if (info == nullptr || plane >= FAST_CAPTURE_PLANE_COUNT)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{request_lock_};
+        CaptureLayout layout;
+        if (auto result = BeginRequest(&layout); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto& capture_plane = layout.planes[plane];
+        if (plane != FAST_CAPTURE_PLANE_COLOR && capture_plane.size == 0)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_CAPTURE_PLANE_NOT_ENABLED);
+        }
+        *info = FastCapturePlaneInfo{
+            capture_plane.width,
+            capture_plane.height,
+            capture_plane.pixel_size,
+            capture_plane.size,
+            capture_plane.format};
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::CopyLatestCapturePlane(uint32_t plane, char* p_memory, size_t memory_size) FAST_CAPTURE_NOEXCEPT
+    {
+        return CopyLatestCapturePlaneEx(plane, p_memory, memory_size, nullptr, nullptr);
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::CopyLatestCapturePlaneEx(uint32_t plane, char* p_memory, size_t memory_size, size_t* copied_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT
+    {
+        if (p_memory == nullptr || plane >= FAST_CAPTURE_PLANE_COUNT)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{request_lock_};
+        CaptureLayout layout;
+        if (auto result = BeginRequest(&layout); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        if (auto result = MapCaptureImageIfNecessary(layout); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto p_capture_image = p_capture_image_.Get();
+        // 注入DLL按所有客户端的并集选择深度格式，与此客户端需要的格式不同时不能把数据当作自己需要的格式交出
+        const auto expected_format =
+            plane == FAST_CAPTURE_PLANE_DEPTH ? GetDepthPlaneFormat(capture_flags_) : FAST_CAPTURE_PLANE_FORMAT_UNKNOWN;
+        FastCaptureFrameInfo frame_info{};
+        FastCaptureErrorCode read_result{};
+        std::size_t plane_size = 0;
+        // 描述信息中的布局可能已经属于下一帧，以图像头部中与数据一起写入的布局为准
+        if (auto result = ReadSharedWithSeqLock(
+                p_capture_image->seq_lock,
+                FAST_CAPTURE_E_READ_CAPTURE_IMAGE_TIMEOUT,
+                [this, p_capture_image, plane, expected_format, p_memory, memory_size, &frame_info, &read_result, &plane_size]()
+                {
+                    const auto image_plane = p_capture_image->planes[plane];
+                    if (image_plane.size == 0 || !IsPlaneMapped(image_plane))
+                    {
+                        read_result = Utils::MakeError(
+                            plane == FAST_CAPTURE_PLANE_COLOR ? FAST_CAPTURE_E_CAPTURE_IMAGE_NOT_READY : FAST_CAPTURE_E_CAPTURE_PLANE_NOT_ENABLED);
+                        return;
+                    }
+                    if (expected_format != FAST_CAPTURE_PLANE_FORMAT_UNKNOWN && image_plane.format != expected_format)
+                    {
+                        read_result = Utils::MakeError(FAST_CAPTURE_E_DEPTH_FORMAT_CONFLICT);
+                        return;
+                    }
+                    if (memory_size < image_plane.size)
+                    {
+                        read_result = Utils::MakeError(FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+                        return;
+                    }
+                    read_result = FastCaptureMakeSuccessValue();
+                    plane_size = static_cast<std::size_t>(image_plane.size);
+                    frame_info.frame_index = p_capture_image->frame_index;
+                    frame_info.timestamp_us = p_capture_image->timestamp_us;
+                    CopyPlaneData(p_memory, p_capture_image->GetDataPointer() + image_plane.offset, plane_size);
+                });
+            !Utils::IsOk(result))
+        {
+            return result;
+        }
+        if (!Utils::IsOk(read_result))
+        {
+            return read_result;
+        }
+        copied_frame_count_.fetch_add(1, std::memory_order_relaxed);
+        copied_bytes_.fetch_add(plane_size, std::memory_order_relaxed);
+        if (const auto now_us = Windows::GetTimestampUs(); now_us >= frame_info.timestamp_us)
+            [[likely]]
+        {
+            delivery_latency_.Record(now_us - frame_info.timestamp_us);
+        }
+        if (copied_size != nullptr)
+        {
+            *copied_size = plane_size;
+        }
+        if (info != nullptr)
+        {
+            *info = frame_info;
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::RequestLatestCaptureFrameInfo(FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT
+    {
+        if (info == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{request_lock_};
+        if (auto result = KeepAlive(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        if (auto result = CheckProducerAlive(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        // 读取期间发布了新帧时，repeat_count可能属于新帧，因此按0处理
+        info->frame_index = p_capture_descriptor->frame_index.load(std::memory_order_acquire);
+        info->repeat_count = p_capture_descriptor->repeat_count.load(std::memory_order_acquire);
+        info->timestamp_us = p_capture_descriptor->frame_timestamp_us.load(std::memory_order_relaxed);
+        if (p_capture_descriptor->frame_index.load(std::memory_order_acquire) != info->frame_index)
+        {
+            info->repeat_count = 0;
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::SetFrameCpuBudget(uint32_t cpu_budget_us) FAST_CAPTURE_NOEXCEPT
+    {
+        p_capture_descriptor_.Get()->frame_cpu_budget_us.store(cpu_budget_us, std::memory_order_relaxed);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::SetCaptureThreadScheduling(const FastCaptureThreadSchedulingDesc* desc) FAST_CAPTURE_NOEXCEPT
+    {
+        if (desc == nullptr
+            || (desc->flags & ~FAST_CAPTURE_SCHEDULING_FLAG_MASK) != 0
+            || !Windows::IsValidThreadPriority(desc->priority))
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        p_capture_descriptor->scheduling_affinity_mask.store(desc->affinity_mask, std::memory_order_relaxed);
+        p_capture_descriptor->scheduling_priority.store(desc->priority, std::memory_order_relaxed);
+        p_capture_descriptor->scheduling_flags.store(desc->flags, std::memory_order_relaxed);
+        p_capture_descriptor->scheduling_generation.fetch_add(1, std::memory_order_release);
+        // 读回线程可能在等待一个心跳间隔，唤醒它以便尽快应用
+        if (!h_attach_event_.IsInvalid())
+        {
+            ::SetEvent(h_attach_event_.Get());
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::RequestFrameEventHandle(void** handle) FAST_CAPTURE_NOEXCEPT
+    {
+        if (handle == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{request_lock_};
+        if (auto result = KeepAlive(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto h_wait_frame_event = GetFrameEvent();
+        if (h_wait_frame_event == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_FRAME_EVENT_NOT_AVAILABLE);
+        }
+        *handle = h_wait_frame_event;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureClient::NotifyNewFrame(uint64_t last_frame_index, uint32_t timeout_ms, FastCaptureNewFrameCallback callback, void* context) FAST_CAPTURE_NOEXCEPT
+    {
+        if (callback == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{request_lock_};
+        if (is_closing_.load(std::memory_order_acquire))
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_FRAME_NOTIFICATION_CANCELLED);
+        }
+        if (is_frame_notification_pending_.load(std::memory_order_acquire))
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_FRAME_NOTIFICATION_PENDING);
+        }
+        if (auto result = KeepAlive(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto h_wait_frame_event = GetFrameEvent();
+        if (h_wait_frame_event == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_FRAME_EVENT_NOT_AVAILABLE);
+        }
+        if (p_frame_wait_ == nullptr)
+        {
+            p_frame_wait_ = ::CreateThreadpoolWait(&OnFrameWait, this, nullptr);
+            if (p_frame_wait_ == nullptr)
+            {
+                return Windows::MakeError(FAST_CAPTURE_E_CREATE_FRAME_NOTIFICATION_FAILED);
+            }
+        }
+        frame_callback_ = callback;
+        frame_callback_context_ = context;
+        h_notification_frame_event_ = h_wait_frame_event;
+        notification_frame_index_ = last_frame_index;
+        notification_deadline_ms_ = timeout_ms == FAST_CAPTURE_TIMEOUT_INFINITE
+                                        ? UINT64_MAX
+                                        : ::GetTickCount64() + timeout_ms;
+        is_frame_notification_pending_.store(true, std::memory_order_release);
+        // 已经有新帧时以0超时等待，回调立即在线程池中执行。之后发布的帧会设置事件，不会被错过
+        const auto frame_index = p_capture_descriptor_.Get()->frame_index.load(std::memory_order_acquire);
+        ArmFrameWait(frame_index != last_frame_index ? 0 : timeout_ms);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    void FastCaptureClient::ArmFrameWait(const std::uint32_t timeout_ms) noexcept
+    {
+        if (timeout_ms == FAST_CAPTURE_TIMEOUT_INFINITE)
+        {
+            ::SetThreadpoolWait(p_frame_wait_, h_notification_frame_event_, nullptr);
+            return;
+        }
+        // 负值表示相对时间，单位为100纳秒
+        ULARGE_INTEGER due_time;
+        due_time.QuadPart = static_cast<ULONGLONG>(-static_cast<LONGLONG>(timeout_ms) * 10000);
+        FILETIME timeout;
+        timeout.dwLowDateTime = due_time.u.LowPart;
+        timeout.dwHighDateTime = due_time.u.HighPart;
+        ::SetThreadpoolWait(p_frame_wait_, h_notification_frame_event_, &timeout);
+    }
+
+    void FastCaptureClient::CompleteFrameNotification(const FastCaptureErrorCode result) noexcept
+    {
+        const auto callback = frame_callback_;
+        const auto context = frame_callback_context_;
+        is_frame_notification_pending_.store(false, std::memory_order_release);
+        callback(context, result);
+    }
+
+    VOID CALLBACK FastCaptureClient::OnFrameWait(PTP_CALLBACK_INSTANCE, PVOID context, PTP_WAIT, TP_WAIT_RESULT wait_result)
+    {
+        auto const p_this = static_cast<FastCaptureClient*>(context);
+        if (wait_result != WAIT_OBJECT_0 && wait_result != WAIT_TIMEOUT)
+        {
+            p_this->CompleteFrameNotification(Windows::MakeError(FAST_CAPTURE_E_WAIT_RESULT_UNEXPECTED));
+            return;
+        }
+        const auto frame_index = p_this->p_capture_descriptor_.Get()->frame_index.load(std::memory_order_acquire);
+        if (frame_index != p_this->notification_frame_index_)
+        {
+            p_this->CompleteFrameNotification(FastCaptureMakeSuccessValue());
+            return;
+        }
+        // 事件由调用者已经看到的帧设置，以剩余的时间继续等待
+        const auto now_ms = ::GetTickCount64();
+        if (wait_result == WAIT_OBJECT_0 && now_ms < p_this->notification_deadline_ms_)
+        {
+            p_this->ArmFrameWait(
+                p_this->notification_deadline_ms_ == UINT64_MAX
+                    ? FAST_CAPTURE_TIMEOUT_INFINITE
+                    : static_cast<std::uint32_t>(p_this->notification_deadline_ms_ - now_ms));
+            return;
+        }
+        p_this->CompleteFrameNotification(Utils::MakeError(FAST_CAPTURE_E_WAIT_NEW_FRAME_TIMEOUT));
+    }
+}
@@ -0,0 +1,279 @@
+#ifndef FAST_CAPTURE_WINDOWS_FAST_CAPTURE_CLIENT_H
+#define FAST_CAPTURE_WINDOWS_FAST_CAPTURE_CLIENT_H
+
+#include "FastCapture.h"
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include "../../FastCaptureInjectDll/FastCaptureInjectDllDef.h"
+#include "../../Utils/PixelPipeline.hpp"
+#include "../../Utils/Windows/UtilsWindows.hpp"
+#include "BrokerProtocol.h"
+#include "../../FastCaptureInjectDll/Windows/FrameEvents.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    class FastCaptureClient final : public IFastCaptureClient
+    {
+    public:
+        /**
+         * @brief 在顺序锁保护下从描述信息中读出的一致的快照
+         *
+         */
+        struct CaptureLayout
+        {
+            std::uint32_t capture_image_generation{};
+            CapturePlane planes[FAST_CAPTURE_PLANE_COUNT]{};
+        };
+
+    private:
+        std::wstring shared_memory_name_prefix_{};
+        Windows::UniqueHandleInvalidNULL h_capture_descriptor_{nullptr};
+        Windows::UniqueMapViewOfFile<CaptureDescriptor> p_capture_descriptor_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_capture_image_{nullptr};
+        Windows::UniqueMapViewOfFile<CaptureImage> p_capture_image_{nullptr};
+        /**
+         * @brief 通过代理连接时有效，此时共享内存的句柄由代理复制而来，不按名称打开
+         *
+         */
+        Windows::UniqueHandleInvalidMinusOne h_broker_pipe_{INVALID_HANDLE_VALUE};
+        /**
+         * @brief 目标发布新帧时被设置的AUTO_RESET事件，在初始化时确定，客户端的整个生命周期内不变，
+            因此可以不加锁地读取，线程池的等待和使用者也可以一直持有。
+            通过代理连接时由代理设置，直接连接时由此客户端从槽位的事件转发
+         *
+         */
+        Windows::UniqueHandleInvalidNULL h_frame_event_{nullptr};
+        /**
+         * @brief h_frame_event_是否会被设置。直接连接旧的注入DLL时槽位没有事件，此时WaitForNewFrame轮询frame_index
+         *
+         */
+        std::atomic<bool> is_frame_event_available_{false};
+        /**
+         * @brief 注入DLL创建的具名AUTO_RESET事件，占用槽位后设置它以立即唤醒休眠中的读回线程。
+            打开失败时读回线程在下一次心跳时才会发现此客户端
+         *
+         */
+        Windows::UniqueHandleInvalidNULL h_attach_event_{nullptr};
+        /**
+         * @brief 直接连接时生产者为此客户端的槽位创建的AUTO_RESET事件，每次占用槽位后重新打开。
+            只由转发的等待使用，不会交给使用者
+         *
+         */
+        Windows::UniqueHandleInvalidNULL h_subscriber_frame_event_{nullptr};
+        /**
+         * @brief 把h_subscriber_frame_event_转发到h_frame_event_的等待，声明在两个事件之后，先于它们被注销
+         *
+         */
+        Windows::UniqueRegisteredWait h_subscriber_frame_wait_{nullptr};
+        /**
+         * @brief NotifyNewFrame使用的线程池等待，第一次调用时创建。以下成员在等待期间只由线程池的回调访问
+         *
+         */
+        PTP_WAIT p_frame_wait_{nullptr};
+        std::atomic<bool> is_frame_notification_pending_{false};
+        std::atomic<bool> is_closing_{false};
+        FastCaptureNewFrameCallback frame_callback_{nullptr};
+        void* frame_callback_context_{nullptr};
+        HANDLE h_notification_frame_event_{nullptr};
+        std::uint64_t notification_frame_index_{0};
+        std::uint64_t notification_deadline_ms_{0};
+        /**
+         * @brief 当前映射的图像共享内存的代数，0表示尚未映射
+         *
+         */
+        std::uint32_t capture_image_mapped_generation_{0};
+        /**
+         * @brief 映射的图像数据部分（头部之后）的字节数。同一代数内布局可能变化，
+            因此映射整个共享内存，平面超出此大小时不读取
+         *
+         */
+        std::size_t capture_image_mapped_data_size_{0};
+        std::size_t subscriber_index_{MAX_SUBSCRIBER_COUNT};
+        /**
+         * @brief 占用subscriber_index_时写入的SubscriberSlot::owner，与槽位中的值不同表示已被回收
+         *
+         */
+        std::uint64_t subscriber_owner_{0};
+        std::uint32_t capture_flags_{FAST_CAPTURE_FLAG_NONE};
+        std::atomic<std::uint32_t> copy_flags_{FAST_CAPTURE_COPY_FLAG_NONE};
+        FastCaptureColorOutputDesc color_output_{
+            FAST_CAPTURE_PIXEL_FORMAT_RGBA,
+            FAST_CAPTURE_ORIENTATION_BOTTOM_UP,
+            0,
+            0,
+            0,
+            0};
+        /**
+         * @brief 在SetColorOutput中按color_output_选出的转换函数
+         *
+         */
+        Utils::PixelPipeline::ConvertFrameFunction convert_color_output_{
+            Utils::PixelPipeline::SelectConvertFrame(
+                Utils::PixelPipeline::PixelFormat::Rgba8,
+                Utils::PixelPipeline::PixelFormat::Rgba8,
+                false,
+                false)};
+        /**
+         * @brief 此客户端在事件日志中的读取位置，即下一个要取出的事件的序号
+         *
+         */
+        std::uint64_t event_read_position_{0};
+        std::atomic<std::uint64_t> copied_frame_count_{0};
+        std::atomic<std::uint64_t> copied_bytes_{0};
+        /**
+         * @brief 从被Hook的函数复制帧到此客户端复制完成的延迟
+         *
+         */
+        LatencyHistogram delivery_latency_{};
+        constexpr static std::size_t PARALLEL_COPY_MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+        /**
+         * @brief 客户端可能同时被使用者和FastCaptureHistory的后台线程调用，保护以上成员
+         *
+         */
+        std::mutex request_lock_{};
+
+        /**
+         * @brief 刷新自己的心跳，若槽位已被注入DLL回收则重新注册
+         *
+         */
+        FastCaptureErrorCode KeepAlive() noexcept;
+        FastCaptureErrorCode MapCaptureDescriptor() noexcept;
+        FastCaptureErrorCode TransactBroker(const Windows::Broker::Request& request, Windows::Broker::Response* p_out_response) noexcept;
+        /**
+         * @brief 按名称打开，或通过代理获得图像共享内存的句柄
+         *
+         */
+        FastCaptureErrorCode OpenCaptureImage(const std::uint32_t capture_image_generation) noexcept;
+        FastCaptureErrorCode CheckProducerAlive() const noexcept;
+        /**
+         * @brief 重新打开当前槽位的事件并转发到h_frame_event_，需要持有request_lock_
+         *
+         */
+        void ForwardSubscriberFrameEvent() noexcept;
+        static VOID CALLBACK OnSubscriberFrameEvent(PVOID context, BOOLEAN);
+        /**
+         * @brief 不需要持有request_lock_，h_frame_event_不会被设置时返回nullptr
+         *
+         */
+        HANDLE GetFrameEvent() const noexcept;
+        /**
+         * @brief 以剩余的超时时间等待h_notification_frame_event_
+         *
+         */
+        void ArmFrameWait(const std::uint32_t timeout_ms) noexcept;
+        /**
+         * @brief 结束等待中的通知并调用回调，回调中可以再次调用NotifyNewFrame
+         *
+         */
+        void CompleteFrameNotification(const FastCaptureErrorCode result) noexcept;
+        static VOID CALLBACK OnFrameWait(PTP_CALLBACK_INSTANCE, PVOID context, PTP_WAIT, TP_WAIT_RESULT wait_result);
+        /**
+         * @brief 在共享内存的顺序锁保护下读取。超时时生产者仍有心跳则返回timeout_error_code，
+            否则返回FAST_CAPTURE_E_PRODUCER_NOT_RESPONDING
+         *
+         */
+        template <class F>
+        FastCaptureErrorCode ReadSharedWithSeqLock(
+            const Utils::SeqLock& lock,
+            const std::uint16_t timeout_error_code,
+            F&& read_function) const noexcept
+        {
+            switch (Utils::ReadWithSeqLock(
+                lock,
+                SEQ_LOCK_READ_TIMEOUT,
+                [this]()
+                { return Utils::IsOk(CheckProducerAlive()); },
+                std::forward<F>(read_function)))
+            {
+            case Utils::SeqLockReadResult::Ok:
+                return FastCaptureMakeSuccessValue();
+            case Utils::SeqLockReadResult::WriterDead:
+                return Utils::MakeError(FAST_CAPTURE_E_PRODUCER_NOT_RESPONDING);
+            default:
+                return Utils::MakeError(timeout_error_code);
+            }
+        }
+        FastCaptureErrorCode ReadLatestCaptureLayout(CaptureLayout* p_out_layout) const noexcept;
+        /**
+         * @brief 图像共享内存的代数变化时重新映射
+         *
+         */
+        FastCaptureErrorCode MapCaptureImageIfNecessary(const CaptureLayout& layout) noexcept;
+        /**
+         * @brief 平面是否完全位于已映射的图像数据中
+         *
+         */
+        bool IsPlaneMapped(const CapturePlane& capture_plane) const noexcept;
+        /**
+         * @brief 心跳检查并读出最新的布局，客户端的每个接口都应该先调用此函数
+         *
+         */
+        FastCaptureErrorCode BeginRequest(CaptureLayout* p_out_layout) noexcept;
+        /**
+         * @brief 按copy_flags_复制一个平面，在顺序锁的读取区间内调用
+         *
+         */
+        void CopyPlaneData(char* p_destination, const std::byte* p_source, const std::size_t size) const noexcept;
+        /**
+         * @brief 把color_output_的区域换算为颜色平面中的区域，颜色平面的第一行在画面底部
+         *
+         */
+        FastCaptureErrorCode ResolveColorOutputRegion(
+            const CapturePlane& color_plane,
+            Utils::PixelPipeline::Region* p_out_region) const noexcept;
+
+    public:
+        FastCaptureClient() = default;
+        ~FastCaptureClient();
+        FastCaptureClient(const FastCaptureClient&) = delete;
+        FastCaptureClient& operator=(const FastCaptureClient&) = delete;
+
+        FastCaptureErrorCode Initialize(const std::wstring& shared_memory_name_prefix) noexcept;
+        FastCaptureErrorCode InitializeFromBroker(const wchar_t* pipe_name, const DWORD process_id) noexcept;
+
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestLatestCaptureSize(size_t* size) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        CopyLatestCapture(char* p_memory, size_t memory_size) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetCaptureFlags(uint32_t capture_flags) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetDepthRange(float near_plane, float far_plane) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestLatestCapturePlaneSize(uint32_t plane, size_t* size) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        CopyLatestCapturePlane(uint32_t plane, char* p_memory, size_t memory_size) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestLatestCapturePlaneInfo(uint32_t plane, FastCapturePlaneInfo* info) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestLatestCaptureFrameInfo(FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        CopyLatestCapturePlaneEx(uint32_t plane, char* p_memory, size_t memory_size, size_t* copied_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetCopyFlags(uint32_t copy_flags) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        WaitForNewFrame(uint32_t timeout_ms) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        DrainCaptureEvents(FastCaptureEvent* events, size_t capacity, size_t* count, uint64_t* lost_count) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestCaptureCounters(FastCaptureCounters* counters) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetColorOutput(const FastCaptureColorOutputDesc* desc) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestLatestColorOutputSize(size_t* size) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        CopyLatestColorOutput(char* p_memory, size_t memory_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetFrameCpuBudget(uint32_t cpu_budget_us) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        SetCaptureThreadScheduling(const FastCaptureThreadSchedulingDesc* desc) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestFrameEventHandle(void** handle) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        NotifyNewFrame(uint64_t last_frame_index, uint32_t timeout_ms, FastCaptureNewFrameCallback callback, void* context) FAST_CAPTURE_NOEXCEPT override;
+    };
+}
+
+#endif // FAST_CAPTURE_WINDOWS_FAST_CAPTURE_CLIENT_H
@@ -0,0 +1,564 @@
+#include "FastCaptureMetricsExporter.h"
+#include <algorithm>
+#include <cstdio>
+#include <new>
+#include <ws2tcpip.h>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Details
+    {
+        struct CounterMetric
+        {
+            const char* name;
+            const char* type;
+            const char* help;
+            std::uint64_t FastCaptureCounters::*p_member;
+        };
+        constexpr CounterMetric COUNTER_METRICS[] = {
+            {"fastcapture_published_frames_total", "counter", "Frames written to shared memory by the producer.", &FastCaptureCounters::published_frame_count},
+            {"fastcapture_repeated_frames_total", "counter", "Frames skipped because they matched the previous frame.", &FastCaptureCounters::repeated_frame_count},
+            {"fastcapture_dropped_frames_total", "counter", "Frames overwritten by a newer frame before readback.", &FastCaptureCounters::dropped_frame_count},
+            {"fastcapture_pbo_ring_full_total", "counter", "Frames discarded because every PBO slot was waiting for the GPU.", &FastCaptureCounters::pbo_ring_full_count},
+            {"fastcapture_capture_image_remaps_total", "counter", "Times the shared capture image was recreated with a larger size.", &FastCaptureCounters::capture_image_remap_count},
+            {"fastcapture_reaped_subscribers_total", "counter", "Client slots reclaimed after a heartbeat timeout.", &FastCaptureCounters::reaped_subscriber_count},
+            {"fastcapture_events_total", "counter", "Records written to the producer event log.", &FastCaptureCounters::event_count},
+            {"fastcapture_pbo_ring_occupancy", "gauge", "Frames submitted for readback and still waiting for the GPU.", &FastCaptureCounters::pbo_ring_occupancy},
+            {"fastcapture_deferred_frames_total", "counter", "Frames whose publishing was deferred at least once to stay within the frame CPU budget or the idle window.", &FastCaptureCounters::deferred_frame_count},
+            {"fastcapture_budget_dropped_frames_total", "counter", "Deferred frames discarded to make room for newer frames.", &FastCaptureCounters::budget_dropped_frame_count},
+            {"fastcapture_swap_interval_microseconds", "gauge", "Moving average of the target's swap interval.", &FastCaptureCounters::swap_interval_us},
+            {"fastcapture_coalesced_read_pixels_total", "counter", "Readback requests merged into a pending one instead of waking the producer thread again.", &FastCaptureCounters::coalesced_read_pixels_count},
+            {"fastcapture_scheduling_generation", "gauge", "Generation of the producer thread scheduling settings the stage latencies were measured under.", &FastCaptureCounters::scheduling_generation},
+            {"fastcapture_copied_frames_total", "counter", "Frames copied out of shared memory by this client.", &FastCaptureCounters::copied_frame_count},
+            {"fastcapture_copied_bytes_total", "counter", "Bytes copied out of shared memory by this client.", &FastCaptureCounters::copied_bytes},
+        };
+
+        /**
+         * @brief 第i个桶（最后一个桶除外）的上界为(first_bucket_bound_ns<<i)纳秒，和为sum_unit_ns纳秒的倍数
+         *
+         */
+        template <std::size_t BucketCount>
+        struct HistogramMetric
+        {
+            const char* name;
+            const char* help;
+            std::uint64_t FastCaptureCounters::*p_sum;
+            std::uint64_t (FastCaptureCounters::*p_buckets)[BucketCount];
+            std::uint64_t sum_unit_ns;
+            std::uint64_t first_bucket_bound_ns;
+        };
+        constexpr HistogramMetric<FAST_CAPTURE_LATENCY_BUCKET_COUNT> LATENCY_HISTOGRAM_METRICS[] = {
+            {"fastcapture_publish_latency_seconds",
+             "Time from the hooked swap to the frame being published in shared memory.",
+             &FastCaptureCounters::publish_latency_us_sum,
+             &FastCaptureCounters::publish_latency_buckets,
+             1000,
+             1000000},
+            {"fastcapture_delivery_latency_seconds",
+             "Time from the hooked swap to this client finishing its copy.",
+             &FastCaptureCounters::delivery_latency_us_sum,
+             &FastCaptureCounters::delivery_latency_buckets,
+             1000,
+             1000000},
+            {"fastcapture_readback_latency_seconds",
+             "Time from submitting the readback commands to the producer taking the frame out of the PBO ring.",
+             &FastCaptureCounters::readback_latency_us_sum,
+             &FastCaptureCounters::readback_latency_buckets,
+             1000,
+             1000000},
+        };
+        constexpr HistogramMetric<FAST_CAPTURE_COST_BUCKET_COUNT> COST_HISTOGRAM_METRICS[] = {
+            {"fastcapture_hook_cpu_cost_seconds",
+             "CPU time the capture work adds to the target's swap call.",
+             &FastCaptureCounters::hook_cpu_cost_ns_sum,
+             &FastCaptureCounters::hook_cpu_cost_buckets,
+             1,
+             10000},
+            {"fastcapture_hook_gpu_cost_seconds",
+             "GPU time of the copy commands submitted in the target's swap call.",
+             &FastCaptureCounters::hook_gpu_cost_ns_sum,
+             &FastCaptureCounters::hook_gpu_cost_buckets,
+             1,
+             10000},
+            {"fastcapture_pack_gpu_cost_seconds",
+             "GPU time of the mipmap and readback commands submitted by the producer thread.",
+             &FastCaptureCounters::pack_gpu_cost_ns_sum,
+             &FastCaptureCounters::pack_gpu_cost_buckets,
+             1,
+             10000},
+            {"fastcapture_pickup_latency_seconds",
+             "Time from the hooked swap submitting a frame to the producer thread picking it up.",
+             &FastCaptureCounters::pickup_latency_ns_sum,
+             &FastCaptureCounters::pickup_latency_buckets,
+             1,
+             10000},
+            {"fastcapture_publish_duration_seconds",
+             "Wall time the producer thread spends writing one frame to shared memory.",
+             &FastCaptureCounters::publish_duration_ns_sum,
+             &FastCaptureCounters::publish_duration_buckets,
+             1,
+             10000},
+        };
+
+        /**
+         * @brief 按Prometheus文本格式转义标签值
+         *
+         */
+        inline void AppendLabelValue(std::string& out, const std::string& value)
+        {
+            for (const auto c : value)
+            {
+                switch (c)
+                {
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                default:
+                    out += c;
+                    break;
+                }
+            }
+        }
+
+        inline void AppendNanosecondsAsSeconds(std::string& out, const std::uint64_t value_ns)
+        {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%llu.%09llu",
+                          static_cast<unsigned long long>(value_ns / 1000000000),
+                          static_cast<unsigned long long>(value_ns % 1000000000));
+            out += buffer;
+        }
+
+        inline void AppendHeader(std::string& out, const char* name, const char* type, const char* help)
+        {
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            out += help;
+            out += "\n# TYPE ";
+            out += name;
+            out += ' ';
+            out += type;
+            out += '\n';
+        }
+
+        /**
+         * @brief 输出name{target="label"[,extra_label]} value
+         *
+         */
+        inline void AppendSample(
+            std::string& out,
+            const char* name,
+            const char* suffix,
+            const std::string& label,
+            const char* extra_label,
+            const std::string& value)
+        {
+            out += name;
+            out += suffix;
+            out += "{target=\"";
+            AppendLabelValue(out, label);
+            out += '"';
+            if (extra_label != nullptr)
+            {
+                out += ',';
+                out += extra_label;
+            }
+            out += "} ";
+            out += value;
+            out += '\n';
+        }
+
+        /**
+         * @brief 按Prometheus的histogram类型输出每个目标的累计桶、和与样本数
+         *
+         */
+        template <class Snapshots, std::size_t BucketCount, std::size_t MetricCount>
+        void AppendHistogramMetrics(
+            std::string& out,
+            const Snapshots& snapshots,
+            const HistogramMetric<BucketCount> (&metrics)[MetricCount])
+        {
+            for (const auto& metric : metrics)
+            {
+                AppendHeader(out, metric.name, "histogram", metric.help);
+                for (const auto& snapshot : snapshots)
+                {
+                    const auto& buckets = snapshot.counters.*metric.p_buckets;
+                    std::uint64_t cumulative_count = 0;
+                    for (std::size_t i = 0; i < BucketCount; ++i)
+                    {
+                        cumulative_count += buckets[i];
+                        std::string le_label{"le=\""};
+                        if (i + 1 == BucketCount)
+                        {
+                            le_label += "+Inf";
+                        }
+                        else
+                        {
+                            AppendNanosecondsAsSeconds(le_label, metric.first_bucket_bound_ns << i);
+                        }
+                        le_label += '"';
+                        AppendSample(
+                            out,
+                            metric.name,
+                            "_bucket",
+                            snapshot.p_target->label,
+                            le_label.c_str(),
+                            std::to_string(cumulative_count));
+                    }
+                    std::string sum{};
+                    AppendNanosecondsAsSeconds(sum, snapshot.counters.*metric.p_sum * metric.sum_unit_ns);
+                    AppendSample(out, metric.name, "_sum", snapshot.p_target->label, nullptr, sum);
+                    AppendSample(out, metric.name, "_count", snapshot.p_target->label, nullptr, std::to_string(cumulative_count));
+                }
+            }
+        }
+    }
+
+    FastCaptureMetricsExporter::~FastCaptureMetricsExporter()
+    {
+        if (!h_exporter_thread_.IsInvalid())
+        {
+            ::SetEvent(h_stop_event_.Get());
+            ::WaitForSingleObject(h_exporter_thread_.Get(), INFINITE);
+        }
+        listen_socket_ = INVALID_SOCKET;
+        if (is_wsa_started_)
+        {
+            ::WSACleanup();
+        }
+    }
+
+    FastCaptureErrorCode FastCaptureMetricsExporter::Listen() noexcept
+    {
+        WSADATA wsa_data;
+        if (::WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_METRICS_SOCKET_FAILED);
+        }
+        is_wsa_started_ = true;
+        listen_socket_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listen_socket_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_METRICS_SOCKET_FAILED);
+        }
+        // 只监听本机，指标不应暴露给其它机器
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = ::htons(desc_.port);
+        address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if (::bind(listen_socket_.Get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR
+            || ::listen(listen_socket_.Get(), SOMAXCONN) == SOCKET_ERROR)
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_METRICS_SOCKET_FAILED);
+        }
+        h_accept_event_ = ::CreateEventW(
+            nullptr,
+            FALSE,
+            FALSE,
+            nullptr);
+        if (h_accept_event_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_METRICS_SOCKET_FAILED);
+        }
+        // 此后监听套接字为非阻塞的
+        if (::WSAEventSelect(listen_socket_.Get(), h_accept_event_.Get(), FD_ACCEPT) == SOCKET_ERROR)
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_METRICS_SOCKET_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureMetricsExporter::Initialize(const FastCaptureMetricsExporterDesc& desc) noexcept
+    {
+        desc_ = desc;
+        if (desc.text_file_path != nullptr)
+        {
+            text_file_path_ = desc.text_file_path;
+        }
+        h_stop_event_ = ::CreateEventW(
+            nullptr,
+            TRUE,
+            FALSE,
+            nullptr);
+        if (h_stop_event_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_METRICS_EXPORTER_THREAD_FAILED);
+        }
+        if (desc.port != 0)
+        {
+            if (auto result = Listen(); !Utils::IsOk(result))
+            {
+                return result;
+            }
+        }
+        h_exporter_thread_ = ::CreateThread(
+            nullptr,
+            0,
+            &Do,
+            this,
+            0,
+            nullptr);
+        if (h_exporter_thread_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_METRICS_EXPORTER_THREAD_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    std::string FastCaptureMetricsExporter::RenderMetrics()
+    {
+        std::vector<TargetSnapshot> snapshots{};
+        std::lock_guard lock{lock_};
+        snapshots.reserve(targets_.size());
+        for (const auto& target : targets_)
+        {
+            TargetSnapshot snapshot{&target};
+            if (!Utils::IsOk(target.p_client->RequestCaptureCounters(&snapshot.counters)))
+            {
+                continue;
+            }
+            FastCaptureFrameInfo frame_info;
+            snapshot.is_producer_up = Utils::IsOk(target.p_client->RequestLatestCaptureFrameInfo(&frame_info));
+            snapshots.push_back(snapshot);
+        }
+
+        std::string result{};
+        Details::AppendHeader(result, "fastcapture_producer_up", "gauge", "Whether the injected producer is alive.");
+        for (const auto& snapshot : snapshots)
+        {
+            Details::AppendSample(result, "fastcapture_producer_up", "", snapshot.p_target->label, nullptr, snapshot.is_producer_up ? "1" : "0");
+        }
+        for (const auto& metric : Details::COUNTER_METRICS)
+        {
+            Details::AppendHeader(result, metric.name, metric.type, metric.help);
+            for (const auto& snapshot : snapshots)
+            {
+                Details::AppendSample(
+                    result,
+                    metric.name,
+                    "",
+                    snapshot.p_target->label,
+                    nullptr,
+                    std::to_string(snapshot.counters.*metric.p_member));
+            }
+        }
+        Details::AppendHistogramMetrics(result, snapshots, Details::LATENCY_HISTOGRAM_METRICS);
+        Details::AppendHistogramMetrics(result, snapshots, Details::COST_HISTOGRAM_METRICS);
+        return result;
+    }
+
+    void FastCaptureMetricsExporter::ServeScrapes() noexcept
+    {
+        while (true)
+        {
+            Windows::UniqueSocket connection = ::accept(listen_socket_.Get(), nullptr, nullptr);
+            if (connection.IsInvalid())
+            {
+                // WSAEWOULDBLOCK，没有更多等待中的连接
+                return;
+            }
+            // 接受的套接字继承了监听套接字的事件选择和非阻塞模式，改回阻塞模式并设置超时，避免慢的对端拖住线程
+            ::WSAEventSelect(connection.Get(), nullptr, 0);
+            u_long is_non_blocking = 0;
+            ::ioctlsocket(connection.Get(), FIONBIO, &is_non_blocking);
+            const DWORD timeout_ms = SCRAPE_TIMEOUT_MS;
+            ::setsockopt(connection.Get(), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+            ::setsockopt(connection.Get(), SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+
+            std::string request{};
+            char buffer[1024];
+            while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_SCRAPE_REQUEST_SIZE)
+            {
+                const auto received_size = ::recv(connection.Get(), buffer, static_cast<int>(sizeof(buffer)), 0);
+                if (received_size <= 0)
+                {
+                    break;
+                }
+                request.append(buffer, static_cast<std::size_t>(received_size));
+            }
+            if (request.find("\r\n\r\n") == std::string::npos)
+            {
+                continue;
+            }
+            std::string body;
+            try
+            {
+                body = RenderMetrics();
+            }
+            catch (...)
+            {
+                continue;
+            }
+            std::string response =
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                "Connection: close\r\n"
+                "Content-Length: "
+                + std::to_string(body.size()) + "\r\n\r\n" + body;
+            for (std::size_t sent_size = 0; sent_size < response.size();)
+            {
+                const auto result = ::send(
+                    connection.Get(),
+                    response.data() + sent_size,
+                    static_cast<int>((std::min)(response.size() - sent_size, std::size_t{1} << 20)),
+                    0);
+                if (result <= 0)
+                {
+                    break;
+                }
+                sent_size += static_cast<std::size_t>(result);
+            }
+            ::shutdown(connection.Get(), SD_BOTH);
+        }
+    }
+
+    void FastCaptureMetricsExporter::WriteTextFile() noexcept
+    {
+        std::string body;
+        try
+        {
+            body = RenderMetrics();
+        }
+        catch (...)
+        {
+            return;
+        }
+        // 先写入临时文件再替换，node_exporter不会读到写了一半的文件
+        const auto temporary_file_path = text_file_path_ + L".tmp";
+        {
+            Windows::UniqueHandleInvalidMinusOne h_file = ::CreateFileW(
+                temporary_file_path.c_str(),
+                GENERIC_WRITE,
+                0,
+                nullptr,
+                CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr);
+            if (h_file.IsInvalid())
+            {
+                return;
+            }
+            DWORD written_size = 0;
+            if (!::WriteFile(h_file.Get(), body.data(), static_cast<DWORD>(body.size()), &written_size, nullptr)
+                || written_size != body.size())
+            {
+                return;
+            }
+        }
+        ::MoveFileExW(temporary_file_path.c_str(), text_file_path_.c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+
+    DWORD WINAPI FastCaptureMetricsExporter::Do(LPVOID lpThreadParameter)
+    {
+        auto p_this = static_cast<FastCaptureMetricsExporter*>(lpThreadParameter);
+        HANDLE wait_handles[2] = {p_this->h_stop_event_.Get()};
+        DWORD wait_handle_count = 1;
+        if (!p_this->h_accept_event_.IsInvalid())
+        {
+            wait_handles[wait_handle_count++] = p_this->h_accept_event_.Get();
+        }
+        const bool is_text_file_enabled = !p_this->text_file_path_.empty();
+        const auto text_file_interval_ms = (std::max)(p_this->desc_.text_file_interval_ms, 1u);
+        auto next_write_ms = ::GetTickCount64();
+        while (true)
+        {
+            DWORD timeout_ms = INFINITE;
+            if (is_text_file_enabled)
+            {
+                const auto now_ms = ::GetTickCount64();
+                if (now_ms >= next_write_ms)
+                {
+                    p_this->WriteTextFile();
+                    next_write_ms = now_ms + text_file_interval_ms;
+                }
+                timeout_ms = static_cast<DWORD>(next_write_ms - now_ms);
+            }
+            switch (::WaitForMultipleObjects(wait_handle_count, wait_handles, FALSE, timeout_ms))
+            {
+            case WAIT_OBJECT_0:
+                return 0;
+            case WAIT_OBJECT_0 + 1:
+                p_this->ServeScrapes();
+                break;
+            case WAIT_TIMEOUT:
+                break;
+            default:
+                return 0;
+            }
+        }
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureMetricsExporter::AddClient(IFastCaptureClient* client, const char* target_label) FAST_CAPTURE_NOEXCEPT
+    {
+        if (client == nullptr || target_label == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        try
+        {
+            std::lock_guard lock{lock_};
+            targets_.push_back({client, target_label});
+        }
+        catch (...)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_ALLOCATE_FRAME_BUFFER_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureMetricsExporter::RemoveClient(IFastCaptureClient* client) FAST_CAPTURE_NOEXCEPT
+    {
+        std::lock_guard lock{lock_};
+        const auto removed_count = std::erase_if(
+            targets_,
+            [client](const Target& target)
+            { return target.p_client == client; });
+        if (removed_count == 0)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_METRICS_TARGET_NOT_FOUND);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+}
+
+FastCaptureErrorCode CreateFastCaptureMetricsExporter(
+    const FastCaptureMetricsExporterDesc* desc,
+    IFastCaptureMetricsExporter** exporter) FAST_CAPTURE_NOEXCEPT
+{
+    if (desc == nullptr || exporter == nullptr || (desc->port == 0 && desc->text_file_path == nullptr))
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    auto p_exporter = new (std::nothrow) FAST_CAPTURE::FastCaptureMetricsExporter{};
+    if (p_exporter == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_CREATE_METRICS_EXPORTER_THREAD_FAILED);
+    }
+    if (auto result = p_exporter->Initialize(*desc); !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        delete p_exporter;
+        return result;
+    }
+    *exporter = p_exporter;
+    return FastCaptureMakeSuccessValue();
+}
+
+FastCaptureErrorCode DestroyFastCaptureMetricsExporter(IFastCaptureMetricsExporter* exporter) FAST_CAPTURE_NOEXCEPT
+{
+    if (exporter == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    delete static_cast<FAST_CAPTURE::FastCaptureMetricsExporter*>(exporter);
+    return FastCaptureMakeSuccessValue();
+}
@@ -0,0 +1,112 @@
+#ifndef FAST_CAPTURE_WINDOWS_FAST_CAPTURE_METRICS_EXPORTER_H
+#define FAST_CAPTURE_WINDOWS_FAST_CAPTURE_METRICS_EXPORTER_H
+
+// winsock2.h必须在Windows.h之前包含，否则Windows.h会包含旧的winsock.h
+#include <winsock2.h>
+#include "FastCapture.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Windows
+    {
+        struct SocketDeleter
+        {
+            void operator()(SOCKET socket) const noexcept
+            {
+                if (socket != INVALID_SOCKET)
+                {
+                    ::closesocket(socket);
+                }
+            }
+        };
+        struct SocketVerifier
+        {
+            bool operator()(SOCKET socket) const noexcept
+            {
+                return socket == INVALID_SOCKET;
+            }
+        };
+        using UniqueSocket = Utils::RAIIWrapper<SOCKET, SocketDeleter, SocketVerifier>;
+    }
+
+    /**
+     * @brief 由后台线程在被抓取或需要写入文本文件时读取各个客户端的计数。
+        计数都是共享内存或客户端中的原子变量，读取它们不会阻塞注入DLL和复制
+     *
+     */
+    class FastCaptureMetricsExporter final : public IFastCaptureMetricsExporter
+    {
+        struct Target
+        {
+            IFastCaptureClient* p_client{nullptr};
+            std::string label{};
+        };
+        /**
+         * @brief 一个目标在某一时刻的所有指标
+         *
+         */
+        struct TargetSnapshot
+        {
+            const Target* p_target{nullptr};
+            FastCaptureCounters counters{};
+            bool is_producer_up{false};
+        };
+
+        constexpr static DWORD SCRAPE_TIMEOUT_MS = 1000;
+        constexpr static std::size_t MAX_SCRAPE_REQUEST_SIZE = 8192;
+
+        FastCaptureMetricsExporterDesc desc_{};
+        std::wstring text_file_path_{};
+        /**
+         * @brief 保护targets_，只在后台线程读取计数和添加、删除目标时持有，不在捕获的路径上
+         *
+         */
+        std::mutex lock_{};
+        std::vector<Target> targets_{};
+
+        bool is_wsa_started_{false};
+        Windows::UniqueSocket listen_socket_{INVALID_SOCKET};
+        /**
+         * @brief 由WSAEventSelect在有新连接时设置
+         *
+         */
+        Windows::UniqueHandleInvalidNULL h_accept_event_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_stop_event_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_exporter_thread_{nullptr};
+
+        FastCaptureErrorCode Listen() noexcept;
+        /**
+         * @brief 以Prometheus的文本格式输出所有目标的指标
+         *
+         */
+        std::string RenderMetrics();
+        /**
+         * @brief 接受所有等待中的连接，读取请求后以当前的指标应答，不解析请求的路径
+         *
+         */
+        void ServeScrapes() noexcept;
+        void WriteTextFile() noexcept;
+
+        static DWORD WINAPI Do(LPVOID lpThreadParameter);
+
+    public:
+        FastCaptureMetricsExporter() = default;
+        ~FastCaptureMetricsExporter();
+        FastCaptureMetricsExporter(const FastCaptureMetricsExporter&) = delete;
+        FastCaptureMetricsExporter& operator=(const FastCaptureMetricsExporter&) = delete;
+
+        FastCaptureErrorCode Initialize(const FastCaptureMetricsExporterDesc& desc) noexcept;
+
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        AddClient(IFastCaptureClient* client, const char* target_label) FAST_CAPTURE_NOEXCEPT override;
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RemoveClient(IFastCaptureClient* client) FAST_CAPTURE_NOEXCEPT override;
+    };
+}
+
+#endif // FAST_CAPTURE_WINDOWS_FAST_CAPTURE_METRICS_EXPORTER_H
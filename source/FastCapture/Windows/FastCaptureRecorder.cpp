@@ -0,0 +1,328 @@
+#include "FastCaptureRecorder.h"
+#include <cstring>
+#include <new>
+#include <limits>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Details
+    {
+        constexpr std::size_t AlignRecordSize(const std::size_t size) noexcept
+        {
+            return (size + FAST_CAPTURE_RECORD_ALIGNMENT - 1) & ~std::size_t{FAST_CAPTURE_RECORD_ALIGNMENT - 1};
+        }
+    }
+
+    FastCaptureRecorder::~FastCaptureRecorder()
+    {
+        if (!h_recorder_thread_.IsInvalid())
+        {
+            ::SetEvent(h_stop_event_.Get());
+            ::WaitForSingleObject(h_recorder_thread_.Get(), INFINITE);
+        }
+    }
+
+    FastCaptureErrorCode FastCaptureRecorder::OpenFile() noexcept
+    {
+        if (!(desc_.flags & FAST_CAPTURE_RECORDER_FLAG_SYNCHRONOUS))
+        {
+            h_file_ = ::CreateFileW(
+                file_path_.c_str(),
+                GENERIC_WRITE,
+                FILE_SHARE_READ,
+                nullptr,
+                CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING,
+                nullptr);
+            if (!h_file_.IsInvalid())
+                [[likely]]
+            {
+                return FastCaptureMakeSuccessValue();
+            }
+        }
+        // 例如网络驱动器等不支持无缓冲写入的文件系统
+        is_synchronous_ = true;
+        h_file_ = ::CreateFileW(
+            file_path_.c_str(),
+            GENERIC_WRITE,
+            FILE_SHARE_READ,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        if (h_file_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_RECORDING_FILE_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureRecorder::InitializeWriteBuffers() noexcept
+    {
+        write_buffer_count_ = is_synchronous_ ? 1 : desc_.max_in_flight_write_count;
+        write_buffer_size_ = Details::AlignRecordSize(sizeof(FastCaptureRecordHeader) + static_cast<std::size_t>(desc_.max_frame_size));
+        p_write_buffer_pool_ = static_cast<std::byte*>(::VirtualAlloc(
+            nullptr,
+            write_buffer_size_ * write_buffer_count_,
+            MEM_COMMIT | MEM_RESERVE,
+            PAGE_READWRITE));
+        write_buffers_.reset(new (std::nothrow) WriteBuffer[write_buffer_count_]);
+        if (p_write_buffer_pool_.IsInvalid() || write_buffers_ == nullptr)
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_ALLOCATE_RECORDING_BUFFER_FAILED);
+        }
+        for (std::size_t i = 0; i < write_buffer_count_; ++i)
+        {
+            auto& write_buffer = write_buffers_[i];
+            write_buffer.p_data = p_write_buffer_pool_.Get() + i * write_buffer_size_;
+            write_buffer.h_write_finish_event = ::CreateEventW(
+                nullptr,
+                TRUE,
+                FALSE,
+                nullptr);
+            if (write_buffer.h_write_finish_event.IsInvalid())
+            {
+                return Windows::MakeError(FAST_CAPTURE_E_CREATE_RECORDER_EVENT_FAILED);
+            }
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode FastCaptureRecorder::Initialize(IFastCaptureClient* p_client, const FastCaptureRecorderDesc& desc) noexcept
+    {
+        p_client_ = p_client;
+        desc_ = desc;
+        file_path_ = desc.file_path;
+        desc_.file_path = file_path_.c_str();
+        if (auto result = OpenFile(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        statistics_.is_synchronous = is_synchronous_;
+        if (auto result = InitializeWriteBuffers(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        h_stop_event_ = ::CreateEventW(
+            nullptr,
+            TRUE,
+            FALSE,
+            nullptr);
+        if (h_stop_event_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_RECORDER_EVENT_FAILED);
+        }
+        h_recorder_thread_ = ::CreateThread(
+            nullptr,
+            0,
+            &Do,
+            this,
+            0,
+            nullptr);
+        if (h_recorder_thread_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_RECORDER_THREAD_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    void FastCaptureRecorder::RecordError(const FastCaptureErrorCode error_code) noexcept
+    {
+        std::lock_guard lock{statistics_lock_};
+        statistics_.last_error = error_code;
+    }
+
+    void FastCaptureRecorder::ReapFinishedWrites(const bool wait) noexcept
+    {
+        for (std::size_t i = 0; i < write_buffer_count_; ++i)
+        {
+            auto& write_buffer = write_buffers_[i];
+            if (!write_buffer.is_in_flight)
+            {
+                continue;
+            }
+            DWORD written_size;
+            const auto is_succeeded = ::GetOverlappedResult(h_file_.Get(), &write_buffer.overlapped, &written_size, wait);
+            if (!is_succeeded && ::GetLastError() == ERROR_IO_INCOMPLETE)
+            {
+                continue;
+            }
+            write_buffer.is_in_flight = false;
+            std::lock_guard lock{statistics_lock_};
+            --statistics_.in_flight_write_count;
+            if (!is_succeeded)
+            {
+                statistics_.last_error = Windows::MakeError(FAST_CAPTURE_E_WRITE_RECORDING_FILE_FAILED);
+                continue;
+            }
+            ++statistics_.written_frame_count;
+            statistics_.written_bytes += written_size;
+        }
+    }
+
+    auto FastCaptureRecorder::AcquireWriteBuffer() noexcept
+        -> WriteBuffer*
+    {
+        for (std::size_t i = 0; i < write_buffer_count_; ++i)
+        {
+            if (!write_buffers_[i].is_in_flight)
+            {
+                return &write_buffers_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void FastCaptureRecorder::SubmitWrite(WriteBuffer& write_buffer, const DWORD record_size) noexcept
+    {
+        if (is_synchronous_)
+        {
+            DWORD written_size;
+            if (!::WriteFile(h_file_.Get(), write_buffer.p_data, record_size, &written_size, nullptr))
+            {
+                RecordError(Windows::MakeError(FAST_CAPTURE_E_WRITE_RECORDING_FILE_FAILED));
+                return;
+            }
+            std::lock_guard lock{statistics_lock_};
+            ++statistics_.written_frame_count;
+            statistics_.written_bytes += written_size;
+            return;
+        }
+        write_buffer.overlapped = OVERLAPPED{};
+        write_buffer.overlapped.Offset = static_cast<DWORD>(file_offset_);
+        write_buffer.overlapped.OffsetHigh = static_cast<DWORD>(file_offset_ >> 32);
+        write_buffer.overlapped.hEvent = write_buffer.h_write_finish_event.Get();
+        ::ResetEvent(write_buffer.overlapped.hEvent);
+        if (!::WriteFile(h_file_.Get(), write_buffer.p_data, record_size, nullptr, &write_buffer.overlapped) &&
+            ::GetLastError() != ERROR_IO_PENDING)
+        {
+            RecordError(Windows::MakeError(FAST_CAPTURE_E_WRITE_RECORDING_FILE_FAILED));
+            return;
+        }
+        // 同步完成的写入也在ReapFinishedWrites中统计
+        write_buffer.is_in_flight = true;
+        file_offset_ += record_size;
+        std::lock_guard lock{statistics_lock_};
+        ++statistics_.in_flight_write_count;
+    }
+
+    void FastCaptureRecorder::RecordLatestFrame() noexcept
+    {
+        FastCaptureFrameInfo latest_info;
+        if (!Utils::IsOk(p_client_->RequestLatestCaptureFrameInfo(&latest_info)) ||
+            latest_info.frame_index == 0 || latest_info.frame_index == last_frame_index_)
+            [[likely]]
+        {
+            return;
+        }
+        FastCapturePlaneInfo plane_info;
+        if (!Utils::IsOk(p_client_->RequestLatestCapturePlaneInfo(desc_.plane, &plane_info)))
+        {
+            return;
+        }
+        auto p_write_buffer = AcquireWriteBuffer();
+        if (p_write_buffer == nullptr || plane_info.size > desc_.max_frame_size)
+        {
+            last_frame_index_ = latest_info.frame_index;
+            std::lock_guard lock{statistics_lock_};
+            ++statistics_.dropped_frame_count;
+            return;
+        }
+        const auto p_header = reinterpret_cast<FastCaptureRecordHeader*>(p_write_buffer->p_data);
+        const auto p_frame = p_write_buffer->p_data + sizeof(FastCaptureRecordHeader);
+        size_t frame_size;
+        FastCaptureFrameInfo frame_info;
+        if (!Utils::IsOk(p_client_->CopyLatestCapturePlaneEx(
+                desc_.plane,
+                reinterpret_cast<char*>(p_frame),
+                static_cast<size_t>(desc_.max_frame_size),
+                &frame_size,
+                &frame_info)) ||
+            frame_size != plane_info.size)
+        {
+            return;
+        }
+        last_frame_index_ = frame_info.frame_index;
+
+        const auto record_size = Details::AlignRecordSize(sizeof(FastCaptureRecordHeader) + frame_size);
+        *p_header = FastCaptureRecordHeader{
+            FAST_CAPTURE_RECORD_MAGIC,
+            desc_.plane,
+            frame_info.frame_index,
+            frame_info.timestamp_us,
+            plane_info.width,
+            plane_info.height,
+            plane_info.pixel_size,
+            0,
+            frame_size,
+            record_size};
+        std::memset(p_frame + frame_size, 0, record_size - sizeof(FastCaptureRecordHeader) - frame_size);
+        SubmitWrite(*p_write_buffer, static_cast<DWORD>(record_size));
+    }
+
+    DWORD WINAPI FastCaptureRecorder::Do(LPVOID lpThreadParameter)
+    {
+        auto p_this = static_cast<FastCaptureRecorder*>(lpThreadParameter);
+        while (true)
+        {
+            switch (::WaitForSingleObject(p_this->h_stop_event_.Get(), p_this->desc_.poll_interval_ms))
+            {
+            case WAIT_TIMEOUT:
+                p_this->ReapFinishedWrites(false);
+                p_this->RecordLatestFrame();
+                break;
+            default:
+                p_this->ReapFinishedWrites(true);
+                return 0;
+            }
+        }
+    }
+
+    FastCaptureErrorCode FAST_CAPTURE_CALL
+    FastCaptureRecorder::RequestStatistics(FastCaptureRecorderStatistics* statistics) FAST_CAPTURE_NOEXCEPT
+    {
+        if (statistics == nullptr)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+        }
+        std::lock_guard lock{statistics_lock_};
+        *statistics = statistics_;
+        return FastCaptureMakeSuccessValue();
+    }
+}
+
+FastCaptureErrorCode CreateFastCaptureRecorder(
+    IFastCaptureClient* client,
+    const FastCaptureRecorderDesc* desc,
+    IFastCaptureRecorder** recorder) FAST_CAPTURE_NOEXCEPT
+{
+    // 一个记录需要在一次WriteFile中写完
+    if (client == nullptr || desc == nullptr || recorder == nullptr || desc->file_path == nullptr ||
+        desc->plane >= FAST_CAPTURE_PLANE_COUNT || desc->max_in_flight_write_count == 0 || desc->max_frame_size == 0 ||
+        desc->max_frame_size > std::numeric_limits<DWORD>::max() - 2 * FAST_CAPTURE_RECORD_ALIGNMENT)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    auto p_recorder = new (std::nothrow) FAST_CAPTURE::FastCaptureRecorder{};
+    if (p_recorder == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_ALLOCATE_RECORDING_BUFFER_FAILED);
+    }
+    if (auto result = p_recorder->Initialize(client, *desc); !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        delete p_recorder;
+        return result;
+    }
+    *recorder = p_recorder;
+    return FastCaptureMakeSuccessValue();
+}
+
+FastCaptureErrorCode DestroyFastCaptureRecorder(IFastCaptureRecorder* recorder) FAST_CAPTURE_NOEXCEPT
+{
+    if (recorder == nullptr)
+    {
+        return FAST_CAPTURE::Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+    }
+    delete static_cast<FAST_CAPTURE::FastCaptureRecorder*>(recorder);
+    return FastCaptureMakeSuccessValue();
+}
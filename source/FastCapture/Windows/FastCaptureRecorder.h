@@ -0,0 +1,73 @@
+#ifndef FAST_CAPTURE_WINDOWS_FAST_CAPTURE_RECORDER_H
+#define FAST_CAPTURE_WINDOWS_FAST_CAPTURE_RECORDER_H
+
+#include "FastCapture.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    class FastCaptureRecorder final : public IFastCaptureRecorder
+    {
+        /**
+         * @brief 一次写入使用的缓冲区，is_in_flight为true时缓冲区和overlapped都属于系统
+         *
+         */
+        struct WriteBuffer
+        {
+            std::byte* p_data{nullptr};
+            OVERLAPPED overlapped{};
+            Windows::UniqueHandleInvalidNULL h_write_finish_event{nullptr};
+            bool is_in_flight{false};
+        };
+
+        IFastCaptureClient* p_client_{nullptr};
+        FastCaptureRecorderDesc desc_{};
+        std::wstring file_path_{};
+        Windows::UniqueHandleInvalidMinusOne h_file_{INVALID_HANDLE_VALUE};
+        bool is_synchronous_{false};
+        std::size_t write_buffer_size_{0};
+        std::size_t write_buffer_count_{0};
+        Windows::UniqueVirtualMemory<std::byte> p_write_buffer_pool_{nullptr};
+        std::unique_ptr<WriteBuffer[]> write_buffers_{};
+        std::uint64_t file_offset_{0};
+        std::uint64_t last_frame_index_{0};
+
+        std::mutex statistics_lock_{};
+        FastCaptureRecorderStatistics statistics_{};
+
+        Windows::UniqueHandleInvalidNULL h_stop_event_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_recorder_thread_{nullptr};
+
+        FastCaptureErrorCode OpenFile() noexcept;
+        FastCaptureErrorCode InitializeWriteBuffers() noexcept;
+        /**
+         * @brief 回收已经完成的写入，wait为true时等待所有写入完成
+         *
+         */
+        void ReapFinishedWrites(const bool wait) noexcept;
+        WriteBuffer* AcquireWriteBuffer() noexcept;
+        void SubmitWrite(WriteBuffer& write_buffer, const DWORD record_size) noexcept;
+        void RecordLatestFrame() noexcept;
+        void RecordError(const FastCaptureErrorCode error_code) noexcept;
+
+        static DWORD WINAPI Do(LPVOID lpThreadParameter);
+
+    public:
+        FastCaptureRecorder() = default;
+        ~FastCaptureRecorder();
+        FastCaptureRecorder(const FastCaptureRecorder&) = delete;
+        FastCaptureRecorder& operator=(const FastCaptureRecorder&) = delete;
+
+        FastCaptureErrorCode Initialize(IFastCaptureClient* p_client, const FastCaptureRecorderDesc& desc) noexcept;
+
+        FastCaptureErrorCode FAST_CAPTURE_CALL
+        RequestStatistics(FastCaptureRecorderStatistics* statistics) FAST_CAPTURE_NOEXCEPT override;
+    };
+}
+
+#endif // FAST_CAPTURE_WINDOWS_FAST_CAPTURE_RECORDER_H
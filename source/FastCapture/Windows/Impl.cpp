@@ -9,6 +9,7 @@
 #include "FastCaptureDef.h"
 #include "../../Utils/Utils.hpp"
 #include "../../Utils/Windows/UtilsWindows.hpp"
+#include "../../FastCaptureInjectDll/FastCaptureInjectDllDef.h"
 #include "../../FastCaptureInjectDll/Windows/FastCaptureInjectDll.h"
 
 FAST_CAPTURE_NAMESPACE
@@ -105,19 +106,51 @@ FAST_CAPTURE_NAMESPACE
             return init_dll_result;
         }
 
+        bool IsProducerAlive(const std::wstring& shared_memory_name_prefix) noexcept
+        {
+            const auto capture_descriptor_shared_name =
+                std::wstring(L"Global\\") + shared_memory_name_prefix + std::wstring(L"Descriptor");
+            UniqueHandleInvalidNULL h_capture_descriptor = ::OpenFileMappingW(
+                FILE_MAP_READ,
+                FALSE,
+                capture_descriptor_shared_name.c_str());
+            if (h_capture_descriptor.IsInvalid())
+            {
+                return false;
+            }
+            UniqueMapViewOfFile<CaptureDescriptor> p_capture_descriptor =
+                reinterpret_cast<CaptureDescriptor*>(
+                    ::MapViewOfFile(
+                        h_capture_descriptor.Get(),
+                        FILE_MAP_READ,
+                        0,
+                        0,
+                        sizeof(CaptureDescriptor)));
+            if (p_capture_descriptor.IsInvalid())
+            {
+                return false;
+            }
+            const auto producer_heartbeat_ms =
+                p_capture_descriptor.Get()->producer_heartbeat_ms.load(std::memory_order_acquire);
+            return producer_heartbeat_ms != 0 && ::GetTickCount64() - producer_heartbeat_ms <= PRODUCER_HEARTBEAT_TIMEOUT_MS;
+        }
+
         FastCaptureErrorCode InjectProcessImpl(
-            const wchar_t& w_process_name,
+            const DWORD process_id,
             const std::wstring& shared_memory_name_prefix) FAST_CAPTURE_NOEXCEPT
         {
-            DWORD pid;
-            if (!QueryProcessId(w_process_name, &pid))
+            if (IsProducerAlive(shared_memory_name_prefix))
             {
-                return MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+                return FastCaptureMakeSuccessValue();
             }
             Windows::UniqueHandleInvalidNULL h_process = ::OpenProcess(
                 PROCESS_ALL_ACCESS,
                 FALSE,
-                pid);
+                process_id);
+            if (h_process.IsInvalid())
+            {
+                return MakeError(FAST_CAPTURE_E_OPEN_TARGET_PROCESS_FAILED);
+            }
             return InstallInjectDll(
                 h_process.Get(), L"FastCaptureInjectDll.dll", shared_memory_name_prefix);
         }
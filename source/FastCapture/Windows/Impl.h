@@ -3,13 +3,24 @@
 
 #include "FastCaptureDef.h"
 #include <string>
+#include "../../Utils/Windows/UtilsWindows.hpp"
 
 FAST_CAPTURE_NAMESPACE
 {
     namespace Windows
     {
+        /**
+         * @brief 目标进程中已经有存活的生产者（之前注入的DLL或Vulkan层）时返回true
+         *
+         */
+        bool IsProducerAlive(const std::wstring& shared_memory_name_prefix) noexcept;
+
+        /**
+         * @brief 已经有存活的生产者时不再注入
+         *
+         */
         FastCaptureErrorCode InjectProcessImpl(
-            const wchar_t& w_process_name,
+            const DWORD process_id,
             const std::wstring& shared_memory_name_prefix) FAST_CAPTURE_NOEXCEPT;
     }
 }
@@ -0,0 +1,212 @@
+#include "ProcessIndex.h"
+#include <bit>
+#include <regex>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Windows
+    {
+        ProcessIndex& ProcessIndex::GetInstance() noexcept
+        {
+            static ProcessIndex process_index{};
+            return process_index;
+        }
+
+        FastCaptureErrorCode ProcessIndex::Refresh() noexcept
+        {
+            UniqueHandleInvalidMinusOne h_snapshot =
+                ::CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+            if (h_snapshot.IsInvalid())
+            {
+                return MakeError(FAST_CAPTURE_E_CREATE_PROCESS_SNAPSHOT_FAILED);
+            }
+            PROCESSENTRY32W pe32w{};
+            pe32w.dwSize = sizeof(PROCESSENTRY32W);
+            if (!::Process32FirstW(h_snapshot.Get(), &pe32w))
+            {
+                return MakeError(FAST_CAPTURE_E_CREATE_PROCESS_SNAPSHOT_FAILED);
+            }
+
+            std::unordered_map<DWORD, ProcessEntry> processes{};
+            processes.reserve(processes_.size());
+            std::unordered_multimap<std::wstring, DWORD> process_ids_by_name{};
+            process_ids_by_name.reserve(processes_.size());
+            do
+            {
+                ProcessEntry entry{pe32w.th32ParentProcessID, pe32w.szExeFile};
+                if (auto it = processes_.find(pe32w.th32ProcessID); it != processes_.end())
+                    [[likely]]
+                {
+                    auto& old_entry = it->second;
+                    if (old_entry.parent_process_id == entry.parent_process_id && old_entry.name == entry.name)
+                        [[likely]]
+                    {
+                        entry.opt_command_line = std::move(old_entry.opt_command_line);
+                    }
+                }
+                process_ids_by_name.emplace(entry.name, pe32w.th32ProcessID);
+                processes.emplace(pe32w.th32ProcessID, std::move(entry));
+            } while (::Process32NextW(h_snapshot.Get(), &pe32w));
+
+            processes_ = std::move(processes);
+            process_ids_by_name_ = std::move(process_ids_by_name);
+            last_refresh_ms_ = ::GetTickCount64();
+            is_refreshed_ = true;
+            return FastCaptureMakeSuccessValue();
+        }
+
+        FastCaptureErrorCode ProcessIndex::RefreshIfOlderThan(const ULONGLONG max_age_ms) noexcept
+        {
+            if (is_refreshed_ && ::GetTickCount64() - last_refresh_ms_ < max_age_ms)
+                [[likely]]
+            {
+                return FastCaptureMakeSuccessValue();
+            }
+            return Refresh();
+        }
+
+        std::wstring ProcessIndex::QueryCommandLine(const DWORD process_id) noexcept
+        {
+            struct UnicodeString
+            {
+                USHORT length;
+                USHORT maximum_length;
+                PWSTR buffer;
+            };
+            using NtQueryInformationProcessFunc = LONG(NTAPI*)(HANDLE, ULONG, PVOID, ULONG, PULONG);
+            // ProcessCommandLineInformation，Windows 8.1起可用，不需要读取目标进程的PEB
+            constexpr ULONG PROCESS_COMMAND_LINE_INFORMATION = 60;
+            static const auto p_nt_query_information_process = std::bit_cast<NtQueryInformationProcessFunc>(
+                ::GetProcAddress(::GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationProcess"));
+            if (p_nt_query_information_process == nullptr)
+            {
+                return {};
+            }
+            UniqueHandleInvalidNULL h_process = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, process_id);
+            if (h_process.IsInvalid())
+            {
+                return {};
+            }
+            ULONG buffer_size = 0;
+            p_nt_query_information_process(h_process.Get(), PROCESS_COMMAND_LINE_INFORMATION, nullptr, 0, &buffer_size);
+            if (buffer_size < sizeof(UnicodeString))
+            {
+                return {};
+            }
+            std::vector<UnicodeString> buffer((buffer_size + sizeof(UnicodeString) - 1) / sizeof(UnicodeString));
+            if (p_nt_query_information_process(
+                    h_process.Get(),
+                    PROCESS_COMMAND_LINE_INFORMATION,
+                    buffer.data(),
+                    buffer_size,
+                    &buffer_size)
+                < 0)
+            {
+                return {};
+            }
+            const auto& command_line = buffer.front();
+            return {command_line.buffer, command_line.length / sizeof(wchar_t)};
+        }
+
+        FastCaptureErrorCode ProcessIndex::FindInIndex(
+            const FastCaptureProcessQuery& query,
+            std::vector<DWORD>* p_out_process_ids) noexcept
+        {
+            p_out_process_ids->clear();
+            switch (query.match_type)
+            {
+            case FAST_CAPTURE_PROCESS_MATCH_NAME:
+            {
+                const auto [first, last] = process_ids_by_name_.equal_range(query.pattern);
+                for (auto it = first; it != last; ++it)
+                {
+                    p_out_process_ids->push_back(it->second);
+                }
+                break;
+            }
+            case FAST_CAPTURE_PROCESS_MATCH_PROCESS_ID:
+                if (processes_.contains(query.process_id))
+                {
+                    p_out_process_ids->push_back(query.process_id);
+                }
+                break;
+            case FAST_CAPTURE_PROCESS_MATCH_COMMAND_LINE:
+            {
+                std::wregex command_line_regex;
+                try
+                {
+                    command_line_regex.assign(query.pattern);
+                }
+                catch (const std::regex_error&)
+                {
+                    return Utils::MakeError(FAST_CAPTURE_E_INVALID_PROCESS_PATTERN);
+                }
+                for (auto& [process_id, entry] : processes_)
+                {
+                    if (!entry.opt_command_line)
+                    {
+                        entry.opt_command_line = QueryCommandLine(process_id);
+                    }
+                    if (std::regex_search(*entry.opt_command_line, command_line_regex))
+                    {
+                        p_out_process_ids->push_back(process_id);
+                    }
+                }
+                break;
+            }
+            default:
+                return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+            }
+            return FastCaptureMakeSuccessValue();
+        }
+
+        FastCaptureErrorCode ProcessIndex::Find(
+            const FastCaptureProcessQuery& query,
+            std::vector<DWORD>* p_out_process_ids) noexcept
+        {
+            if (query.match_type != FAST_CAPTURE_PROCESS_MATCH_PROCESS_ID && query.pattern == nullptr)
+            {
+                return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+            }
+            std::lock_guard lock{lock_};
+            if (auto result = RefreshIfOlderThan(MAX_INDEX_AGE_MS); !Utils::IsOk(result))
+            {
+                return result;
+            }
+            if (auto result = FindInIndex(query, p_out_process_ids); !Utils::IsOk(result) || !p_out_process_ids->empty())
+            {
+                return result;
+            }
+            // 目标进程可能是在上一次扫描之后启动的
+            if (::GetTickCount64() - last_refresh_ms_ < MIN_REFRESH_INTERVAL_MS)
+            {
+                return FastCaptureMakeSuccessValue();
+            }
+            if (auto result = Refresh(); !Utils::IsOk(result))
+            {
+                return result;
+            }
+            return FindInIndex(query, p_out_process_ids);
+        }
+
+        FastCaptureErrorCode ProcessIndex::FindUnique(const wchar_t* const w_process_name, DWORD* p_out_process_id) noexcept
+        {
+            std::vector<DWORD> process_ids;
+            const FastCaptureProcessQuery query{FAST_CAPTURE_PROCESS_MATCH_NAME, 0, w_process_name};
+            if (auto result = Find(query, &process_ids); !Utils::IsOk(result))
+            {
+                return result;
+            }
+            if (process_ids.empty())
+            {
+                return Utils::MakeError(FAST_CAPTURE_E_PROCESS_NOT_FOUND);
+            }
+            if (process_ids.size() > 1)
+            {
+                return Utils::MakeError(FAST_CAPTURE_E_PROCESS_NAME_AMBIGUOUS);
+            }
+            *p_out_process_id = process_ids.front();
+            return FastCaptureMakeSuccessValue();
+        }
+    }
+}
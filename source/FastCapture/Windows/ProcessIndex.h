@@ -0,0 +1,76 @@
+#ifndef FAST_CAPTURE_WINDOWS_PROCESS_INDEX_H
+#define FAST_CAPTURE_WINDOWS_PROCESS_INDEX_H
+
+#include "FastCaptureDef.h"
+#include <string>
+#include <optional>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Windows
+    {
+        /**
+         * @brief 系统进程的缓存索引。按名称和进程ID查找不需要遍历进程快照，
+            只有索引过期或查找不到时才重新扫描
+         *
+         */
+        class ProcessIndex
+        {
+            struct ProcessEntry
+            {
+                DWORD parent_process_id{0};
+                std::wstring name{};
+                /**
+                 * @brief 第一次按命令行匹配时才读取，读取失败时为空字符串
+                 *
+                 */
+                std::optional<std::wstring> opt_command_line{};
+            };
+
+            /**
+             * @brief 超过此时间的索引在下一次查找前重新扫描
+             *
+             */
+            constexpr static ULONGLONG MAX_INDEX_AGE_MS = 1000;
+            /**
+             * @brief 查找不到时也会重新扫描，但两次扫描的间隔不小于此值，避免反复重试时每次都扫描
+             *
+             */
+            constexpr static ULONGLONG MIN_REFRESH_INTERVAL_MS = 50;
+
+            std::mutex lock_{};
+            ULONGLONG last_refresh_ms_{0};
+            bool is_refreshed_{false};
+            std::unordered_map<DWORD, ProcessEntry> processes_{};
+            std::unordered_multimap<std::wstring, DWORD> process_ids_by_name_{};
+
+            /**
+             * @brief 重新扫描进程快照。进程ID、父进程ID和名称都没有变化的条目保留已经读取的命令行
+             *
+             */
+            FastCaptureErrorCode Refresh() noexcept;
+            FastCaptureErrorCode RefreshIfOlderThan(const ULONGLONG max_age_ms) noexcept;
+            FastCaptureErrorCode FindInIndex(
+                const FastCaptureProcessQuery& query,
+                std::vector<DWORD>* p_out_process_ids) noexcept;
+            static std::wstring QueryCommandLine(const DWORD process_id) noexcept;
+
+        public:
+            FastCaptureErrorCode Find(
+                const FastCaptureProcessQuery& query,
+                std::vector<DWORD>* p_out_process_ids) noexcept;
+            /**
+             * @brief 按名称查找唯一的进程
+             *
+             */
+            FastCaptureErrorCode FindUnique(const wchar_t* const w_process_name, DWORD* p_out_process_id) noexcept;
+            static ProcessIndex& GetInstance() noexcept;
+        };
+    }
+}
+
+#endif // FAST_CAPTURE_WINDOWS_PROCESS_INDEX_H
@@ -0,0 +1,119 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <system_error>
+
+FAST_CAPTURE_NAMESPACE
+{
+    thread_local bool WorkerPool::is_running_task_{false};
+
+    WorkerPool::WorkerPool() noexcept
+    {
+        const auto worker_count = (std::min)(
+            (std::max)(std::thread::hardware_concurrency(), 1u) - 1,
+            MAX_WORKER_COUNT);
+        try
+        {
+            worker_threads_.reserve(worker_count);
+            for (std::uint32_t i = 0; i < worker_count; ++i)
+            {
+                worker_threads_.emplace_back(&WorkerPool::RunWorker, this);
+            }
+        }
+        catch (const std::system_error&)
+        {
+            // 少于预期的工作线程时只是变慢，任务总能由调用Run的线程完成
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard lock{lock_};
+            is_stop_requested_ = true;
+        }
+        work_condition_.notify_all();
+        for (auto& worker_thread : worker_threads_)
+        {
+            worker_thread.join();
+        }
+    }
+
+    WorkerPool& WorkerPool::GetInstance() noexcept
+    {
+        static WorkerPool worker_pool{};
+        return worker_pool;
+    }
+
+    void WorkerPool::RunTasks(const std::function<void(std::size_t)>& task, const std::size_t task_count) noexcept
+    {
+        is_running_task_ = true;
+        for (auto i = next_task_index_.fetch_add(1, std::memory_order_relaxed);
+             i < task_count;
+             i = next_task_index_.fetch_add(1, std::memory_order_relaxed))
+        {
+            task(i);
+        }
+        is_running_task_ = false;
+    }
+
+    void WorkerPool::RunWorker() noexcept
+    {
+        std::uint64_t last_generation = 0;
+        std::unique_lock lock{lock_};
+        while (true)
+        {
+            work_condition_.wait(
+                lock,
+                [this, last_generation]()
+                { return is_stop_requested_ || generation_ != last_generation; });
+            if (is_stop_requested_)
+            {
+                return;
+            }
+            // 醒来时上一批任务可能已经结束，此时next_task_index_不小于task_count_，不会调用p_task_
+            last_generation = generation_;
+            const auto p_task = p_task_;
+            const auto task_count = task_count_;
+            ++active_worker_count_;
+            lock.unlock();
+            RunTasks(*p_task, task_count);
+            lock.lock();
+            if (--active_worker_count_ == 0)
+            {
+                done_condition_.notify_all();
+            }
+        }
+    }
+
+    void WorkerPool::Run(const std::size_t task_count, const std::function<void(std::size_t)>& task) noexcept
+    {
+        if (task_count <= 1 || worker_threads_.empty() || is_running_task_)
+        {
+            for (std::size_t i = 0; i < task_count; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+        std::lock_guard run_lock{run_lock_};
+        {
+            std::unique_lock lock{lock_};
+            // 上一批结束后才醒来的工作线程仍持有旧的p_task_，等它退出后才能开始新的一批
+            done_condition_.wait(
+                lock,
+                [this]()
+                { return active_worker_count_ == 0; });
+            p_task_ = &task;
+            task_count_ = task_count;
+            next_task_index_.store(0, std::memory_order_relaxed);
+            ++generation_;
+        }
+        work_condition_.notify_all();
+        RunTasks(task, task_count);
+        std::unique_lock lock{lock_};
+        done_condition_.wait(
+            lock,
+            [this]()
+            { return active_worker_count_ == 0; });
+    }
+}
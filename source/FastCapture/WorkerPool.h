@@ -0,0 +1,70 @@
+#ifndef FAST_CAPTURE_WORKER_POOL_H
+#define FAST_CAPTURE_WORKER_POOL_H
+
+#include "FastCaptureDef.h"
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 常驻的工作线程池，用于把一批互相独立的复制任务分摊到多个核心上。
+        调用Run的线程也会执行任务，同一时刻只执行一批任务
+     *
+     */
+    class WorkerPool
+    {
+        /**
+         * @brief 复制受内存带宽限制，更多的线程不会更快
+         *
+         */
+        constexpr static std::uint32_t MAX_WORKER_COUNT = 7;
+
+        std::mutex run_lock_{};
+        std::mutex lock_{};
+        std::condition_variable work_condition_{};
+        std::condition_variable done_condition_{};
+        const std::function<void(std::size_t)>* p_task_{nullptr};
+        std::size_t task_count_{0};
+        std::atomic<std::size_t> next_task_index_{0};
+        std::uint64_t generation_{0};
+        std::size_t active_worker_count_{0};
+        bool is_stop_requested_{false};
+        static thread_local bool is_running_task_;
+        std::vector<std::thread> worker_threads_{};
+
+        /**
+         * @brief 领取并执行任务，直到本批任务全部被领取
+         *
+         */
+        void RunTasks(const std::function<void(std::size_t)>& task, const std::size_t task_count) noexcept;
+        void RunWorker() noexcept;
+
+    public:
+        WorkerPool() noexcept;
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /**
+         * @brief 以[0, task_count)中的每个值调用一次task，全部完成后返回。task不能抛出异常。
+            在task中再次调用Run时直接在当前线程中执行：同一时刻只有一批任务，内层的任务无法交给
+            正在执行外层任务的工作线程，等待它们只会死锁。因此批量复制中的每个请求不会再分块
+         *
+         */
+        void Run(const std::size_t task_count, const std::function<void(std::size_t)>& task) noexcept;
+        std::uint32_t GetWorkerCount() const noexcept
+        {
+            return static_cast<std::uint32_t>(worker_threads_.size());
+        }
+        static WorkerPool& GetInstance() noexcept;
+    };
+}
+
+#endif // FAST_CAPTURE_WORKER_POOL_H
@@ -0,0 +1,103 @@
+#include "DepthConvert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAST_CAPTURE_DEPTH_CONVERT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+FAST_CAPTURE_NAMESPACE
+{
+    // 标准OpenGL深度范围下，线性距离 = near * far / (far - depth * (far - near))
+    namespace Details
+    {
+        constexpr float DEPTH_24_MAX = 16777215.0f;
+
+        inline float LinearizeDepth(const float depth, const float numerator, const float far_plane, const float range) noexcept
+        {
+            return numerator / (far_plane - depth * range);
+        }
+    }
+
+    void ConvertDepth24ToLinear(
+        const std::uint32_t* p_source,
+        float* p_destination,
+        const std::size_t count,
+        const float near_plane,
+        const float far_plane) noexcept
+    {
+        const float numerator = near_plane * far_plane;
+        const float range = far_plane - near_plane;
+        std::size_t i = 0;
+#ifdef FAST_CAPTURE_DEPTH_CONVERT_USE_SSE2
+        const __m128 v_numerator = _mm_set1_ps(numerator);
+        const __m128 v_far_plane = _mm_set1_ps(far_plane);
+        const __m128 v_scale = _mm_set1_ps(range / Details::DEPTH_24_MAX);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i v_packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_source + i));
+            // 24位深度右移后一定小于2^31，可以安全地按有符号数转换
+            const __m128 v_depth = _mm_cvtepi32_ps(_mm_srli_epi32(v_packed, 8));
+            const __m128 v_result = _mm_div_ps(v_numerator, _mm_sub_ps(v_far_plane, _mm_mul_ps(v_depth, v_scale)));
+            _mm_storeu_ps(p_destination + i, v_result);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const float depth = static_cast<float>(p_source[i] >> 8) / Details::DEPTH_24_MAX;
+            p_destination[i] = Details::LinearizeDepth(depth, numerator, far_plane, range);
+        }
+    }
+
+    void ConvertDepthFloatToLinear(
+        const float* p_source,
+        float* p_destination,
+        const std::size_t count,
+        const float near_plane,
+        const float far_plane) noexcept
+    {
+        const float numerator = near_plane * far_plane;
+        const float range = far_plane - near_plane;
+        std::size_t i = 0;
+#ifdef FAST_CAPTURE_DEPTH_CONVERT_USE_SSE2
+        const __m128 v_numerator = _mm_set1_ps(numerator);
+        const __m128 v_far_plane = _mm_set1_ps(far_plane);
+        const __m128 v_range = _mm_set1_ps(range);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 v_depth = _mm_loadu_ps(p_source + i);
+            const __m128 v_result = _mm_div_ps(v_numerator, _mm_sub_ps(v_far_plane, _mm_mul_ps(v_depth, v_range)));
+            _mm_storeu_ps(p_destination + i, v_result);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            p_destination[i] = Details::LinearizeDepth(p_source[i], numerator, far_plane, range);
+        }
+    }
+
+    void ExtractStencilFromDepth24(
+        const std::uint32_t* p_source,
+        std::uint8_t* p_destination,
+        const std::size_t count) noexcept
+    {
+        std::size_t i = 0;
+#ifdef FAST_CAPTURE_DEPTH_CONVERT_USE_SSE2
+        const __m128i v_mask = _mm_set1_epi32(0xFF);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto p_block = reinterpret_cast<const __m128i*>(p_source + i);
+            const __m128i v0 = _mm_and_si128(_mm_loadu_si128(p_block + 0), v_mask);
+            const __m128i v1 = _mm_and_si128(_mm_loadu_si128(p_block + 1), v_mask);
+            const __m128i v2 = _mm_and_si128(_mm_loadu_si128(p_block + 2), v_mask);
+            const __m128i v3 = _mm_and_si128(_mm_loadu_si128(p_block + 3), v_mask);
+            // 每个值都不超过0xFF，因此两次饱和打包不会改变数值
+            const __m128i v_result = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p_destination + i), v_result);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            p_destination[i] = static_cast<std::uint8_t>(p_source[i] & 0xFF);
+        }
+    }
+}
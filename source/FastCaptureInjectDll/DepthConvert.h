@@ -0,0 +1,50 @@
+#ifndef FAST_CAPTURE_INJECT_DLL_DEPTH_CONVERT_H
+#define FAST_CAPTURE_INJECT_DLL_DEPTH_CONVERT_H
+
+#include "FastCaptureDef.h"
+#include <cstddef>
+#include <cstdint>
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 把GL_UNSIGNED_INT_24_8格式的深度（高24位）转换为线性的视空间距离
+     *
+     * @param p_source 读回的深度模板数据
+     * @param p_destination 转换结果，可以与p_source相同
+     * @param count 像素数
+     * @param near_plane 投影矩阵的近裁剪面
+     * @param far_plane 投影矩阵的远裁剪面
+     */
+    void ConvertDepth24ToLinear(
+        const std::uint32_t* p_source,
+        float* p_destination,
+        const std::size_t count,
+        const float near_plane,
+        const float far_plane) noexcept;
+
+    /**
+     * @brief 把GL_FLOAT格式的[0, 1]深度转换为线性的视空间距离
+     *
+     * @param p_source 读回的深度数据
+     * @param p_destination 转换结果，可以与p_source相同
+     */
+    void ConvertDepthFloatToLinear(
+        const float* p_source,
+        float* p_destination,
+        const std::size_t count,
+        const float near_plane,
+        const float far_plane) noexcept;
+
+    /**
+     * @brief 从GL_UNSIGNED_INT_24_8格式的数据中取出模板（低8位），
+        这样同时捕获深度和模板时只需要一次glReadPixels
+     *
+     */
+    void ExtractStencilFromDepth24(
+        const std::uint32_t* p_source,
+        std::uint8_t* p_destination,
+        const std::size_t count) noexcept;
+}
+
+#endif // FAST_CAPTURE_INJECT_DLL_DEPTH_CONVERT_H
@@ -2,24 +2,435 @@
 #define FAST_CAPTURE_INJECT_DLL_INJECT_DLL_DEF_H
 
 #include <cstddef>
-#include <mutex>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 #include "FastCaptureDef.h"
-#include "GL/glew.h"
+#include "../Utils/GLDef.hpp"
+#include "../Utils/SeqLock.hpp"
+#include "../Utils/GLFunctions.hpp"
 
 FAST_CAPTURE_NAMESPACE
 {
     /**
-     * @brief 捕获图像的描述信息，读写前必须加锁
+     * @brief 客户端在描述信息中占用的槽位。
+        客户端定期刷新心跳，注入DLL发现心跳超时后回收槽位，
+        因此客户端进程崩溃后不会留下永久占用的槽位
+     *
+     */
+    struct SubscriberSlot
+    {
+        /**
+         * @brief 高32位为代数，每次被占用时加1，低32位为进程ID，进程ID为0表示槽位空闲。
+            占用者由同一个原子变量确定，同一进程中的多个客户端、被回收后重新占用的客户端都可以区分
+         *
+         */
+        std::atomic<std::uint64_t> owner{0};
+        /**
+         * @brief 在占用槽位之前写入，看到新的占用者时一定也能看到它的心跳
+         *
+         */
+        std::atomic<std::uint64_t> heartbeat_ms{0};
+        /**
+         * @brief 此客户端需要的FAST_CAPTURE_FLAG_*，注入DLL按所有存活客户端的并集捕获
+         *
+         */
+        std::atomic<std::uint32_t> capture_flags{FAST_CAPTURE_FLAG_NONE};
+
+        constexpr static std::uint64_t GENERATION_MASK = 0xFFFFFFFF00000000ull;
+
+        constexpr static std::uint32_t GetProcessId(const std::uint64_t owner) noexcept
+        {
+            return static_cast<std::uint32_t>(owner);
+        }
+        bool IsOccupied(const std::memory_order order = std::memory_order_acquire) const noexcept
+        {
+            return GetProcessId(owner.load(order)) != 0;
+        }
+    };
+
+    /**
+     * @brief 一个平面在图像数据中的位置，offset相对于CaptureImage::GetDataPointer()
+     *
+     */
+    struct CapturePlane
+    {
+        std::uint64_t offset{};
+        std::uint64_t size{};
+        std::uint32_t pixel_size{};
+        GLenum gl_format{};
+        GLenum gl_type{};
+        GLint width{};
+        GLint height{};
+        /**
+         * @brief 读回时使用的颜色纹理的mipmap层级
+         *
+         */
+        GLint mip_level{};
+        /**
+         * @brief FAST_CAPTURE_PLANE_FORMAT_*，GL_FLOAT的深度可能是原始深度也可能是线性深度，只靠gl_type无法区分
+         *
+         */
+        std::uint32_t format{FAST_CAPTURE_PLANE_FORMAT_UNKNOWN};
+    };
+
+    /**
+     * @brief 平面在图像数据中的对齐，便于使用对齐的SIMD指令读写
+     *
+     */
+    constexpr std::uint64_t CAPTURE_PLANE_ALIGNMENT = 64;
+    constexpr std::uint32_t CAPTURE_COLOR_PIXEL_SIZE = 4;
+
+    inline bool IsDepthCaptureEnabled(const std::uint32_t capture_flags) noexcept
+    {
+        return capture_flags & (FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_DEPTH_FLOAT);
+    }
+
+    /**
+     * @brief 捕获标志对应的深度平面格式，未启用深度时返回FAST_CAPTURE_PLANE_FORMAT_UNKNOWN。
+        注入DLL按所有客户端的并集调用，客户端按自己的标志调用，两者不同时说明深度格式发生了冲突
+     *
+     */
+    inline std::uint32_t GetDepthPlaneFormat(const std::uint32_t capture_flags) noexcept
+    {
+        if (!IsDepthCaptureEnabled(capture_flags))
+        {
+            return FAST_CAPTURE_PLANE_FORMAT_UNKNOWN;
+        }
+        // 线性深度总是以float存放
+        if (capture_flags & FAST_CAPTURE_FLAG_LINEAR_DEPTH)
+        {
+            return FAST_CAPTURE_PLANE_FORMAT_LINEAR_DEPTH_FLOAT;
+        }
+        if (capture_flags & FAST_CAPTURE_FLAG_DEPTH_FLOAT)
+        {
+            return FAST_CAPTURE_PLANE_FORMAT_DEPTH_FLOAT;
+        }
+        return FAST_CAPTURE_PLANE_FORMAT_DEPTH_24_STENCIL_8;
+    }
+
+    /**
+     * @brief 去掉上下文无法读回的平面，OpenGL ES只能读回颜色
+     *
+     */
+    inline std::uint32_t FilterCaptureFlags(const std::uint32_t capture_flags, const GlApi gl_api) noexcept
+    {
+        if (gl_api == GlApi::OpenGL)
+        {
+            return capture_flags;
+        }
+        return capture_flags
+               & ~(FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_DEPTH_FLOAT
+                   | FAST_CAPTURE_FLAG_STENCIL | FAST_CAPTURE_FLAG_LINEAR_DEPTH);
+    }
+
+    /**
+     * @brief 获得启用的最高颜色mipmap层级，未启用时返回0
+     *
+     */
+    inline GLint GetMaxColorMipLevel(const std::uint32_t capture_flags) noexcept
+    {
+        GLint result = 0;
+        for (GLint mip_level = 1; mip_level <= FAST_CAPTURE_MAX_COLOR_MIP_LEVEL; ++mip_level)
+        {
+            if (capture_flags & (FAST_CAPTURE_FLAG_COLOR_MIP_1 << (mip_level - 1)))
+            {
+                result = mip_level;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief 根据捕获标志计算各个平面的布局，未启用的平面size为0
+     *
+     * @return std::uint64_t 所有平面占用的总字节数
+     */
+    inline std::uint64_t MakeCapturePlanes(
+        const GLint width,
+        const GLint height,
+        const std::uint32_t capture_flags,
+        CapturePlane (&planes)[FAST_CAPTURE_PLANE_COUNT]) noexcept
+    {
+        std::uint64_t offset = 0;
+        const auto append_plane =
+            [&offset, width, height](CapturePlane& plane, std::uint32_t format, std::uint32_t pixel_size, GLenum gl_format, GLenum gl_type, GLint mip_level = 0)
+        {
+            const auto mip_width = (std::max)(width >> mip_level, 1);
+            const auto mip_height = (std::max)(height >> mip_level, 1);
+            const auto pixel_count = static_cast<std::uint64_t>(mip_width) * mip_height;
+            plane = {offset, pixel_count * pixel_size, pixel_size, gl_format, gl_type, mip_width, mip_height, mip_level, format};
+            offset += (plane.size + CAPTURE_PLANE_ALIGNMENT - 1) / CAPTURE_PLANE_ALIGNMENT * CAPTURE_PLANE_ALIGNMENT;
+        };
+        for (auto& plane : planes)
+        {
+            plane = {};
+        }
+
+        append_plane(planes[FAST_CAPTURE_PLANE_COLOR], FAST_CAPTURE_PLANE_FORMAT_RGBA8, CAPTURE_COLOR_PIXEL_SIZE, GL_RGBA, GL_UNSIGNED_BYTE);
+        switch (const auto depth_format = GetDepthPlaneFormat(capture_flags))
+        {
+        case FAST_CAPTURE_PLANE_FORMAT_DEPTH_FLOAT:
+        case FAST_CAPTURE_PLANE_FORMAT_LINEAR_DEPTH_FLOAT:
+            append_plane(planes[FAST_CAPTURE_PLANE_DEPTH], depth_format, sizeof(float), GL_DEPTH_COMPONENT, GL_FLOAT);
+            break;
+        case FAST_CAPTURE_PLANE_FORMAT_DEPTH_24_STENCIL_8:
+            append_plane(planes[FAST_CAPTURE_PLANE_DEPTH], depth_format, sizeof(std::uint32_t), GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+            break;
+        default:
+            break;
+        }
+        if (capture_flags & FAST_CAPTURE_FLAG_STENCIL)
+        {
+            append_plane(planes[FAST_CAPTURE_PLANE_STENCIL], FAST_CAPTURE_PLANE_FORMAT_STENCIL_8, sizeof(std::uint8_t), GL_STENCIL_INDEX, GL_UNSIGNED_BYTE);
+        }
+        for (GLint mip_level = 1; mip_level <= FAST_CAPTURE_MAX_COLOR_MIP_LEVEL; ++mip_level)
+        {
+            if (capture_flags & (FAST_CAPTURE_FLAG_COLOR_MIP_1 << (mip_level - 1)))
+            {
+                append_plane(
+                    planes[FAST_CAPTURE_PLANE_COLOR_MIP_1 + mip_level - 1],
+                    FAST_CAPTURE_PLANE_FORMAT_RGBA8,
+                    CAPTURE_COLOR_PIXEL_SIZE,
+                    GL_RGBA,
+                    GL_UNSIGNED_BYTE,
+                    mip_level);
+            }
+        }
+        return offset;
+    }
+
+    constexpr std::size_t MAX_SUBSCRIBER_COUNT = 16;
+    constexpr std::uint64_t SUBSCRIBER_HEARTBEAT_TIMEOUT_MS = 3000;
+    constexpr std::uint64_t PRODUCER_HEARTBEAT_TIMEOUT_MS = 3000;
+    /**
+     * @brief 读回线程以休眠状态启动，只需要等待线程本身启动
+     *
+     */
+    constexpr std::uint32_t READ_PIXELS_THREAD_INIT_TIMEOUT_MS = 4000;
+    /**
+     * @brief 读者在顺序锁上等待的时限，足够覆盖写者复制一帧多MB的图像。
+        超时后以生产者的心跳区分写者繁忙和写者崩溃
+     *
+     */
+    constexpr std::chrono::milliseconds SEQ_LOCK_READ_TIMEOUT{100};
+
+    /**
+     * @brief 事件日志的容量，写满后覆盖最旧的事件
+     *
+     */
+    constexpr std::size_t CAPTURE_EVENT_LOG_CAPACITY = 256;
+
+    struct CaptureEventSlot
+    {
+        Utils::SeqLock seq_lock{};
+        FastCaptureEvent event{};
+    };
+
+    /**
+     * @brief 放在共享内存中的单写者事件环。只有读回线程写入，写者从不等待读者；
+        每个读者自己保存读取位置，读到的event.sequence与读取位置不同说明该槽位已被覆盖
+     *
+     */
+    struct CaptureEventLog
+    {
+        /**
+         * @brief 下一个事件的序号，也是已经写入的事件总数
+         *
+         */
+        std::atomic<std::uint64_t> write_position{0};
+        CaptureEventSlot slots[CAPTURE_EVENT_LOG_CAPACITY]{};
+
+        /**
+         * @brief 只能由读回线程调用
+         *
+         */
+        void Push(
+            const std::uint32_t code,
+            const FastCaptureErrorCode error,
+            const std::uint64_t timestamp_us,
+            const std::uint64_t context_0 = 0,
+            const std::uint64_t context_1 = 0) noexcept
+        {
+            const auto position = write_position.load(std::memory_order_relaxed);
+            auto& slot = slots[position % CAPTURE_EVENT_LOG_CAPACITY];
+            {
+                auto slot_write_guard = Utils::MakeSeqLockWriteGuard(slot.seq_lock);
+                slot.event = {position, timestamp_us, code, error, {context_0, context_1}};
+            }
+            write_position.store(position + 1, std::memory_order_release);
+        }
+    };
+
+    /**
+     * @brief 获得延迟所属的直方图的桶，见FAST_CAPTURE_LATENCY_BUCKET_COUNT
+     *
+     */
+    inline std::size_t GetLatencyBucketIndex(const std::uint64_t latency_us) noexcept
+    {
+        std::size_t result = 0;
+        while (result < FAST_CAPTURE_LATENCY_BUCKET_COUNT - 1 && latency_us > (1000ull << result))
+        {
+            ++result;
+        }
+        return result;
+    }
+
+    /**
+     * @brief 无锁的延迟直方图，可以放在共享内存中
+     *
+     */
+    struct LatencyHistogram
+    {
+        std::atomic<std::uint64_t> sum_us{0};
+        std::atomic<std::uint64_t> buckets[FAST_CAPTURE_LATENCY_BUCKET_COUNT]{};
+
+        void Record(const std::uint64_t latency_us) noexcept
+        {
+            sum_us.fetch_add(latency_us, std::memory_order_relaxed);
+            buckets[GetLatencyBucketIndex(latency_us)].fetch_add(1, std::memory_order_relaxed);
+        }
+        void Load(std::uint64_t* p_out_sum_us, std::uint64_t (&out_buckets)[FAST_CAPTURE_LATENCY_BUCKET_COUNT]) const noexcept
+        {
+            *p_out_sum_us = sum_us.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < FAST_CAPTURE_LATENCY_BUCKET_COUNT; ++i)
+            {
+                out_buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * @brief 获得开销所属的直方图的桶，见FAST_CAPTURE_COST_BUCKET_COUNT
+     *
+     */
+    inline std::size_t GetCostBucketIndex(const std::uint64_t cost_ns) noexcept
+    {
+        std::size_t result = 0;
+        while (result < FAST_CAPTURE_COST_BUCKET_COUNT - 1 && cost_ns > (10000ull << result))
+        {
+            ++result;
+        }
+        return result;
+    }
+
+    /**
+     * @brief 无锁的开销直方图，可以放在共享内存中。
+        捕获的开销通常只有几十微秒，因此以纳秒累加，桶也比延迟直方图细
+     *
+     */
+    struct CostHistogram
+    {
+        std::atomic<std::uint64_t> sum_ns{0};
+        std::atomic<std::uint64_t> buckets[FAST_CAPTURE_COST_BUCKET_COUNT]{};
+
+        void Record(const std::uint64_t cost_ns) noexcept
+        {
+            sum_ns.fetch_add(cost_ns, std::memory_order_relaxed);
+            buckets[GetCostBucketIndex(cost_ns)].fetch_add(1, std::memory_order_relaxed);
+        }
+        void Load(std::uint64_t* p_out_sum_ns, std::uint64_t (&out_buckets)[FAST_CAPTURE_COST_BUCKET_COUNT]) const noexcept
+        {
+            *p_out_sum_ns = sum_ns.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < FAST_CAPTURE_COST_BUCKET_COUNT; ++i)
+            {
+                out_buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * @brief 与FastCaptureCounters对应，各成员可以由不同的线程累加
+     *
+     */
+    struct CaptureCounters
+    {
+        std::atomic<std::uint64_t> published_frame_count{0};
+        std::atomic<std::uint64_t> repeated_frame_count{0};
+        std::atomic<std::uint64_t> dropped_frame_count{0};
+        std::atomic<std::uint64_t> pbo_ring_full_count{0};
+        std::atomic<std::uint64_t> capture_image_remap_count{0};
+        std::atomic<std::uint64_t> reaped_subscriber_count{0};
+        std::atomic<std::uint64_t> pbo_ring_occupancy{0};
+        std::atomic<std::uint64_t> deferred_frame_count{0};
+        std::atomic<std::uint64_t> budget_dropped_frame_count{0};
+        std::atomic<std::uint64_t> swap_interval_us{0};
+        std::atomic<std::uint64_t> coalesced_read_pixels_count{0};
+        LatencyHistogram publish_latency{};
+        CostHistogram hook_cpu_cost{};
+        CostHistogram hook_gpu_cost{};
+        CostHistogram pack_gpu_cost{};
+        std::atomic<std::uint64_t> scheduling_generation{0};
+        CostHistogram pickup_latency{};
+        LatencyHistogram readback_latency{};
+        CostHistogram publish_duration{};
+    };
+
+    /**
+     * @brief 捕获图像的描述信息，读写viewport等普通成员时必须通过seq_lock，
+        原子成员可以直接读写
      *
      */
     struct CaptureDescriptor
     {
-        std::mutex lock{};
+        Utils::SeqLock seq_lock{};
         GLint viewport[4]{};
         GLint color_size{};
         struct CaptureImage* p_capture_image{};
         FastCaptureErrorCode wgl_swap_buffers_fake_last_error = FastCaptureMakeSuccessValue();
         FastCaptureErrorCode swap_buffers_fake_last_error = FastCaptureMakeSuccessValue();
+        /**
+         * @brief 注入DLL每处理一次命令就刷新一次，客户端据此判断注入DLL是否存活
+         *
+         */
+        std::atomic<std::uint64_t> producer_heartbeat_ms{0};
+        SubscriberSlot subscribers[MAX_SUBSCRIBER_COUNT]{};
+        /**
+         * @brief 当前图像实际包含的平面，以及各平面的布局
+         *
+         */
+        std::uint32_t capture_flags{FAST_CAPTURE_FLAG_NONE};
+        CapturePlane planes[FAST_CAPTURE_PLANE_COUNT]{};
+        /**
+         * @brief 图像共享内存的代数，图像共享内存需要扩大时会以新的代数重新创建，
+            客户端发现代数变化后需要重新映射。新的共享内存写入第一帧后才与布局一起更新
+         *
+         */
+        std::uint32_t capture_image_generation{};
+        /**
+         * @brief 与CaptureImage::frame_index相同，写完图像后更新，客户端可以据此跳过没有变化的帧
+         *
+         */
+        std::atomic<std::uint64_t> frame_index{0};
+        /**
+         * @brief 最新一帧之后，内容与其相同而被跳过写入的帧数，发布新的帧时清零
+         *
+         */
+        std::atomic<std::uint64_t> repeat_count{0};
+        std::atomic<std::uint64_t> frame_timestamp_us{0};
+        /**
+         * @brief 启用FAST_CAPTURE_FLAG_LINEAR_DEPTH时使用的近、远裁剪面，由客户端设置
+         *
+         */
+        std::atomic<float> depth_near_plane{0.1f};
+        std::atomic<float> depth_far_plane{1000.0f};
+        /**
+         * @brief 读回线程每帧的CPU预算，由客户端设置，见IFastCaptureClient::SetFrameCpuBudget
+         *
+         */
+        std::atomic<std::uint32_t> frame_cpu_budget_us{0};
+        /**
+         * @brief 读回线程的调度设置，由客户端写入各成员后增加scheduling_generation，
+            读回线程发现代数变化时应用，见IFastCaptureClient::SetCaptureThreadScheduling
+         *
+         */
+        std::atomic<std::uint64_t> scheduling_affinity_mask{0};
+        std::atomic<std::int32_t> scheduling_priority{0};
+        std::atomic<std::uint32_t> scheduling_flags{0};
+        std::atomic<std::uint32_t> scheduling_generation{0};
+        CaptureCounters counters{};
+        CaptureEventLog event_log{};
 
         GLint GetWidth() const noexcept
         {
@@ -29,24 +440,184 @@ FAST_CAPTURE_NAMESPACE
         {
             return viewport[3];
         }
+        /**
+         * @brief 获得颜色平面的字节数，color_size为每个像素的字节数
+         *
+         */
+        std::size_t GetImageSize() const noexcept
+        {
+            return static_cast<std::size_t>(GetWidth()) * GetHeight() * color_size;
+        }
+        /**
+         * @brief 获得图像数据部分（所有平面）的字节数
+         *
+         */
+        std::size_t GetTotalImageSize() const noexcept
+        {
+            std::size_t result = 0;
+            for (const auto& plane : planes)
+            {
+                if (plane.size != 0 && plane.offset + plane.size > result)
+                {
+                    result = static_cast<std::size_t>(plane.offset + plane.size);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief 占用一个空闲槽位
+         *
+         * @param p_out_owner 占用成功时写入此次占用的owner，之后以它刷新心跳和释放槽位
+         * @return std::size_t 槽位下标，没有空闲槽位时返回MAX_SUBSCRIBER_COUNT
+         */
+        std::size_t RegisterSubscriber(
+            const std::uint32_t process_id,
+            const std::uint64_t now_ms,
+            const std::uint32_t capture_flags,
+            std::uint64_t* p_out_owner) noexcept
+        {
+            for (std::size_t i = 0; i < MAX_SUBSCRIBER_COUNT; ++i)
+            {
+                auto& slot = subscribers[i];
+                auto owner = slot.owner.load(std::memory_order_acquire);
+                if (SubscriberSlot::GetProcessId(owner) != 0)
+                {
+                    continue;
+                }
+                // 先写心跳再占用，回收者不会读到上一个占用者的旧心跳。同时竞争此槽位的客户端写入的时间几乎相同
+                slot.heartbeat_ms.store(now_ms, std::memory_order_relaxed);
+                const auto new_owner = ((owner & SubscriberSlot::GENERATION_MASK) + (1ull << 32)) | process_id;
+                if (slot.owner.compare_exchange_strong(owner, new_owner, std::memory_order_acq_rel))
+                {
+                    slot.capture_flags.store(capture_flags, std::memory_order_relaxed);
+                    *p_out_owner = new_owner;
+                    return i;
+                }
+            }
+            return MAX_SUBSCRIBER_COUNT;
+        }
+        /**
+         * @brief 槽位仍属于owner时刷新心跳
+         *
+         * @return false 槽位已被回收，需要重新占用
+         */
+        bool RefreshSubscriber(const std::size_t index, const std::uint64_t owner, const std::uint64_t now_ms) noexcept
+        {
+            if (index >= MAX_SUBSCRIBER_COUNT)
+            {
+                return false;
+            }
+            auto& slot = subscribers[index];
+            // 先确认占用者，不刷新已经属于其它客户端的槽位
+            if (slot.owner.load(std::memory_order_acquire) != owner)
+            {
+                return false;
+            }
+            slot.heartbeat_ms.store(now_ms, std::memory_order_release);
+            return true;
+        }
+        /**
+         * @brief 只释放仍属于owner的槽位，被回收后已被其它客户端占用的槽位不受影响
+         *
+         */
+        void UnregisterSubscriber(const std::size_t index, std::uint64_t owner) noexcept
+        {
+            if (index < MAX_SUBSCRIBER_COUNT)
+            {
+                subscribers[index].owner.compare_exchange_strong(
+                    owner,
+                    owner & SubscriberSlot::GENERATION_MASK,
+                    std::memory_order_acq_rel);
+            }
+        }
+        /**
+         * @brief 由注入DLL调用，回收心跳超时的槽位
+         *
+         * @param on_reaped 以被回收的客户端的进程ID调用
+         * @return std::size_t 仍然存活的客户端数量
+         */
+        template <class F>
+        std::size_t ReapStaleSubscribers(const std::uint64_t now_ms, F&& on_reaped) noexcept
+        {
+            std::size_t alive_count = 0;
+            for (auto& slot : subscribers)
+            {
+                auto owner = slot.owner.load(std::memory_order_acquire);
+                const auto process_id = SubscriberSlot::GetProcessId(owner);
+                if (process_id == 0)
+                {
+                    continue;
+                }
+                // 心跳可能由在now_ms之后才取时间的客户端写入，此时不是超时
+                const auto heartbeat_ms = slot.heartbeat_ms.load(std::memory_order_acquire);
+                if (heartbeat_ms < now_ms && now_ms - heartbeat_ms > SUBSCRIBER_HEARTBEAT_TIMEOUT_MS)
+                {
+                    // owner包含代数，槽位在此期间被释放并重新占用时比较失败
+                    if (slot.owner.compare_exchange_strong(
+                            owner,
+                            owner & SubscriberSlot::GENERATION_MASK,
+                            std::memory_order_acq_rel))
+                    {
+                        on_reaped(process_id);
+                    }
+                    continue;
+                }
+                ++alive_count;
+            }
+            return alive_count;
+        }
+        /**
+         * @brief 由注入DLL调用，获得所有存活客户端需要的捕获标志的并集
+         *
+         */
+        std::uint32_t GetSubscribedCaptureFlags() const noexcept
+        {
+            std::uint32_t result = FAST_CAPTURE_FLAG_NONE;
+            for (const auto& slot : subscribers)
+            {
+                if (slot.IsOccupied())
+                {
+                    result |= slot.capture_flags.load(std::memory_order_relaxed);
+                }
+            }
+            return result;
+        }
     };
 
     /**
-     * @brief 捕获图像的数据，读写前必须加锁
+     * @brief 捕获图像的数据，读写数据前必须通过seq_lock
      *
      */
-    struct CaptureImage
+    struct alignas(64) CaptureImage
     {
-        std::mutex lock{};
+        Utils::SeqLock seq_lock{};
         /**
-         * @brief 实际上在lock后还有一个成员std::byte data[];
+         * @brief 数据所属的帧，与数据一起在seq_lock保护下写入
+         *
+         */
+        std::uint64_t frame_index{};
+        std::uint64_t timestamp_us{};
+        /**
+         * @brief 数据的平面布局，与数据一起在seq_lock保护下写入。
+            描述信息中的布局只用于查询大小，复制时以这里的布局为准，否则可能以旧布局读出新数据
+         *
+         */
+        CapturePlane planes[FAST_CAPTURE_PLANE_COUNT]{};
+        /**
+         * @brief 实际上在头部后还有一个成员std::byte data[];
             但是C++不支持柔性数组，因此在这里不写出，而是通过后移指针来实现。
+            头部按64字节对齐，以便数据部分可以使用对齐的SIMD指令读写。
          *
-         * @return const std::byte* 移动到lock之后的指针
+         * @return std::byte* 移动到头部之后的指针
          */
-        const std::byte* GetDataPointer() noexcept
+        std::byte* GetDataPointer() noexcept
+        {
+            return reinterpret_cast<std::byte*>(this) + sizeof(CaptureImage);
+        }
+        const std::byte* GetDataPointer() const noexcept
         {
-            return reinterpret_cast<const std::byte*>(this) + sizeof(lock);
+            return reinterpret_cast<const std::byte*>(this) + sizeof(CaptureImage);
         }
     };
 }
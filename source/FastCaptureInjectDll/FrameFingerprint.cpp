@@ -0,0 +1,142 @@
+#include "FrameFingerprint.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAST_CAPTURE_FRAME_FINGERPRINT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Details
+    {
+        constexpr std::uint64_t FINGERPRINT_PRIME_1 = 0x9E3779B185EBCA87ull;
+        constexpr std::uint64_t FINGERPRINT_PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+        constexpr std::size_t FINGERPRINT_BLOCK_SIZE = 64;
+
+        inline std::uint64_t Avalanche(std::uint64_t value) noexcept
+        {
+            value ^= value >> 33;
+            value *= FINGERPRINT_PRIME_2;
+            value ^= value >> 29;
+            value *= FINGERPRINT_PRIME_1;
+            value ^= value >> 32;
+            return value;
+        }
+
+        /**
+         * @brief 以64字节为一块累加指纹，每块使用不同的密钥，保证结果与块的位置相关
+         *
+         */
+        class FingerprintAccumulator
+        {
+        private:
+#ifdef FAST_CAPTURE_FRAME_FINGERPRINT_USE_SSE2
+            __m128i accumulators_[4]{
+                _mm_set1_epi32(0x165667B1),
+                _mm_set1_epi32(0x27D4EB2F),
+                _mm_set1_epi32(0x61C88647),
+                _mm_set1_epi32(0x7F4A7C15)};
+            __m128i key_{_mm_set_epi32(0x3C6EF372, 0x1B873593, 0x5BD1E995, 0x85EBCA6B)};
+            const __m128i key_step_{_mm_set1_epi32(0x61C88647)};
+
+            static __m128i Accumulate(const __m128i accumulator, const __m128i data, const __m128i key) noexcept
+            {
+                // 与XXH3相同的累加方式：(data ^ key)的高低32位相乘，再加上交换过高低位的原始数据
+                const __m128i data_key = _mm_xor_si128(data, key);
+                const __m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, 0x31));
+                return _mm_add_epi64(accumulator, _mm_add_epi64(product, _mm_shuffle_epi32(data, 0x4E)));
+            }
+#else
+            std::uint64_t accumulators_[4]{
+                0x165667B1165667B1ull,
+                0x27D4EB2F27D4EB2Full,
+                0x61C8864761C88647ull,
+                0x7F4A7C157F4A7C15ull};
+            std::uint64_t key_{0x1B8735935BD1E995ull};
+#endif
+
+        public:
+            void AddBlock(const std::byte* p_block) noexcept
+            {
+#ifdef FAST_CAPTURE_FRAME_FINGERPRINT_USE_SSE2
+                const auto p_vector = reinterpret_cast<const __m128i*>(p_block);
+                for (int i = 0; i < 4; ++i)
+                {
+                    accumulators_[i] = Accumulate(accumulators_[i], _mm_loadu_si128(p_vector + i), key_);
+                }
+                key_ = _mm_add_epi32(key_, key_step_);
+#else
+                for (int i = 0; i < 4; ++i)
+                {
+                    std::uint64_t data[2];
+                    std::memcpy(data, p_block + i * sizeof(data), sizeof(data));
+                    accumulators_[i] = (accumulators_[i] ^ (data[0] + key_)) * FINGERPRINT_PRIME_1
+                                       + (data[1] ^ (key_ >> 7));
+                }
+                key_ += FINGERPRINT_PRIME_2;
+#endif
+            }
+            std::uint64_t Finish(const std::byte* p_tail, const std::size_t tail_size, const std::size_t total_size) noexcept
+            {
+                if (tail_size != 0)
+                {
+                    std::byte block[FINGERPRINT_BLOCK_SIZE]{};
+                    std::memcpy(block, p_tail, tail_size);
+                    AddBlock(block);
+                }
+                std::uint64_t lanes[8];
+#ifdef FAST_CAPTURE_FRAME_FINGERPRINT_USE_SSE2
+                for (int i = 0; i < 4; ++i)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + i * 2), accumulators_[i]);
+                }
+#else
+                for (int i = 0; i < 4; ++i)
+                {
+                    lanes[i * 2] = accumulators_[i];
+                    lanes[i * 2 + 1] = accumulators_[i] >> 17;
+                }
+#endif
+                std::uint64_t result = total_size * FINGERPRINT_PRIME_1;
+                for (const auto lane : lanes)
+                {
+                    result = (result ^ Avalanche(lane)) * FINGERPRINT_PRIME_2;
+                }
+                return Avalanche(result);
+            }
+        };
+    }
+
+    std::uint64_t MakeFrameFingerprint(const std::byte* p_data, const std::size_t size) noexcept
+    {
+        Details::FingerprintAccumulator accumulator{};
+        const auto block_count = size / Details::FINGERPRINT_BLOCK_SIZE;
+        for (std::size_t i = 0; i < block_count; ++i)
+        {
+            accumulator.AddBlock(p_data + i * Details::FINGERPRINT_BLOCK_SIZE);
+        }
+        const auto tail_offset = block_count * Details::FINGERPRINT_BLOCK_SIZE;
+        return accumulator.Finish(p_data + tail_offset, size - tail_offset, size);
+    }
+
+    std::uint64_t MakeSampledFrameFingerprint(
+        const std::byte* p_data,
+        const std::size_t size,
+        const std::size_t sample_count) noexcept
+    {
+        const auto block_count = size / Details::FINGERPRINT_BLOCK_SIZE;
+        if (block_count <= sample_count)
+        {
+            return MakeFrameFingerprint(p_data, size);
+        }
+        Details::FingerprintAccumulator accumulator{};
+        // 步长取奇数个块，避免与图像的行宽对齐而总是采样同一列
+        const auto stride = (block_count / sample_count) | 1;
+        for (std::size_t i = 0; i < block_count; i += stride)
+        {
+            accumulator.AddBlock(p_data + i * Details::FINGERPRINT_BLOCK_SIZE);
+        }
+        return accumulator.Finish(nullptr, 0, size);
+    }
+}
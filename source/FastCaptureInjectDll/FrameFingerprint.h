@@ -0,0 +1,28 @@
+#ifndef FAST_CAPTURE_INJECT_DLL_FRAME_FINGERPRINT_H
+#define FAST_CAPTURE_INJECT_DLL_FRAME_FINGERPRINT_H
+
+#include "FastCaptureDef.h"
+#include <cstddef>
+#include <cstdint>
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 计算整帧的64位指纹，用于判断两帧是否相同，不具备抗碰撞的安全性。
+        与位置相关，交换两个数据块会得到不同的指纹
+     *
+     */
+    std::uint64_t MakeFrameFingerprint(const std::byte* p_data, const std::size_t size) noexcept;
+
+    /**
+     * @brief 只对均匀分布的sample_count个64字节块计算指纹，
+        结果不同说明两帧一定不同，结果相同时需要再用MakeFrameFingerprint确认
+     *
+     */
+    std::uint64_t MakeSampledFrameFingerprint(
+        const std::byte* p_data,
+        const std::size_t size,
+        const std::size_t sample_count) noexcept;
+}
+
+#endif // FAST_CAPTURE_INJECT_DLL_FRAME_FINGERPRINT_H
@@ -0,0 +1,85 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <limits>
+
+FAST_CAPTURE_NAMESPACE
+{
+    std::uint64_t FramePacer::UpdateAverage(const std::uint64_t average, const std::uint64_t sample) noexcept
+    {
+        if (average == 0)
+        {
+            return sample;
+        }
+        return sample >= average
+                   ? average + ((sample - average) >> EWMA_SHIFT)
+                   : average - ((average - sample) >> EWMA_SHIFT);
+    }
+
+    bool FramePacer::IsPaced(
+        const std::uint64_t now_us,
+        const std::uint64_t last_swap_us,
+        const std::uint64_t swap_interval_us) noexcept
+    {
+        return last_swap_us != 0
+               && swap_interval_us != 0
+               && now_us >= last_swap_us
+               && now_us - last_swap_us <= swap_interval_us * STALLED_SWAP_INTERVAL_COUNT;
+    }
+
+    void FramePacer::RecordSwap(const std::uint64_t swap_us) noexcept
+    {
+        const auto last_swap_us = last_swap_us_.load(std::memory_order_relaxed);
+        if (last_swap_us != 0 && swap_us > last_swap_us && swap_us - last_swap_us <= MAX_SWAP_INTERVAL_US)
+        {
+            swap_interval_us_.store(
+                UpdateAverage(swap_interval_us_.load(std::memory_order_relaxed), swap_us - last_swap_us),
+                std::memory_order_relaxed);
+        }
+        last_swap_us_.store(swap_us, std::memory_order_release);
+    }
+
+    void FramePacer::RecordWorkCost(const std::uint64_t cost_us) noexcept
+    {
+        work_cost_us_ = UpdateAverage(work_cost_us_, cost_us);
+    }
+
+    std::uint64_t FramePacer::GetDeadlineUs(const std::uint64_t now_us, const std::uint32_t cpu_budget_us) const noexcept
+    {
+        if (cpu_budget_us == FAST_CAPTURE_FRAME_CPU_BUDGET_UNLIMITED)
+        {
+            return std::numeric_limits<std::uint64_t>::max();
+        }
+        const auto budget_us = cpu_budget_us == 0 ? DEFAULT_FRAME_CPU_BUDGET_US : cpu_budget_us;
+        auto result = now_us + budget_us;
+        const auto last_swap_us = last_swap_us_.load(std::memory_order_acquire);
+        const auto swap_interval_us = swap_interval_us_.load(std::memory_order_relaxed);
+        if (!IsPaced(now_us, last_swap_us, swap_interval_us))
+        {
+            // 还没有帧节奏，或目标程序没有在绘制，没有需要避让的下一帧
+            return result;
+        }
+        return std::min(result, last_swap_us + swap_interval_us / IDLE_WINDOW_DIVISOR);
+    }
+
+    std::optional<std::uint64_t> FramePacer::GetWindowSwapUs(const std::uint64_t now_us) const noexcept
+    {
+        const auto last_swap_us = last_swap_us_.load(std::memory_order_acquire);
+        if (!IsPaced(now_us, last_swap_us, swap_interval_us_.load(std::memory_order_relaxed)))
+        {
+            return {};
+        }
+        return last_swap_us;
+    }
+
+    std::optional<std::uint64_t> FramePacer::GetNextWindowUs(const std::uint64_t now_us) const noexcept
+    {
+        const auto last_swap_us = last_swap_us_.load(std::memory_order_acquire);
+        const auto swap_interval_us = swap_interval_us_.load(std::memory_order_relaxed);
+        if (!IsPaced(now_us, last_swap_us, swap_interval_us))
+        {
+            return {};
+        }
+        // 预计的交换中第一个晚于now_us的
+        return last_swap_us + ((now_us - last_swap_us) / swap_interval_us + 1) * swap_interval_us;
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef FAST_CAPTURE_INJECT_DLL_FRAME_PACER_H
+#define FAST_CAPTURE_INJECT_DLL_FRAME_PACER_H
+
+#include "FastCaptureDef.h"
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 以交换间隔的指数加权移动平均估计目标程序的帧节奏，
+        把读回线程映射、转换和发布的工作安排在交换之后的空闲窗口中，
+        并限制每帧用于这些工作的CPU时间，避免与目标程序的下一帧争抢
+     *
+     */
+    class FramePacer
+    {
+    private:
+        /**
+         * @brief 移动平均的权重为1/(1<<EWMA_SHIFT)
+         *
+         */
+        constexpr static std::uint32_t EWMA_SHIFT = 3;
+        /**
+         * @brief 超过此值的交换间隔（例如窗口被最小化）不计入帧节奏
+         *
+         */
+        constexpr static std::uint64_t MAX_SWAP_INTERVAL_US = 250000;
+        /**
+         * @brief 空闲窗口在预计的下一次交换之前结束，为交换间隔的一半
+         *
+         */
+        constexpr static std::uint64_t IDLE_WINDOW_DIVISOR = 2;
+        /**
+         * @brief 超过这么多个交换间隔没有交换时认为目标程序停止了绘制，不再限制在空闲窗口中
+         *
+         */
+        constexpr static std::uint64_t STALLED_SWAP_INTERVAL_COUNT = 2;
+
+        /**
+         * @brief 由被Hook的线程写入，读回线程读取，由Windows::GetTimestampUs获得
+         *
+         */
+        std::atomic<std::uint64_t> last_swap_us_{0};
+        std::atomic<std::uint64_t> swap_interval_us_{0};
+        /**
+         * @brief 发布一帧的CPU时间的移动平均，只在读回线程中使用
+         *
+         */
+        std::uint64_t work_cost_us_{0};
+
+        static std::uint64_t UpdateAverage(const std::uint64_t average, const std::uint64_t sample) noexcept;
+        /**
+         * @brief 有帧节奏并且目标程序仍在绘制
+         *
+         */
+        static bool IsPaced(const std::uint64_t now_us, const std::uint64_t last_swap_us, const std::uint64_t swap_interval_us) noexcept;
+
+    public:
+        /**
+         * @brief 为0时使用DEFAULT_FRAME_CPU_BUDGET_US
+         *
+         */
+        constexpr static std::uint32_t DEFAULT_FRAME_CPU_BUDGET_US = 2000;
+
+        /**
+         * @brief 由被Hook的线程在每次交换时调用，只读写原子变量，不加锁
+         *
+         */
+        void RecordSwap(const std::uint64_t swap_us) noexcept;
+        /**
+         * @brief 由读回线程在完成一项工作后调用
+         *
+         */
+        void RecordWorkCost(const std::uint64_t cost_us) noexcept;
+        /**
+         * @brief 由读回线程在被唤醒时调用，获得这一帧的工作必须完成的时刻。
+            取预算耗尽的时刻与空闲窗口结束的时刻中较早的一个
+         *
+         * @param cpu_budget_us FAST_CAPTURE_FRAME_CPU_BUDGET_UNLIMITED时不限制
+         */
+        std::uint64_t GetDeadlineUs(const std::uint64_t now_us, const std::uint32_t cpu_budget_us) const noexcept;
+        /**
+         * @brief 按移动平均估计的开销判断下一项工作能否在deadline_us之前完成
+         *
+         */
+        bool IsWorkFit(const std::uint64_t now_us, const std::uint64_t deadline_us) const noexcept
+        {
+            return now_us + work_cost_us_ <= deadline_us;
+        }
+        /**
+         * @brief 当前空闲窗口的标识，即开始此窗口的交换的时刻。
+            没有帧节奏或目标程序停止绘制时没有空闲窗口，返回空
+         *
+         */
+        std::optional<std::uint64_t> GetWindowSwapUs(const std::uint64_t now_us) const noexcept;
+        /**
+         * @brief 下一个空闲窗口开始的时刻，即预计的下一次交换。
+            没有帧节奏或目标程序停止绘制时返回空
+         *
+         */
+        std::optional<std::uint64_t> GetNextWindowUs(const std::uint64_t now_us) const noexcept;
+        std::uint64_t GetSwapIntervalUs() const noexcept
+        {
+            return swap_interval_us_.load(std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif // FAST_CAPTURE_INJECT_DLL_FRAME_PACER_H
@@ -1,7 +1,8 @@
 #include "GLCapture.h"
+#include <chrono>
 #include <optional>
 #include "../Utils/Utils.hpp"
-#include "GL/gl.h"
+#include "../Utils/GLFunctions.hpp"
 
 FAST_CAPTURE_NAMESPACE
 {
@@ -25,7 +26,7 @@ FAST_CAPTURE_NAMESPACE
                          {
                            if (opt_id)
                            {
-                               ::glBindTexture(GL_TEXTURE_2D, opt_id.value());
+                               GlFunctions::GetCurrent().BindTexture(GL_TEXTURE_2D, opt_id.value());
                             } }),
                 OptionalVerifier>;
     }
@@ -33,7 +34,7 @@ FAST_CAPTURE_NAMESPACE
         ->Details::AutoRecoveryGlTexture2DId
     {
         GLint old_id{-1};
-        ::glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_id);
+        GlFunctions::GetCurrent().GetIntegerv(GL_TEXTURE_BINDING_2D, &old_id);
         if (old_id == -1)
             [[unlikely]]
         {
@@ -56,7 +57,78 @@ FAST_CAPTURE_NAMESPACE
     GLCapture::~GLCapture() = default;
     // 在Windows下共享上下文
     // https://stackoverflow.com/questions/64271775/sharing-opengl-context-on-windows
-    void GLCapture::operator()(GLuint target_texture_id) const noexcept
+    GLsync GLCapture::operator()(const GLCaptureTargets& targets, const GLCaptureCost& cost) const noexcept
     {
+        const auto begin_time = std::chrono::steady_clock::now();
+        const auto& gl = GlFunctions::GetCurrent();
+        const auto p_gpu_timer_query_ring = cost.p_gpu_timer_query_ring;
+        if (p_gpu_timer_query_ring != nullptr)
+        {
+            p_gpu_timer_query_ring->Collect(
+                [p_gpu_cost = cost.p_gpu_cost](const std::uint64_t elapsed_ns)
+                {
+                    if (p_gpu_cost != nullptr)
+                    {
+                        p_gpu_cost->Record(elapsed_ns);
+                    }
+                });
+            p_gpu_timer_query_ring->Begin();
+        }
+        GLint old_read_fbo_id{0};
+        GLint old_draw_fbo_id{0};
+        gl.GetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &old_read_fbo_id);
+        gl.GetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &old_draw_fbo_id);
+        // glBlitFramebuffer受裁剪测试影响
+        const auto is_scissor_test_enabled = gl.IsEnabled(GL_SCISSOR_TEST);
+        if (is_scissor_test_enabled)
+        {
+            gl.Disable(GL_SCISSOR_TEST);
+        }
+
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, targets.draw_fbo_id);
+        gl.FramebufferTexture2D(
+            GL_DRAW_FRAMEBUFFER,
+            GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D,
+            targets.color_texture_id,
+            0);
+        gl.FramebufferTexture2D(
+            GL_DRAW_FRAMEBUFFER,
+            GL_DEPTH_STENCIL_ATTACHMENT,
+            GL_TEXTURE_2D,
+            targets.depth_stencil_texture_id,
+            0);
+        GLbitfield blit_mask = GL_COLOR_BUFFER_BIT;
+        if (targets.depth_stencil_texture_id != 0)
+        {
+            blit_mask |= GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+        }
+        gl.BlitFramebuffer(
+            0, 0, targets.width, targets.height,
+            0, 0, targets.width, targets.height,
+            blit_mask,
+            GL_NEAREST);
+        if (p_gpu_timer_query_ring != nullptr)
+        {
+            p_gpu_timer_query_ring->End();
+        }
+
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(old_read_fbo_id));
+        gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(old_draw_fbo_id));
+        if (is_scissor_test_enabled)
+        {
+            gl.Enable(GL_SCISSOR_TEST);
+        }
+
+        auto fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // 栅栏必须被提交，另一个上下文才能等待它
+        gl.Flush();
+        if (cost.p_cpu_cost != nullptr)
+        {
+            cost.p_cpu_cost->Record(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_time).count()));
+        }
+        return fence;
     }
 }
@@ -2,10 +2,41 @@
 #define FAST_CAPTURE_INJECT_DLL_GL_CAPTURE_H
 
 #include "FastCaptureDef.h"
-#include "GL/glew.h"
+#include "../Utils/GLDef.hpp"
+#include "FastCaptureInjectDllDef.h"
+#include "GpuTimerQueryRing.h"
 
 FAST_CAPTURE_NAMESPACE
 {
+    /**
+     * @brief 复制的目标。纹理与读回线程的上下文共享，fbo属于被Hook的上下文
+     *
+     */
+    struct GLCaptureTargets
+    {
+        GLuint draw_fbo_id{0};
+        GLuint color_texture_id{0};
+        /**
+         * @brief GL_DEPTH24_STENCIL8格式的纹理，为0时不复制深度和模板
+         *
+         */
+        GLuint depth_stencil_texture_id{0};
+        GLint width{0};
+        GLint height{0};
+    };
+
+    /**
+     * @brief 记录捕获给目标程序增加的开销，成员为nullptr时不记录对应的开销。
+        计时查询环与targets一样属于被Hook的上下文，需要跨帧保存
+     *
+     */
+    struct GLCaptureCost
+    {
+        GpuTimerQueryRing* p_gpu_timer_query_ring{nullptr};
+        CostHistogram* p_cpu_cost{nullptr};
+        CostHistogram* p_gpu_cost{nullptr};
+    };
+
     /**
      * @brief 此类用于在被Hook的名为类似于SwapBuffer的函数中构造、执行括号重载和析构，
         例如：GLCapture{}();
@@ -18,7 +49,14 @@ FAST_CAPTURE_NAMESPACE
     public:
         GLCapture();
         ~GLCapture();
-        void operator()(GLuint target_texture_id) const noexcept;
+        /**
+         * @brief 把默认帧缓冲复制到targets中，调用前需要以GlFunctions::SetCurrent设置被Hook的上下文的函数表。
+            OpenGL ES上下文不复制深度和模板，此时targets.depth_stencil_texture_id应为0
+         *
+         * @param cost 复制命令的GPU时间在之后的帧中结果可用时才记录
+         * @return GLsync 复制完成的栅栏，读回线程需要先glWaitSync再读取纹理
+         */
+        GLsync operator()(const GLCaptureTargets& targets, const GLCaptureCost& cost = {}) const noexcept;
 
     private:
         class AutoRecoveryGlTexture2DId;
@@ -0,0 +1,58 @@
+#include "GpuTimerQueryRing.h"
+
+FAST_CAPTURE_NAMESPACE
+{
+    GpuTimerQueryRing::~GpuTimerQueryRing()
+    {
+        if (query_ids_.empty())
+        {
+            return;
+        }
+        const auto& gl = GlFunctions::GetCurrent();
+        if (is_query_active_)
+        {
+            gl.EndQuery(GL_TIME_ELAPSED);
+        }
+        gl.DeleteQueries(static_cast<GLsizei>(query_ids_.size()), query_ids_.data());
+    }
+
+    void GpuTimerQueryRing::Initialize(const std::size_t slot_count)
+    {
+        const auto& gl = GlFunctions::GetCurrent();
+        if (!gl.is_timer_query_supported || slot_count == 0)
+        {
+            return;
+        }
+        query_ids_.resize(slot_count);
+        gl.GenQueries(static_cast<GLsizei>(slot_count), query_ids_.data());
+    }
+
+    bool GpuTimerQueryRing::Begin() noexcept
+    {
+        if (query_ids_.empty() || pending_count_ == query_ids_.size())
+        {
+            return false;
+        }
+        const auto& gl = GlFunctions::GetCurrent();
+        GLint current_query_id{0};
+        gl.GetQueryiv(GL_TIME_ELAPSED, GL_CURRENT_QUERY, &current_query_id);
+        if (current_query_id != 0)
+        {
+            return false;
+        }
+        gl.BeginQuery(GL_TIME_ELAPSED, query_ids_[(head_ + pending_count_) % query_ids_.size()]);
+        is_query_active_ = true;
+        return true;
+    }
+
+    void GpuTimerQueryRing::End() noexcept
+    {
+        if (!is_query_active_)
+        {
+            return;
+        }
+        GlFunctions::GetCurrent().EndQuery(GL_TIME_ELAPSED);
+        is_query_active_ = false;
+        ++pending_count_;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef FAST_CAPTURE_INJECT_DLL_GPU_TIMER_QUERY_RING_H
+#define FAST_CAPTURE_INJECT_DLL_GPU_TIMER_QUERY_RING_H
+
+#include "FastCaptureDef.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Utils/GLFunctions.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 由多个GL_TIME_ELAPSED查询组成的环形队列，测量注入DLL自己提交的命令的GPU时间。
+        结果只在可用时取出，所有查询都在等待GPU时跳过这一帧的计时，因此永远不会等待GPU。
+        查询属于创建它的上下文，只能在该上下文为当前上下文时使用和析构
+     *
+     */
+    class GpuTimerQueryRing
+    {
+    private:
+        std::vector<GLuint> query_ids_{};
+        /**
+         * @brief 最早结束、尚未取出结果的查询
+         *
+         */
+        std::size_t head_{0};
+        std::size_t pending_count_{0};
+        bool is_query_active_{false};
+
+    public:
+        GpuTimerQueryRing() = default;
+        ~GpuTimerQueryRing();
+        GpuTimerQueryRing(const GpuTimerQueryRing&) = delete;
+        GpuTimerQueryRing& operator=(const GpuTimerQueryRing&) = delete;
+
+        /**
+         * @brief 当前上下文不支持计时查询时不创建查询，之后Begin总是返回false
+         *
+         */
+        void Initialize(const std::size_t slot_count);
+        /**
+         * @brief 在要计时的命令之前调用。
+            目标程序自己的GL_TIME_ELAPSED查询正在进行时不计时，因为同一类型的查询不能嵌套
+         *
+         * @return true 开始了计时
+         */
+        bool Begin() noexcept;
+        /**
+         * @brief 在要计时的命令之后调用，Begin没有开始计时时什么也不做
+         *
+         */
+        void End() noexcept;
+        /**
+         * @brief 按结束的顺序取出所有已经可用的结果，以GPU时间的纳秒数调用on_elapsed_ns(std::uint64_t)。
+            不读取GL_GPU_DISJOINT_EXT，读取它会清除目标程序自己的计时查询依赖的标志
+         *
+         */
+        template <class F>
+        void Collect(F&& on_elapsed_ns) noexcept
+        {
+            if (pending_count_ == 0)
+            {
+                return;
+            }
+            const auto& gl = GlFunctions::GetCurrent();
+            while (pending_count_ != 0)
+            {
+                const auto query_id = query_ids_[head_];
+                GLuint is_available{GL_FALSE};
+                gl.GetQueryObjectuiv(query_id, GL_QUERY_RESULT_AVAILABLE, &is_available);
+                if (is_available == GL_FALSE)
+                {
+                    return;
+                }
+                GLuint64 elapsed_ns{0};
+                gl.GetQueryObjectui64v(query_id, GL_QUERY_RESULT, &elapsed_ns);
+                head_ = (head_ + 1) % query_ids_.size();
+                --pending_count_;
+                on_elapsed_ns(static_cast<std::uint64_t>(elapsed_ns));
+            }
+        }
+    };
+}
+
+#endif // FAST_CAPTURE_INJECT_DLL_GPU_TIMER_QUERY_RING_H
@@ -0,0 +1,127 @@
+#include "PboRing.h"
+#include <cstdint>
+
+FAST_CAPTURE_NAMESPACE
+{
+    PboRing::~PboRing()
+    {
+        const auto& gl = GlFunctions::GetCurrent();
+        for (auto& slot : slots_)
+        {
+            if (slot.fence != nullptr)
+            {
+                gl.DeleteSync(slot.fence);
+            }
+            if (slot.buffer_id != 0)
+            {
+                gl.DeleteBuffers(1, &slot.buffer_id);
+            }
+        }
+    }
+
+    void PboRing::Initialize(const std::size_t slot_count)
+    {
+        const auto& gl = GlFunctions::GetCurrent();
+        slots_.resize(slot_count);
+        for (auto& slot : slots_)
+        {
+            gl.GenBuffers(1, &slot.buffer_id);
+        }
+    }
+
+    void PboRing::PackPlane(const CapturePlane& plane, const GLuint color_texture_id) noexcept
+    {
+        const auto& gl = GlFunctions::GetCurrent();
+        if (plane.size == 0)
+        {
+            return;
+        }
+        if (plane.mip_level != 0)
+        {
+            gl.FramebufferTexture2D(
+                GL_READ_FRAMEBUFFER,
+                GL_COLOR_ATTACHMENT0,
+                GL_TEXTURE_2D,
+                color_texture_id,
+                plane.mip_level);
+        }
+        gl.PixelStorei(GL_PACK_ALIGNMENT, plane.pixel_size >= 4 ? 4 : 1);
+        gl.ReadPixels(
+            0,
+            0,
+            plane.width,
+            plane.height,
+            plane.gl_format,
+            plane.gl_type,
+            reinterpret_cast<void*>(static_cast<std::uintptr_t>(plane.offset)));
+        if (plane.mip_level != 0)
+        {
+            gl.FramebufferTexture2D(
+                GL_READ_FRAMEBUFFER,
+                GL_COLOR_ATTACHMENT0,
+                GL_TEXTURE_2D,
+                color_texture_id,
+                0);
+        }
+    }
+
+    bool PboRing::Pack(const PboFrameLayout& layout, const GLuint color_texture_id) noexcept
+    {
+        if (slots_.empty() || pending_count_ == slots_.size())
+        {
+            return false;
+        }
+        const auto& gl = GlFunctions::GetCurrent();
+        auto& slot = slots_[(head_ + pending_count_) % slots_.size()];
+        gl.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+        if (slot.capacity < layout.total_size)
+        {
+            gl.BufferData(
+                GL_PIXEL_PACK_BUFFER,
+                static_cast<GLsizeiptr>(layout.total_size),
+                nullptr,
+                GL_STREAM_READ);
+            slot.capacity = layout.total_size;
+        }
+        slot.layout = layout;
+
+        GLint old_pack_alignment{4};
+        gl.GetIntegerv(GL_PACK_ALIGNMENT, &old_pack_alignment);
+        for (const auto& plane : layout.planes)
+        {
+            PackPlane(plane, color_texture_id);
+        }
+        gl.PixelStorei(GL_PACK_ALIGNMENT, old_pack_alignment);
+
+        slot.fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // 以0超时轮询的栅栏不会自行提交，未提交的栅栏可能永远不会被触发
+        gl.Flush();
+        gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        ++pending_count_;
+        return true;
+    }
+
+    bool PboRing::IsReady() const noexcept
+    {
+        if (pending_count_ == 0)
+        {
+            return false;
+        }
+        const auto wait_result = GlFunctions::GetCurrent().ClientWaitSync(slots_[head_].fence, 0, 0);
+        return wait_result == GL_ALREADY_SIGNALED || wait_result == GL_CONDITION_SATISFIED;
+    }
+
+    bool PboRing::DiscardReady() noexcept
+    {
+        if (!IsReady())
+        {
+            return false;
+        }
+        auto& slot = slots_[head_];
+        GlFunctions::GetCurrent().DeleteSync(slot.fence);
+        slot.fence = nullptr;
+        head_ = (head_ + 1) % slots_.size();
+        --pending_count_;
+        return true;
+    }
+}
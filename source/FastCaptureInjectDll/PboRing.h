@@ -0,0 +1,163 @@
+#ifndef FAST_CAPTURE_INJECT_DLL_PBO_RING_H
+#define FAST_CAPTURE_INJECT_DLL_PBO_RING_H
+
+#include "FastCaptureDef.h"
+#include <cstddef>
+#include <vector>
+#include "FastCaptureInjectDllDef.h"
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 一帧读回请求的布局，平面的offset同时也是它在PBO中的偏移
+     *
+     */
+    struct PboFrameLayout
+    {
+        /**
+         * @brief 被Hook的函数复制此帧的时刻，随布局一起保存在槽位中
+         *
+         */
+        std::uint64_t timestamp_us{};
+        GLint width{};
+        GLint height{};
+        std::uint32_t capture_flags{FAST_CAPTURE_FLAG_NONE};
+        CapturePlane planes[FAST_CAPTURE_PLANE_COUNT]{};
+        std::uint64_t total_size{};
+        /**
+         * @brief 读回线程提交读回命令的时刻
+         *
+         */
+        std::uint64_t pack_timestamp_us{};
+    };
+
+    /**
+     * @brief 计算读回capture_flags所需的PBO布局。
+        同时捕获24位深度和模板时，模板从GL_UNSIGNED_INT_24_8的低8位中取出，不单独读回
+     *
+     */
+    inline PboFrameLayout MakePboFrameLayout(const GLint width, const GLint height, const std::uint32_t capture_flags) noexcept
+    {
+        auto pbo_capture_flags = capture_flags & ~FAST_CAPTURE_FLAG_LINEAR_DEPTH;
+        if ((pbo_capture_flags & FAST_CAPTURE_FLAG_DEPTH_24) && !(pbo_capture_flags & FAST_CAPTURE_FLAG_DEPTH_FLOAT))
+        {
+            pbo_capture_flags &= ~FAST_CAPTURE_FLAG_STENCIL;
+        }
+        PboFrameLayout result{0, width, height, capture_flags};
+        result.total_size = MakeCapturePlanes(width, height, pbo_capture_flags, result.planes);
+        return result;
+    }
+
+    /**
+     * @brief 由多个PBO组成的环形队列，在读回线程的OpenGL上下文中使用。
+        Pack只提交异步的glReadPixels并插入栅栏，ConsumeReady只处理栅栏已经触发的帧，
+        因此读回线程永远不会等待GPU
+     *
+     */
+    class PboRing
+    {
+    private:
+        struct Slot
+        {
+            GLuint buffer_id{0};
+            std::uint64_t capacity{0};
+            GLsync fence{nullptr};
+            PboFrameLayout layout{};
+        };
+
+        std::vector<Slot> slots_{};
+        /**
+         * @brief 最早提交、尚未被消费的槽位
+         *
+         */
+        std::size_t head_{0};
+        std::size_t pending_count_{0};
+
+        static void PackPlane(const CapturePlane& plane, const GLuint color_texture_id) noexcept;
+
+    public:
+        PboRing() = default;
+        ~PboRing();
+        PboRing(const PboRing&) = delete;
+        PboRing& operator=(const PboRing&) = delete;
+
+        void Initialize(const std::size_t slot_count);
+        /**
+         * @brief 从当前绑定到GL_READ_FRAMEBUFFER的帧缓冲读回一帧。
+            color_texture_id的第0层必须已经附加到GL_COLOR_ATTACHMENT0，
+            读回mip_level不为0的平面时会临时附加对应的层级
+         *
+         * @return true 已提交；false 所有槽位都在等待GPU，此帧被丢弃
+         */
+        bool Pack(const PboFrameLayout& layout, const GLuint color_texture_id) noexcept;
+        /**
+         * @brief 若最早提交的帧已经完成，则映射它并调用consumer(const std::byte*, const PboFrameLayout&)
+         *
+         * @return true 消费了一帧
+         */
+        template <class F>
+        bool ConsumeReady(F&& consumer) noexcept
+        {
+            if (pending_count_ == 0)
+            {
+                return false;
+            }
+            const auto& gl = GlFunctions::GetCurrent();
+            auto& slot = slots_[head_];
+            const auto wait_result = gl.ClientWaitSync(slot.fence, 0, 0);
+            if (wait_result != GL_ALREADY_SIGNALED && wait_result != GL_CONDITION_SATISFIED)
+            {
+                return false;
+            }
+            gl.DeleteSync(slot.fence);
+            slot.fence = nullptr;
+
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+            const auto p_data = gl.MapBufferRange(
+                GL_PIXEL_PACK_BUFFER,
+                0,
+                static_cast<GLsizeiptr>(slot.layout.total_size),
+                GL_MAP_READ_BIT);
+            if (p_data != nullptr)
+                [[likely]]
+            {
+                consumer(static_cast<const std::byte*>(p_data), slot.layout);
+                gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            head_ = (head_ + 1) % slots_.size();
+            --pending_count_;
+            return p_data != nullptr;
+        }
+        /**
+         * @brief 最早提交的帧的读回是否已经完成，不消费它
+         *
+         */
+        bool IsReady() const noexcept;
+        /**
+         * @brief 若最早提交的帧已经完成，则不映射就释放它的槽位，用于给更新的帧腾出位置
+         *
+         * @return true 丢弃了一帧
+         */
+        bool DiscardReady() noexcept;
+        /**
+         * @brief 最早提交、尚未被消费的帧的布局，GetPendingCount()不为0时才能调用
+         *
+         */
+        const PboFrameLayout& GetOldestLayout() const noexcept
+        {
+            return slots_[head_].layout;
+        }
+        bool IsFull() const noexcept
+        {
+            return pending_count_ == slots_.size();
+        }
+        std::size_t GetPendingCount() const noexcept
+        {
+            return pending_count_;
+        }
+    };
+}
+
+#endif // FAST_CAPTURE_INJECT_DLL_PBO_RING_H
@@ -4,6 +4,8 @@
 #include "FastCaptureDef.h"
 #include <string>
 #include "../FastCaptureInjectDllDef.h"
+#include "GlReadPixelsThread.h"
+#include "FrameEvents.hpp"
 #include "../../Utils/Windows/UtilsWindows.hpp"
 
 FAST_CAPTURE_NAMESPACE
@@ -36,6 +38,23 @@ FAST_CAPTURE_NAMESPACE
          *
          */
         std::wstring shared_memory_name_prefix_{};
+        /**
+         * @brief 此变量在FastCaptureInitInjectDll中初始化，之后不会被修改。
+            AUTO_RESET的具名事件，客户端占用槽位后设置它，唤醒休眠中的读回线程
+         *
+         */
+        Windows::UniqueHandleInvalidNULL h_attach_event_{};
+        /**
+         * @brief 此变量在FastCaptureInitInjectDll中初始化，之后不会被修改
+         *
+         */
+        FrameEvents frame_events_{};
+        /**
+         * @brief 在FastCaptureInitInjectDll中启动，之后在DLL的生命周期内一直存在，
+            再次注入时不会重新启动
+         *
+         */
+        GlReadPixelsThread read_pixels_thread_{};
 
     private:
         DllData() = default;
@@ -0,0 +1,125 @@
+#include "EglContext.h"
+
+FAST_CAPTURE_NAMESPACE
+{
+    EglContext::~EglContext()
+    {
+        Destroy();
+    }
+
+    FastCaptureErrorCode EglContext::MakeEglError(const std::uint16_t fast_capture_error_code) const noexcept
+    {
+        return {
+            fast_capture_error_code,
+            FAST_CAPTURE_ERROR_TYPE_EGL,
+            static_cast<std::uint32_t>(egl_.GetError())};
+    }
+
+    void* EglContext::GetGlProcAddress(const char* name) const noexcept
+    {
+        auto p_function = egl_.GetProcAddress(name);
+        if (p_function == nullptr && h_gles_module_ != nullptr)
+        {
+            p_function = reinterpret_cast<void*>(::GetProcAddress(h_gles_module_, name));
+        }
+        return p_function;
+    }
+
+    void EglContext::Destroy() noexcept
+    {
+        if (context_ != nullptr)
+        {
+            egl_.MakeCurrent(display_, nullptr, nullptr, nullptr);
+            egl_.DestroyContext(display_, context_);
+            context_ = nullptr;
+            GlFunctions::SetCurrent(nullptr);
+        }
+        if (surface_ != nullptr)
+        {
+            egl_.DestroySurface(display_, surface_);
+            surface_ = nullptr;
+        }
+    }
+
+    FastCaptureErrorCode EglContext::Initialize() noexcept
+    {
+        // 不增加引用计数，目标程序卸载EGL时它的上下文也已经不存在了
+        const auto h_egl_module = ::GetModuleHandleW(L"libEGL.dll");
+        if (h_egl_module == nullptr)
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_LOAD_EGL_FAILED);
+        }
+        bool is_all_loaded = true;
+#define FAST_CAPTURE_EGL_LOAD_FUNCTION(return_type, name, parameters)                                      \
+    egl_.name = reinterpret_cast<decltype(egl_.name)>(::GetProcAddress(h_egl_module, "egl" #name)); \
+    is_all_loaded = is_all_loaded && egl_.name != nullptr;
+        FAST_CAPTURE_EGL_FUNCTION_LIST(FAST_CAPTURE_EGL_LOAD_FUNCTION)
+#undef FAST_CAPTURE_EGL_LOAD_FUNCTION
+        if (!is_all_loaded)
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_LOAD_EGL_FAILED);
+        }
+        h_egl_module_ = h_egl_module;
+        h_gles_module_ = ::GetModuleHandleW(L"libGLESv2.dll");
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode EglContext::RecreateContextAndShareContextFrom(
+        const Egl::Display display,
+        const Egl::Context shared_context) noexcept
+    {
+        Destroy();
+        display_ = display;
+
+        Egl::Int config_id{0};
+        Egl::Int client_version{0};
+        if (!egl_.QueryContext(display, shared_context, Egl::CONFIG_ID, &config_id)
+            || !egl_.QueryContext(display, shared_context, Egl::CONTEXT_CLIENT_VERSION, &client_version))
+        {
+            return MakeEglError(FAST_CAPTURE_E_CREATE_EGL_CONTEXT_FAILED);
+        }
+        if (client_version < 3)
+        {
+            return Utils::MakeError(FAST_CAPTURE_E_GLES_VERSION_NOT_SUPPORTED);
+        }
+
+        const Egl::Int config_attributes[] = {Egl::CONFIG_ID, config_id, Egl::NONE};
+        Egl::Config config{nullptr};
+        Egl::Int config_count{0};
+        if (!egl_.ChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0)
+        {
+            return MakeEglError(FAST_CAPTURE_E_CREATE_EGL_CONTEXT_FAILED);
+        }
+
+        // 读回只使用自己的fbo，表面只是为了能成为当前上下文。
+        // 配置不支持pbuffer时surface_为nullptr，此时依赖EGL_KHR_surfaceless_context，ANGLE总是支持它
+        const Egl::Int pbuffer_attributes[] = {Egl::WIDTH, 1, Egl::HEIGHT, 1, Egl::NONE};
+        surface_ = egl_.CreatePbufferSurface(display, config, pbuffer_attributes);
+
+        const Egl::Int context_attributes[] = {Egl::CONTEXT_CLIENT_VERSION, 3, Egl::NONE};
+        context_ = egl_.CreateContext(display, config, shared_context, context_attributes);
+        if (context_ == nullptr)
+        {
+            return MakeEglError(FAST_CAPTURE_E_CREATE_EGL_CONTEXT_FAILED);
+        }
+        if (!egl_.MakeCurrent(display, surface_, surface_, context_))
+        {
+            return MakeEglError(FAST_CAPTURE_E_EGL_MAKE_CURRENT_FAILED);
+        }
+
+        // eglGetProcAddress返回的地址与上下文无关，所以函数地址只需要获得一次
+        if (!is_gl_functions_loaded_)
+        {
+            auto load_result = gl_functions_.Load(
+                [this](const char* name)
+                { return GetGlProcAddress(name); });
+            if (!Utils::IsOk(load_result))
+            {
+                return load_result;
+            }
+            is_gl_functions_loaded_ = true;
+        }
+        GlFunctions::SetCurrent(&gl_functions_);
+        return FastCaptureMakeSuccessValue();
+    }
+}
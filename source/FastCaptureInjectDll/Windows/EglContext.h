@@ -0,0 +1,105 @@
+#ifndef FAST_CAPTURE_INJECT_DLL_EGL_CONTEXT_H
+#define FAST_CAPTURE_INJECT_DLL_EGL_CONTEXT_H
+
+#include "FastCaptureDef.h"
+#include <cstdint>
+#include <windows.h>
+#include "../../Utils/GLFunctions.hpp"
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+// EGL由目标程序自己加载（例如ANGLE的libEGL.dll），因此这里不链接EGL，只声明用到的类型和常量
+// https://registry.khronos.org/EGL/sdk/docs/man/html/eglCreateContext.xhtml
+
+/**
+ * @brief 读回线程用到的EGL函数
+ *
+ */
+#define FAST_CAPTURE_EGL_FUNCTION_LIST(X)                                                                           \
+    X(void*, GetProcAddress, (const char* name))                                                                    \
+    X(Egl::Int, GetError, ())                                                                                       \
+    X(Egl::Boolean, QueryContext, (Egl::Display display, Egl::Context context, Egl::Int attribute, Egl::Int * value)) \
+    X(Egl::Boolean, ChooseConfig, (Egl::Display display, const Egl::Int* attributes, Egl::Config* configs, Egl::Int config_size, Egl::Int* config_count)) \
+    X(Egl::Surface, CreatePbufferSurface, (Egl::Display display, Egl::Config config, const Egl::Int* attributes))  \
+    X(Egl::Boolean, DestroySurface, (Egl::Display display, Egl::Surface surface))                                   \
+    X(Egl::Context, CreateContext, (Egl::Display display, Egl::Config config, Egl::Context shared_context, const Egl::Int* attributes)) \
+    X(Egl::Boolean, DestroyContext, (Egl::Display display, Egl::Context context))                                   \
+    X(Egl::Boolean, MakeCurrent, (Egl::Display display, Egl::Surface draw, Egl::Surface read, Egl::Context context))
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Egl
+    {
+        using Display = void*;
+        using Context = void*;
+        using Surface = void*;
+        using Config = void*;
+        using Int = std::int32_t;
+        using Boolean = unsigned int;
+
+        constexpr Int CONFIG_ID = 0x3028;
+        constexpr Int HEIGHT = 0x3056;
+        constexpr Int WIDTH = 0x3057;
+        constexpr Int NONE = 0x3038;
+        constexpr Int CONTEXT_CLIENT_VERSION = 0x3098;
+
+        struct Functions
+        {
+#define FAST_CAPTURE_EGL_DECLARE_FUNCTION(return_type, name, parameters) \
+    return_type(WINAPI * name) parameters { nullptr };
+            FAST_CAPTURE_EGL_FUNCTION_LIST(FAST_CAPTURE_EGL_DECLARE_FUNCTION)
+#undef FAST_CAPTURE_EGL_DECLARE_FUNCTION
+        };
+    }
+
+    /**
+     * @brief 与被Hook的EGL上下文共享的OpenGL ES 3.0上下文，作用与WglContext相同。
+        只支持OpenGL ES 3.0及以上，PBO和栅栏在OpenGL ES 2.0中不存在
+     *
+     */
+    class EglContext
+    {
+    private:
+        HMODULE h_egl_module_{nullptr};
+        HMODULE h_gles_module_{nullptr};
+        Egl::Functions egl_{};
+        Egl::Display display_{nullptr};
+        Egl::Surface surface_{nullptr};
+        Egl::Context context_{nullptr};
+        GlFunctions gl_functions_{};
+        bool is_gl_functions_loaded_{false};
+
+        FastCaptureErrorCode MakeEglError(const std::uint16_t fast_capture_error_code) const noexcept;
+        /**
+         * @brief EGL 1.5之前eglGetProcAddress不一定能获得核心函数，失败时从libGLESv2.dll的导出中查找
+         *
+         */
+        void* GetGlProcAddress(const char* name) const noexcept;
+        void Destroy() noexcept;
+
+    public:
+        EglContext() = default;
+        ~EglContext();
+        EglContext(const EglContext&) = delete;
+        EglContext& operator=(const EglContext&) = delete;
+
+        /**
+         * @brief 从目标程序已经加载的libEGL.dll中获得EGL函数
+         *
+         */
+        FastCaptureErrorCode Initialize() noexcept;
+        /**
+         * @brief 以被共享的上下文的配置创建上下文和1x1的pbuffer表面。
+            成功后上下文为当前线程的当前上下文，它的函数表为当前线程的函数表
+         *
+         */
+        FastCaptureErrorCode RecreateContextAndShareContextFrom(
+            const Egl::Display display,
+            const Egl::Context shared_context) noexcept;
+        bool IsInitialized() const noexcept
+        {
+            return h_egl_module_ != nullptr;
+        }
+    };
+}
+
+#endif // FAST_CAPTURE_INJECT_DLL_EGL_CONTEXT_H
@@ -2,7 +2,7 @@
 #include <string>
 #include <Windows.h>
 #include "GlReadPixelsThread.h"
-#include "DllData.h"
+#include "DllData.hpp"
 #include "../FastCaptureInjectDllDef.h"
 #include "../../Utils/Windows/UtilsWindows.hpp"
 #include "GL/gl.h"
@@ -14,6 +14,11 @@ DWORD WINAPI FastCaptureInitInjectDll(LPVOID lpThreadParameter) FAST_CAPTURE_NOE
         return static_cast<DWORD>(FAST_CAPTURE_E_INVALID_ARGUMENT);
     }
     auto& dll_data = FAST_CAPTURE::DllData::GetInstance();
+    // 读回线程在DLL的生命周期内一直存在，再次注入时只需要确认它已经启动
+    if (!dll_data.p_capture_descriptor_.IsInvalid())
+    {
+        return FAST_CAPTURE_S_OK;
+    }
     auto p_w_shared_memory_name_prefix = static_cast<wchar_t*>(lpThreadParameter);
     dll_data.shared_memory_name_prefix_ = p_w_shared_memory_name_prefix;
     auto capture_descriptor_shared_name =
@@ -41,15 +46,39 @@ DWORD WINAPI FastCaptureInitInjectDll(LPVOID lpThreadParameter) FAST_CAPTURE_NOE
     {
         return FAST_CAPTURE_E_CREATE_SHARED_CAPTURE_DESCRIPTOR_MAP_OF_VIEW_FAILED;
     }
+    // 上一个注入DLL可能在写入途中崩溃，映射仍被客户端持有时序号会停留在奇数
+    p_shared_capture_descriptor.Get()->seq_lock.RecoverFromDeadWriter();
+    auto attach_event_shared_name =
+        std::wstring(L"Global\\") + dll_data.shared_memory_name_prefix_ + std::wstring(L"Attach");
+    FAST_CAPTURE::Windows::UniqueHandleInvalidNULL h_attach_event = ::CreateEventW(
+        nullptr,
+        FALSE,
+        FALSE,
+        attach_event_shared_name.c_str());
+    if (h_attach_event.IsInvalid())
+    {
+        return FAST_CAPTURE_E_CREATE_ATTACH_EVENT_FAILED;
+    }
+    dll_data.h_attach_event_ = std::move(h_attach_event);
+    if (auto result = dll_data.frame_events_.Initialize(dll_data.shared_memory_name_prefix_);
+        !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        return result.error_code;
+    }
     dll_data.p_capture_descriptor_ = std::move(p_shared_capture_descriptor);
     dll_data.h_capture_descriptor_ = std::move(h_capture_descriptor);
-    std::ignore = FAST_CAPTURE::ReadPixelsThread::GetInstance();
+    // 读回线程以休眠状态启动，不创建上下文，因此这里只等待线程本身启动
+    if (auto result = dll_data.read_pixels_thread_.Initialize(FAST_CAPTURE::READ_PIXELS_THREAD_INIT_TIMEOUT_MS);
+        !FAST_CAPTURE::Utils::IsOk(result))
+    {
+        return result.error_code;
+    }
     return FAST_CAPTURE_S_OK;
 }
 
 DWORD WINAPI FastCaptureDestroyDll([[maybe_unused]] LPVOID lpThreadParameter) FAST_CAPTURE_NOEXCEPT
 {
-    FAST_CAPTURE::ReadPixelsThread::GetInstance().RequestThreadStop();
+    std::ignore = FAST_CAPTURE::DllData::GetInstance().read_pixels_thread_.RequestStopThread();
     return FAST_CAPTURE_S_OK;
 }
 
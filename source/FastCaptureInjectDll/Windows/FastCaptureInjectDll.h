@@ -21,7 +21,12 @@ extern "C"
      *      捕获的图片的信息的共享内存名称为
      *          std::wstring(L"Global\\") + std::wstring(lpThreadParameter) + std::wstring(L"Descriptor")"
      *      捕获的图片的共享内存的名称为
-     *          std::wstring(L"Global\\") + std::wstring(lpThreadParameter)
+     *          std::wstring(L"Global\\") + std::wstring(lpThreadParameter) + std::to_wstring(CaptureDescriptor::capture_image_generation)
+     *      客户端占用槽位后设置的事件的名称为
+     *          std::wstring(L"Global\\") + std::wstring(lpThreadParameter) + std::wstring(L"Attach")
+     *      发布新帧后设置的、第i个客户端槽位的事件的名称为
+     *          std::wstring(L"Global\\") + std::wstring(lpThreadParameter) + std::wstring(L"Frame") + std::to_wstring(i)
+     *      DLL已经初始化过时直接返回成功，读回线程以休眠状态启动，有客户端时才创建OpenGL资源
      * @return FAST_CAPTURE_EXPORT 返回值一定可以被转换为有效的 FastCaptureErrorCode
      */
     FAST_CAPTURE_EXPORT
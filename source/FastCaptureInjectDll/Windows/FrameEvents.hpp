@@ -0,0 +1,63 @@
+#ifndef FAST_CAPTURE_INJECT_DLL_FRAME_EVENTS_HPP
+#define FAST_CAPTURE_INJECT_DLL_FRAME_EVENTS_HPP
+
+#include "FastCaptureDef.h"
+#include <cstddef>
+#include <string>
+#include <windows.h>
+#include "../FastCaptureInjectDllDef.h"
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    inline std::wstring MakeFrameEventName(const std::wstring& shared_memory_name_prefix, const std::size_t subscriber_index)
+    {
+        return std::wstring(L"Global\\") + shared_memory_name_prefix + std::wstring(L"Frame") + std::to_wstring(subscriber_index);
+    }
+
+    /**
+     * @brief 每个客户端槽位对应一个具名的AUTO_RESET事件，生产者发布新帧后设置被占用的槽位的事件。
+        客户端等待自己槽位的事件，不需要轮询frame_index，等待也可以交给线程池或事件循环而不占用线程
+     *
+     */
+    class FrameEvents
+    {
+    private:
+        Windows::UniqueHandleInvalidNULL h_frame_events_[MAX_SUBSCRIBER_COUNT]{};
+
+    public:
+        FastCaptureErrorCode Initialize(const std::wstring& shared_memory_name_prefix) noexcept
+        {
+            for (std::size_t i = 0; i < MAX_SUBSCRIBER_COUNT; ++i)
+            {
+                h_frame_events_[i] = ::CreateEventW(
+                    nullptr,
+                    FALSE,
+                    FALSE,
+                    MakeFrameEventName(shared_memory_name_prefix, i).c_str());
+                if (h_frame_events_[i].IsInvalid())
+                {
+                    return Windows::MakeError(FAST_CAPTURE_E_CREATE_FRAME_EVENT_FAILED);
+                }
+            }
+            return FastCaptureMakeSuccessValue();
+        }
+        /**
+         * @brief 在frame_index更新之后调用
+         *
+         */
+        void Notify(const CaptureDescriptor& capture_descriptor) const noexcept
+        {
+            for (std::size_t i = 0; i < MAX_SUBSCRIBER_COUNT; ++i)
+            {
+                if (capture_descriptor.subscribers[i].IsOccupied(std::memory_order_relaxed)
+                    && !h_frame_events_[i].IsInvalid())
+                {
+                    ::SetEvent(h_frame_events_[i].Get());
+                }
+            }
+        }
+    };
+}
+
+#endif // FAST_CAPTURE_INJECT_DLL_FRAME_EVENTS_HPP
@@ -1,5 +1,17 @@
 #include "GlReadPixelsThread.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
 #include "WglContext.h"
+#include "EglContext.h"
+#include "DllData.hpp"
+#include "../PboRing.h"
+#include "../GpuTimerQueryRing.h"
+#include "../DepthConvert.h"
+#include "../FrameFingerprint.h"
+#include "../../Utils/GLUtils.hpp"
+#include "../../Utils/StreamingCopy.hpp"
 
 FAST_CAPTURE_NAMESPACE
 {
@@ -17,7 +29,7 @@ FAST_CAPTURE_NAMESPACE
 
         h_is_need_run_command_ = ::CreateEvent(
             nullptr,
-            TRUE,
+            FALSE,
             FALSE,
             nullptr);
         if (h_is_need_run_command_.IsInvalid())
@@ -44,7 +56,7 @@ FAST_CAPTURE_NAMESPACE
         }
 
         auto wait_result = ::WaitForSingleObject(
-            h_read_pixels_thread_.Get(),
+            h_is_thread_init_finish_.Get(),
             timeout_ms);
         switch (wait_result)
         {
@@ -75,13 +87,135 @@ FAST_CAPTURE_NAMESPACE
         return FastCaptureMakeSuccessValue();
     }
 
+    FastCaptureErrorCode GlReadPixelsThread::RecreateSharedContext(WglContext& wgl_context, EglContext& egl_context)
+    {
+        SharedGlContext shared_gl_context;
+        {
+            std::lock_guard<std::mutex> capture_source_lock_guard{capture_source_lock_};
+            shared_gl_context = shared_gl_context_;
+        }
+        FastCaptureErrorCode result;
+        if (shared_gl_context.egl_context != nullptr)
+        {
+            if (!egl_context.IsInitialized())
+            {
+                result = egl_context.Initialize();
+                if (!Utils::IsOk(result))
+                {
+                    return result;
+                }
+            }
+            result = egl_context.RecreateContextAndShareContextFrom(
+                shared_gl_context.egl_display,
+                shared_gl_context.egl_context);
+        }
+        else
+        {
+            if (!wgl_context.IsInitialized())
+            {
+                result = wgl_context.Initialize(thread_init_timeout_ms_);
+                if (!Utils::IsOk(result))
+                {
+                    return result;
+                }
+            }
+            result = wgl_context.RecreateGlRcAndShareContextFrom(shared_gl_context.h_gl_rc);
+        }
+        if (!Utils::IsOk(result))
+        {
+            return result;
+        }
+        gl_api_ = GlFunctions::GetCurrent().api;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    namespace Details
+    {
+        /**
+         * @brief 读回线程的上下文中的OpenGL资源，重新创建上下文前必须先析构
+         *
+         */
+        struct ReadPixelsResources
+        {
+            UniqueOpenGLFbo read_fbo{MakeUniqueOpenGLFbo()};
+            PboRing pbo_ring{};
+            GpuTimerQueryRing pack_timer_query_ring{};
+        };
+
+        /**
+         * @brief 读回线程的上下文和其中的OpenGL资源，只在有客户端时存在
+         *
+         */
+        struct ReadPixelsContext
+        {
+            // 按声明的逆序析构，资源总是在它所属的上下文仍为当前上下文时删除
+            std::optional<WglContext> opt_wgl_context{};
+            std::optional<EglContext> opt_egl_context{};
+            std::optional<ReadPixelsResources> opt_resources{};
+
+            void Release() noexcept
+            {
+                opt_resources.reset();
+                opt_egl_context.reset();
+                opt_wgl_context.reset();
+            }
+        };
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::PrepareReadPixelsContext(Details::ReadPixelsContext& read_pixels_context)
+    {
+        if (read_pixels_context.opt_resources)
+            [[likely]]
+        {
+            return FastCaptureMakeSuccessValue();
+        }
+        if (!read_pixels_context.opt_wgl_context)
+        {
+            read_pixels_context.opt_wgl_context.emplace();
+        }
+        if (!read_pixels_context.opt_egl_context)
+        {
+            read_pixels_context.opt_egl_context.emplace();
+        }
+        auto result = RecreateSharedContext(
+            *read_pixels_context.opt_wgl_context,
+            *read_pixels_context.opt_egl_context);
+        if (!Utils::IsOk(result))
+        {
+            return result;
+        }
+        read_pixels_context.opt_resources.emplace();
+        read_pixels_context.opt_resources->pbo_ring.Initialize(PBO_RING_SLOT_COUNT);
+        read_pixels_context.opt_resources->pack_timer_query_ring.Initialize(GPU_TIMER_QUERY_SLOT_COUNT);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::RunReadPixels(Details::ReadPixelsContext& read_pixels_context)
+    {
+        // 休眠前最后提交的帧不值得为它重新创建上下文，它的栅栏由下一次SetCaptureSource删除
+        if (!IsCaptureActive())
+        {
+            has_pending_frames_ = false;
+            return FastCaptureMakeSuccessValue();
+        }
+        auto result = PrepareReadPixelsContext(read_pixels_context);
+        if (!Utils::IsOk(result))
+        {
+            return result;
+        }
+        return ReadPixels(
+            read_pixels_context.opt_resources->read_fbo.Get(),
+            read_pixels_context.opt_resources->pbo_ring,
+            read_pixels_context.opt_resources->pack_timer_query_ring);
+    }
+
     DWORD WINAPI GlReadPixelsThread::Do(LPVOID lpThreadParameter)
     {
         auto const p_this = reinterpret_cast<GlReadPixelsThread*>(lpThreadParameter);
         auto& error_code = p_this->thread_execute_result_;
 
         Windows::FreeLibraryAndExitThreadGuard free_library_and_exit_thread_guard{nullptr};
-        WglContext thread_wgl_context{};
+        Details::ReadPixelsContext read_pixels_context{};
         {
             Utils::RAIIWrapper<HANDLE, decltype([](HANDLE h_is_init_finish)
                                                 { ::SetEvent(h_is_init_finish); })>
@@ -94,29 +228,29 @@ FAST_CAPTURE_NAMESPACE
                 return error_code.error_code;
             }
             free_library_and_exit_thread_guard = h_current_dll;
-
-            error_code = thread_wgl_context.Initialize(p_this->thread_init_timeout_ms_);
-            if (!Utils::IsOk(error_code))
-            {
-                return error_code.error_code;
-            }
-            error_code = thread_wgl_context.RecreateGlRcAndShareContextFrom(p_this->current_shared_gl_rc_);
-            if (!Utils::IsOk(error_code))
-            {
-                return error_code.error_code;
-            }
         }
+        // 立即刷新一次心跳，客户端不需要等待一个心跳间隔就能发现注入DLL已经启动
+        std::ignore = p_this->UpdateCaptureActive(p_this->RefreshHeartbeat());
+        p_this->ApplyScheduling();
+        const HANDLE wait_handles[] = {
+            p_this->h_is_need_run_command_.Get(),
+            DllData::GetInstance().h_attach_event_.Get()};
         do
         {
-            switch (::WaitForSingleObject(
-                p_this->h_is_need_run_command_.Get(),
-                INFINITE))
+            // 即使目标程序暂停了交换缓冲区，也要定期刷新心跳，避免客户端误判注入DLL已经崩溃
+            const auto wait_result = ::WaitForMultipleObjects(
+                static_cast<DWORD>(std::size(wait_handles)),
+                wait_handles,
+                FALSE,
+                p_this->has_pending_frames_ ? p_this->GetPendingFrameRetryIntervalMs() : HEARTBEAT_INTERVAL_MS);
+            switch (wait_result)
             {
             case WAIT_OBJECT_0:
                 [[likely]] break;
+            case WAIT_OBJECT_0 + 1:
+                // 新的客户端占用了槽位，下面刷新心跳时会从休眠中恢复
             case WAIT_TIMEOUT:
-                error_code = Windows::MakeError(FAST_CAPTURE_E_WAIT_INIT_READ_PIXELS_THREAD_TIMEOUT);
-                return error_code.error_code;
+                break;
             case WAIT_FAILED:
                 error_code = Windows::MakeError(FAST_CAPTURE_E_WAIT_INIT_READ_PIXELS_THREAD_FAILED);
                 return error_code.error_code;
@@ -124,46 +258,634 @@ FAST_CAPTURE_NAMESPACE
                 error_code = Windows::MakeError(FAST_CAPTURE_E_WAIT_RESULT_UNEXPECTED);
                 return error_code.error_code;
             }
-            switch (p_this->command_)
+            if (p_this->UpdateCaptureActive(p_this->RefreshHeartbeat()))
             {
-            case Command::ReadPixels:
-                [[likely]]
-                // TODO: read pixels
-                break;
-            case Command::ChangeSharedGlRc:
-                error_code = thread_wgl_context.RecreateGlRcAndShareContextFrom(p_this->current_shared_gl_rc_);
+                read_pixels_context.Release();
+                p_this->has_pending_frames_ = false;
+            }
+            p_this->ApplyScheduling();
+            while (const auto opt_command = p_this->commands_.PopControlCommand())
+            {
+                switch (*opt_command)
+                {
+                case Command::ChangeSharedGlRc:
+                    // 旧上下文中的资源必须在旧上下文仍为当前上下文时删除，新的上下文在下一次读回时创建
+                    read_pixels_context.opt_resources.reset();
+                    p_this->has_pending_frames_ = false;
+                    p_this->PushEvent(FAST_CAPTURE_EVENT_SHARED_CONTEXT_CHANGED);
+                    break;
+                case Command::Exit:
+                    error_code = FastCaptureMakeSuccessValue();
+                    return error_code.error_code;
+                case Command::ReadPixels:
+                    // 读回命令不进入队列
+                    break;
+                }
+            }
+            // 目标程序停止交换时没有新的读回命令，推迟的帧和还在等待GPU的帧也在这里发布
+            const auto is_read_pixels_requested = p_this->commands_.TakeCoalescedCommand();
+            if (is_read_pixels_requested || p_this->has_pending_frames_)
+            {
+                error_code = p_this->RunReadPixels(read_pixels_context);
                 if (!Utils::IsOk(error_code))
                 {
+                    p_this->PushEvent(FAST_CAPTURE_EVENT_READ_PIXELS_THREAD_FAILED, error_code);
                     return error_code.error_code;
                 }
-                break;
-            case Command::Exit:
-                error_code = FastCaptureMakeSuccessValue();
-                return error_code.error_code;
             }
         } while (true);
     }
 
-    FastCaptureErrorCode GlReadPixelsThread::Initialize(const std::uint32_t timeout_ms)
+    bool GlReadPixelsThread::UpdateCaptureActive(const std::size_t alive_subscriber_count) noexcept
     {
-        FastCaptureErrorCode result;
-        result = InitializeSignals();
-        result = InitializeThread(timeout_ms);
+        const auto now_ms = ::GetTickCount64();
+        const auto is_capture_active = is_capture_active_.load(std::memory_order_relaxed);
+        if (alive_subscriber_count != 0)
+        {
+            last_subscribed_ms_ = now_ms;
+            if (!is_capture_active)
+            {
+                is_capture_active_.store(true, std::memory_order_release);
+                PushEvent(FAST_CAPTURE_EVENT_CAPTURE_ACTIVATED);
+            }
+            return false;
+        }
+        if (!is_capture_active || now_ms - last_subscribed_ms_ <= CAPTURE_IDLE_TIMEOUT_MS)
+        {
+            return false;
+        }
+        is_capture_active_.store(false, std::memory_order_release);
+        PushEvent(
+            FAST_CAPTURE_EVENT_CAPTURE_DEACTIVATED,
+            FastCaptureMakeSuccessValue(),
+            now_ms - last_subscribed_ms_);
+        return true;
+    }
+
+    std::size_t GlReadPixelsThread::RefreshHeartbeat() noexcept
+    {
+        auto p_capture_descriptor = DllData::GetInstance().p_capture_descriptor_.Get();
+        if (p_capture_descriptor == nullptr)
+            [[unlikely]]
+        {
+            return 0;
+        }
+        const auto now_ms = ::GetTickCount64();
+        p_capture_descriptor->producer_heartbeat_ms.store(now_ms, std::memory_order_release);
+        const auto alive_subscriber_count = p_capture_descriptor->ReapStaleSubscribers(
+            now_ms,
+            [this, p_capture_descriptor](const std::uint32_t process_id)
+            {
+                p_capture_descriptor->counters.reaped_subscriber_count.fetch_add(1, std::memory_order_relaxed);
+                PushEvent(FAST_CAPTURE_EVENT_SUBSCRIBER_REAPED, FastCaptureMakeSuccessValue(), process_id);
+            });
+        subscribed_capture_flags_.store(
+            FilterCaptureFlags(p_capture_descriptor->GetSubscribedCaptureFlags(), gl_api_),
+            std::memory_order_relaxed);
+        return alive_subscriber_count;
+    }
+
+    void GlReadPixelsThread::ApplyScheduling() noexcept
+    {
+        auto p_capture_descriptor = DllData::GetInstance().p_capture_descriptor_.Get();
+        if (p_capture_descriptor == nullptr)
+            [[unlikely]]
+        {
+            return;
+        }
+        const auto generation = p_capture_descriptor->scheduling_generation.load(std::memory_order_acquire);
+        const auto render_processor = render_processor_.load(std::memory_order_relaxed);
+        auto& applied = applied_scheduling_;
+        if (generation == applied.generation)
+            [[likely]]
+        {
+            if ((applied.flags & FAST_CAPTURE_SCHEDULING_FLAG_AVOID_RENDER_PROCESSOR)
+                && render_processor != applied.avoided_processor)
+            {
+                // 渲染线程迁移了，失败时保持原来的亲和性，不值得为此记录事件
+                std::ignore = ApplyAffinity(render_processor);
+            }
+            return;
+        }
+        applied.generation = generation;
+        applied.affinity_mask = p_capture_descriptor->scheduling_affinity_mask.load(std::memory_order_relaxed);
+        applied.flags = p_capture_descriptor->scheduling_flags.load(std::memory_order_relaxed);
+        const auto priority = p_capture_descriptor->scheduling_priority.load(std::memory_order_relaxed);
+
+        auto result = ApplyAffinity(render_processor);
+        const auto h_current_thread = ::GetCurrentThread();
+        if (!::SetThreadPriority(h_current_thread, priority) && Utils::IsOk(result))
+        {
+            result = Windows::MakeError(FAST_CAPTURE_E_SET_READ_PIXELS_THREAD_SCHEDULING_FAILED);
+        }
+        const BOOL is_priority_boost_disabled =
+            (applied.flags & FAST_CAPTURE_SCHEDULING_FLAG_DISABLE_PRIORITY_BOOST) ? TRUE : FALSE;
+        if (!::SetThreadPriorityBoost(h_current_thread, is_priority_boost_disabled) && Utils::IsOk(result))
+        {
+            result = Windows::MakeError(FAST_CAPTURE_E_SET_READ_PIXELS_THREAD_SCHEDULING_FAILED);
+        }
+        p_capture_descriptor->counters.scheduling_generation.store(generation, std::memory_order_relaxed);
+        PushEvent(
+            FAST_CAPTURE_EVENT_THREAD_SCHEDULING_APPLIED,
+            result,
+            applied.thread_affinity_mask,
+            static_cast<std::uint32_t>(priority) | (static_cast<std::uint64_t>(applied.flags) << 32));
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::ApplyAffinity(const std::uint32_t render_processor) noexcept
+    {
+        auto& applied = applied_scheduling_;
+        applied.avoided_processor = render_processor;
+        auto affinity_mask = applied.affinity_mask;
+        if (affinity_mask == 0)
+        {
+            DWORD_PTR process_affinity_mask;
+            DWORD_PTR system_affinity_mask;
+            if (!::GetProcessAffinityMask(::GetCurrentProcess(), &process_affinity_mask, &system_affinity_mask))
+            {
+                return Windows::MakeError(FAST_CAPTURE_E_SET_READ_PIXELS_THREAD_SCHEDULING_FAILED);
+            }
+            affinity_mask = process_affinity_mask;
+        }
+        // 处理器编号是处理器组内的编号，与亲和性掩码的位一致
+        if ((applied.flags & FAST_CAPTURE_SCHEDULING_FLAG_AVOID_RENDER_PROCESSOR) && render_processor < 64)
+        {
+            const auto other_affinity_mask = affinity_mask & ~(std::uint64_t{1} << render_processor);
+            if (other_affinity_mask != 0)
+            {
+                affinity_mask = other_affinity_mask;
+            }
+        }
+        if (::SetThreadAffinityMask(::GetCurrentThread(), static_cast<DWORD_PTR>(affinity_mask)) == 0)
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_SET_READ_PIXELS_THREAD_SCHEDULING_FAILED);
+        }
+        applied.thread_affinity_mask = affinity_mask;
+        return FastCaptureMakeSuccessValue();
+    }
+
+    void GlReadPixelsThread::PushEvent(
+        const std::uint32_t code,
+        const FastCaptureErrorCode error,
+        const std::uint64_t context_0,
+        const std::uint64_t context_1) noexcept
+    {
+        auto p_capture_descriptor = DllData::GetInstance().p_capture_descriptor_.Get();
+        if (p_capture_descriptor == nullptr)
+            [[unlikely]]
+        {
+            return;
+        }
+        p_capture_descriptor->event_log.Push(code, error, Windows::GetTimestampUs(), context_0, context_1);
+    }
+
+    void GlReadPixelsThread::LogDroppedFrames() noexcept
+    {
+        auto p_capture_descriptor = DllData::GetInstance().p_capture_descriptor_.Get();
+        if (p_capture_descriptor == nullptr)
+            [[unlikely]]
+        {
+            return;
+        }
+        const auto dropped_frame_count =
+            p_capture_descriptor->counters.dropped_frame_count.load(std::memory_order_relaxed);
+        if (dropped_frame_count == logged_dropped_frame_count_)
+            [[likely]]
+        {
+            return;
+        }
+        // 被Hook的线程不能写入单写者的事件日志，因此在这里合并为一个事件
+        PushEvent(
+            FAST_CAPTURE_EVENT_FRAME_DROPPED,
+            FastCaptureMakeSuccessValue(),
+            dropped_frame_count - logged_dropped_frame_count_);
+        logged_dropped_frame_count_ = dropped_frame_count;
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::ReadPixels(
+        GLuint read_fbo_id,
+        PboRing& pbo_ring,
+        GpuTimerQueryRing& pack_timer_query_ring)
+    {
+        auto& counters = DllData::GetInstance().p_capture_descriptor_.Get()->counters;
+        pack_timer_query_ring.Collect(
+            [&counters](const std::uint64_t elapsed_ns)
+            { counters.pack_gpu_cost.Record(elapsed_ns); });
+        auto result = PublishReadyFrames(pbo_ring);
+        if (!Utils::IsOk(result))
+        {
+            return result;
+        }
+        counters.pbo_ring_occupancy.store(pbo_ring.GetPendingCount(), std::memory_order_relaxed);
+
+        CaptureSource capture_source;
+        {
+            std::lock_guard<std::mutex> capture_source_lock_guard{capture_source_lock_};
+            capture_source = std::exchange(capture_source_, {});
+        }
+        LogDroppedFrames();
+        if (capture_source.fence == nullptr)
+        {
+            // 没有新的帧
+            has_pending_frames_ = pbo_ring.GetPendingCount() != 0;
+            return result;
+        }
+        counters.pickup_latency.Record((Windows::GetTimestampUs() - capture_source.timestamp_us) * 1000);
+        const auto& gl = GlFunctions::GetCurrent();
+        gl.WaitSync(capture_source.fence, 0, GL_TIMEOUT_IGNORED);
+        gl.DeleteSync(capture_source.fence);
+
+        auto capture_flags = GetSubscribedCaptureFlags();
+        if (capture_source.depth_stencil_texture_id == 0)
+        {
+            capture_flags &= ~(FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_DEPTH_FLOAT
+                               | FAST_CAPTURE_FLAG_STENCIL | FAST_CAPTURE_FLAG_LINEAR_DEPTH);
+        }
+        auto pbo_layout = MakePboFrameLayout(capture_source.width, capture_source.height, capture_flags);
+        pbo_layout.timestamp_us = capture_source.timestamp_us;
+
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo_id);
+        gl.FramebufferTexture2D(
+            GL_READ_FRAMEBUFFER,
+            GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D,
+            capture_source.color_texture_id,
+            0);
+        gl.FramebufferTexture2D(
+            GL_READ_FRAMEBUFFER,
+            GL_DEPTH_STENCIL_ATTACHMENT,
+            GL_TEXTURE_2D,
+            capture_source.depth_stencil_texture_id,
+            0);
+        gl.ReadBuffer(GL_COLOR_ATTACHMENT0);
+        pack_timer_query_ring.Begin();
+        if (const auto max_color_mip_level = GetMaxColorMipLevel(capture_flags); max_color_mip_level != 0)
+        {
+            // 只生成需要的层级，而不是一直缩小到1x1
+            gl.BindTexture(GL_TEXTURE_2D, capture_source.color_texture_id);
+            gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+            gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_color_mip_level);
+            gl.GenerateMipmap(GL_TEXTURE_2D);
+            gl.BindTexture(GL_TEXTURE_2D, 0);
+        }
+        // 被推迟的旧帧让位给最新的帧；所有槽位都在等待GPU时丢弃此帧，不阻塞读回线程
+        if (pbo_ring.IsFull() && pbo_ring.DiscardReady())
+        {
+            counters.budget_dropped_frame_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        pbo_layout.pack_timestamp_us = Windows::GetTimestampUs();
+        const auto is_packed = pbo_ring.Pack(pbo_layout, capture_source.color_texture_id);
+        pack_timer_query_ring.End();
+        if (!is_packed)
+        {
+            counters.pbo_ring_full_count.fetch_add(1, std::memory_order_relaxed);
+            PushEvent(
+                FAST_CAPTURE_EVENT_PBO_RING_FULL,
+                FastCaptureMakeSuccessValue(),
+                static_cast<std::uint64_t>(pbo_layout.width),
+                static_cast<std::uint64_t>(pbo_layout.height));
+        }
+        counters.pbo_ring_occupancy.store(pbo_ring.GetPendingCount(), std::memory_order_relaxed);
+        counters.swap_interval_us.store(frame_pacer_.GetSwapIntervalUs(), std::memory_order_relaxed);
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        has_pending_frames_ = pbo_ring.GetPendingCount() != 0;
         return result;
     }
 
-    FastCaptureErrorCode GlReadPixelsThread::RequestStopThread()
+    FastCaptureErrorCode GlReadPixelsThread::PublishReadyFrames(PboRing& pbo_ring)
     {
-        SetCommand(Command::Exit);
-        return InvokeThread();
+        const auto p_capture_descriptor = DllData::GetInstance().p_capture_descriptor_.Get();
+        const auto deadline_us = frame_pacer_.GetDeadlineUs(
+            Windows::GetTimestampUs(),
+            p_capture_descriptor->frame_cpu_budget_us.load(std::memory_order_relaxed));
+        auto& counters = p_capture_descriptor->counters;
+        // 连续多个窗口都放不下时不论预算发布一帧，否则开销超过预算的画面永远不会更新
+        auto is_forced = deferred_window_count_ >= MAX_DEFERRED_WINDOW_COUNT;
+        auto result = FastCaptureMakeSuccessValue();
+        while (Utils::IsOk(result) && pbo_ring.IsReady())
+        {
+            const auto begin_us = Windows::GetTimestampUs();
+            if (!is_forced && !frame_pacer_.IsWorkFit(begin_us, deadline_us))
+            {
+                // 同一个空闲窗口中被唤醒多次只算推迟了一个窗口；没有空闲窗口时每次重试都算一个窗口
+                const auto opt_window_swap_us = frame_pacer_.GetWindowSwapUs(begin_us);
+                if (!opt_window_swap_us || opt_window_swap_us != opt_deferred_window_swap_us_)
+                {
+                    ++deferred_window_count_;
+                    opt_deferred_window_swap_us_ = opt_window_swap_us;
+                }
+                const auto frame_timestamp_us = pbo_ring.GetOldestLayout().timestamp_us;
+                if (frame_timestamp_us != deferred_frame_timestamp_us_)
+                {
+                    counters.deferred_frame_count.fetch_add(1, std::memory_order_relaxed);
+                    deferred_frame_timestamp_us_ = frame_timestamp_us;
+                }
+                return result;
+            }
+            if (!pbo_ring.ConsumeReady(
+                    [this, &result, &counters, begin_us](const std::byte* p_pbo_data, const PboFrameLayout& pbo_layout)
+                    {
+                        counters.readback_latency.Record(begin_us - pbo_layout.pack_timestamp_us);
+                        result = PublishFrame(p_pbo_data, pbo_layout);
+                    }))
+            {
+                break;
+            }
+            const auto work_cost_us = Windows::GetTimestampUs() - begin_us;
+            frame_pacer_.RecordWorkCost(work_cost_us);
+            counters.publish_duration.Record(work_cost_us * 1000);
+            is_forced = false;
+            deferred_window_count_ = 0;
+            opt_deferred_window_swap_us_.reset();
+        }
+        return result;
+    }
+
+    DWORD GlReadPixelsThread::GetPendingFrameRetryIntervalMs() const noexcept
+    {
+        const auto now_us = Windows::GetTimestampUs();
+        const auto opt_next_window_us = frame_pacer_.GetNextWindowUs(now_us);
+        if (!opt_next_window_us)
+        {
+            return PENDING_FRAME_RETRY_INTERVAL_MS;
+        }
+        // 向上取整，不在窗口开始之前醒来
+        const auto interval_ms = (opt_next_window_us.value() - now_us + 999) / 1000;
+        return static_cast<DWORD>(std::clamp<std::uint64_t>(interval_ms, 1, HEARTBEAT_INTERVAL_MS));
+    }
+
+    bool GlReadPixelsThread::IsRepeatedFrame(
+        const std::byte* p_pbo_data,
+        const PboFrameLayout& pbo_layout,
+        float near_plane,
+        float far_plane) noexcept
+    {
+        // 不输出线性深度时深度范围不影响发布的内容，不应使指纹失效
+        if (!(pbo_layout.capture_flags & FAST_CAPTURE_FLAG_LINEAR_DEPTH))
+        {
+            near_plane = 0.0f;
+            far_plane = 0.0f;
+        }
+        const auto size = static_cast<std::size_t>(pbo_layout.total_size);
+        const auto sampled_fingerprint = MakeSampledFrameFingerprint(p_pbo_data, size, FINGERPRINT_SAMPLE_COUNT);
+        auto& last = last_frame_fingerprint_;
+        const bool is_same_output =
+            last.width == pbo_layout.width
+            && last.height == pbo_layout.height
+            && last.capture_flags == pbo_layout.capture_flags
+            && last.depth_near_plane == near_plane
+            && last.depth_far_plane == far_plane;
+        const bool is_sampled_match =
+            frame_index_ != 0 && is_same_output && last.sampled_fingerprint == sampled_fingerprint;
+        // 抽样指纹不同时画面一定变化了，不需要为比较读取整帧。
+        // 但画面刚静止过时很可能马上再次静止，这一帧的整帧指纹可以让下一帧直接被判定为重复帧
+        std::optional<std::uint64_t> opt_fingerprint{};
+        if (is_sampled_match || last.is_sampled_match)
+        {
+            opt_fingerprint = MakeFrameFingerprint(p_pbo_data, size);
+        }
+        const bool result = is_sampled_match && opt_fingerprint && opt_fingerprint == last.opt_fingerprint;
+        last = {
+            pbo_layout.width,
+            pbo_layout.height,
+            pbo_layout.capture_flags,
+            near_plane,
+            far_plane,
+            sampled_fingerprint,
+            is_sampled_match,
+            opt_fingerprint};
+        return result;
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::PublishFrame(const std::byte* p_pbo_data, const PboFrameLayout& pbo_layout)
+    {
+        auto& dll_data = DllData::GetInstance();
+        const auto p_capture_descriptor = dll_data.p_capture_descriptor_.Get();
+        // 只读取一次，保证指纹比较与线性化使用同一深度范围
+        const auto near_plane = p_capture_descriptor->depth_near_plane.load(std::memory_order_relaxed);
+        const auto far_plane = p_capture_descriptor->depth_far_plane.load(std::memory_order_relaxed);
+        if (IsRepeatedFrame(p_pbo_data, pbo_layout, near_plane, far_plane))
+        {
+            p_capture_descriptor->repeat_count.fetch_add(1, std::memory_order_release);
+            p_capture_descriptor->counters.repeated_frame_count.fetch_add(1, std::memory_order_relaxed);
+            return FastCaptureMakeSuccessValue();
+        }
+
+        const auto capture_flags = pbo_layout.capture_flags;
+        CapturePlane image_planes[FAST_CAPTURE_PLANE_COUNT];
+        const auto image_size = MakeCapturePlanes(pbo_layout.width, pbo_layout.height, capture_flags, image_planes);
+        auto result = PrepareCaptureImage(static_cast<std::size_t>(image_size));
+        if (!Utils::IsOk(result))
+        {
+            return result;
+        }
+
+        const auto p_capture_image = dll_data.p_capture_data_.Get();
+        ++frame_index_;
+        const auto pixel_count = static_cast<std::size_t>(pbo_layout.width) * pbo_layout.height;
+        {
+            auto capture_image_write_guard = Utils::MakeSeqLockWriteGuard(p_capture_image->seq_lock);
+            const auto p_image_data = p_capture_image->GetDataPointer();
+            p_capture_image->frame_index = frame_index_;
+            p_capture_image->timestamp_us = pbo_layout.timestamp_us;
+            std::memcpy(p_capture_image->planes, image_planes, sizeof(image_planes));
+
+            for (const auto plane_index : {
+                     FAST_CAPTURE_PLANE_COLOR,
+                     FAST_CAPTURE_PLANE_COLOR_MIP_1,
+                     FAST_CAPTURE_PLANE_COLOR_MIP_2,
+                     FAST_CAPTURE_PLANE_COLOR_MIP_3})
+            {
+                const auto& pbo_color_plane = pbo_layout.planes[plane_index];
+                if (pbo_color_plane.size == 0)
+                {
+                    continue;
+                }
+                Utils::CopyFrameData(
+                    p_image_data + image_planes[plane_index].offset,
+                    p_pbo_data + pbo_color_plane.offset,
+                    static_cast<std::size_t>(pbo_color_plane.size));
+            }
+
+            const auto& pbo_depth_plane = pbo_layout.planes[FAST_CAPTURE_PLANE_DEPTH];
+            const auto p_pbo_depth = p_pbo_data + pbo_depth_plane.offset;
+            if (pbo_depth_plane.size != 0)
+            {
+                const auto p_image_depth = p_image_data + image_planes[FAST_CAPTURE_PLANE_DEPTH].offset;
+                if (capture_flags & FAST_CAPTURE_FLAG_LINEAR_DEPTH)
+                {
+                    if (pbo_depth_plane.gl_type == GL_FLOAT)
+                    {
+                        ConvertDepthFloatToLinear(
+                            reinterpret_cast<const float*>(p_pbo_depth),
+                            reinterpret_cast<float*>(p_image_depth),
+                            pixel_count,
+                            near_plane,
+                            far_plane);
+                    }
+                    else
+                    {
+                        ConvertDepth24ToLinear(
+                            reinterpret_cast<const std::uint32_t*>(p_pbo_depth),
+                            reinterpret_cast<float*>(p_image_depth),
+                            pixel_count,
+                            near_plane,
+                            far_plane);
+                    }
+                }
+                else
+                {
+                    Utils::CopyFrameData(p_image_depth, p_pbo_depth, static_cast<std::size_t>(pbo_depth_plane.size));
+                }
+            }
+
+            const auto& image_stencil_plane = image_planes[FAST_CAPTURE_PLANE_STENCIL];
+            if (image_stencil_plane.size != 0)
+            {
+                const auto p_image_stencil = reinterpret_cast<std::uint8_t*>(p_image_data + image_stencil_plane.offset);
+                const auto& pbo_stencil_plane = pbo_layout.planes[FAST_CAPTURE_PLANE_STENCIL];
+                if (pbo_stencil_plane.size != 0)
+                {
+                    Utils::CopyFrameData(p_image_stencil, p_pbo_data + pbo_stencil_plane.offset, static_cast<std::size_t>(pbo_stencil_plane.size));
+                }
+                else
+                {
+                    ExtractStencilFromDepth24(
+                        reinterpret_cast<const std::uint32_t*>(p_pbo_depth),
+                        p_image_stencil,
+                        pixel_count);
+                }
+            }
+        }
+        {
+            auto capture_descriptor_write_guard = Utils::MakeSeqLockWriteGuard(p_capture_descriptor->seq_lock);
+            p_capture_descriptor->viewport[0] = 0;
+            p_capture_descriptor->viewport[1] = 0;
+            p_capture_descriptor->viewport[2] = pbo_layout.width;
+            p_capture_descriptor->viewport[3] = pbo_layout.height;
+            p_capture_descriptor->color_size = CAPTURE_COLOR_PIXEL_SIZE;
+            p_capture_descriptor->capture_flags = capture_flags;
+            std::memcpy(p_capture_descriptor->planes, image_planes, sizeof(image_planes));
+            p_capture_descriptor->capture_image_generation = capture_image_generation_;
+        }
+        p_capture_descriptor->repeat_count.store(0, std::memory_order_relaxed);
+        p_capture_descriptor->frame_timestamp_us.store(pbo_layout.timestamp_us, std::memory_order_relaxed);
+        p_capture_descriptor->frame_index.store(frame_index_, std::memory_order_release);
+        dll_data.frame_events_.Notify(*p_capture_descriptor);
+        p_capture_descriptor->counters.published_frame_count.fetch_add(1, std::memory_order_relaxed);
+        p_capture_descriptor->counters.publish_latency.Record(Windows::GetTimestampUs() - pbo_layout.timestamp_us);
+        return result;
     }
 
-    void GlReadPixelsThread::SetCommand(const Command command)
+    FastCaptureErrorCode GlReadPixelsThread::PrepareCaptureImage(const std::size_t image_size)
     {
-        if (command_ != Command::Exit)
+        if (image_size <= capture_image_capacity_)
             [[likely]]
         {
-            command_ = command;
+            return FastCaptureMakeSuccessValue();
+        }
+        auto& dll_data = DllData::GetInstance();
+        // 旧的共享内存可能仍被客户端映射着，同名创建会得到旧的、更小的共享内存，因此使用新的代数
+        const auto generation = capture_image_generation_ + 1;
+        const auto capture_image_shared_name =
+            std::wstring(L"Global\\") + dll_data.shared_memory_name_prefix_ + std::to_wstring(generation);
+        const std::uint64_t mapping_size = sizeof(CaptureImage) + image_size;
+        Windows::UniqueHandleInvalidNULL h_capture_image = ::CreateFileMappingW(
+            INVALID_HANDLE_VALUE,
+            NULL,
+            PAGE_READWRITE,
+            static_cast<DWORD>(mapping_size >> 32),
+            static_cast<DWORD>(mapping_size),
+            capture_image_shared_name.c_str());
+        if (h_capture_image.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_READ_PIXELS_THREAD_CREATE_SHARED_CAPTURE_IMAGE_FAILED);
         }
+        Windows::UniqueMapViewOfFile<CaptureImage> p_capture_image =
+            reinterpret_cast<CaptureImage*>(
+                ::MapViewOfFile(
+                    h_capture_image.Get(),
+                    FILE_MAP_ALL_ACCESS,
+                    0,
+                    0,
+                    static_cast<SIZE_T>(mapping_size)));
+        if (p_capture_image.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_READ_PIXELS_THREAD_CREATE_SHARED_CAPTURE_IMAGE_MAP_OF_VIEW_FAILED);
+        }
+        p_capture_image.Get()->seq_lock.RecoverFromDeadWriter();
+        dll_data.h_capture_image_ = std::move(h_capture_image);
+        dll_data.p_capture_data_ = std::move(p_capture_image);
+        capture_image_capacity_ = image_size;
+        // 描述信息中的代数由PublishFrame在写入第一帧后更新
+        capture_image_generation_ = generation;
+        dll_data.p_capture_descriptor_.Get()->counters.capture_image_remap_count.fetch_add(1, std::memory_order_relaxed);
+        PushEvent(
+            FAST_CAPTURE_EVENT_CAPTURE_IMAGE_REMAPPED,
+            FastCaptureMakeSuccessValue(),
+            generation,
+            image_size);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::Initialize(const std::uint32_t timeout_ms)
+    {
+        auto result = InitializeSignals();
+        if (!Utils::IsOk(result))
+        {
+            return result;
+        }
+        return InitializeThread(timeout_ms);
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::RequestStopThread()
+    {
+        return PostCommand(Command::Exit);
+    }
+
+    void GlReadPixelsThread::SetCaptureSource(const CaptureSource& capture_source)
+    {
+        frame_pacer_.RecordSwap(capture_source.timestamp_us);
+        render_processor_.store(::GetCurrentProcessorNumber(), std::memory_order_relaxed);
+        GLsync dropped_fence;
+        {
+            std::lock_guard<std::mutex> capture_source_lock_guard{capture_source_lock_};
+            dropped_fence = std::exchange(capture_source_, capture_source).fence;
+        }
+        if (dropped_fence != nullptr)
+        {
+            GlFunctions::GetCurrent().DeleteSync(dropped_fence);
+            if (auto p_capture_descriptor = DllData::GetInstance().p_capture_descriptor_.Get();
+                p_capture_descriptor != nullptr)
+            {
+                p_capture_descriptor->counters.dropped_frame_count.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void GlReadPixelsThread::SetSharedGlContext(const SharedGlContext& shared_gl_context)
+    {
+        std::lock_guard<std::mutex> capture_source_lock_guard{capture_source_lock_};
+        shared_gl_context_ = shared_gl_context;
+    }
+
+    FastCaptureErrorCode GlReadPixelsThread::PostCommand(const Command command)
+    {
+        switch (commands_.Post(command))
+        {
+        case Utils::MailboxPostResult::Posted:
+            break;
+        case Utils::MailboxPostResult::Coalesced:
+            // 读回线程还没有取走上一次的读回命令，它会读回最新的帧
+            if (auto p_capture_descriptor = DllData::GetInstance().p_capture_descriptor_.Get();
+                p_capture_descriptor != nullptr)
+            {
+                p_capture_descriptor->counters.coalesced_read_pixels_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            return FastCaptureMakeSuccessValue();
+        case Utils::MailboxPostResult::Full:
+            return Utils::MakeError(FAST_CAPTURE_E_READ_PIXELS_THREAD_COMMAND_QUEUE_FULL);
+        }
+        return InvokeThread();
     }
 }
\ No newline at end of file
@@ -2,15 +2,34 @@
 #define FAST_CAPTURE_INJECT_DLL_READ_PIXELS_THREAD_H
 
 #include "FastCaptureDef.h"
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include "../FastCaptureInjectDllDef.h"
+#include "../GLCapture.h"
+#include "../FramePacer.h"
+#include "../../Utils/CoalescingMailbox.hpp"
+#include "EglContext.h"
 #include "../../Utils/Windows/UtilsWindows.hpp"
 
 FAST_CAPTURE_NAMESPACE
 {
     class WglContext;
+    class PboRing;
+    class GpuTimerQueryRing;
+    struct PboFrameLayout;
+    namespace Details
+    {
+        struct ReadPixelsContext;
+    }
 
     class GlReadPixelsThread
     {
     public:
+        /**
+         * @brief ReadPixels的多次提交合并为一次，ChangeSharedGlRc和Exit是控制命令，按提交顺序执行并且先于读回执行
+         *
+         */
         enum class Command
         {
             ReadPixels,
@@ -18,7 +37,66 @@ FAST_CAPTURE_NAMESPACE
             Exit
         };
 
+        /**
+         * @brief 被Hook的上下文复制出的一帧，纹理与读回线程的上下文共享
+         *
+         */
+        struct CaptureSource
+        {
+            GLuint color_texture_id{0};
+            GLuint depth_stencil_texture_id{0};
+            GLint width{0};
+            GLint height{0};
+            GLsync fence{nullptr};
+            /**
+             * @brief 由Windows::GetTimestampUs获得
+             *
+             */
+            std::uint64_t timestamp_us{0};
+        };
+
+        /**
+         * @brief 被Hook的上下文，读回线程创建与它共享的上下文
+         *
+         */
+        struct SharedGlContext
+        {
+            HGLRC h_gl_rc{nullptr};
+            /**
+             * @brief 不为nullptr时通过EGL共享，此时忽略h_gl_rc
+             *
+             */
+            Egl::Display egl_display{nullptr};
+            Egl::Context egl_context{nullptr};
+        };
+
     private:
+        constexpr static DWORD HEARTBEAT_INTERVAL_MS = PRODUCER_HEARTBEAT_TIMEOUT_MS / 3;
+        constexpr static std::size_t PBO_RING_SLOT_COUNT = 3;
+        /**
+         * @brief 比PBO槽位多一个，读回的结果通常比计时结果晚可用，不会因为计时查询不足而跳过计时
+         *
+         */
+        constexpr static std::size_t GPU_TIMER_QUERY_SLOT_COUNT = PBO_RING_SLOT_COUNT + 1;
+        /**
+         * @brief 最后一个客户端离开后经过这段时间才释放OpenGL资源，避免客户端短暂重连时反复创建
+         *
+         */
+        constexpr static std::uint64_t CAPTURE_IDLE_TIMEOUT_MS = 10000;
+        /**
+         * @brief 有推迟或还在等待GPU的帧时，即使没有新的命令也会在下一个空闲窗口开始时重试发布。
+            没有帧节奏或目标程序停止绘制时没有空闲窗口，以此间隔重试
+         *
+         */
+        constexpr static DWORD PENDING_FRAME_RETRY_INTERVAL_MS = 16;
+        /**
+         * @brief 连续这么多个空闲窗口都因为预算不足而没有发布时，不论预算发布一帧
+         *
+         */
+        constexpr static std::uint32_t MAX_DEFERRED_WINDOW_COUNT = 3;
+        constexpr static std::uint32_t UNKNOWN_PROCESSOR = 0xFFFFFFFFu;
+        constexpr static std::size_t CONTROL_COMMAND_QUEUE_CAPACITY = 16;
+
         Windows::UniqueHandleInvalidNULL h_read_pixels_thread_{nullptr};
         /**
         * @brief 这是一个AUTO_RESET的，默认值为0的信号量。
@@ -29,26 +107,257 @@ FAST_CAPTURE_NAMESPACE
         Windows::UniqueHandleInvalidNULL h_is_thread_init_finish_{nullptr};
         /**
         * @brief 这是一个AUTO_RESET的，默认值为0的信号量。
-           当此信号量变为1时，线程调用的::WaitForSingleObject返回，
-           通知线程开始执行::glReadPixel函数
+           当此信号量变为1时，线程调用的::WaitForMultipleObjects返回，
+           通知线程取出并执行命令。线程每次被唤醒都取完所有命令，因此多次通知只需要唤醒一次
         *
         */
         Windows::UniqueHandleInvalidNULL h_is_need_run_command_{nullptr};
         FastCaptureErrorCode thread_execute_result_{FastCaptureMakeSuccessValue()};
-        HGLRC current_shared_gl_rc_{nullptr};
+        SharedGlContext shared_gl_context_{};
+        /**
+         * @brief 读回线程当前上下文的API，只在读回线程中使用
+         *
+         */
+        GlApi gl_api_{GlApi::OpenGL};
         std::uint32_t thread_init_timeout_ms_{0};
-        Command command_{Command::ReadPixels};
+        /**
+         * @brief 只由读回线程取出。读回命令不进入控制命令队列：被Hook的线程只保留最新的一帧，
+            读回线程取走之前再次提交的读回命令只需要置位，不需要再唤醒线程
+         *
+         */
+        Utils::CoalescingMailbox<Command, Command::ReadPixels, CONTROL_COMMAND_QUEUE_CAPACITY> commands_{};
+        /**
+         * @brief 只在进程内使用，保护capture_source_和shared_gl_context_
+         *
+         */
+        std::mutex capture_source_lock_{};
+        CaptureSource capture_source_{};
+        /**
+         * @brief 所有存活客户端需要的捕获标志的并集，在RefreshHeartbeat中更新
+         *
+         */
+        std::atomic<std::uint32_t> subscribed_capture_flags_{FAST_CAPTURE_FLAG_NONE};
+        /**
+         * @brief 为false时注入DLL处于休眠状态，被Hook的函数不做任何捕获工作，
+            读回线程也没有上下文和OpenGL资源。只由读回线程写入
+         *
+         */
+        std::atomic<bool> is_capture_active_{false};
+        /**
+         * @brief 最近一次发现存活客户端的时间，由::GetTickCount64获得，只在读回线程中使用
+         *
+         */
+        std::uint64_t last_subscribed_ms_{0};
+        /**
+         * @brief 由被Hook的线程记录交换的时刻，读回线程据此安排发布的时机
+         *
+         */
+        FramePacer frame_pacer_{};
+        /**
+         * @brief 被Hook的线程最近一次提交帧时所在的逻辑处理器，用于FAST_CAPTURE_SCHEDULING_FLAG_AVOID_RENDER_PROCESSOR
+         *
+         */
+        std::atomic<std::uint32_t> render_processor_{UNKNOWN_PROCESSOR};
+        /**
+         * @brief 读回线程已经应用的调度设置，代数为0时还没有客户端设置过
+         *
+         */
+        struct AppliedScheduling
+        {
+            std::uint32_t generation{0};
+            std::uint64_t affinity_mask{0};
+            std::uint32_t flags{0};
+            std::uint32_t avoided_processor{UNKNOWN_PROCESSOR};
+            std::uint64_t thread_affinity_mask{0};
+        } applied_scheduling_{};
+        /**
+         * @brief 以下只在读回线程中使用
+         *
+         */
+        std::uint32_t deferred_window_count_{0};
+        /**
+         * @brief 最近一次计入deferred_window_count_的空闲窗口，同一个窗口中的多次重试只计一次
+         *
+         */
+        std::optional<std::uint64_t> opt_deferred_window_swap_us_{};
+        /**
+         * @brief 最近一次计入deferred_frame_count的帧的时间戳，同一帧被多次推迟只计一次
+         *
+         */
+        std::uint64_t deferred_frame_timestamp_us_{0};
+        bool has_pending_frames_{false};
+        std::size_t capture_image_capacity_{0};
+        std::uint32_t capture_image_generation_{0};
+        constexpr static std::size_t FINGERPRINT_SAMPLE_COUNT = 4096;
+        /**
+         * @brief 上一个读回的帧的指纹，用于跳过内容没有变化的帧
+         *
+         */
+        struct LastFrameFingerprint
+        {
+            GLint width{0};
+            GLint height{0};
+            std::uint32_t capture_flags{FAST_CAPTURE_FLAG_NONE};
+            /**
+             * @brief 输出线性深度时使用的深度范围，其它情况下为0
+             *
+             */
+            float depth_near_plane{0.0f};
+            float depth_far_plane{0.0f};
+            std::uint64_t sampled_fingerprint{0};
+            /**
+             * @brief 抽样指纹与再上一帧相同，说明画面最近静止过
+             *
+             */
+            bool is_sampled_match{false};
+            /**
+             * @brief 只在画面最近静止过时计算，画面持续变化时不读取整帧
+             *
+             */
+            std::optional<std::uint64_t> opt_fingerprint{};
+        } last_frame_fingerprint_{};
+        std::uint64_t frame_index_{0};
+        /**
+         * @brief 已经记录到事件日志中的丢弃帧数，与CaptureCounters::dropped_frame_count的差为新丢弃的帧数
+         *
+         */
+        std::uint64_t logged_dropped_frame_count_{0};
 
         FastCaptureErrorCode InitializeSignals();
         FastCaptureErrorCode InitializeThread(const std::uint32_t timeout_ms);
         FastCaptureErrorCode InvokeThread() const;
+        /**
+         * @brief 按shared_gl_context_选择WGL或EGL重新创建读回线程的上下文
+         *
+         */
+        FastCaptureErrorCode RecreateSharedContext(WglContext& wgl_context, EglContext& egl_context);
+        /**
+         * @brief 上下文和OpenGL资源不存在时创建它们，因此只有真正需要读回时才付出创建的开销
+         *
+         */
+        FastCaptureErrorCode PrepareReadPixelsContext(Details::ReadPixelsContext& read_pixels_context);
+        /**
+         * @brief 刷新注入DLL的心跳，回收心跳超时的客户端槽位，并更新需要捕获的平面
+         *
+         * @return std::size_t 仍然存活的客户端数量
+         */
+        std::size_t RefreshHeartbeat() noexcept;
+        /**
+         * @brief 按存活的客户端数量在活动和休眠之间切换
+         *
+         * @return true 空闲超时，需要释放读回线程的上下文和OpenGL资源
+         */
+        bool UpdateCaptureActive(const std::size_t alive_subscriber_count) noexcept;
+        /**
+         * @brief 客户端修改了调度设置，或渲染线程迁移到了需要避开的处理器时，重新设置读回线程的调度
+         *
+         */
+        void ApplyScheduling() noexcept;
+        /**
+         * @brief 按applied_scheduling_设置读回线程的亲和性，并避开render_processor
+         *
+         */
+        FastCaptureErrorCode ApplyAffinity(const std::uint32_t render_processor) noexcept;
+        /**
+         * @brief 向共享内存中的事件日志写入一个事件，只能在读回线程中调用
+         *
+         */
+        void PushEvent(
+            const std::uint32_t code,
+            const FastCaptureErrorCode error = FastCaptureMakeSuccessValue(),
+            const std::uint64_t context_0 = 0,
+            const std::uint64_t context_1 = 0) noexcept;
+        /**
+         * @brief 把被Hook的线程累加的丢弃帧数记录为事件
+         *
+         */
+        void LogDroppedFrames() noexcept;
+        /**
+         * @brief 在活动状态下准备上下文并读回
+         *
+         */
+        FastCaptureErrorCode RunReadPixels(Details::ReadPixelsContext& read_pixels_context);
+        /**
+         * @brief 在这一帧的CPU预算和空闲窗口内按提交顺序发布已经读回的帧，放不下的帧留到下一个窗口
+         *
+         */
+        FastCaptureErrorCode PublishReadyFrames(PboRing& pbo_ring);
+        /**
+         * @brief 有待发布的帧时读回线程等待命令的时限，到下一个空闲窗口开始为止
+         *
+         */
+        DWORD GetPendingFrameRetryIntervalMs() const noexcept;
+        /**
+         * @brief 发布已经读回的帧，并为最新复制出的帧提交异步读回，读回命令的GPU时间由pack_timer_query_ring测量
+         *
+         */
+        FastCaptureErrorCode ReadPixels(GLuint read_fbo_id, PboRing& pbo_ring, GpuTimerQueryRing& pack_timer_query_ring);
+        /**
+         * @brief 把PBO中的一帧写入共享内存
+         *
+         */
+        FastCaptureErrorCode PublishFrame(const std::byte* p_pbo_data, const PboFrameLayout& pbo_layout);
+        /**
+         * @brief 先比较抽样指纹，相同时再比较整帧指纹，因此画面持续变化时只需要读取少量数据。
+            画面静止过之后，变化的帧也计算整帧指纹，下一次静止从第二帧起就是重复帧。
+            尺寸、捕获标志或线性深度使用的深度范围变化时，即使像素相同发布的内容也不同，不视为重复帧
+         *
+         * @return true 与上一个读回的帧内容相同
+         */
+        bool IsRepeatedFrame(
+            const std::byte* p_pbo_data,
+            const PboFrameLayout& pbo_layout,
+            float near_plane,
+            float far_plane) noexcept;
+        /**
+         * @brief 图像共享内存不足以容纳image_size时，以新的代数重新创建
+         *
+         */
+        FastCaptureErrorCode PrepareCaptureImage(const std::size_t image_size);
 
         static DWORD WINAPI Do(LPVOID lpThreadParameter);
 
     public:
+        /**
+         * @brief 启动处于休眠状态的读回线程，只等待线程启动，不创建任何OpenGL对象
+         *
+         */
         FastCaptureErrorCode Initialize(const std::uint32_t timeout_ms);
         FastCaptureErrorCode RequestStopThread();
-        void SetCommand(const Command command);
+        /**
+         * @brief 可以在任意线程中调用，控制命令队列已满时返回FAST_CAPTURE_E_READ_PIXELS_THREAD_COMMAND_QUEUE_FULL
+         *
+         */
+        FastCaptureErrorCode PostCommand(const Command command);
+        /**
+         * @brief 由被Hook的线程调用，提交GLCapture复制出的一帧，之后需要以PostCommand(Command::ReadPixels)唤醒线程。
+            未被读回的旧帧会被覆盖，它的栅栏也会被删除，因此调用前需要以GlFunctions::SetCurrent设置被Hook的上下文的函数表
+         *
+         */
+        void SetCaptureSource(const CaptureSource& capture_source);
+        /**
+         * @brief 设置被Hook的上下文，线程启动前设置或之后以PostCommand(Command::ChangeSharedGlRc)通知线程。
+            读回线程在第一次需要读回时才创建与它共享的上下文
+         *
+         */
+        void SetSharedGlContext(const SharedGlContext& shared_gl_context);
+        /**
+         * @brief 被Hook的函数每次调用时首先检查此值，为false时直接返回，
+            因此休眠中的注入DLL对目标程序的开销只是一次原子读取
+         *
+         */
+        bool IsCaptureActive() const noexcept
+        {
+            return is_capture_active_.load(std::memory_order_acquire);
+        }
+        /**
+         * @brief 被Hook的线程据此决定是否需要复制深度和模板，OpenGL ES上下文总是不需要
+         *
+         */
+        std::uint32_t GetSubscribedCaptureFlags() const noexcept
+        {
+            return subscribed_capture_flags_.load(std::memory_order_relaxed);
+        }
     };
 }
 
@@ -14,6 +14,22 @@ FAST_CAPTURE_NAMESPACE
             return target_class;
         }
 
+        /**
+         * @brief wglGetProcAddress只能获得OpenGL 1.1以后的函数，失败时除了nullptr，某些驱动还会返回1、2、3或-1
+         *
+         */
+        void* GetWglProcAddress(const char* name) noexcept
+        {
+            auto p_function = reinterpret_cast<void*>(::wglGetProcAddress(name));
+            const auto value = reinterpret_cast<std::intptr_t>(p_function);
+            if (value >= -1 && value <= 3)
+            {
+                static const auto h_opengl32 = ::GetModuleHandleW(L"opengl32.dll");
+                p_function = reinterpret_cast<void*>(::GetProcAddress(h_opengl32, name));
+            }
+            return p_function;
+        }
+
         using UniqueWindowClassABase = Utils::RAIIWrapper<WNDCLASSA, decltype([](const WNDCLASSA& window_class)
                                                                               { ::UnregisterClassA(window_class.lpszClassName, window_class.hInstance); })>;
     }
@@ -256,19 +272,22 @@ FAST_CAPTURE_NAMESPACE
             return Windows::MakeError(FAST_CAPTURE_E_GL_BASIC_WINDOW_WGL_MAKE_CURRENT_FAILED);
         }
 
-        auto glew_init_result = ::glewInit();
-        if (glew_init_result != GLEW_OK)
+        if (!::wglShareLists(gl_rc_.Get(), gl_rc))
         {
-            return {
-                FAST_CAPTURE_E_GL_BASIC_WINDOW_GLEW_INIT_FAILED,
-                FAST_CAPTURE_ERROR_TYPE_GLEW,
-                glew_init_result};
+            return Windows::MakeError(FAST_CAPTURE_E_GL_BASIC_WINDOW_WGL_SHARE_LISTS_FAILED);
         }
 
-        if (!::wglShareLists(gl_rc_.Get(), gl_rc))
+        // 上下文总是创建在同一个窗口上，像素格式不变，所以函数地址只需要获得一次
+        if (!is_gl_functions_loaded_)
         {
-            return Windows::MakeError(FAST_CAPTURE_E_GL_BASIC_WINDOW_WGL_SHARE_LISTS_FAILED);
+            auto load_result = gl_functions_.Load(&Details::GetWglProcAddress);
+            if (!Utils::IsOk(load_result))
+            {
+                return load_result;
+            }
+            is_gl_functions_loaded_ = true;
         }
+        GlFunctions::SetCurrent(&gl_functions_);
 
         return FastCaptureMakeSuccessValue();
     }
@@ -4,8 +4,7 @@
 #include "FastCaptureDef.h"
 #include <windows.h>
 #include <string>
-#include "GL/glew.h"
-#include "GL/gl.h"
+#include "../../Utils/GLFunctions.hpp"
 #include "../../Utils/Windows/UtilsWindows.hpp"
 
 // https://stackoverflow.com/questions/45518843/initializing-opengl-without-libraries
@@ -64,13 +63,23 @@ FAST_CAPTURE_NAMESPACE
         GlBasicWindow gl_window_;
         Windows::UniqueGlRc gl_rc_{nullptr};
         Windows::UniqueHandleInvalidNULL h_window_process_thread_{nullptr};
+        GlFunctions gl_functions_{};
+        bool is_gl_functions_loaded_{false};
 
     public:
         WglContext();
         ~WglContext();
 
         FastCaptureErrorCode Initialize(const std::uint32_t timeout_ms);
+        /**
+         * @brief 成功后上下文为当前线程的当前上下文，它的函数表为当前线程的函数表
+         *
+         */
         FastCaptureErrorCode RecreateGlRcAndShareContextFrom(HGLRC gl_rc);
+        bool IsInitialized() const noexcept
+        {
+            return gl_window_.GetHdc() != nullptr;
+        }
     };
 }
 
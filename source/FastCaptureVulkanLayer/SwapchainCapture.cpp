@@ -0,0 +1,415 @@
+#include "SwapchainCapture.h"
+#include <cstdint>
+#include <limits>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Vulkan
+    {
+        namespace
+        {
+            /**
+             * @brief 只支持每个像素4字节的8位格式，与注入DLL发布的RGBA一致
+             *
+             * @return 不支持时返回false
+             */
+            bool GetFormatSwizzle(const VkFormat format, bool* p_out_is_bgra) noexcept
+            {
+                switch (format)
+                {
+                case VK_FORMAT_B8G8R8A8_UNORM:
+                case VK_FORMAT_B8G8R8A8_SRGB:
+                    *p_out_is_bgra = true;
+                    return true;
+                case VK_FORMAT_R8G8B8A8_UNORM:
+                case VK_FORMAT_R8G8B8A8_SRGB:
+                    *p_out_is_bgra = false;
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            /**
+             * @brief 读回的内存优先选择带缓存的，没有时退回到任意主机可见的内存
+             *
+             * @return std::uint32_t 没有合适的内存类型时返回VK_MAX_MEMORY_TYPES
+             */
+            std::uint32_t FindReadbackMemoryType(
+                const VkPhysicalDeviceMemoryProperties& memory_properties,
+                const std::uint32_t memory_type_bits) noexcept
+            {
+                const VkMemoryPropertyFlags preferred_flags[] = {
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+                for (const auto flags : preferred_flags)
+                {
+                    for (std::uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+                    {
+                        if ((memory_type_bits & (1u << i))
+                            && (memory_properties.memoryTypes[i].propertyFlags & flags) == flags)
+                        {
+                            return i;
+                        }
+                    }
+                }
+                return VK_MAX_MEMORY_TYPES;
+            }
+        }
+
+        SwapchainCapture::~SwapchainCapture()
+        {
+            if (p_device_ == nullptr)
+            {
+                return;
+            }
+            const auto device = p_device_->device;
+            const auto& dispatch = p_device_->dispatch;
+            // 复制命令可能仍在执行，等到最后一次提交完成后再释放资源
+            if (timeline_semaphore_ != VK_NULL_HANDLE && next_timeline_value_ > 1)
+            {
+                const auto last_timeline_value = next_timeline_value_ - 1;
+                VkSemaphoreWaitInfo wait_info{};
+                wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+                wait_info.semaphoreCount = 1;
+                wait_info.pSemaphores = &timeline_semaphore_;
+                wait_info.pValues = &last_timeline_value;
+                dispatch.WaitSemaphores(device, &wait_info, (std::numeric_limits<std::uint64_t>::max)());
+            }
+            for (auto& slot : slots_)
+            {
+                if (slot.present_semaphore != VK_NULL_HANDLE)
+                {
+                    dispatch.DestroySemaphore(device, slot.present_semaphore, nullptr);
+                }
+                if (slot.buffer != VK_NULL_HANDLE)
+                {
+                    dispatch.DestroyBuffer(device, slot.buffer, nullptr);
+                }
+                if (slot.memory != VK_NULL_HANDLE)
+                {
+                    dispatch.FreeMemory(device, slot.memory, nullptr);
+                }
+            }
+            if (command_pool_ != VK_NULL_HANDLE)
+            {
+                dispatch.DestroyCommandPool(device, command_pool_, nullptr);
+            }
+            if (timeline_semaphore_ != VK_NULL_HANDLE)
+            {
+                dispatch.DestroySemaphore(device, timeline_semaphore_, nullptr);
+            }
+        }
+
+        FastCaptureErrorCode SwapchainCapture::Initialize(
+            DeviceData* p_device,
+            const VkSwapchainKHR swapchain,
+            const VkSwapchainCreateInfoKHR& create_info) noexcept
+        {
+            if (!GetFormatSwizzle(create_info.imageFormat, &is_bgra_)
+                || !(create_info.imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+            {
+                return Utils::MakeError(FAST_CAPTURE_E_VULKAN_SWAPCHAIN_NOT_CAPTURABLE);
+            }
+            p_device_ = p_device;
+            swapchain_ = swapchain;
+            extent_ = create_info.imageExtent;
+            buffer_size_ = static_cast<std::size_t>(extent_.width) * extent_.height * 4;
+            const auto device = p_device_->device;
+            const auto& dispatch = p_device_->dispatch;
+
+            std::uint32_t image_count = 0;
+            auto vk_result = dispatch.GetSwapchainImagesKHR(device, swapchain_, &image_count, nullptr);
+            if (vk_result != VK_SUCCESS)
+            {
+                return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+            }
+            images_.resize(image_count);
+            vk_result = dispatch.GetSwapchainImagesKHR(device, swapchain_, &image_count, images_.data());
+            if (vk_result != VK_SUCCESS)
+            {
+                return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+            }
+
+            VkSemaphoreTypeCreateInfo semaphore_type_info{};
+
+            semaphore_type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            semaphore_type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+            semaphore_type_info.initialValue = 0;
+            VkSemaphoreCreateInfo semaphore_info{};
+            semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphore_info.pNext = &semaphore_type_info;
+            vk_result = dispatch.CreateSemaphore(device, &semaphore_info, nullptr, &timeline_semaphore_);
+            if (vk_result != VK_SUCCESS)
+            {
+                return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+            }
+
+            for (auto& slot : slots_)
+            {
+                VkSemaphoreCreateInfo binary_semaphore_info{};
+                binary_semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+                vk_result = dispatch.CreateSemaphore(device, &binary_semaphore_info, nullptr, &slot.present_semaphore);
+                if (vk_result != VK_SUCCESS)
+                {
+                    return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+                }
+
+                VkBufferCreateInfo buffer_info{};
+
+                buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+                buffer_info.size = buffer_size_;
+                buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+                buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                vk_result = dispatch.CreateBuffer(device, &buffer_info, nullptr, &slot.buffer);
+                if (vk_result != VK_SUCCESS)
+                {
+                    return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+                }
+                VkMemoryRequirements memory_requirements{};
+                dispatch.GetBufferMemoryRequirements(device, slot.buffer, &memory_requirements);
+                const auto memory_type_index =
+                    FindReadbackMemoryType(p_device_->memory_properties, memory_requirements.memoryTypeBits);
+                if (memory_type_index == VK_MAX_MEMORY_TYPES)
+                {
+                    return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, VK_ERROR_FEATURE_NOT_PRESENT);
+                }
+                is_memory_coherent_ =
+                    p_device_->memory_properties.memoryTypes[memory_type_index].propertyFlags
+                    & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+                VkMemoryAllocateInfo allocate_info{};
+
+                allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+                allocate_info.allocationSize = memory_requirements.size;
+                allocate_info.memoryTypeIndex = memory_type_index;
+                vk_result = dispatch.AllocateMemory(device, &allocate_info, nullptr, &slot.memory);
+                if (vk_result != VK_SUCCESS)
+                {
+                    return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+                }
+                vk_result = dispatch.BindBufferMemory(device, slot.buffer, slot.memory, 0);
+                if (vk_result != VK_SUCCESS)
+                {
+                    return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+                }
+                // 与PBO不同，缓冲区在整个生命周期内保持映射
+                void* p_mapped_memory = nullptr;
+                vk_result = dispatch.MapMemory(device, slot.memory, 0, VK_WHOLE_SIZE, 0, &p_mapped_memory);
+                if (vk_result != VK_SUCCESS)
+                {
+                    return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+                }
+                slot.p_mapped_memory = static_cast<const std::byte*>(p_mapped_memory);
+            }
+            return FastCaptureMakeSuccessValue();
+        }
+
+        FastCaptureErrorCode SwapchainCapture::PrepareCommandBuffers(const std::uint32_t queue_family_index) noexcept
+        {
+            if (command_pool_ != VK_NULL_HANDLE)
+                [[likely]]
+            {
+                return command_pool_queue_family_index_ == queue_family_index
+                           ? FastCaptureMakeSuccessValue()
+                           : Utils::MakeError(FAST_CAPTURE_E_VULKAN_SWAPCHAIN_NOT_CAPTURABLE);
+            }
+            const auto device = p_device_->device;
+            const auto& dispatch = p_device_->dispatch;
+            VkCommandPoolCreateInfo command_pool_info{};
+            command_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            command_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            command_pool_info.queueFamilyIndex = queue_family_index;
+            auto vk_result = dispatch.CreateCommandPool(device, &command_pool_info, nullptr, &command_pool_);
+            if (vk_result != VK_SUCCESS)
+            {
+                command_pool_ = VK_NULL_HANDLE;
+                return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+            }
+            command_pool_queue_family_index_ = queue_family_index;
+
+            VkCommandBuffer command_buffers[SLOT_COUNT]{};
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = command_pool_;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandBufferCount = SLOT_COUNT;
+            vk_result = dispatch.AllocateCommandBuffers(device, &allocate_info, command_buffers);
+            if (vk_result != VK_SUCCESS)
+            {
+                dispatch.DestroyCommandPool(device, command_pool_, nullptr);
+                command_pool_ = VK_NULL_HANDLE;
+                return MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_RESOURCE_FAILED, vk_result);
+            }
+            for (std::size_t i = 0; i < SLOT_COUNT; ++i)
+            {
+                // 层自己分配的可分发对象没有经过加载器，需要手动设置分发表
+                p_device_->set_device_loader_data(device, command_buffers[i]);
+                slots_[i].command_buffer = command_buffers[i];
+            }
+            return FastCaptureMakeSuccessValue();
+        }
+
+        void SwapchainCapture::RecordCopy(Slot& slot, const VkImage image) const noexcept
+        {
+            const auto& dispatch = p_device_->dispatch;
+            const auto command_buffer = slot.command_buffer;
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            dispatch.BeginCommandBuffer(command_buffer, &begin_info);
+
+            VkImageMemoryBarrier image_barrier{};
+
+            image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            image_barrier.srcAccessMask = 0;
+            image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            image_barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            image_barrier.image = image;
+            image_barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+            dispatch.CmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                1,
+                &image_barrier);
+
+            VkBufferImageCopy region{};
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+            region.imageExtent = {extent_.width, extent_.height, 1};
+            dispatch.CmdCopyImageToBuffer(
+                command_buffer,
+                image,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                slot.buffer,
+                1,
+                &region);
+
+            // 还原布局，呈现引擎看到的图像与应用交给它的一致
+            image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            image_barrier.dstAccessMask = 0;
+            image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            image_barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            VkBufferMemoryBarrier buffer_barrier{};
+            buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            buffer_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            buffer_barrier.buffer = slot.buffer;
+            buffer_barrier.size = VK_WHOLE_SIZE;
+            dispatch.CmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                0,
+                0,
+                nullptr,
+                1,
+                &buffer_barrier,
+                1,
+                &image_barrier);
+
+            dispatch.EndCommandBuffer(command_buffer);
+        }
+
+        std::size_t SwapchainCapture::AcquireSlot() noexcept
+        {
+            for (std::size_t i = 0; i < SLOT_COUNT; ++i)
+            {
+                if (!slots_[i].is_busy.exchange(true, std::memory_order_acquire))
+                {
+                    return i;
+                }
+            }
+            return SLOT_COUNT;
+        }
+
+        VkSemaphore SwapchainCapture::Capture(
+            const std::size_t slot_index,
+            const VkQueue queue,
+            const std::uint32_t queue_family_index,
+            const std::uint32_t image_index,
+            const std::uint32_t wait_semaphore_count,
+            const VkSemaphore* wait_semaphores,
+            const std::uint64_t timestamp_us) noexcept
+        {
+            constexpr std::uint32_t MAX_WAIT_SEMAPHORE_COUNT = 16;
+            if (image_index >= images_.size()
+                || wait_semaphore_count > MAX_WAIT_SEMAPHORE_COUNT
+                || !Utils::IsOk(PrepareCommandBuffers(queue_family_index)))
+            {
+                return VK_NULL_HANDLE;
+            }
+            auto& slot = slots_[slot_index];
+            RecordCopy(slot, images_[image_index]);
+
+            VkPipelineStageFlags wait_stages[MAX_WAIT_SEMAPHORE_COUNT];
+            for (std::uint32_t i = 0; i < wait_semaphore_count; ++i)
+            {
+                wait_stages[i] = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            }
+            const VkSemaphore signal_semaphores[] = {timeline_semaphore_, slot.present_semaphore};
+            // 二值信号量的值会被忽略
+            const std::uint64_t signal_values[] = {next_timeline_value_, 0};
+            VkTimelineSemaphoreSubmitInfo timeline_submit_info{};
+            timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timeline_submit_info.signalSemaphoreValueCount = 2;
+            timeline_submit_info.pSignalSemaphoreValues = signal_values;
+            VkSubmitInfo submit_info{};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.pNext = &timeline_submit_info;
+            submit_info.waitSemaphoreCount = wait_semaphore_count;
+            submit_info.pWaitSemaphores = wait_semaphores;
+            submit_info.pWaitDstStageMask = wait_stages;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &slot.command_buffer;
+            submit_info.signalSemaphoreCount = 2;
+            submit_info.pSignalSemaphores = signal_semaphores;
+            if (p_device_->dispatch.QueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+            {
+                return VK_NULL_HANDLE;
+            }
+            slot.timeline_value = next_timeline_value_++;
+            slot.timestamp_us = timestamp_us;
+            return slot.present_semaphore;
+        }
+
+        VkResult SwapchainCapture::WaitSlot(const std::size_t slot_index, const std::uint64_t timeout_ns) const noexcept
+        {
+            VkSemaphoreWaitInfo wait_info{};
+            wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            wait_info.semaphoreCount = 1;
+            wait_info.pSemaphores = &timeline_semaphore_;
+            wait_info.pValues = &slots_[slot_index].timeline_value;
+            return p_device_->dispatch.WaitSemaphores(p_device_->device, &wait_info, timeout_ns);
+        }
+
+        const std::byte* SwapchainCapture::MapSlot(const std::size_t slot_index) const noexcept
+        {
+            const auto& slot = slots_[slot_index];
+            if (!is_memory_coherent_)
+            {
+                VkMappedMemoryRange range{};
+                range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+                range.memory = slot.memory;
+                range.size = VK_WHOLE_SIZE;
+                p_device_->dispatch.InvalidateMappedMemoryRanges(p_device_->device, 1, &range);
+            }
+            return slot.p_mapped_memory;
+        }
+
+        void SwapchainCapture::ReleaseSlot(const std::size_t slot_index) noexcept
+        {
+            slots_[slot_index].is_busy.store(false, std::memory_order_release);
+        }
+    }
+}
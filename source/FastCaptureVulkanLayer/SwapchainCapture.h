@@ -0,0 +1,129 @@
+#ifndef FAST_CAPTURE_VULKAN_LAYER_SWAPCHAIN_CAPTURE_H
+#define FAST_CAPTURE_VULKAN_LAYER_SWAPCHAIN_CAPTURE_H
+
+#include "VulkanLayer.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Vulkan
+    {
+        /**
+         * @brief 在呈现前把交换链图像复制到主机可见的缓冲区，作用与注入DLL中的PBO环相同
+         *
+         */
+        class SwapchainCapture
+        {
+        public:
+            constexpr static std::size_t SLOT_COUNT = 3;
+
+        private:
+            struct Slot
+            {
+                VkBuffer buffer{VK_NULL_HANDLE};
+                VkDeviceMemory memory{VK_NULL_HANDLE};
+                const std::byte* p_mapped_memory{nullptr};
+                VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+                /**
+                 * @brief 复制完成后发出，替换应用交给呈现的等待信号量
+                 *
+                 */
+                VkSemaphore present_semaphore{VK_NULL_HANDLE};
+                /**
+                 * @brief 复制完成时时间线信号量达到的值
+                 *
+                 */
+                std::uint64_t timeline_value{0};
+                std::uint64_t timestamp_us{0};
+                /**
+                 * @brief 从提交复制到后台线程发布完成期间为true
+                 *
+                 */
+                std::atomic<bool> is_busy{false};
+            };
+
+            DeviceData* p_device_{nullptr};
+            VkSwapchainKHR swapchain_{VK_NULL_HANDLE};
+            std::vector<VkImage> images_{};
+            VkExtent2D extent_{};
+            bool is_bgra_{false};
+            bool is_memory_coherent_{false};
+            std::size_t buffer_size_{0};
+            /**
+             * @brief 命令池属于第一次呈现时使用的队列族，之后呈现到其他队列族的帧不会被捕获
+             *
+             */
+            VkCommandPool command_pool_{VK_NULL_HANDLE};
+            std::uint32_t command_pool_queue_family_index_{0};
+            VkSemaphore timeline_semaphore_{VK_NULL_HANDLE};
+            std::uint64_t next_timeline_value_{1};
+            Slot slots_[SLOT_COUNT]{};
+
+            FastCaptureErrorCode PrepareCommandBuffers(const std::uint32_t queue_family_index) noexcept;
+            void RecordCopy(Slot& slot, const VkImage image) const noexcept;
+
+        public:
+            SwapchainCapture() = default;
+            ~SwapchainCapture();
+            SwapchainCapture(const SwapchainCapture&) = delete;
+            SwapchainCapture& operator=(const SwapchainCapture&) = delete;
+
+            FastCaptureErrorCode Initialize(
+                DeviceData* p_device,
+                const VkSwapchainKHR swapchain,
+                const VkSwapchainCreateInfoKHR& create_info) noexcept;
+
+            /**
+             * @brief 占用一个空闲槽位，只由呈现的线程调用
+             *
+             * @return std::size_t 槽位下标，没有空闲槽位时返回SLOT_COUNT
+             */
+            std::size_t AcquireSlot() noexcept;
+            /**
+             * @brief 在呈现的队列上提交复制命令，由vkQueuePresentKHR的Hook调用
+             *
+             * @param wait_semaphores 应用交给呈现的等待信号量，复制会先等待它们
+             * @return VkSemaphore 呈现应改为等待此信号量，失败时返回VK_NULL_HANDLE，
+                此时应用的等待信号量没有被消耗，调用者需要释放槽位
+             */
+            VkSemaphore Capture(
+                const std::size_t slot_index,
+                const VkQueue queue,
+                const std::uint32_t queue_family_index,
+                const std::uint32_t image_index,
+                const std::uint32_t wait_semaphore_count,
+                const VkSemaphore* wait_semaphores,
+                const std::uint64_t timestamp_us) noexcept;
+
+            /**
+             * @brief 等待槽位的复制完成
+             *
+             * @return VkResult 超时返回VK_TIMEOUT
+             */
+            VkResult WaitSlot(const std::size_t slot_index, const std::uint64_t timeout_ns) const noexcept;
+            /**
+             * @brief 复制完成后读出槽位中的像素，行从上到下排列
+             *
+             */
+            const std::byte* MapSlot(const std::size_t slot_index) const noexcept;
+            void ReleaseSlot(const std::size_t slot_index) noexcept;
+
+            VkExtent2D GetExtent() const noexcept
+            {
+                return extent_;
+            }
+            bool IsBgra() const noexcept
+            {
+                return is_bgra_;
+            }
+            std::uint64_t GetSlotTimestampUs(const std::size_t slot_index) const noexcept
+            {
+                return slots_[slot_index].timestamp_us;
+            }
+        };
+    }
+}
+
+#endif // FAST_CAPTURE_VULKAN_LAYER_SWAPCHAIN_CAPTURE_H
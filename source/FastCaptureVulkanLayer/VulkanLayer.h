@@ -0,0 +1,143 @@
+#ifndef FAST_CAPTURE_VULKAN_LAYER_VULKAN_LAYER_H
+#define FAST_CAPTURE_VULKAN_LAYER_VULKAN_LAYER_H
+
+#include "FastCaptureDef.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vk_layer.h>
+#include "../Utils/Utils.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Vulkan
+    {
+        class SwapchainCapture;
+
+        inline FastCaptureErrorCode MakeError(std::uint16_t fast_capture_error_code, VkResult vk_result)
+        {
+            return {
+                fast_capture_error_code,
+                FAST_CAPTURE_ERROR_TYPE_VULKAN,
+                static_cast<std::uint32_t>(vk_result)};
+        }
+
+        /**
+         * @brief 可分发对象的第一个成员是加载器的分发表指针，同一个实例或设备的所有子对象都相同
+         *
+         */
+        using DispatchKey = void*;
+        template <class T>
+        DispatchKey GetDispatchKey(T dispatchable_object) noexcept
+        {
+            return *reinterpret_cast<DispatchKey*>(dispatchable_object);
+        }
+
+        struct InstanceDispatch
+        {
+            PFN_vkGetInstanceProcAddr GetInstanceProcAddr{nullptr};
+            PFN_vkDestroyInstance DestroyInstance{nullptr};
+            PFN_vkGetPhysicalDeviceProperties GetPhysicalDeviceProperties{nullptr};
+            PFN_vkGetPhysicalDeviceMemoryProperties GetPhysicalDeviceMemoryProperties{nullptr};
+            PFN_vkGetPhysicalDeviceQueueFamilyProperties GetPhysicalDeviceQueueFamilyProperties{nullptr};
+            PFN_vkGetPhysicalDeviceFeatures2 GetPhysicalDeviceFeatures2{nullptr};
+            PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR GetPhysicalDeviceSurfaceCapabilitiesKHR{nullptr};
+        };
+
+        struct InstanceData
+        {
+            VkInstance instance{VK_NULL_HANDLE};
+            InstanceDispatch dispatch{};
+            /**
+             * @brief 应用在VkApplicationInfo中请求的版本，低于1.2时不能使用核心的时间线信号量
+             *
+             */
+            std::uint32_t api_version{VK_API_VERSION_1_0};
+        };
+
+        struct DeviceDispatch
+        {
+            PFN_vkGetDeviceProcAddr GetDeviceProcAddr{nullptr};
+            PFN_vkDestroyDevice DestroyDevice{nullptr};
+            PFN_vkGetDeviceQueue GetDeviceQueue{nullptr};
+            PFN_vkGetDeviceQueue2 GetDeviceQueue2{nullptr};
+            PFN_vkCreateSwapchainKHR CreateSwapchainKHR{nullptr};
+            PFN_vkDestroySwapchainKHR DestroySwapchainKHR{nullptr};
+            PFN_vkGetSwapchainImagesKHR GetSwapchainImagesKHR{nullptr};
+            PFN_vkQueuePresentKHR QueuePresentKHR{nullptr};
+            PFN_vkQueueSubmit QueueSubmit{nullptr};
+            PFN_vkCreateCommandPool CreateCommandPool{nullptr};
+            PFN_vkDestroyCommandPool DestroyCommandPool{nullptr};
+            PFN_vkAllocateCommandBuffers AllocateCommandBuffers{nullptr};
+            PFN_vkBeginCommandBuffer BeginCommandBuffer{nullptr};
+            PFN_vkEndCommandBuffer EndCommandBuffer{nullptr};
+            PFN_vkCmdPipelineBarrier CmdPipelineBarrier{nullptr};
+            PFN_vkCmdCopyImageToBuffer CmdCopyImageToBuffer{nullptr};
+            PFN_vkCreateBuffer CreateBuffer{nullptr};
+            PFN_vkDestroyBuffer DestroyBuffer{nullptr};
+            PFN_vkGetBufferMemoryRequirements GetBufferMemoryRequirements{nullptr};
+            PFN_vkAllocateMemory AllocateMemory{nullptr};
+            PFN_vkFreeMemory FreeMemory{nullptr};
+            PFN_vkBindBufferMemory BindBufferMemory{nullptr};
+            PFN_vkMapMemory MapMemory{nullptr};
+            PFN_vkInvalidateMappedMemoryRanges InvalidateMappedMemoryRanges{nullptr};
+            PFN_vkCreateSemaphore CreateSemaphore{nullptr};
+            PFN_vkDestroySemaphore DestroySemaphore{nullptr};
+            PFN_vkWaitSemaphores WaitSemaphores{nullptr};
+        };
+
+        struct DeviceData
+        {
+            VkDevice device{VK_NULL_HANDLE};
+            VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+            InstanceData* p_instance{nullptr};
+            DeviceDispatch dispatch{};
+            /**
+             * @brief 为层自己分配的命令缓冲区设置加载器的分发表
+             *
+             */
+            PFN_vkSetDeviceLoaderData set_device_loader_data{nullptr};
+            VkPhysicalDeviceMemoryProperties memory_properties{};
+            std::vector<VkQueueFamilyProperties> queue_family_properties{};
+            /**
+             * @brief 创建设备时启用了时间线信号量，否则此设备上的交换链不会被捕获
+             *
+             */
+            bool is_capture_supported{false};
+            /**
+             * @brief 只记录能执行传输命令的队列，呈现到其他队列的帧不会被捕获
+             *
+             */
+            std::unordered_map<VkQueue, std::uint32_t> queue_family_indices{};
+            std::unordered_map<VkSwapchainKHR, std::unique_ptr<SwapchainCapture>> swapchains{};
+        };
+
+        /**
+         * @brief 层的全局状态，lock_保护所有成员
+         *
+         */
+        class LayerData
+        {
+        public:
+            std::mutex lock_{};
+            std::unordered_map<DispatchKey, std::unique_ptr<InstanceData>> instances_{};
+            std::unordered_map<DispatchKey, std::unique_ptr<DeviceData>> devices_{};
+
+        private:
+            LayerData() = default;
+            ~LayerData() = default;
+
+        public:
+            static LayerData& GetInstance() noexcept
+            {
+                static LayerData result;
+                return result;
+            }
+        };
+    }
+}
+
+#endif // FAST_CAPTURE_VULKAN_LAYER_VULKAN_LAYER_H
@@ -0,0 +1,165 @@
+#include "CaptureWorker.h"
+#include <algorithm>
+#include <iterator>
+
+FAST_CAPTURE_NAMESPACE
+{
+    CaptureWorker::~CaptureWorker()
+    {
+        if (h_worker_thread_.IsInvalid())
+        {
+            return;
+        }
+        ::SetEvent(h_stop_event_.Get());
+        ::WaitForSingleObject(h_worker_thread_.Get(), INFINITE);
+    }
+
+    FastCaptureErrorCode CaptureWorker::Initialize() noexcept
+    {
+        if (auto result = publisher_.Initialize(); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        h_job_event_ = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        h_stop_event_ = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (h_job_event_.IsInvalid() || h_stop_event_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_THREAD_FAILED);
+        }
+        h_worker_thread_ = ::CreateThread(
+            nullptr,
+            0,
+            &Do,
+            this,
+            0,
+            nullptr);
+        if (h_worker_thread_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_VULKAN_CAPTURE_THREAD_FAILED);
+        }
+        return FastCaptureMakeSuccessValue();
+    }
+
+    DWORD WINAPI CaptureWorker::Do(LPVOID p_context)
+    {
+        static_cast<CaptureWorker*>(p_context)->Run();
+        return 0;
+    }
+
+    void CaptureWorker::Run() noexcept
+    {
+        const HANDLE wait_handles[] = {h_stop_event_.Get(), h_job_event_.Get()};
+        while (true)
+        {
+            const auto wait_result = ::WaitForMultipleObjects(
+                static_cast<DWORD>(std::size(wait_handles)),
+                wait_handles,
+                FALSE,
+                HEARTBEAT_INTERVAL_MS);
+            if (wait_result != WAIT_OBJECT_0 + 1 && wait_result != WAIT_TIMEOUT)
+            {
+                break;
+            }
+            publisher_.RefreshHeartbeat();
+            Job job;
+            while (PopJob(&job))
+            {
+                ProcessJob(job);
+                FinishJob(job);
+            }
+        }
+    }
+
+    bool CaptureWorker::PopJob(Job* p_out_job) noexcept
+    {
+        std::lock_guard guard{jobs_lock_};
+        if (jobs_.empty())
+        {
+            return false;
+        }
+        *p_out_job = jobs_.front();
+        jobs_.pop_front();
+        p_current_capture_ = p_out_job->p_capture;
+        return true;
+    }
+
+    void CaptureWorker::FinishJob(const Job& job) noexcept
+    {
+        job.p_capture->ReleaseSlot(job.slot_index);
+        {
+            std::lock_guard guard{jobs_lock_};
+            p_current_capture_ = nullptr;
+        }
+        job_finished_condition_.notify_all();
+    }
+
+    void CaptureWorker::ProcessJob(const Job& job) noexcept
+    {
+        const auto p_capture = job.p_capture;
+        auto vk_result = VK_TIMEOUT;
+        while (vk_result == VK_TIMEOUT)
+        {
+            if (::WaitForSingleObject(h_stop_event_.Get(), 0) == WAIT_OBJECT_0)
+            {
+                return;
+            }
+            vk_result = p_capture->WaitSlot(job.slot_index, WAIT_SLOT_TIMEOUT_NS);
+        }
+        if (vk_result != VK_SUCCESS)
+        {
+            publisher_.PushEvent(
+                FAST_CAPTURE_EVENT_READ_PIXELS_THREAD_FAILED,
+                Vulkan::MakeError(FAST_CAPTURE_E_READ_PIXELS_THREAD_INVOKE_FAILED, vk_result));
+            return;
+        }
+        // 客户端可能在提交复制之后才全部退出
+        if (!publisher_.HasSubscribers())
+        {
+            return;
+        }
+        const auto extent = p_capture->GetExtent();
+        FramePixels frame{};
+        frame.p_data = p_capture->MapSlot(job.slot_index);
+        frame.width = extent.width;
+        frame.height = extent.height;
+        frame.row_pitch = static_cast<std::size_t>(extent.width) * CAPTURE_COLOR_PIXEL_SIZE;
+        frame.is_bgra = p_capture->IsBgra();
+        frame.timestamp_us = p_capture->GetSlotTimestampUs(job.slot_index);
+        if (auto result = publisher_.Publish(frame); !Utils::IsOk(result))
+        {
+            publisher_.PushEvent(FAST_CAPTURE_EVENT_READ_PIXELS_THREAD_FAILED, result);
+        }
+    }
+
+    void CaptureWorker::Push(Vulkan::SwapchainCapture* p_capture, const std::size_t slot_index) noexcept
+    {
+        {
+            std::lock_guard guard{jobs_lock_};
+            jobs_.push_back({p_capture, slot_index});
+        }
+        ::SetEvent(h_job_event_.Get());
+    }
+
+    void CaptureWorker::Cancel(Vulkan::SwapchainCapture* p_capture) noexcept
+    {
+        std::unique_lock guard{jobs_lock_};
+        const auto removed_begin = std::remove_if(
+            jobs_.begin(),
+            jobs_.end(),
+            [p_capture](const Job& job)
+            {
+                return job.p_capture == p_capture;
+            });
+        for (auto it = removed_begin; it != jobs_.end(); ++it)
+        {
+            p_capture->ReleaseSlot(it->slot_index);
+        }
+        jobs_.erase(removed_begin, jobs_.end());
+        job_finished_condition_.wait(
+            guard,
+            [this, p_capture]()
+            {
+                return p_current_capture_ != p_capture;
+            });
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FAST_CAPTURE_VULKAN_LAYER_WINDOWS_CAPTURE_WORKER_H
+#define FAST_CAPTURE_VULKAN_LAYER_WINDOWS_CAPTURE_WORKER_H
+
+#include "FastCaptureDef.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include "SharedFramePublisher.h"
+#include "../SwapchainCapture.h"
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 等待复制完成并发布帧的后台线程，同时负责刷新生产者心跳，呈现的线程只提交复制命令
+     *
+     */
+    class CaptureWorker
+    {
+        struct Job
+        {
+            Vulkan::SwapchainCapture* p_capture{nullptr};
+            std::size_t slot_index{0};
+        };
+
+        constexpr static DWORD HEARTBEAT_INTERVAL_MS = PRODUCER_HEARTBEAT_TIMEOUT_MS / 3;
+        /**
+         * @brief 等待复制完成时的超时，超时后检查是否需要退出
+         *
+         */
+        constexpr static std::uint64_t WAIT_SLOT_TIMEOUT_NS = 100'000'000;
+
+        SharedFramePublisher publisher_{};
+        std::mutex jobs_lock_{};
+        /**
+         * @brief 正在处理的任务不在jobs_中，Cancel需要等待它完成
+         *
+         */
+        std::condition_variable job_finished_condition_{};
+        std::deque<Job> jobs_{};
+        Vulkan::SwapchainCapture* p_current_capture_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_job_event_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_stop_event_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_worker_thread_{nullptr};
+
+        static DWORD WINAPI Do(LPVOID p_context);
+        void Run() noexcept;
+        bool PopJob(Job* p_out_job) noexcept;
+        void FinishJob(const Job& job) noexcept;
+        void ProcessJob(const Job& job) noexcept;
+
+    public:
+        CaptureWorker() = default;
+        ~CaptureWorker();
+        CaptureWorker(const CaptureWorker&) = delete;
+        CaptureWorker& operator=(const CaptureWorker&) = delete;
+
+        FastCaptureErrorCode Initialize() noexcept;
+
+        CaptureCounters& GetCounters() noexcept
+        {
+            return publisher_.GetCounters();
+        }
+        /**
+         * @brief 交给后台线程发布，槽位在发布后释放
+         *
+         */
+        void Push(Vulkan::SwapchainCapture* p_capture, const std::size_t slot_index) noexcept;
+        /**
+         * @brief 销毁交换链前调用，丢弃其尚未发布的帧并等待正在发布的帧完成
+         *
+         */
+        void Cancel(Vulkan::SwapchainCapture* p_capture) noexcept;
+    };
+}
+
+#endif // FAST_CAPTURE_VULKAN_LAYER_WINDOWS_CAPTURE_WORKER_H
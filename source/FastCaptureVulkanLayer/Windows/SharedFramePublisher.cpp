@@ -0,0 +1,166 @@
+#include "SharedFramePublisher.h"
+#include <cstring>
+#include "../../Utils/PixelPipeline.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    FastCaptureErrorCode SharedFramePublisher::Initialize() noexcept
+    {
+        shared_memory_name_prefix_ = Windows::MakeSharedMemoryNamePrefix(::GetCurrentProcessId());
+        const auto capture_descriptor_shared_name =
+            std::wstring(L"Global\\") + shared_memory_name_prefix_ + std::wstring(L"Descriptor");
+        h_capture_descriptor_ = ::CreateFileMappingW(
+            INVALID_HANDLE_VALUE,
+            NULL,
+            PAGE_READWRITE,
+            0,
+            sizeof(CaptureDescriptor),
+            capture_descriptor_shared_name.c_str());
+        if (h_capture_descriptor_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_SHARED_CAPTURE_DESCRIPTOR_FAILED);
+        }
+        p_capture_descriptor_ = reinterpret_cast<CaptureDescriptor*>(
+            ::MapViewOfFile(
+                h_capture_descriptor_.Get(),
+                FILE_MAP_ALL_ACCESS,
+                0,
+                0,
+                sizeof(CaptureDescriptor)));
+        if (p_capture_descriptor_.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_CREATE_SHARED_CAPTURE_DESCRIPTOR_MAP_OF_VIEW_FAILED);
+        }
+        if (auto result = frame_events_.Initialize(shared_memory_name_prefix_); !Utils::IsOk(result))
+        {
+            return result;
+        }
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        p_capture_descriptor->seq_lock.RecoverFromDeadWriter();
+        // 同一进程中之前的生产者可能已经用过一些代数，继续递增以免打开旧的、更小的共享内存
+        capture_image_generation_ = p_capture_descriptor->capture_image_generation;
+        frame_index_ = p_capture_descriptor->frame_index.load(std::memory_order_relaxed);
+        RefreshHeartbeat();
+        return FastCaptureMakeSuccessValue();
+    }
+
+    void SharedFramePublisher::RefreshHeartbeat() noexcept
+    {
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        const auto now_ms = ::GetTickCount64();
+        p_capture_descriptor->producer_heartbeat_ms.store(now_ms, std::memory_order_release);
+        const auto alive_count = p_capture_descriptor->ReapStaleSubscribers(
+            now_ms,
+            [p_capture_descriptor](const std::uint32_t process_id)
+            {
+                p_capture_descriptor->counters.reaped_subscriber_count.fetch_add(1, std::memory_order_relaxed);
+                p_capture_descriptor->event_log.Push(
+                    FAST_CAPTURE_EVENT_SUBSCRIBER_REAPED,
+                    FastCaptureMakeSuccessValue(),
+                    Windows::GetTimestampUs(),
+                    process_id);
+            });
+        has_subscribers_.store(alive_count != 0, std::memory_order_relaxed);
+    }
+
+    FastCaptureErrorCode SharedFramePublisher::PrepareCaptureImage(const std::size_t image_size) noexcept
+    {
+        if (image_size <= capture_image_capacity_)
+            [[likely]]
+        {
+            return FastCaptureMakeSuccessValue();
+        }
+        const auto generation = capture_image_generation_ + 1;
+        const auto capture_image_shared_name =
+            std::wstring(L"Global\\") + shared_memory_name_prefix_ + std::to_wstring(generation);
+        const std::uint64_t mapping_size = sizeof(CaptureImage) + image_size;
+        Windows::UniqueHandleInvalidNULL h_capture_image = ::CreateFileMappingW(
+            INVALID_HANDLE_VALUE,
+            NULL,
+            PAGE_READWRITE,
+            static_cast<DWORD>(mapping_size >> 32),
+            static_cast<DWORD>(mapping_size),
+            capture_image_shared_name.c_str());
+        if (h_capture_image.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_READ_PIXELS_THREAD_CREATE_SHARED_CAPTURE_IMAGE_FAILED);
+        }
+        Windows::UniqueMapViewOfFile<CaptureImage> p_capture_image =
+            reinterpret_cast<CaptureImage*>(
+                ::MapViewOfFile(
+                    h_capture_image.Get(),
+                    FILE_MAP_ALL_ACCESS,
+                    0,
+                    0,
+                    static_cast<SIZE_T>(mapping_size)));
+        if (p_capture_image.IsInvalid())
+        {
+            return Windows::MakeError(FAST_CAPTURE_E_READ_PIXELS_THREAD_CREATE_SHARED_CAPTURE_IMAGE_MAP_OF_VIEW_FAILED);
+        }
+        p_capture_image.Get()->seq_lock.RecoverFromDeadWriter();
+        h_capture_image_ = std::move(h_capture_image);
+        p_capture_image_ = std::move(p_capture_image);
+        capture_image_capacity_ = image_size;
+        // 描述信息中的代数由Publish在写入第一帧后更新
+        capture_image_generation_ = generation;
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        p_capture_descriptor->counters.capture_image_remap_count.fetch_add(1, std::memory_order_relaxed);
+        p_capture_descriptor->event_log.Push(
+            FAST_CAPTURE_EVENT_CAPTURE_IMAGE_REMAPPED,
+            FastCaptureMakeSuccessValue(),
+            Windows::GetTimestampUs(),
+            generation,
+            image_size);
+        return FastCaptureMakeSuccessValue();
+    }
+
+    FastCaptureErrorCode SharedFramePublisher::Publish(const FramePixels& frame) noexcept
+    {
+        const auto p_capture_descriptor = p_capture_descriptor_.Get();
+        const auto width = static_cast<GLint>(frame.width);
+        const auto height = static_cast<GLint>(frame.height);
+        CapturePlane image_planes[FAST_CAPTURE_PLANE_COUNT];
+        const auto image_size = MakeCapturePlanes(width, height, CAPTURE_COLOR_ONLY_FLAGS, image_planes);
+        if (auto result = PrepareCaptureImage(static_cast<std::size_t>(image_size)); !Utils::IsOk(result))
+        {
+            return result;
+        }
+
+        const auto p_capture_image = p_capture_image_.Get();
+        ++frame_index_;
+        {
+            auto capture_image_write_guard = Utils::MakeSeqLockWriteGuard(p_capture_image->seq_lock);
+            p_capture_image->frame_index = frame_index_;
+            p_capture_image->timestamp_us = frame.timestamp_us;
+            std::memcpy(p_capture_image->planes, image_planes, sizeof(image_planes));
+            // 交换链图像的第一行在上，OpenGL读回的第一行在下
+            const auto convert_frame = Utils::PixelPipeline::SelectConvertFrame(
+                frame.is_bgra ? Utils::PixelPipeline::PixelFormat::Bgra8 : Utils::PixelPipeline::PixelFormat::Rgba8,
+                Utils::PixelPipeline::PixelFormat::Rgba8,
+                true,
+                false);
+            convert_frame(
+                {frame.p_data, frame.row_pitch, frame.width, frame.height},
+                {},
+                p_capture_image->GetDataPointer() + image_planes[FAST_CAPTURE_PLANE_COLOR].offset);
+        }
+        {
+            auto capture_descriptor_write_guard = Utils::MakeSeqLockWriteGuard(p_capture_descriptor->seq_lock);
+            p_capture_descriptor->viewport[0] = 0;
+            p_capture_descriptor->viewport[1] = 0;
+            p_capture_descriptor->viewport[2] = width;
+            p_capture_descriptor->viewport[3] = height;
+            p_capture_descriptor->color_size = CAPTURE_COLOR_PIXEL_SIZE;
+            p_capture_descriptor->capture_flags = CAPTURE_COLOR_ONLY_FLAGS;
+            std::memcpy(p_capture_descriptor->planes, image_planes, sizeof(image_planes));
+            p_capture_descriptor->capture_image_generation = capture_image_generation_;
+        }
+        p_capture_descriptor->repeat_count.store(0, std::memory_order_relaxed);
+        p_capture_descriptor->frame_timestamp_us.store(frame.timestamp_us, std::memory_order_relaxed);
+        p_capture_descriptor->frame_index.store(frame_index_, std::memory_order_release);
+        frame_events_.Notify(*p_capture_descriptor);
+        p_capture_descriptor->counters.published_frame_count.fetch_add(1, std::memory_order_relaxed);
+        p_capture_descriptor->counters.publish_latency.Record(Windows::GetTimestampUs() - frame.timestamp_us);
+        return FastCaptureMakeSuccessValue();
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef FAST_CAPTURE_VULKAN_LAYER_WINDOWS_SHARED_FRAME_PUBLISHER_H
+#define FAST_CAPTURE_VULKAN_LAYER_WINDOWS_SHARED_FRAME_PUBLISHER_H
+
+#include "FastCaptureDef.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "../../FastCaptureInjectDll/FastCaptureInjectDllDef.h"
+#include "../../FastCaptureInjectDll/Windows/FrameEvents.hpp"
+#include "../../Utils/Windows/UtilsWindows.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    /**
+     * @brief 读回的一帧，行从上到下排列
+     *
+     */
+    struct FramePixels
+    {
+        const std::byte* p_data{nullptr};
+        std::uint32_t width{0};
+        std::uint32_t height{0};
+        std::size_t row_pitch{0};
+        /**
+         * @brief 为true时像素按B、G、R、A排列，发布时交换为R、G、B、A
+         *
+         */
+        bool is_bgra{false};
+        std::uint64_t timestamp_us{0};
+    };
+
+    /**
+     * @brief 在目标进程内创建与注入DLL相同的描述信息和图像共享内存并发布帧，
+        已有的客户端不需要区分帧来自OpenGL还是Vulkan。
+        除HasSubscribers和GetCounters外只能由同一个线程调用，以满足事件日志只有一个写者的要求
+     *
+     */
+    class SharedFramePublisher
+    {
+        constexpr static std::uint32_t CAPTURE_COLOR_ONLY_FLAGS = FAST_CAPTURE_FLAG_NONE;
+
+        std::wstring shared_memory_name_prefix_{};
+        Windows::UniqueHandleInvalidNULL h_capture_descriptor_{nullptr};
+        Windows::UniqueMapViewOfFile<CaptureDescriptor> p_capture_descriptor_{nullptr};
+        Windows::UniqueHandleInvalidNULL h_capture_image_{nullptr};
+        Windows::UniqueMapViewOfFile<CaptureImage> p_capture_image_{nullptr};
+        FrameEvents frame_events_{};
+        std::size_t capture_image_capacity_{0};
+        std::uint32_t capture_image_generation_{0};
+        std::uint64_t frame_index_{0};
+        /**
+         * @brief 共享内存以进程ID命名，一个进程内只有一个发布者，因此是静态的。
+            呈现的线程不持有层的锁就可以读取，发布者被销毁后仍然可以安全地读取
+         *
+         */
+        inline static std::atomic<bool> has_subscribers_{false};
+
+        FastCaptureErrorCode PrepareCaptureImage(const std::size_t image_size) noexcept;
+
+    public:
+        SharedFramePublisher() = default;
+        ~SharedFramePublisher()
+        {
+            has_subscribers_.store(false, std::memory_order_relaxed);
+        }
+        SharedFramePublisher(const SharedFramePublisher&) = delete;
+        SharedFramePublisher& operator=(const SharedFramePublisher&) = delete;
+
+        FastCaptureErrorCode Initialize() noexcept;
+        /**
+         * @brief 刷新生产者心跳并回收心跳超时的客户端，需要定期调用
+         *
+         */
+        void RefreshHeartbeat() noexcept;
+        /**
+         * @brief 没有客户端时被Hook的函数直接跳过捕获，可以在任意线程调用，不需要发布者存在
+         *
+         */
+        static bool HasSubscribers() noexcept
+        {
+            return has_subscribers_.load(std::memory_order_relaxed);
+        }
+        /**
+         * @brief 计数都是原子变量，可以在任意线程累加
+         *
+         */
+        CaptureCounters& GetCounters() noexcept
+        {
+            return p_capture_descriptor_.Get()->counters;
+        }
+        void PushEvent(
+            const std::uint32_t code,
+            const FastCaptureErrorCode error,
+            const std::uint64_t context_0 = 0,
+            const std::uint64_t context_1 = 0) noexcept
+        {
+            p_capture_descriptor_.Get()->event_log.Push(code, error, Windows::GetTimestampUs(), context_0, context_1);
+        }
+        /**
+         * @brief 以OpenGL的约定（行从下到上，RGBA）写入颜色平面
+         *
+         */
+        FastCaptureErrorCode Publish(const FramePixels& frame) noexcept;
+
+        static std::uint64_t GetTimestampUs() noexcept
+        {
+            return Windows::GetTimestampUs();
+        }
+    };
+}
+
+#endif // FAST_CAPTURE_VULKAN_LAYER_WINDOWS_SHARED_FRAME_PUBLISHER_H
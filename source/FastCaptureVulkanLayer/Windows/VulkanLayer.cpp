@@ -0,0 +1,587 @@
+#include "../VulkanLayer.h"
+#include <cstring>
+#include <new>
+#include "CaptureWorker.h"
+#include "../SwapchainCapture.h"
+
+#define FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, get_proc_addr, handle, name) \
+    (dispatch).name = reinterpret_cast<PFN_vk##name>((get_proc_addr)((handle), "vk" #name))
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Vulkan
+    {
+        namespace
+        {
+            /**
+             * @brief 存在能捕获的设备时才运行后台线程，与capture_device_count一起由LayerData::lock_保护
+             *
+             */
+            std::unique_ptr<CaptureWorker> p_capture_worker{};
+            std::size_t capture_device_count = 0;
+
+            /**
+             * @brief 在pNext链中找到加载器传给层的信息
+             *
+             */
+            template <class T>
+            T* FindLoaderCreateInfo(const void* p_next, const VkStructureType type, const VkLayerFunction function) noexcept
+            {
+                auto p_create_info = static_cast<T*>(const_cast<void*>(p_next));
+                while (p_create_info != nullptr
+                       && !(p_create_info->sType == type && p_create_info->function == function))
+                {
+                    p_create_info = static_cast<T*>(const_cast<void*>(p_create_info->pNext));
+                }
+                return p_create_info;
+            }
+
+            InstanceData* FindInstance(LayerData& layer_data, const DispatchKey key) noexcept
+            {
+                const auto it = layer_data.instances_.find(key);
+                return it == layer_data.instances_.end() ? nullptr : it->second.get();
+            }
+
+            DeviceData* FindDevice(LayerData& layer_data, const DispatchKey key) noexcept
+            {
+                const auto it = layer_data.devices_.find(key);
+                return it == layer_data.devices_.end() ? nullptr : it->second.get();
+            }
+
+            /**
+             * @brief 复制完成的通知依赖核心的时间线信号量，实例和物理设备都需要至少1.2
+             *
+             */
+            bool IsTimelineSemaphoreSupported(const InstanceData& instance, const VkPhysicalDevice physical_device) noexcept
+            {
+                if (instance.api_version < VK_API_VERSION_1_2)
+                {
+                    return false;
+                }
+                VkPhysicalDeviceProperties properties{};
+                instance.dispatch.GetPhysicalDeviceProperties(physical_device, &properties);
+                if (properties.apiVersion < VK_API_VERSION_1_2 || instance.dispatch.GetPhysicalDeviceFeatures2 == nullptr)
+                {
+                    return false;
+                }
+                VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{};
+                timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+                VkPhysicalDeviceFeatures2 features{};
+                features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features.pNext = &timeline_semaphore_features;
+                instance.dispatch.GetPhysicalDeviceFeatures2(physical_device, &features);
+                return timeline_semaphore_features.timelineSemaphore == VK_TRUE;
+            }
+
+            /**
+             * @brief 应用已经在pNext链中声明了时间线信号量特性时，返回其开关
+             *
+             */
+            VkBool32* FindTimelineSemaphoreFeature(const void* p_next) noexcept
+            {
+                auto p_structure = static_cast<VkBaseOutStructure*>(const_cast<void*>(p_next));
+                for (; p_structure != nullptr; p_structure = p_structure->pNext)
+                {
+                    if (p_structure->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES)
+                    {
+                        return &reinterpret_cast<VkPhysicalDeviceVulkan12Features*>(p_structure)->timelineSemaphore;
+                    }
+                    if (p_structure->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES)
+                    {
+                        return &reinterpret_cast<VkPhysicalDeviceTimelineSemaphoreFeatures*>(p_structure)->timelineSemaphore;
+                    }
+                }
+                return nullptr;
+            }
+
+            VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetInstanceProcAddr(VkInstance instance, const char* p_name);
+            VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice device, const char* p_name);
+
+            VKAPI_ATTR VkResult VKAPI_CALL CreateInstance(
+                const VkInstanceCreateInfo* p_create_info,
+                const VkAllocationCallbacks* p_allocator,
+                VkInstance* p_instance)
+            {
+                auto p_link_info = FindLoaderCreateInfo<VkLayerInstanceCreateInfo>(
+                    p_create_info->pNext,
+                    VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO,
+                    VK_LAYER_LINK_INFO);
+                if (p_link_info == nullptr)
+                {
+                    return VK_ERROR_INITIALIZATION_FAILED;
+                }
+                const auto next_get_instance_proc_addr = p_link_info->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+                // 下一层从链表的下一个节点取得自己的信息
+                p_link_info->u.pLayerInfo = p_link_info->u.pLayerInfo->pNext;
+                const auto next_create_instance = reinterpret_cast<PFN_vkCreateInstance>(
+                    next_get_instance_proc_addr(VK_NULL_HANDLE, "vkCreateInstance"));
+                const auto vk_result = next_create_instance(p_create_info, p_allocator, p_instance);
+                if (vk_result != VK_SUCCESS)
+                {
+                    return vk_result;
+                }
+
+                std::unique_ptr<InstanceData> p_instance_data{new (std::nothrow) InstanceData{}};
+                if (p_instance_data == nullptr)
+                {
+                    const auto next_destroy_instance = reinterpret_cast<PFN_vkDestroyInstance>(
+                        next_get_instance_proc_addr(*p_instance, "vkDestroyInstance"));
+                    next_destroy_instance(*p_instance, p_allocator);
+                    return VK_ERROR_OUT_OF_HOST_MEMORY;
+                }
+                p_instance_data->instance = *p_instance;
+                if (p_create_info->pApplicationInfo != nullptr && p_create_info->pApplicationInfo->apiVersion != 0)
+                {
+                    p_instance_data->api_version = p_create_info->pApplicationInfo->apiVersion;
+                }
+                auto& dispatch = p_instance_data->dispatch;
+                dispatch.GetInstanceProcAddr = next_get_instance_proc_addr;
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_instance_proc_addr, *p_instance, DestroyInstance);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_instance_proc_addr, *p_instance, GetPhysicalDeviceProperties);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_instance_proc_addr, *p_instance, GetPhysicalDeviceMemoryProperties);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_instance_proc_addr, *p_instance, GetPhysicalDeviceQueueFamilyProperties);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_instance_proc_addr, *p_instance, GetPhysicalDeviceFeatures2);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_instance_proc_addr, *p_instance, GetPhysicalDeviceSurfaceCapabilitiesKHR);
+
+                auto& layer_data = LayerData::GetInstance();
+                std::lock_guard guard{layer_data.lock_};
+                layer_data.instances_[GetDispatchKey(*p_instance)] = std::move(p_instance_data);
+                return VK_SUCCESS;
+            }
+
+            VKAPI_ATTR void VKAPI_CALL DestroyInstance(VkInstance instance, const VkAllocationCallbacks* p_allocator)
+            {
+                auto& layer_data = LayerData::GetInstance();
+                std::unique_ptr<InstanceData> p_instance_data{};
+                {
+                    std::lock_guard guard{layer_data.lock_};
+                    const auto it = layer_data.instances_.find(GetDispatchKey(instance));
+                    if (it == layer_data.instances_.end())
+                    {
+                        return;
+                    }
+                    p_instance_data = std::move(it->second);
+                    layer_data.instances_.erase(it);
+                }
+                p_instance_data->dispatch.DestroyInstance(instance, p_allocator);
+            }
+
+            VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(
+                VkPhysicalDevice physical_device,
+                const VkDeviceCreateInfo* p_create_info,
+                const VkAllocationCallbacks* p_allocator,
+                VkDevice* p_device)
+            {
+                auto p_link_info = FindLoaderCreateInfo<VkLayerDeviceCreateInfo>(
+                    p_create_info->pNext,
+                    VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO,
+                    VK_LAYER_LINK_INFO);
+                const auto p_callback_info = FindLoaderCreateInfo<VkLayerDeviceCreateInfo>(
+                    p_create_info->pNext,
+                    VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO,
+                    VK_LOADER_DATA_CALLBACK);
+                if (p_link_info == nullptr || p_callback_info == nullptr)
+                {
+                    return VK_ERROR_INITIALIZATION_FAILED;
+                }
+                const auto next_get_instance_proc_addr = p_link_info->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+                const auto next_get_device_proc_addr = p_link_info->u.pLayerInfo->pfnNextGetDeviceProcAddr;
+                p_link_info->u.pLayerInfo = p_link_info->u.pLayerInfo->pNext;
+
+                auto& layer_data = LayerData::GetInstance();
+                InstanceData* p_instance_data = nullptr;
+                {
+                    std::lock_guard guard{layer_data.lock_};
+                    p_instance_data = FindInstance(layer_data, GetDispatchKey(physical_device));
+                }
+                if (p_instance_data == nullptr)
+                {
+                    return VK_ERROR_INITIALIZATION_FAILED;
+                }
+                const auto next_create_device = reinterpret_cast<PFN_vkCreateDevice>(
+                    next_get_instance_proc_addr(p_instance_data->instance, "vkCreateDevice"));
+
+                // 启用时间线信号量，应用自己声明了特性结构体时临时打开其开关，否则在pNext链头部插入一个
+                const auto is_capture_supported = IsTimelineSemaphoreSupported(*p_instance_data, physical_device);
+                auto create_info = *p_create_info;
+                VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{};
+                timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+                VkBool32* p_application_timeline_semaphore_feature = nullptr;
+                VkBool32 application_timeline_semaphore_feature = VK_FALSE;
+                if (is_capture_supported)
+                {
+                    p_application_timeline_semaphore_feature = FindTimelineSemaphoreFeature(create_info.pNext);
+                    if (p_application_timeline_semaphore_feature != nullptr)
+                    {
+                        application_timeline_semaphore_feature = *p_application_timeline_semaphore_feature;
+                        *p_application_timeline_semaphore_feature = VK_TRUE;
+                    }
+                    else
+                    {
+                        timeline_semaphore_features.pNext = const_cast<void*>(create_info.pNext);
+                        timeline_semaphore_features.timelineSemaphore = VK_TRUE;
+                        create_info.pNext = &timeline_semaphore_features;
+                    }
+                }
+                const auto vk_result = next_create_device(physical_device, &create_info, p_allocator, p_device);
+                if (p_application_timeline_semaphore_feature != nullptr)
+                {
+                    *p_application_timeline_semaphore_feature = application_timeline_semaphore_feature;
+                }
+                if (vk_result != VK_SUCCESS)
+                {
+                    return vk_result;
+                }
+
+                std::unique_ptr<DeviceData> p_device_data{new (std::nothrow) DeviceData{}};
+                if (p_device_data == nullptr)
+                {
+                    const auto next_destroy_device = reinterpret_cast<PFN_vkDestroyDevice>(
+                        next_get_device_proc_addr(*p_device, "vkDestroyDevice"));
+                    next_destroy_device(*p_device, p_allocator);
+                    return VK_ERROR_OUT_OF_HOST_MEMORY;
+                }
+                p_device_data->device = *p_device;
+                p_device_data->physical_device = physical_device;
+                p_device_data->p_instance = p_instance_data;
+                p_device_data->set_device_loader_data = p_callback_info->u.pfnSetDeviceLoaderData;
+                p_instance_data->dispatch.GetPhysicalDeviceMemoryProperties(physical_device, &p_device_data->memory_properties);
+                std::uint32_t queue_family_count = 0;
+                p_instance_data->dispatch.GetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+                p_device_data->queue_family_properties.resize(queue_family_count);
+                p_instance_data->dispatch.GetPhysicalDeviceQueueFamilyProperties(
+                    physical_device,
+                    &queue_family_count,
+                    p_device_data->queue_family_properties.data());
+
+                auto& dispatch = p_device_data->dispatch;
+                dispatch.GetDeviceProcAddr = next_get_device_proc_addr;
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, DestroyDevice);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, GetDeviceQueue);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, GetDeviceQueue2);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, CreateSwapchainKHR);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, DestroySwapchainKHR);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, GetSwapchainImagesKHR);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, QueuePresentKHR);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, QueueSubmit);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, CreateCommandPool);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, DestroyCommandPool);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, AllocateCommandBuffers);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, BeginCommandBuffer);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, EndCommandBuffer);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, CmdPipelineBarrier);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, CmdCopyImageToBuffer);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, CreateBuffer);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, DestroyBuffer);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, GetBufferMemoryRequirements);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, AllocateMemory);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, FreeMemory);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, BindBufferMemory);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, MapMemory);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, InvalidateMappedMemoryRanges);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, CreateSemaphore);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, DestroySemaphore);
+                FAST_CAPTURE_VULKAN_LOAD_FUNCTION(dispatch, next_get_device_proc_addr, *p_device, WaitSemaphores);
+                p_device_data->is_capture_supported = is_capture_supported && dispatch.WaitSemaphores != nullptr;
+
+                std::lock_guard guard{layer_data.lock_};
+                if (p_device_data->is_capture_supported)
+                {
+                    if (capture_device_count == 0)
+                    {
+                        p_capture_worker.reset(new (std::nothrow) CaptureWorker{});
+                        if (p_capture_worker != nullptr && !Utils::IsOk(p_capture_worker->Initialize()))
+                        {
+                            p_capture_worker.reset();
+                        }
+                    }
+                    ++capture_device_count;
+                }
+                layer_data.devices_[GetDispatchKey(*p_device)] = std::move(p_device_data);
+                return VK_SUCCESS;
+            }
+
+            VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCallbacks* p_allocator)
+            {
+                auto& layer_data = LayerData::GetInstance();
+                std::unique_ptr<DeviceData> p_device_data{};
+                {
+                    std::lock_guard guard{layer_data.lock_};
+                    const auto it = layer_data.devices_.find(GetDispatchKey(device));
+                    if (it == layer_data.devices_.end())
+                    {
+                        return;
+                    }
+                    p_device_data = std::move(it->second);
+                    layer_data.devices_.erase(it);
+                    for (const auto& [swapchain, p_capture] : p_device_data->swapchains)
+                    {
+                        if (p_capture_worker != nullptr)
+                        {
+                            p_capture_worker->Cancel(p_capture.get());
+                        }
+                    }
+                    p_device_data->swapchains.clear();
+                    if (p_device_data->is_capture_supported && --capture_device_count == 0)
+                    {
+                        p_capture_worker.reset();
+                    }
+                }
+                p_device_data->dispatch.DestroyDevice(device, p_allocator);
+            }
+
+            /**
+             * @brief 记录队列所属的队列族，捕获时在同一个队列上提交复制命令
+             *
+             */
+            void RecordQueueFamily(const VkDevice device, const VkQueue queue, const std::uint32_t queue_family_index) noexcept
+            {
+                constexpr VkQueueFlags TRANSFER_CAPABLE_FLAGS =
+                    VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+                auto& layer_data = LayerData::GetInstance();
+                std::lock_guard guard{layer_data.lock_};
+                const auto p_device_data = FindDevice(layer_data, GetDispatchKey(device));
+                if (queue == VK_NULL_HANDLE
+                    || p_device_data == nullptr
+                    || queue_family_index >= p_device_data->queue_family_properties.size()
+                    || !(p_device_data->queue_family_properties[queue_family_index].queueFlags & TRANSFER_CAPABLE_FLAGS))
+                {
+                    return;
+                }
+                p_device_data->queue_family_indices[queue] = queue_family_index;
+            }
+
+            VKAPI_ATTR void VKAPI_CALL GetDeviceQueue(
+                VkDevice device,
+                uint32_t queue_family_index,
+                uint32_t queue_index,
+                VkQueue* p_queue)
+            {
+                PFN_vkGetDeviceQueue next_get_device_queue = nullptr;
+                {
+                    auto& layer_data = LayerData::GetInstance();
+                    std::lock_guard guard{layer_data.lock_};
+                    next_get_device_queue = FindDevice(layer_data, GetDispatchKey(device))->dispatch.GetDeviceQueue;
+                }
+                next_get_device_queue(device, queue_family_index, queue_index, p_queue);
+                RecordQueueFamily(device, *p_queue, queue_family_index);
+            }
+
+            VKAPI_ATTR void VKAPI_CALL GetDeviceQueue2(
+                VkDevice device,
+                const VkDeviceQueueInfo2* p_queue_info,
+                VkQueue* p_queue)
+            {
+                PFN_vkGetDeviceQueue2 next_get_device_queue2 = nullptr;
+                {
+                    auto& layer_data = LayerData::GetInstance();
+                    std::lock_guard guard{layer_data.lock_};
+                    next_get_device_queue2 = FindDevice(layer_data, GetDispatchKey(device))->dispatch.GetDeviceQueue2;
+                }
+                next_get_device_queue2(device, p_queue_info, p_queue);
+                RecordQueueFamily(device, *p_queue, p_queue_info->queueFamilyIndex);
+            }
+
+            VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(
+                VkDevice device,
+                const VkSwapchainCreateInfoKHR* p_create_info,
+                const VkAllocationCallbacks* p_allocator,
+                VkSwapchainKHR* p_swapchain)
+            {
+                auto& layer_data = LayerData::GetInstance();
+                std::lock_guard guard{layer_data.lock_};
+                const auto p_device_data = FindDevice(layer_data, GetDispatchKey(device));
+                auto create_info = *p_create_info;
+                if (p_device_data->is_capture_supported)
+                {
+                    // 复制交换链图像需要TRANSFER_SRC用途，表面不支持时交换链照常创建但不会被捕获
+                    VkSurfaceCapabilitiesKHR surface_capabilities{};
+                    const auto& instance_dispatch = p_device_data->p_instance->dispatch;
+                    if (instance_dispatch.GetPhysicalDeviceSurfaceCapabilitiesKHR != nullptr
+                        && instance_dispatch.GetPhysicalDeviceSurfaceCapabilitiesKHR(
+                               p_device_data->physical_device,
+                               create_info.surface,
+                               &surface_capabilities)
+                               == VK_SUCCESS
+                        && (surface_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+                    {
+                        create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                    }
+                }
+                const auto vk_result = p_device_data->dispatch.CreateSwapchainKHR(device, &create_info, p_allocator, p_swapchain);
+                if (vk_result != VK_SUCCESS || !p_device_data->is_capture_supported)
+                {
+                    return vk_result;
+                }
+                std::unique_ptr<SwapchainCapture> p_capture{new (std::nothrow) SwapchainCapture{}};
+                if (p_capture != nullptr && Utils::IsOk(p_capture->Initialize(p_device_data, *p_swapchain, create_info)))
+                {
+                    p_device_data->swapchains[*p_swapchain] = std::move(p_capture);
+                }
+                return vk_result;
+            }
+
+            VKAPI_ATTR void VKAPI_CALL DestroySwapchainKHR(
+                VkDevice device,
+                VkSwapchainKHR swapchain,
+                const VkAllocationCallbacks* p_allocator)
+            {
+                auto& layer_data = LayerData::GetInstance();
+                std::lock_guard guard{layer_data.lock_};
+                const auto p_device_data = FindDevice(layer_data, GetDispatchKey(device));
+                if (const auto it = p_device_data->swapchains.find(swapchain); it != p_device_data->swapchains.end())
+                {
+                    if (p_capture_worker != nullptr)
+                    {
+                        p_capture_worker->Cancel(it->second.get());
+                    }
+                    p_device_data->swapchains.erase(it);
+                }
+                p_device_data->dispatch.DestroySwapchainKHR(device, swapchain, p_allocator);
+            }
+
+            VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* p_present_info)
+            {
+                auto present_info = *p_present_info;
+                // 没有客户端时不提交任何额外的命令，也不判断交换链能否捕获
+                const bool should_capture = SharedFramePublisher::HasSubscribers() && present_info.swapchainCount != 0;
+                VkSemaphore capture_semaphore = VK_NULL_HANDLE;
+                PFN_vkQueuePresentKHR next_queue_present = nullptr;
+                {
+                    auto& layer_data = LayerData::GetInstance();
+                    std::lock_guard guard{layer_data.lock_};
+                    const auto p_device_data = FindDevice(layer_data, GetDispatchKey(queue));
+                    next_queue_present = p_device_data->dispatch.QueuePresentKHR;
+                    const auto queue_family_it = p_device_data->queue_family_indices.find(queue);
+                    // 描述信息只有一个，同时呈现多个交换链时只捕获第一个
+                    const auto swapchain_it = should_capture
+                                                  ? p_device_data->swapchains.find(present_info.pSwapchains[0])
+                                                  : p_device_data->swapchains.end();
+                    if (p_capture_worker != nullptr
+                        && queue_family_it != p_device_data->queue_family_indices.end()
+                        && swapchain_it != p_device_data->swapchains.end())
+                    {
+                        const auto p_capture = swapchain_it->second.get();
+                        const auto slot_index = p_capture->AcquireSlot();
+                        if (slot_index == SwapchainCapture::SLOT_COUNT)
+                        {
+                            p_capture_worker->GetCounters().pbo_ring_full_count.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        else
+                        {
+                            capture_semaphore = p_capture->Capture(
+                                slot_index,
+                                queue,
+                                queue_family_it->second,
+                                present_info.pImageIndices[0],
+                                present_info.waitSemaphoreCount,
+                                present_info.pWaitSemaphores,
+                                SharedFramePublisher::GetTimestampUs());
+                            if (capture_semaphore == VK_NULL_HANDLE)
+                            {
+                                p_capture->ReleaseSlot(slot_index);
+                            }
+                            else
+                            {
+                                p_capture_worker->Push(p_capture, slot_index);
+                            }
+                        }
+                    }
+                }
+                if (capture_semaphore != VK_NULL_HANDLE)
+                {
+                    // 应用的信号量已经被复制命令等待过，呈现改为等待复制完成
+                    present_info.waitSemaphoreCount = 1;
+                    present_info.pWaitSemaphores = &capture_semaphore;
+                }
+                // 呈现可能因垂直同步而阻塞，不能持有层的锁，否则所有设备和队列的呈现都被串行化
+                return next_queue_present(queue, &present_info);
+            }
+
+            struct HookEntry
+            {
+                const char* name;
+                PFN_vkVoidFunction function;
+            };
+
+            const HookEntry DEVICE_HOOKS[] = {
+                {"vkGetDeviceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(&GetDeviceProcAddr)},
+                {"vkDestroyDevice", reinterpret_cast<PFN_vkVoidFunction>(&DestroyDevice)},
+                {"vkGetDeviceQueue", reinterpret_cast<PFN_vkVoidFunction>(&GetDeviceQueue)},
+                {"vkGetDeviceQueue2", reinterpret_cast<PFN_vkVoidFunction>(&GetDeviceQueue2)},
+                {"vkCreateSwapchainKHR", reinterpret_cast<PFN_vkVoidFunction>(&CreateSwapchainKHR)},
+                {"vkDestroySwapchainKHR", reinterpret_cast<PFN_vkVoidFunction>(&DestroySwapchainKHR)},
+                {"vkQueuePresentKHR", reinterpret_cast<PFN_vkVoidFunction>(&QueuePresentKHR)},
+            };
+            const HookEntry INSTANCE_HOOKS[] = {
+                {"vkGetInstanceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(&GetInstanceProcAddr)},
+                {"vkCreateInstance", reinterpret_cast<PFN_vkVoidFunction>(&CreateInstance)},
+                {"vkDestroyInstance", reinterpret_cast<PFN_vkVoidFunction>(&DestroyInstance)},
+                {"vkCreateDevice", reinterpret_cast<PFN_vkVoidFunction>(&CreateDevice)},
+            };
+
+            template <std::size_t N>
+            PFN_vkVoidFunction FindHook(const HookEntry (&hooks)[N], const char* p_name) noexcept
+            {
+                for (const auto& hook : hooks)
+                {
+                    if (std::strcmp(hook.name, p_name) == 0)
+                    {
+                        return hook.function;
+                    }
+                }
+                return nullptr;
+            }
+
+            VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice device, const char* p_name)
+            {
+                if (const auto function = FindHook(DEVICE_HOOKS, p_name); function != nullptr)
+                {
+                    return function;
+                }
+                auto& layer_data = LayerData::GetInstance();
+                std::lock_guard guard{layer_data.lock_};
+                const auto p_device_data = FindDevice(layer_data, GetDispatchKey(device));
+                return p_device_data == nullptr ? nullptr : p_device_data->dispatch.GetDeviceProcAddr(device, p_name);
+            }
+
+            VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetInstanceProcAddr(VkInstance instance, const char* p_name)
+            {
+                if (const auto function = FindHook(INSTANCE_HOOKS, p_name); function != nullptr)
+                {
+                    return function;
+                }
+                if (const auto function = FindHook(DEVICE_HOOKS, p_name); function != nullptr)
+                {
+                    return function;
+                }
+                if (instance == VK_NULL_HANDLE)
+                {
+                    return nullptr;
+                }
+                auto& layer_data = LayerData::GetInstance();
+                std::lock_guard guard{layer_data.lock_};
+                const auto p_instance_data = FindInstance(layer_data, GetDispatchKey(instance));
+                return p_instance_data == nullptr ? nullptr : p_instance_data->dispatch.GetInstanceProcAddr(instance, p_name);
+            }
+        }
+    }
+}
+
+extern "C" FAST_CAPTURE_EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkNegotiateLoaderLayerInterfaceVersion(
+    VkNegotiateLayerInterface* p_version_struct)
+{
+    if (p_version_struct == nullptr || p_version_struct->sType != LAYER_NEGOTIATE_INTERFACE_STRUCT)
+    {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    // 版本2起加载器通过此函数获得入口，不再需要导出vkGetInstanceProcAddr
+    if (p_version_struct->loaderLayerInterfaceVersion > 2)
+    {
+        p_version_struct->loaderLayerInterfaceVersion = 2;
+    }
+    p_version_struct->pfnGetInstanceProcAddr = &FAST_CAPTURE::Vulkan::GetInstanceProcAddr;
+    p_version_struct->pfnGetDeviceProcAddr = &FAST_CAPTURE::Vulkan::GetDeviceProcAddr;
+    p_version_struct->pfnGetPhysicalDeviceProcAddr = nullptr;
+    return VK_SUCCESS;
+}
@@ -0,0 +1,108 @@
+#ifndef FAST_CAPTURE_UTILS_BOUNDED_MPSC_QUEUE_HPP
+#define FAST_CAPTURE_UTILS_BOUNDED_MPSC_QUEUE_HPP
+
+#include "FastCaptureDef.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Utils
+    {
+        /**
+         * @brief 容量固定的无锁队列，允许多个生产者、一个消费者。
+            每个槽位带有序号，生产者以CAS占用写入位置，消费者只读取自己的位置，
+            因此任何线程都不会等待另一个线程，队列满时Push直接失败
+         *
+         * @tparam T 必须可以平凡复制，槽位在Pop之后不析构
+         * @tparam Capacity 必须是2的幂
+         */
+        template <class T, std::size_t Capacity>
+        class BoundedMpscQueue
+        {
+        private:
+            static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+            static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
+
+            struct Slot
+            {
+                /**
+                 * @brief 等于位置时可以写入，等于位置+1时可以读取
+                 *
+                 */
+                std::atomic<std::size_t> sequence{0};
+                T value{};
+            };
+
+            std::array<Slot, Capacity> slots_{};
+            std::atomic<std::size_t> write_position_{0};
+            std::size_t read_position_{0};
+
+        public:
+            BoundedMpscQueue() noexcept
+            {
+                for (std::size_t i = 0; i < Capacity; ++i)
+                {
+                    slots_[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+            BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+            BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+            /**
+             * @brief 可以在任意线程中调用
+             *
+             * @return false 队列已满
+             */
+            bool Push(const T& value) noexcept
+            {
+                auto position = write_position_.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    auto& slot = slots_[position & (Capacity - 1)];
+                    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+                    if (sequence == position)
+                    {
+                        if (write_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            slot.value = value;
+                            slot.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                        // 失败时position已被更新为最新的写入位置
+                    }
+                    else if (sequence < position)
+                    {
+                        // 消费者还没有取走上一轮写入此槽位的元素
+                        return false;
+                    }
+                    else
+                    {
+                        position = write_position_.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+            /**
+             * @brief 只能在消费者线程中调用。生产者已经占用但还没有写完的位置被视为空，之后的元素也不会被越过
+             *
+             */
+            std::optional<T> Pop() noexcept
+            {
+                auto& slot = slots_[read_position_ & (Capacity - 1)];
+                if (slot.sequence.load(std::memory_order_acquire) != read_position_ + 1)
+                {
+                    return {};
+                }
+                const T result = slot.value;
+                slot.sequence.store(read_position_ + Capacity, std::memory_order_release);
+                ++read_position_;
+                return result;
+            }
+        };
+    }
+}
+
+#endif // FAST_CAPTURE_UTILS_BOUNDED_MPSC_QUEUE_HPP
@@ -0,0 +1,86 @@
+#ifndef FAST_CAPTURE_UTILS_COALESCING_MAILBOX_HPP
+#define FAST_CAPTURE_UTILS_COALESCING_MAILBOX_HPP
+
+#include "FastCaptureDef.h"
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include "BoundedMpscQueue.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Utils
+    {
+        enum class MailboxPostResult
+        {
+            /**
+             * @brief 命令已投递，需要唤醒消费者
+             *
+             */
+            Posted,
+            /**
+             * @brief 消费者还没有取走上一次的同类命令，两次合并为一次，不需要再唤醒消费者
+             *
+             */
+            Coalesced,
+            /**
+             * @brief 控制命令队列已满
+             *
+             */
+            Full
+        };
+
+        /**
+         * @brief 多个生产者、一个消费者的命令邮箱。
+            CoalescedCommand只保留一个待处理标志，消费者取走之前的多次投递合并为一次；
+            其它命令是控制命令，进入有界队列并按投递顺序取出
+         *
+         * @tparam Command 命令的枚举类型
+         * @tparam CoalescedCommand 需要合并的命令
+         * @tparam Capacity 控制命令队列的容量，必须是2的幂
+         */
+        template <class Command, Command CoalescedCommand, std::size_t Capacity>
+        class CoalescingMailbox
+        {
+        private:
+            BoundedMpscQueue<Command, Capacity> control_commands_{};
+            std::atomic<bool> is_coalesced_command_pending_{false};
+
+        public:
+            /**
+             * @brief 可以在任意线程中调用
+             *
+             */
+            MailboxPostResult Post(const Command command) noexcept
+            {
+                if (command == CoalescedCommand)
+                    [[likely]]
+                {
+                    return is_coalesced_command_pending_.exchange(true, std::memory_order_release)
+                               ? MailboxPostResult::Coalesced
+                               : MailboxPostResult::Posted;
+                }
+                return control_commands_.Push(command) ? MailboxPostResult::Posted : MailboxPostResult::Full;
+            }
+            /**
+             * @brief 只能在消费者线程中调用，按投递顺序取出控制命令
+             *
+             */
+            std::optional<Command> PopControlCommand() noexcept
+            {
+                return control_commands_.Pop();
+            }
+            /**
+             * @brief 只能在消费者线程中调用，取走待处理的合并命令，之后的投递重新需要唤醒消费者
+             *
+             * @return true 取走之前有待处理的合并命令
+             */
+            bool TakeCoalescedCommand() noexcept
+            {
+                return is_coalesced_command_pending_.exchange(false, std::memory_order_acquire);
+            }
+        };
+    }
+}
+
+#endif // FAST_CAPTURE_UTILS_COALESCING_MAILBOX_HPP
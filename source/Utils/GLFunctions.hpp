@@ -0,0 +1,187 @@
+#ifndef FAST_CAPTURE_UTILS_GL_FUNCTIONS_HPP
+#define FAST_CAPTURE_UTILS_GL_FUNCTIONS_HPP
+
+#include "Utils.hpp"
+#include <cstring>
+#include "GLDef.hpp"
+
+/**
+ * @brief 捕获路径用到的全部OpenGL函数，OpenGL ES 3.0中都有同名同签名的入口。
+    增加函数时只需要在这里添加一行
+ *
+ */
+#define FAST_CAPTURE_GL_FUNCTION_LIST(X)                                                                                          \
+    X(const GLubyte*, GetString, (GLenum name))                                                                                   \
+    X(void, GetIntegerv, (GLenum pname, GLint * data))                                                                            \
+    X(GLboolean, IsEnabled, (GLenum cap))                                                                                         \
+    X(void, Enable, (GLenum cap))                                                                                                 \
+    X(void, Disable, (GLenum cap))                                                                                                \
+    X(void, Flush, ())                                                                                                            \
+    X(void, PixelStorei, (GLenum pname, GLint param))                                                                             \
+    X(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels))               \
+    X(void, ReadBuffer, (GLenum src))                                                                                             \
+    X(void, BindTexture, (GLenum target, GLuint texture))                                                                         \
+    X(void, TexParameteri, (GLenum target, GLenum pname, GLint param))                                                            \
+    X(void, GenerateMipmap, (GLenum target))                                                                                      \
+    X(void, GenFramebuffers, (GLsizei n, GLuint * framebuffers))                                                                  \
+    X(void, DeleteFramebuffers, (GLsizei n, const GLuint* framebuffers))                                                          \
+    X(void, BindFramebuffer, (GLenum target, GLuint framebuffer))                                                                 \
+    X(void, FramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level))               \
+    X(void, BlitFramebuffer, (GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1, GLint dst_x0, GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter)) \
+    X(void, GenBuffers, (GLsizei n, GLuint * buffers))                                                                            \
+    X(void, DeleteBuffers, (GLsizei n, const GLuint* buffers))                                                                    \
+    X(void, BindBuffer, (GLenum target, GLuint buffer))                                                                           \
+    X(void, BufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage))                                         \
+    X(void*, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))                              \
+    X(GLboolean, UnmapBuffer, (GLenum target))                                                                                    \
+    X(GLsync, FenceSync, (GLenum condition, GLbitfield flags))                                                                    \
+    X(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout))                                                  \
+    X(void, WaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout))                                                          \
+    X(void, DeleteSync, (GLsync sync))
+
+/**
+ * @brief 只用于测量GPU开销的函数，缺少它们时仍然可以捕获。
+    OpenGL ES 3.0没有glGetQueryObjectui64v，需要EXT_disjoint_timer_query，因此找不到时再查找带EXT后缀的入口
+ *
+ */
+#define FAST_CAPTURE_GL_OPTIONAL_FUNCTION_LIST(X)                                                 \
+    X(void, GenQueries, (GLsizei n, GLuint * ids))                                                \
+    X(void, DeleteQueries, (GLsizei n, const GLuint* ids))                                        \
+    X(void, BeginQuery, (GLenum target, GLuint id))                                               \
+    X(void, EndQuery, (GLenum target))                                                            \
+    X(void, GetQueryiv, (GLenum target, GLenum pname, GLint * params))                            \
+    X(void, GetQueryObjectuiv, (GLuint id, GLenum pname, GLuint * params))                        \
+    X(void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64 * params))
+
+FAST_CAPTURE_NAMESPACE
+{
+    enum class GlApi
+    {
+        OpenGL,
+        /**
+         * @brief OpenGL ES 3.0及以上，没有深度和模板的glReadPixels
+         *
+         */
+        OpenGLES
+    };
+
+    /**
+     * @brief 从上下文自己的GetProcAddress加载的函数表。
+        桌面OpenGL与OpenGL ES的函数来自不同的库（例如opengl32.dll与ANGLE的libGLESv2.dll），
+        因此捕获代码总是通过当前线程的函数表调用，而不是直接调用全局的gl函数。
+        函数表只包含下面列出的函数，而不是像GLEW那样获得所有扩展的入口
+     *
+     */
+    struct GlFunctions
+    {
+        GlApi api{GlApi::OpenGL};
+        /**
+         * @brief 可以使用GL_TIME_ELAPSED计时查询，需要OpenGL 3.3或OpenGL ES的EXT_disjoint_timer_query
+         *
+         */
+        bool is_timer_query_supported{false};
+
+#define FAST_CAPTURE_GL_DECLARE_FUNCTION(return_type, name, parameters) \
+    return_type(GLAPIENTRY * name) parameters { nullptr };
+        FAST_CAPTURE_GL_FUNCTION_LIST(FAST_CAPTURE_GL_DECLARE_FUNCTION)
+        FAST_CAPTURE_GL_OPTIONAL_FUNCTION_LIST(FAST_CAPTURE_GL_DECLARE_FUNCTION)
+#undef FAST_CAPTURE_GL_DECLARE_FUNCTION
+
+        /**
+         * @brief 在目标上下文为当前上下文时调用，加载所有函数并判断上下文的API
+         *
+         * @param get_proc_address 以"glReadPixels"这样的完整函数名调用，返回函数地址，找不到时返回nullptr。
+            可以包装wglGetProcAddress、eglGetProcAddress或glXGetProcAddress
+         */
+        template <class F>
+        FastCaptureErrorCode Load(F&& get_proc_address) noexcept
+        {
+            bool is_all_loaded = true;
+#define FAST_CAPTURE_GL_LOAD_FUNCTION(return_type, name, parameters)                  \
+    name = reinterpret_cast<decltype(name)>(get_proc_address("gl" #name)); \
+    is_all_loaded = is_all_loaded && name != nullptr;
+            FAST_CAPTURE_GL_FUNCTION_LIST(FAST_CAPTURE_GL_LOAD_FUNCTION)
+#undef FAST_CAPTURE_GL_LOAD_FUNCTION
+            if (!is_all_loaded)
+            {
+                return Utils::MakeError(FAST_CAPTURE_E_LOAD_GL_FUNCTIONS_FAILED);
+            }
+
+            constexpr char GLES_VERSION_PREFIX[] = "OpenGL ES";
+            const auto p_version = reinterpret_cast<const char*>(GetString(GL_VERSION));
+            api = p_version != nullptr && std::strncmp(p_version, GLES_VERSION_PREFIX, sizeof(GLES_VERSION_PREFIX) - 1) == 0
+                      ? GlApi::OpenGLES
+                      : GlApi::OpenGL;
+            if (api == GlApi::OpenGLES)
+            {
+                // PBO、栅栏和glBlitFramebuffer都需要OpenGL ES 3.0
+                GLint major_version{0};
+                GetIntegerv(GL_MAJOR_VERSION, &major_version);
+                if (major_version < 3)
+                {
+                    return Utils::MakeError(FAST_CAPTURE_E_GLES_VERSION_NOT_SUPPORTED);
+                }
+            }
+            LoadTimerQuery(get_proc_address);
+            return FastCaptureMakeSuccessValue();
+        }
+
+        /**
+         * @brief 获得当前线程的函数表，线程中的上下文变为当前上下文后必须先调用SetCurrent
+         *
+         */
+        static const GlFunctions& GetCurrent() noexcept
+        {
+            return *p_current_;
+        }
+        static bool HasCurrent() noexcept
+        {
+            return p_current_ != nullptr;
+        }
+        static void SetCurrent(const GlFunctions* p_gl_functions) noexcept
+        {
+            p_current_ = p_gl_functions;
+        }
+
+    private:
+        static inline thread_local const GlFunctions* p_current_{nullptr};
+
+        /**
+         * @brief 某些GetProcAddress对不支持的函数也返回非空的地址，因此还要检查版本或扩展
+         *
+         */
+        template <class F>
+        void LoadTimerQuery(F&& get_proc_address) noexcept
+        {
+            bool is_all_loaded = true;
+#define FAST_CAPTURE_GL_LOAD_OPTIONAL_FUNCTION(return_type, name, parameters)   \
+    name = reinterpret_cast<decltype(name)>(get_proc_address("gl" #name));      \
+    if (name == nullptr)                                                        \
+    {                                                                           \
+        name = reinterpret_cast<decltype(name)>(get_proc_address("gl" #name "EXT")); \
+    }                                                                           \
+    is_all_loaded = is_all_loaded && name != nullptr;
+            FAST_CAPTURE_GL_OPTIONAL_FUNCTION_LIST(FAST_CAPTURE_GL_LOAD_OPTIONAL_FUNCTION)
+#undef FAST_CAPTURE_GL_LOAD_OPTIONAL_FUNCTION
+            if (!is_all_loaded)
+            {
+                is_timer_query_supported = false;
+                return;
+            }
+            if (api == GlApi::OpenGLES)
+            {
+                const auto p_extensions = reinterpret_cast<const char*>(GetString(GL_EXTENSIONS));
+                is_timer_query_supported =
+                    p_extensions != nullptr && std::strstr(p_extensions, "GL_EXT_disjoint_timer_query") != nullptr;
+                return;
+            }
+            GLint major_version{0};
+            GLint minor_version{0};
+            GetIntegerv(GL_MAJOR_VERSION, &major_version);
+            GetIntegerv(GL_MINOR_VERSION, &minor_version);
+            is_timer_query_supported = major_version > 3 || (major_version == 3 && minor_version >= 3);
+        }
+    };
+}
+
+#endif // FAST_CAPTURE_UTILS_GL_FUNCTIONS_HPP
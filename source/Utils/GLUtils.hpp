@@ -3,8 +3,7 @@
 
 #include "Utils.hpp"
 #include <optional>
-#include "GL/glew.h"
-#include "GL/gl.h"
+#include "GLFunctions.hpp"
 
 FAST_CAPTURE_NAMESPACE
 {
@@ -14,7 +13,7 @@ FAST_CAPTURE_NAMESPACE
         {
             if (opt_fbo_id.has_value())
             {
-                ::glDeleteFramebuffers(1, &opt_fbo_id.value());
+                GlFunctions::GetCurrent().DeleteFramebuffers(1, &opt_fbo_id.value());
             }
         }
     };
@@ -51,7 +50,7 @@ FAST_CAPTURE_NAMESPACE
     inline UniqueOpenGLFbo MakeUniqueOpenGLFbo() noexcept
     {
         GLuint fbo_id[1];
-        ::glGenFramebuffers(1, fbo_id);
+        GlFunctions::GetCurrent().GenFramebuffers(1, fbo_id);
         return UniqueOpenGLFbo{fbo_id[0]};
     }
 }
@@ -0,0 +1,296 @@
+#ifndef FAST_CAPTURE_UTILS_PIXEL_PIPELINE_HPP
+#define FAST_CAPTURE_UTILS_PIXEL_PIPELINE_HPP
+
+#include "FastCaptureDef.h"
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "StreamingCopy.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Utils
+    {
+        /**
+         * @brief 由源格式、目标格式、行序和区域四个策略组合出的复制转换内核。
+            每种组合都是一个单独实例化的函数，在协商输出格式时从分派表中选出一次，
+            之后每帧只调用这个函数指针，最内层的循环中没有按像素或按行的分支
+         *
+         */
+        namespace PixelPipeline
+        {
+            /**
+             * @brief 像素在内存中的排列。Load把像素读为R在最低字节的RGBA，Store把它写回
+             *
+             */
+            template <class T>
+            concept is_pixel_format =
+                requires(const std::byte* p_from, std::byte* p_to, std::uint32_t rgba) {
+                    { T::PIXEL_SIZE } -> std::convertible_to<std::size_t>;
+                    { T::Load(p_from) } noexcept -> std::same_as<std::uint32_t>;
+                    { T::Store(p_to, rgba) } noexcept;
+                };
+            template <class T>
+            concept is_row_order =
+                requires {
+                    { T::IS_REVERSED } -> std::convertible_to<bool>;
+                };
+            template <class T>
+            concept is_region =
+                requires {
+                    { T::IS_FULL_FRAME } -> std::convertible_to<bool>;
+                };
+
+            struct Rgba8
+            {
+                constexpr static std::size_t PIXEL_SIZE = 4;
+                static std::uint32_t Load(const std::byte* p_from) noexcept
+                {
+                    std::uint32_t pixel;
+                    std::memcpy(&pixel, p_from, sizeof(pixel));
+                    return pixel;
+                }
+                static void Store(std::byte* p_to, const std::uint32_t rgba) noexcept
+                {
+                    std::memcpy(p_to, &rgba, sizeof(rgba));
+                }
+            };
+            struct Bgra8
+            {
+                constexpr static std::size_t PIXEL_SIZE = 4;
+                static std::uint32_t Swap(const std::uint32_t pixel) noexcept
+                {
+                    return (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0xFFu) | ((pixel & 0xFFu) << 16);
+                }
+                static std::uint32_t Load(const std::byte* p_from) noexcept
+                {
+                    return Swap(Rgba8::Load(p_from));
+                }
+                static void Store(std::byte* p_to, const std::uint32_t rgba) noexcept
+                {
+                    Rgba8::Store(p_to, Swap(rgba));
+                }
+            };
+            /**
+             * @brief 没有alpha的3字节像素，读取时alpha为0xFF
+             *
+             */
+            struct Rgb8
+            {
+                constexpr static std::size_t PIXEL_SIZE = 3;
+                static std::uint32_t Load(const std::byte* p_from) noexcept
+                {
+                    return static_cast<std::uint32_t>(p_from[0])
+                           | (static_cast<std::uint32_t>(p_from[1]) << 8)
+                           | (static_cast<std::uint32_t>(p_from[2]) << 16)
+                           | 0xFF000000u;
+                }
+                static void Store(std::byte* p_to, const std::uint32_t rgba) noexcept
+                {
+                    p_to[0] = static_cast<std::byte>(rgba);
+                    p_to[1] = static_cast<std::byte>(rgba >> 8);
+                    p_to[2] = static_cast<std::byte>(rgba >> 16);
+                }
+            };
+
+            /**
+             * @brief 目标的第一行是源区域的第一行
+             *
+             */
+            struct KeepRowOrder
+            {
+                constexpr static bool IS_REVERSED = false;
+            };
+            /**
+             * @brief 目标的第一行是源区域的最后一行，用于在OpenGL从下到上与常见的从上到下之间转换
+             *
+             */
+            struct ReverseRowOrder
+            {
+                constexpr static bool IS_REVERSED = true;
+            };
+
+            /**
+             * @brief 忽略请求的区域，复制整帧。格式和行序都不变且源没有行间填充时整帧只复制一次
+             *
+             */
+            struct FullFrame
+            {
+                constexpr static bool IS_FULL_FRAME = true;
+            };
+            /**
+             * @brief 只复制请求的区域，调用者保证区域在源图像内
+             *
+             */
+            struct Window
+            {
+                constexpr static bool IS_FULL_FRAME = false;
+            };
+
+            struct Frame
+            {
+                const std::byte* p_data{nullptr};
+                std::size_t row_pitch{0};
+                std::uint32_t width{0};
+                std::uint32_t height{0};
+            };
+            /**
+             * @brief 以源图像的第一行、第一列为原点
+             *
+             */
+            struct Region
+            {
+                std::uint32_t x{0};
+                std::uint32_t y{0};
+                std::uint32_t width{0};
+                std::uint32_t height{0};
+            };
+
+            template <is_pixel_format Source, is_pixel_format Destination>
+            void ConvertRow(const std::byte* p_source, std::byte* p_destination, const std::uint32_t width) noexcept
+            {
+                if constexpr (std::is_same_v<Source, Destination>)
+                {
+                    std::memcpy(p_destination, p_source, width * Source::PIXEL_SIZE);
+                }
+                else
+                {
+                    for (std::uint32_t x = 0; x < width; ++x)
+                    {
+                        Destination::Store(p_destination + x * Destination::PIXEL_SIZE, Source::Load(p_source + x * Source::PIXEL_SIZE));
+                    }
+                }
+            }
+
+            /**
+             * @brief 把源图像的区域转换到紧密排列的目标中，目标的行大小为区域宽度乘以目标像素大小
+             *
+             */
+            template <is_pixel_format Source, is_pixel_format Destination, is_row_order RowOrder, is_region RegionMode>
+            void ConvertFrame(const Frame& source, const Region& requested_region, std::byte* p_destination) noexcept
+            {
+                const Region region = RegionMode::IS_FULL_FRAME ? Region{0, 0, source.width, source.height} : requested_region;
+                const auto destination_row_size = static_cast<std::size_t>(region.width) * Destination::PIXEL_SIZE;
+                if constexpr (std::is_same_v<Source, Destination> && !RowOrder::IS_REVERSED && RegionMode::IS_FULL_FRAME)
+                {
+                    if (source.row_pitch == destination_row_size)
+                    {
+                        CopyFrameData(p_destination, source.p_data, destination_row_size * region.height);
+                        return;
+                    }
+                }
+                if (region.height == 0)
+                {
+                    return;
+                }
+                auto p_source_row = source.p_data + region.y * source.row_pitch + region.x * Source::PIXEL_SIZE;
+                auto source_step = static_cast<std::ptrdiff_t>(source.row_pitch);
+                if constexpr (RowOrder::IS_REVERSED)
+                {
+                    p_source_row += (region.height - 1) * source.row_pitch;
+                    source_step = -source_step;
+                }
+                for (std::uint32_t y = 0; y < region.height; ++y)
+                {
+                    ConvertRow<Source, Destination>(p_source_row, p_destination, region.width);
+                    p_source_row += source_step;
+                    p_destination += destination_row_size;
+                }
+            }
+
+            enum class PixelFormat : std::uint32_t
+            {
+                Rgba8,
+                Bgra8,
+                Rgb8,
+                Count
+            };
+
+            constexpr std::size_t GetPixelSize(const PixelFormat format) noexcept
+            {
+                return format == PixelFormat::Rgb8 ? Rgb8::PIXEL_SIZE : Rgba8::PIXEL_SIZE;
+            }
+
+            using ConvertFrameFunction = void (*)(const Frame&, const Region&, std::byte*) noexcept;
+
+            namespace Details
+            {
+                template <PixelFormat Format>
+                struct PixelFormatPolicy;
+                template <>
+                struct PixelFormatPolicy<PixelFormat::Rgba8>
+                {
+                    using Type = Rgba8;
+                };
+                template <>
+                struct PixelFormatPolicy<PixelFormat::Bgra8>
+                {
+                    using Type = Bgra8;
+                };
+                template <>
+                struct PixelFormatPolicy<PixelFormat::Rgb8>
+                {
+                    using Type = Rgb8;
+                };
+
+                constexpr std::size_t PIXEL_FORMAT_COUNT = static_cast<std::size_t>(PixelFormat::Count);
+
+                constexpr std::size_t GetTableIndex(
+                    const PixelFormat source,
+                    const PixelFormat destination,
+                    const bool is_reversed,
+                    const bool is_window) noexcept
+                {
+                    return ((static_cast<std::size_t>(source) * PIXEL_FORMAT_COUNT
+                             + static_cast<std::size_t>(destination))
+                                * 2
+                            + is_reversed)
+                               * 2
+                           + is_window;
+                }
+
+                template <std::size_t Index>
+                constexpr ConvertFrameFunction MakeTableEntry() noexcept
+                {
+                    using Source = typename PixelFormatPolicy<static_cast<PixelFormat>(Index / 4 / PIXEL_FORMAT_COUNT)>::Type;
+                    using Destination = typename PixelFormatPolicy<static_cast<PixelFormat>(Index / 4 % PIXEL_FORMAT_COUNT)>::Type;
+                    using RowOrder = std::conditional_t<(Index / 2 % 2) != 0, ReverseRowOrder, KeepRowOrder>;
+                    using RegionMode = std::conditional_t<(Index % 2) != 0, Window, FullFrame>;
+                    return &ConvertFrame<Source, Destination, RowOrder, RegionMode>;
+                }
+
+                template <std::size_t... Indexes>
+                constexpr auto MakeTable(std::index_sequence<Indexes...>) noexcept
+                {
+                    return std::array<ConvertFrameFunction, sizeof...(Indexes)>{MakeTableEntry<Indexes>()...};
+                }
+
+                inline constexpr auto CONVERT_FRAME_TABLE =
+                    MakeTable(std::make_index_sequence<PIXEL_FORMAT_COUNT * PIXEL_FORMAT_COUNT * 4>{});
+            }
+
+            /**
+             * @brief 从分派表中选出对应组合的内核，格式无效时返回nullptr
+             *
+             */
+            constexpr ConvertFrameFunction SelectConvertFrame(
+                const PixelFormat source,
+                const PixelFormat destination,
+                const bool is_reversed,
+                const bool is_window) noexcept
+            {
+                if (source >= PixelFormat::Count || destination >= PixelFormat::Count)
+                {
+                    return nullptr;
+                }
+                return Details::CONVERT_FRAME_TABLE[Details::GetTableIndex(source, destination, is_reversed, is_window)];
+            }
+        }
+    }
+}
+
+#endif // FAST_CAPTURE_UTILS_PIXEL_PIPELINE_HPP
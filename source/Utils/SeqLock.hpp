@@ -0,0 +1,193 @@
+#ifndef FAST_CAPTURE_UTILS_SEQ_LOCK_HPP
+#define FAST_CAPTURE_UTILS_SEQ_LOCK_HPP
+
+#include "FastCaptureDef.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "Utils.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Utils
+    {
+        /**
+         * @brief 放在共享内存中的顺序锁，只允许一个写者（注入DLL），允许任意多个读者（客户端）。
+            写者永远不会等待读者，因此读者进程在读取途中崩溃不会阻塞写者；
+            写者在写入途中崩溃时序号会停留在奇数，读者通过读取时限和写者的心跳发现这种情况，而不是永久等待。
+         *
+         */
+        class SeqLock
+        {
+        public:
+            using Sequence = std::uint32_t;
+
+        private:
+            static_assert(std::atomic<Sequence>::is_always_lock_free,
+                          "SeqLock must be lock free to be placed in shared memory.");
+
+            std::atomic<Sequence> sequence_{0};
+
+        public:
+            void BeginWrite() noexcept
+            {
+                const auto sequence = sequence_.load(std::memory_order_relaxed);
+                sequence_.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+            void EndWrite() noexcept
+            {
+                const auto sequence = sequence_.load(std::memory_order_relaxed);
+                sequence_.store(sequence + 1, std::memory_order_release);
+            }
+            /**
+             * @brief 写者在启动时调用，用于丢弃上一个崩溃的写者留下的奇数序号
+             *
+             */
+            void RecoverFromDeadWriter() noexcept
+            {
+                const auto sequence = sequence_.load(std::memory_order_relaxed);
+                if (sequence & 1)
+                {
+                    sequence_.store(sequence + 1, std::memory_order_release);
+                }
+            }
+            /**
+             * @brief 开始一次读取
+             *
+             * @return std::optional<Sequence> 写者正在写入时返回空
+             */
+            std::optional<Sequence> BeginRead() const noexcept
+            {
+                const auto sequence = sequence_.load(std::memory_order_acquire);
+                if (sequence & 1)
+                {
+                    return {};
+                }
+                return sequence;
+            }
+            /**
+             * @brief 结束一次读取
+             *
+             * @param begin_sequence BeginRead的返回值
+             * @return true 读取期间数据没有被修改，读到的内容有效
+             */
+            bool EndRead(const Sequence begin_sequence) const noexcept
+            {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return sequence_.load(std::memory_order_relaxed) == begin_sequence;
+            }
+            Sequence GetSequence() const noexcept
+            {
+                return sequence_.load(std::memory_order_acquire);
+            }
+        };
+
+        struct SeqLockWriteGuardDeleter
+        {
+            void operator()(SeqLock* p_lock) const noexcept
+            {
+                if (p_lock)
+                {
+                    p_lock->EndWrite();
+                }
+            }
+        };
+        /**
+         * @brief 构造时请先调用BeginWrite，析构时自动调用EndWrite
+         *
+         */
+        using SeqLockWriteGuard = RAIIWrapper<SeqLock*, SeqLockWriteGuardDeleter>;
+
+        inline SeqLockWriteGuard MakeSeqLockWriteGuard(SeqLock& lock) noexcept
+        {
+            lock.BeginWrite();
+            return {&lock};
+        }
+
+        /**
+         * @brief 读者等待写者时，先以CPU的暂停指令自旋这么多次，之后让出时间片
+         *
+         */
+        constexpr std::uint32_t SEQ_LOCK_READ_SPIN_COUNT = 64;
+
+        /**
+         * @brief 等待写者时的退避，自旋时不抢占同一物理核心上写者的执行资源，
+            写者复制大块数据时让出时间片而不是占满一个核心
+         *
+         */
+        inline void BackoffSeqLockRead(const std::uint32_t attempt) noexcept
+        {
+            if (attempt < SEQ_LOCK_READ_SPIN_COUNT)
+            {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#endif
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        enum class SeqLockReadResult
+        {
+            Ok,
+            /**
+             * @brief 超时时写者仍然存活，只是一直在写入
+             *
+             */
+            WriterBusy,
+            /**
+             * @brief 超时时写者已经失去心跳，可能在写入途中崩溃
+             *
+             */
+            WriterDead
+        };
+
+        /**
+         * @brief 在顺序锁保护下执行读取函数，读到一致的数据前带退避地重试，直到超过时限
+         *
+         * @param lock 顺序锁
+         * @param timeout 读取时限，防止写者在写入途中崩溃导致永久等待
+         * @param is_writer_alive 超时后调用，根据写者的心跳区分写者繁忙和写者崩溃
+         * @param read_function 读取函数，可能被执行多次，因此不能有副作用
+         */
+        template <class W, class F>
+        SeqLockReadResult ReadWithSeqLock(
+            const SeqLock& lock,
+            const std::chrono::steady_clock::duration timeout,
+            W&& is_writer_alive,
+            F&& read_function)
+        {
+            std::optional<std::chrono::steady_clock::time_point> opt_deadline{};
+            for (std::uint32_t attempt = 0;; ++attempt)
+            {
+                if (const auto opt_sequence = lock.BeginRead())
+                {
+                    read_function();
+                    if (lock.EndRead(opt_sequence.value()))
+                    {
+                        return SeqLockReadResult::Ok;
+                    }
+                }
+                // 只在需要等待时读取时钟，没有竞争的读取不付出这份开销
+                const auto now = std::chrono::steady_clock::now();
+                if (!opt_deadline)
+                {
+                    opt_deadline = now + timeout;
+                }
+                else if (now >= opt_deadline.value())
+                {
+                    return is_writer_alive() ? SeqLockReadResult::WriterBusy : SeqLockReadResult::WriterDead;
+                }
+                BackoffSeqLockRead(attempt);
+            }
+        }
+    }
+}
+
+#endif // FAST_CAPTURE_UTILS_SEQ_LOCK_HPP
@@ -0,0 +1,159 @@
+#ifndef FAST_CAPTURE_UTILS_STREAMING_COPY_HPP
+#define FAST_CAPTURE_UTILS_STREAMING_COPY_HPP
+
+#include "FastCaptureDef.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAST_CAPTURE_STREAMING_COPY_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Utils
+    {
+        /**
+         * @brief 无法查询末级缓存大小时使用的值，取常见桌面处理器中较小的L3。
+            取大不取小：误用非临时存储会让立即读取数据的一方直接访问内存，代价比多占一些缓存更高
+         *
+         */
+        constexpr std::size_t DEFAULT_LAST_LEVEL_CACHE_SIZE = 8 * 1024 * 1024;
+
+        /**
+         * @brief 返回末级缓存的大小（字节），查询失败时返回0
+         *
+         */
+        inline std::size_t QueryLastLevelCacheSize() noexcept
+        {
+#ifdef _WIN32
+            DWORD buffer_size = 0;
+            ::GetLogicalProcessorInformation(nullptr, &buffer_size);
+            if (::GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+            {
+                return 0;
+            }
+            try
+            {
+                std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> information(
+                    buffer_size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+                if (!::GetLogicalProcessorInformation(information.data(), &buffer_size))
+                {
+                    return 0;
+                }
+                BYTE max_level = 0;
+                std::size_t result = 0;
+                for (const auto& item : information)
+                {
+                    if (item.Relationship == RelationCache && item.Cache.Level >= max_level)
+                    {
+                        max_level = item.Cache.Level;
+                        result = item.Cache.Size;
+                    }
+                }
+                return result;
+            }
+            catch (const std::bad_alloc&)
+            {
+                return 0;
+            }
+#elif defined(_SC_LEVEL3_CACHE_SIZE)
+            for (const auto name : {_SC_LEVEL3_CACHE_SIZE, _SC_LEVEL2_CACHE_SIZE})
+            {
+                if (const auto size = ::sysconf(name); size > 0)
+                {
+                    return static_cast<std::size_t>(size);
+                }
+            }
+            return 0;
+#else
+            return 0;
+#endif
+        }
+
+        /**
+         * @brief 不小于此大小的帧数据用非临时存储复制。只有目标数据本身就能填满整个末级缓存时，
+            经过缓存复制才一定会把游戏和客户端自己的数据挤出去；更小的数据经过缓存复制，
+            读取方还能从缓存中拿到它。末级缓存的大小只在第一次调用时查询
+         *
+         */
+        inline std::size_t GetStreamingCopyMinSize() noexcept
+        {
+            static const auto min_size = []() noexcept
+            {
+                const auto cache_size = QueryLastLevelCacheSize();
+                return cache_size == 0 ? DEFAULT_LAST_LEVEL_CACHE_SIZE : cache_size;
+            }();
+            return min_size;
+        }
+
+        /**
+         * @brief 使用非临时存储（movntdq）绕过缓存复制，目标数据不会留在缓存中，
+            因此只适用于复制后不会立即读取的数据。
+            源数据是顺序读取的，硬件预取已经足够，实测加入_mm_prefetch反而更慢
+         *
+         */
+        inline void StreamingCopy(void* p_destination, const void* p_source, std::size_t size) noexcept
+        {
+#ifdef FAST_CAPTURE_STREAMING_COPY_USE_SSE2
+            constexpr std::size_t BLOCK_SIZE = 64;
+            auto p_to = static_cast<std::byte*>(p_destination);
+            auto p_from = static_cast<const std::byte*>(p_source);
+            // 非临时存储要求目标按16字节对齐，开头不对齐的部分用普通复制
+            const auto head_size = (16 - reinterpret_cast<std::uintptr_t>(p_to) % 16) % 16;
+            if (size < head_size + BLOCK_SIZE)
+            {
+                std::memcpy(p_to, p_from, size);
+                return;
+            }
+            std::memcpy(p_to, p_from, head_size);
+            p_to += head_size;
+            p_from += head_size;
+            size -= head_size;
+            for (; size >= BLOCK_SIZE; size -= BLOCK_SIZE, p_to += BLOCK_SIZE, p_from += BLOCK_SIZE)
+            {
+                const auto p_from_block = reinterpret_cast<const __m128i*>(p_from);
+                const auto data0 = _mm_loadu_si128(p_from_block);
+                const auto data1 = _mm_loadu_si128(p_from_block + 1);
+                const auto data2 = _mm_loadu_si128(p_from_block + 2);
+                const auto data3 = _mm_loadu_si128(p_from_block + 3);
+                const auto p_to_block = reinterpret_cast<__m128i*>(p_to);
+                _mm_stream_si128(p_to_block, data0);
+                _mm_stream_si128(p_to_block + 1, data1);
+                _mm_stream_si128(p_to_block + 2, data2);
+                _mm_stream_si128(p_to_block + 3, data3);
+            }
+            // 非临时存储是弱序的，之后的顺序锁解锁必须在它们可见之后
+            _mm_sfence();
+            std::memcpy(p_to, p_from, size);
+#else
+            std::memcpy(p_destination, p_source, size);
+#endif
+        }
+
+        /**
+         * @brief 按大小选择复制方式：小的数据经过缓存复制，大的帧数据用StreamingCopy
+         *
+         */
+        inline void CopyFrameData(void* p_destination, const void* p_source, const std::size_t size) noexcept
+        {
+            if (size >= GetStreamingCopyMinSize())
+            {
+                StreamingCopy(p_destination, p_source, size);
+                return;
+            }
+            std::memcpy(p_destination, p_source, size);
+        }
+    }
+}
+
+#endif // FAST_CAPTURE_UTILS_STREAMING_COPY_HPP
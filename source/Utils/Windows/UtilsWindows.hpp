@@ -3,6 +3,7 @@
 
 #include "FastCaptureDef.h"
 #include <exception>
+#include <string>
 #include <Windows.h>
 #include <tlhelp32.h>
 #include "../Utils.hpp"
@@ -34,11 +35,7 @@ FAST_CAPTURE_NAMESPACE
         {
             bool operator()(HANDLE handle) const noexcept
             {
-                if (handle != INVALID_HANDLE_VALUE && handle != 0)
-                {
-                    return true;
-                }
-                return false;
+                return handle == INVALID_HANDLE_VALUE || handle == 0;
             }
         };
         using UniqueHandleInvalidMinusOne =
@@ -78,6 +75,66 @@ FAST_CAPTURE_NAMESPACE
                 std::add_pointer_t<T>,
                 MapViewOfFileDeleter>;
 
+        struct VirtualMemoryDeleter
+        {
+            void operator()(void* pointer) const noexcept
+            {
+                if (pointer)
+                {
+                    ::VirtualFree(pointer, 0, MEM_RELEASE);
+                }
+            }
+        };
+        /**
+         * @brief 由::VirtualAlloc分配，按页对齐
+         *
+         */
+        template <class T>
+        using UniqueVirtualMemory =
+            FAST_CAPTURE::Utils::RAIIWrapper<
+                std::add_pointer_t<T>,
+                VirtualMemoryDeleter>;
+
+        struct RegisteredWaitDeleter
+        {
+            void operator()(HANDLE h_wait) const noexcept
+            {
+                if (h_wait)
+                {
+                    // 等待正在执行的回调结束，之后可以安全地关闭回调使用的句柄
+                    ::UnregisterWaitEx(h_wait, INVALID_HANDLE_VALUE);
+                }
+            }
+        };
+        /**
+         * @brief 由::RegisterWaitForSingleObject注册的等待
+         *
+         */
+        using UniqueRegisteredWait =
+            FAST_CAPTURE::Utils::RAIIWrapper<
+                HANDLE,
+                RegisteredWaitDeleter>;
+
+        struct LocalMemoryDeleter
+        {
+            void operator()(void* pointer) const noexcept
+            {
+                if (pointer)
+                {
+                    ::LocalFree(pointer);
+                }
+            }
+        };
+        /**
+         * @brief 由系统以::LocalAlloc分配、需要调用者释放的内存，例如安全描述符
+         *
+         */
+        template <class T>
+        using UniqueLocalMemory =
+            FAST_CAPTURE::Utils::RAIIWrapper<
+                T,
+                LocalMemoryDeleter>;
+
         struct GDIHandleDeleter
         {
             void operator()(HGDIOBJ h_gdi_object) const noexcept
@@ -127,31 +184,43 @@ FAST_CAPTURE_NAMESPACE
             return false;
         }
 
-        bool QueryProcessId(const wchar_t& w_process_name, DWORD* p_out_pid) FAST_CAPTURE_NOEXCEPT
+        /**
+         * @brief 基于QueryPerformanceCounter的单调时间戳，单位为微秒，同一台机器上的各个进程之间可以比较
+         *
+         */
+        inline std::uint64_t GetTimestampUs() noexcept
         {
-            UniqueHandleInvalidMinusOne h_snapshot =
-                ::CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-            const std::wstring_view process_name{&w_process_name};
-            PROCESSENTRY32W pe32w{};
-            pe32w.dwSize = sizeof(PROCESSENTRY32W);
-
-            if (!Process32FirstW(h_snapshot.Get(), &pe32w))
-            {
-                goto on_error;
-            }
-            do
+            static const auto frequency = []()
             {
-                const std::wstring_view pe32_name{pe32w.szExeFile};
-                if (process_name == pe32_name)
-                {
-                    *p_out_pid = pe32w.th32ProcessID;
-                    return true;
-                }
-            } while (::Process32NextW(h_snapshot.Get(), &pe32w));
+                LARGE_INTEGER result;
+                ::QueryPerformanceFrequency(&result);
+                return result.QuadPart;
+            }();
+            LARGE_INTEGER counter;
+            ::QueryPerformanceCounter(&counter);
+            return static_cast<std::uint64_t>(counter.QuadPart / frequency * 1000000
+                                              + counter.QuadPart % frequency * 1000000 / frequency);
+        }
 
-        on_error:
-            *p_out_pid = -1;
-            return false;
+        /**
+         * @brief 非实时优先级类中::SetThreadPriority接受的THREAD_PRIORITY_*
+         *
+         */
+        constexpr bool IsValidThreadPriority(const int priority) noexcept
+        {
+            return priority == THREAD_PRIORITY_IDLE
+                   || (priority >= THREAD_PRIORITY_LOWEST && priority <= THREAD_PRIORITY_HIGHEST)
+                   || priority == THREAD_PRIORITY_TIME_CRITICAL;
+        }
+
+        /**
+         * @brief 以进程ID区分共享内存，多个同名进程不会互相覆盖。
+            注入DLL由注入方传入前缀，Vulkan层在目标进程内按自己的进程ID生成
+         *
+         */
+        inline std::wstring MakeSharedMemoryNamePrefix(const DWORD process_id)
+        {
+            return std::wstring(L"FastCapture") + std::to_wstring(process_id);
         }
 
         inline bool CopyDataToRemote(HANDLE h_process, const void* from, void* to, const SIZE_T size) noexcept
@@ -0,0 +1,143 @@
+#include "../source/Utils/BoundedMpscQueue.hpp"
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using FAST_CAPTURE::Utils::BoundedMpscQueue;
+
+    constexpr std::size_t CAPACITY = 8;
+
+    void TestEmptyQueue()
+    {
+        BoundedMpscQueue<std::uint32_t, CAPACITY> queue{};
+        FAST_CAPTURE_TEST_CHECK(!queue.Pop().has_value());
+    }
+
+    void TestFifoOrder()
+    {
+        BoundedMpscQueue<std::uint32_t, CAPACITY> queue{};
+        for (std::uint32_t i = 0; i < 5; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(queue.Push(i));
+        }
+        for (std::uint32_t i = 0; i < 5; ++i)
+        {
+            const auto opt_value = queue.Pop();
+            FAST_CAPTURE_TEST_CHECK(opt_value.has_value() && opt_value.value() == i);
+        }
+        FAST_CAPTURE_TEST_CHECK(!queue.Pop().has_value());
+    }
+
+    void TestPushFailsWhenFull()
+    {
+        BoundedMpscQueue<std::uint32_t, CAPACITY> queue{};
+        for (std::uint32_t i = 0; i < CAPACITY; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(queue.Push(i));
+        }
+        FAST_CAPTURE_TEST_CHECK(!queue.Push(100));
+        // 失败的Push不会覆盖已有的元素，取走一个后又可以写入
+        FAST_CAPTURE_TEST_CHECK(queue.Pop().value_or(100) == 0);
+        FAST_CAPTURE_TEST_CHECK(queue.Push(100));
+        FAST_CAPTURE_TEST_CHECK(!queue.Push(101));
+    }
+
+    void TestWraparound()
+    {
+        BoundedMpscQueue<std::uint32_t, CAPACITY> queue{};
+        std::uint32_t next_push = 0;
+        std::uint32_t next_pop = 0;
+        // 每轮写入的个数与容量互质，读写位置在多轮之后落到槽位的每一个偏移上
+        for (std::uint32_t round = 0; round < CAPACITY * 16; ++round)
+        {
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                FAST_CAPTURE_TEST_CHECK(queue.Push(next_push++));
+            }
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                const auto opt_value = queue.Pop();
+                FAST_CAPTURE_TEST_CHECK(opt_value.has_value() && opt_value.value() == next_pop);
+                ++next_pop;
+            }
+        }
+        // 位置远超过容量之后，满和空的判断仍然正确
+        for (std::uint32_t i = 0; i < CAPACITY; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(queue.Push(next_push++));
+        }
+        FAST_CAPTURE_TEST_CHECK(!queue.Push(next_push));
+        for (std::uint32_t i = 0; i < CAPACITY; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(queue.Pop().value_or(0) == next_pop++);
+        }
+        FAST_CAPTURE_TEST_CHECK(!queue.Pop().has_value());
+    }
+
+    void TestMultiProducerOrder()
+    {
+        constexpr std::uint32_t PRODUCER_COUNT = 4;
+        constexpr std::uint32_t PUSH_COUNT = 100000;
+        // 高32位是生产者编号，低32位是该生产者的序号
+        BoundedMpscQueue<std::uint64_t, CAPACITY> queue{};
+        std::vector<std::thread> producers{};
+        for (std::uint32_t producer = 0; producer < PRODUCER_COUNT; ++producer)
+        {
+            producers.emplace_back(
+                [&queue, producer]()
+                {
+                    for (std::uint32_t i = 0; i < PUSH_COUNT; ++i)
+                    {
+                        while (!queue.Push((static_cast<std::uint64_t>(producer) << 32) | i))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+        }
+        std::vector<std::uint32_t> next_sequences(PRODUCER_COUNT, 0);
+        std::uint64_t out_of_order_count = 0;
+        std::uint64_t pop_count = 0;
+        while (pop_count < static_cast<std::uint64_t>(PRODUCER_COUNT) * PUSH_COUNT)
+        {
+            const auto opt_value = queue.Pop();
+            if (!opt_value)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            const auto producer = static_cast<std::uint32_t>(opt_value.value() >> 32);
+            const auto sequence = static_cast<std::uint32_t>(opt_value.value());
+            if (producer >= PRODUCER_COUNT || sequence != next_sequences[producer])
+            {
+                ++out_of_order_count;
+            }
+            else
+            {
+                ++next_sequences[producer];
+            }
+            ++pop_count;
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        FAST_CAPTURE_TEST_CHECK(out_of_order_count == 0);
+        FAST_CAPTURE_TEST_CHECK(next_sequences == std::vector<std::uint32_t>(PRODUCER_COUNT, PUSH_COUNT));
+        FAST_CAPTURE_TEST_CHECK(!queue.Pop().has_value());
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"EmptyQueue", &TestEmptyQueue},
+        {"FifoOrder", &TestFifoOrder},
+        {"PushFailsWhenFull", &TestPushFailsWhenFull},
+        {"Wraparound", &TestWraparound},
+        {"MultiProducerOrder", &TestMultiProducerOrder},
+    });
+}
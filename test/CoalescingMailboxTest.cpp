@@ -0,0 +1,124 @@
+#include "../source/Utils/CoalescingMailbox.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using FAST_CAPTURE::Utils::MailboxPostResult;
+
+    /**
+     * @brief 与读回线程的命令相同的组合：ReadPixels合并，其它命令按顺序排队
+     *
+     */
+    enum class Command
+    {
+        ReadPixels,
+        ChangeSharedGlRc,
+        Exit
+    };
+
+    constexpr std::size_t CAPACITY = 4;
+    using Mailbox = FAST_CAPTURE::Utils::CoalescingMailbox<Command, Command::ReadPixels, CAPACITY>;
+
+    void TestReadPixelsCoalesced()
+    {
+        Mailbox mailbox{};
+        FAST_CAPTURE_TEST_CHECK(!mailbox.TakeCoalescedCommand());
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ReadPixels) == MailboxPostResult::Posted);
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ReadPixels) == MailboxPostResult::Coalesced);
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ReadPixels) == MailboxPostResult::Coalesced);
+        // 合并的命令不进入控制命令队列
+        FAST_CAPTURE_TEST_CHECK(!mailbox.PopControlCommand().has_value());
+        FAST_CAPTURE_TEST_CHECK(mailbox.TakeCoalescedCommand());
+        FAST_CAPTURE_TEST_CHECK(!mailbox.TakeCoalescedCommand());
+        // 取走之后的投递需要重新唤醒消费者
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ReadPixels) == MailboxPostResult::Posted);
+    }
+
+    void TestControlCommandsQueued()
+    {
+        Mailbox mailbox{};
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ChangeSharedGlRc) == MailboxPostResult::Posted);
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ChangeSharedGlRc) == MailboxPostResult::Posted);
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::Exit) == MailboxPostResult::Posted);
+        FAST_CAPTURE_TEST_CHECK(mailbox.PopControlCommand() == Command::ChangeSharedGlRc);
+        FAST_CAPTURE_TEST_CHECK(mailbox.PopControlCommand() == Command::ChangeSharedGlRc);
+        FAST_CAPTURE_TEST_CHECK(mailbox.PopControlCommand() == Command::Exit);
+        FAST_CAPTURE_TEST_CHECK(!mailbox.PopControlCommand().has_value());
+        FAST_CAPTURE_TEST_CHECK(!mailbox.TakeCoalescedCommand());
+    }
+
+    void TestFullControlQueue()
+    {
+        Mailbox mailbox{};
+        for (std::size_t i = 0; i < CAPACITY; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ChangeSharedGlRc) == MailboxPostResult::Posted);
+        }
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::Exit) == MailboxPostResult::Full);
+        // 控制命令队列满时读回命令不受影响
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::ReadPixels) == MailboxPostResult::Posted);
+        FAST_CAPTURE_TEST_CHECK(mailbox.PopControlCommand() == Command::ChangeSharedGlRc);
+        FAST_CAPTURE_TEST_CHECK(mailbox.Post(Command::Exit) == MailboxPostResult::Posted);
+    }
+
+    void TestConcurrentPostsWakeOncePerTake()
+    {
+        constexpr std::uint32_t PRODUCER_COUNT = 4;
+        constexpr std::uint32_t POST_COUNT = 50000;
+        Mailbox mailbox{};
+        std::atomic<std::uint64_t> posted_count{0};
+        std::atomic<std::uint64_t> coalesced_count{0};
+        std::atomic<std::uint32_t> running_producer_count{PRODUCER_COUNT};
+        std::vector<std::thread> producers{};
+        for (std::uint32_t producer = 0; producer < PRODUCER_COUNT; ++producer)
+        {
+            producers.emplace_back(
+                [&]()
+                {
+                    for (std::uint32_t i = 0; i < POST_COUNT; ++i)
+                    {
+                        switch (mailbox.Post(Command::ReadPixels))
+                        {
+                        case MailboxPostResult::Posted:
+                            posted_count.fetch_add(1, std::memory_order_relaxed);
+                            break;
+                        case MailboxPostResult::Coalesced:
+                            coalesced_count.fetch_add(1, std::memory_order_relaxed);
+                            break;
+                        case MailboxPostResult::Full:
+                            break;
+                        }
+                    }
+                    running_producer_count.fetch_sub(1, std::memory_order_release);
+                });
+        }
+        std::uint64_t take_count = 0;
+        while (running_producer_count.load(std::memory_order_acquire) != 0)
+        {
+            take_count += mailbox.TakeCoalescedCommand();
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        take_count += mailbox.TakeCoalescedCommand();
+        // 每次需要唤醒消费者的投递都恰好对应一次取走，没有丢失也没有多余的唤醒
+        FAST_CAPTURE_TEST_CHECK(posted_count.load() == take_count);
+        FAST_CAPTURE_TEST_CHECK(posted_count.load() + coalesced_count.load() == static_cast<std::uint64_t>(PRODUCER_COUNT) * POST_COUNT);
+        FAST_CAPTURE_TEST_CHECK(!mailbox.TakeCoalescedCommand());
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"ReadPixelsCoalesced", &TestReadPixelsCoalesced},
+        {"ControlCommandsQueued", &TestControlCommandsQueued},
+        {"FullControlQueue", &TestFullControlQueue},
+        {"ConcurrentPostsWakeOncePerTake", &TestConcurrentPostsWakeOncePerTake},
+    });
+}
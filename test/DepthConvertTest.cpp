@@ -0,0 +1,94 @@
+#include "../source/FastCaptureInjectDll/DepthConvert.h"
+#include <cstdint>
+#include <vector>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+    using FAST_CAPTURE::Test::IsNear;
+
+    constexpr float NEAR_PLANE = 0.1f;
+    constexpr float FAR_PLANE = 1000.0f;
+    constexpr float TOLERANCE = 1e-5f;
+    // 深度为1时分母far - (far - near)在float中相减抵消，端点只能粗略比较
+    constexpr float FAR_PLANE_TOLERANCE = 1e-3f;
+    // 不是4和16的倍数，同时覆盖SIMD的主循环和剩余部分
+    constexpr std::size_t COUNT = 37;
+
+    float LinearizeReference(const float depth)
+    {
+        return NEAR_PLANE * FAR_PLANE / (FAR_PLANE - depth * (FAR_PLANE - NEAR_PLANE));
+    }
+
+    void TestDepth24ToLinear()
+    {
+        std::vector<std::uint32_t> source(COUNT);
+        for (std::size_t i = 0; i < COUNT; ++i)
+        {
+            const auto depth = static_cast<std::uint32_t>(0xFFFFFFu * i / (COUNT - 1));
+            source[i] = (depth << 8) | static_cast<std::uint32_t>(i & 0xFF);
+        }
+        std::vector<float> destination(COUNT);
+        ConvertDepth24ToLinear(source.data(), destination.data(), COUNT, NEAR_PLANE, FAR_PLANE);
+        FAST_CAPTURE_TEST_CHECK(IsNear(destination.front(), NEAR_PLANE, TOLERANCE));
+        FAST_CAPTURE_TEST_CHECK(IsNear(destination.back(), FAR_PLANE, FAR_PLANE_TOLERANCE));
+        for (std::size_t i = 0; i < COUNT; ++i)
+        {
+            const auto depth = static_cast<float>(source[i] >> 8) / 16777215.0f;
+            FAST_CAPTURE_TEST_CHECK(IsNear(destination[i], LinearizeReference(depth), TOLERANCE));
+        }
+    }
+
+    void TestDepthFloatToLinear()
+    {
+        std::vector<float> source(COUNT);
+        for (std::size_t i = 0; i < COUNT; ++i)
+        {
+            source[i] = static_cast<float>(i) / (COUNT - 1);
+        }
+        std::vector<float> destination(COUNT);
+        ConvertDepthFloatToLinear(source.data(), destination.data(), COUNT, NEAR_PLANE, FAR_PLANE);
+        FAST_CAPTURE_TEST_CHECK(IsNear(destination.front(), NEAR_PLANE, TOLERANCE));
+        FAST_CAPTURE_TEST_CHECK(IsNear(destination.back(), FAR_PLANE, FAR_PLANE_TOLERANCE));
+        for (std::size_t i = 0; i < COUNT; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(IsNear(destination[i], LinearizeReference(source[i]), TOLERANCE));
+        }
+    }
+
+    void TestConvertInPlace()
+    {
+        // 接口允许目标与源相同，原地转换
+        std::vector<float> depth{0.0f, 0.25f, 0.5f, 0.75f, 1.0f};
+        const auto expected = LinearizeReference(0.5f);
+        ConvertDepthFloatToLinear(depth.data(), depth.data(), depth.size(), NEAR_PLANE, FAR_PLANE);
+        FAST_CAPTURE_TEST_CHECK(IsNear(depth[2], expected, TOLERANCE));
+    }
+
+    void TestExtractStencil()
+    {
+        std::vector<std::uint32_t> source(COUNT);
+        for (std::size_t i = 0; i < COUNT; ++i)
+        {
+            source[i] = 0xABCDEF00u | static_cast<std::uint32_t>((i * 7) & 0xFF);
+        }
+        source[3] = 0xFFFFFFFFu;
+        std::vector<std::uint8_t> destination(COUNT);
+        ExtractStencilFromDepth24(source.data(), destination.data(), COUNT);
+        for (std::size_t i = 0; i < COUNT; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(destination[i] == (source[i] & 0xFF));
+        }
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"Depth24ToLinear", &TestDepth24ToLinear},
+        {"DepthFloatToLinear", &TestDepthFloatToLinear},
+        {"ConvertInPlace", &TestConvertInPlace},
+        {"ExtractStencil", &TestExtractStencil},
+    });
+}
@@ -0,0 +1,240 @@
+#include "../source/FastCapture/FastCaptureHistory.h"
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "../source/Utils/Utils.hpp"
+#include "MockFastCaptureClient.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+    using FAST_CAPTURE::Test::MockFastCaptureClient;
+    using FAST_CAPTURE::Test::WaitUntil;
+
+    constexpr std::uint32_t MAX_FRAME_COUNT = 3;
+    constexpr std::uint64_t MAX_FRAME_SIZE = 16;
+
+    FastCaptureHistoryDesc MakeDesc(const std::uint32_t max_duration_ms = 0)
+    {
+        return {MAX_FRAME_COUNT, max_duration_ms, FAST_CAPTURE_PLANE_COLOR, 1, MAX_FRAME_SIZE};
+    }
+
+    std::vector<char> MakeFrameData(const std::uint64_t frame_index)
+    {
+        return std::vector<char>(static_cast<std::size_t>(frame_index % MAX_FRAME_SIZE + 1), static_cast<char>(frame_index));
+    }
+
+    bool HasLastFrame(IFastCaptureHistory* p_history, const std::uint64_t frame_index)
+    {
+        std::uint64_t first_frame_index;
+        std::uint64_t last_frame_index;
+        return Utils::IsOk(p_history->RequestFrameRange(&first_frame_index, &last_frame_index))
+               && last_frame_index == frame_index;
+    }
+
+    /**
+     * @brief 发布一帧并等待历史记录的后台线程把它取走
+     *
+     */
+    bool PublishAndWait(MockFastCaptureClient& client, IFastCaptureHistory* p_history, const std::uint64_t frame_index, const std::uint64_t timestamp_us)
+    {
+        client.PublishFrame(frame_index, timestamp_us, MakeFrameData(frame_index));
+        return WaitUntil([p_history, frame_index]()
+                         { return HasLastFrame(p_history, frame_index); });
+    }
+
+    void TestInvalidDesc()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        auto desc = MakeDesc();
+        desc.max_frame_count = 0;
+        FAST_CAPTURE_TEST_CHECK(CreateFastCaptureHistory(&client, &desc, &p_history).error_code == FAST_CAPTURE_E_INVALID_ARGUMENT);
+        desc = MakeDesc();
+        desc.plane = FAST_CAPTURE_PLANE_COUNT;
+        FAST_CAPTURE_TEST_CHECK(CreateFastCaptureHistory(&client, &desc, &p_history).error_code == FAST_CAPTURE_E_INVALID_ARGUMENT);
+        FAST_CAPTURE_TEST_CHECK(p_history == nullptr);
+    }
+
+    void TestEvictsOldestByCount()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        const auto desc = MakeDesc();
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(CreateFastCaptureHistory(&client, &desc, &p_history)));
+        if (p_history == nullptr)
+        {
+            return;
+        }
+        std::uint64_t first_frame_index;
+        std::uint64_t last_frame_index;
+        FAST_CAPTURE_TEST_CHECK(
+            p_history->RequestFrameRange(&first_frame_index, &last_frame_index).error_code == FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        for (std::uint64_t frame_index = 1; frame_index <= 5; ++frame_index)
+        {
+            FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, frame_index, frame_index * 1000));
+        }
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFrameRange(&first_frame_index, &last_frame_index)));
+        FAST_CAPTURE_TEST_CHECK(first_frame_index == 3 && last_frame_index == 5);
+        size_t size;
+        FAST_CAPTURE_TEST_CHECK(p_history->RequestFrameSize(2, &size).error_code == FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        DestroyFastCaptureHistory(p_history);
+    }
+
+    void TestCopyFrame()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        const auto desc = MakeDesc();
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(CreateFastCaptureHistory(&client, &desc, &p_history)));
+        if (p_history == nullptr)
+        {
+            return;
+        }
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 7, 7000));
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 9, 9000));
+        const auto expected = MakeFrameData(7);
+        size_t size;
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFrameSize(7, &size)) && size == expected.size());
+        std::vector<char> buffer(MAX_FRAME_SIZE);
+        FastCaptureFrameInfo info{};
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->CopyFrame(7, buffer.data(), buffer.size(), &info)));
+        FAST_CAPTURE_TEST_CHECK(info.frame_index == 7 && info.timestamp_us == 7000);
+        FAST_CAPTURE_TEST_CHECK(std::vector<char>(buffer.begin(), buffer.begin() + expected.size()) == expected);
+        FAST_CAPTURE_TEST_CHECK(
+            p_history->CopyFrame(7, buffer.data(), expected.size() - 1, &info).error_code == FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+        FAST_CAPTURE_TEST_CHECK(
+            p_history->CopyFrame(8, buffer.data(), buffer.size(), &info).error_code == FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        DestroyFastCaptureHistory(p_history);
+    }
+
+    void TestFindByTime()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        const auto desc = MakeDesc();
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(CreateFastCaptureHistory(&client, &desc, &p_history)));
+        if (p_history == nullptr)
+        {
+            return;
+        }
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 1, 1000));
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 2, 2000));
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 3, 3000));
+        std::uint64_t frame_index = 0;
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->FindFrameByTime(2500, &frame_index)) && frame_index == 2);
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->FindFrameByTime(3000, &frame_index)) && frame_index == 3);
+        FAST_CAPTURE_TEST_CHECK(p_history->FindFrameByTime(999, &frame_index).error_code == FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+
+        size_t count = 0;
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFramesInTimeRange(1500, 3000, nullptr, 0, &count)) && count == 2);
+        std::uint64_t frame_indexes[2]{};
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFramesInTimeRange(1500, 3000, frame_indexes, 2, &count)));
+        FAST_CAPTURE_TEST_CHECK(frame_indexes[0] == 2 && frame_indexes[1] == 3);
+        FAST_CAPTURE_TEST_CHECK(
+            p_history->RequestFramesInTimeRange(0, 3000, frame_indexes, 2, &count).error_code == FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+        DestroyFastCaptureHistory(p_history);
+    }
+
+    void TestEvictsByDuration()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        const auto desc = MakeDesc(1);
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(CreateFastCaptureHistory(&client, &desc, &p_history)));
+        if (p_history == nullptr)
+        {
+            return;
+        }
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 1, 10000));
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 2, 10500));
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 3, 11200));
+        std::uint64_t first_frame_index;
+        std::uint64_t last_frame_index;
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFrameRange(&first_frame_index, &last_frame_index)));
+        FAST_CAPTURE_TEST_CHECK(first_frame_index == 2 && last_frame_index == 3);
+        DestroyFastCaptureHistory(p_history);
+    }
+
+    void TestEarlierTimestampDoesNotEvict()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        const auto desc = MakeDesc(1);
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(CreateFastCaptureHistory(&client, &desc, &p_history)));
+        if (p_history == nullptr)
+        {
+            return;
+        }
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 1, 10000));
+        // 比最旧的帧更早的时间戳不能被当作相隔很久
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 2, 5000));
+        std::uint64_t first_frame_index;
+        std::uint64_t last_frame_index;
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFrameRange(&first_frame_index, &last_frame_index)));
+        FAST_CAPTURE_TEST_CHECK(first_frame_index == 1 && last_frame_index == 2);
+        DestroyFastCaptureHistory(p_history);
+    }
+
+    void TestSkipsOversizedFrame()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        const auto desc = MakeDesc();
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(CreateFastCaptureHistory(&client, &desc, &p_history)));
+        if (p_history == nullptr)
+        {
+            return;
+        }
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 1, 1000));
+        client.PublishFrame(2, 2000, std::vector<char>(MAX_FRAME_SIZE + 1));
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, 3, 3000));
+        size_t size;
+        FAST_CAPTURE_TEST_CHECK(p_history->RequestFrameSize(2, &size).error_code == FAST_CAPTURE_E_HISTORY_FRAME_NOT_FOUND);
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFrameSize(1, &size)));
+        DestroyFastCaptureHistory(p_history);
+    }
+
+    void TestKeepsFramesWhenCopyFails()
+    {
+        MockFastCaptureClient client{};
+        IFastCaptureHistory* p_history = nullptr;
+        const auto desc = MakeDesc();
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(CreateFastCaptureHistory(&client, &desc, &p_history)));
+        if (p_history == nullptr)
+        {
+            return;
+        }
+        for (std::uint64_t frame_index = 1; frame_index <= MAX_FRAME_COUNT; ++frame_index)
+        {
+            FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, frame_index, frame_index * 1000));
+        }
+        // 后台线程每个轮询间隔都会重试复制这个放不下的帧，已满的历史记录不能因此淘汰旧帧
+        client.PublishFrame(MAX_FRAME_COUNT + 1, 9000, std::vector<char>(MAX_FRAME_SIZE + 1));
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        std::uint64_t first_frame_index;
+        std::uint64_t last_frame_index;
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFrameRange(&first_frame_index, &last_frame_index)));
+        FAST_CAPTURE_TEST_CHECK(first_frame_index == 1 && last_frame_index == MAX_FRAME_COUNT);
+        FAST_CAPTURE_TEST_CHECK(PublishAndWait(client, p_history, MAX_FRAME_COUNT + 2, 10000));
+        FAST_CAPTURE_TEST_CHECK(Utils::IsOk(p_history->RequestFrameRange(&first_frame_index, &last_frame_index)));
+        FAST_CAPTURE_TEST_CHECK(first_frame_index == 2 && last_frame_index == MAX_FRAME_COUNT + 2);
+        DestroyFastCaptureHistory(p_history);
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"InvalidDesc", &TestInvalidDesc},
+        {"EvictsOldestByCount", &TestEvictsOldestByCount},
+        {"CopyFrame", &TestCopyFrame},
+        {"FindByTime", &TestFindByTime},
+        {"EvictsByDuration", &TestEvictsByDuration},
+        {"EarlierTimestampDoesNotEvict", &TestEarlierTimestampDoesNotEvict},
+        {"SkipsOversizedFrame", &TestSkipsOversizedFrame},
+        {"KeepsFramesWhenCopyFails", &TestKeepsFramesWhenCopyFails},
+    });
+}
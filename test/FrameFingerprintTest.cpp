@@ -0,0 +1,101 @@
+#include "../source/FastCaptureInjectDll/FrameFingerprint.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+
+    constexpr std::size_t BLOCK_SIZE = 64;
+    constexpr std::size_t SAMPLE_COUNT = 16;
+
+    std::vector<std::byte> MakeFrameData(const std::size_t size)
+    {
+        std::vector<std::byte> result(size);
+        std::uint32_t state = 0x12345678u;
+        for (auto& value : result)
+        {
+            state = state * 1664525u + 1013904223u;
+            value = static_cast<std::byte>(state >> 24);
+        }
+        return result;
+    }
+
+    void TestSameDataSameFingerprint()
+    {
+        const auto data = MakeFrameData(BLOCK_SIZE * 100 + 17);
+        const auto copy = data;
+        FAST_CAPTURE_TEST_CHECK(MakeFrameFingerprint(data.data(), data.size()) == MakeFrameFingerprint(copy.data(), copy.size()));
+        FAST_CAPTURE_TEST_CHECK(
+            MakeSampledFrameFingerprint(data.data(), data.size(), SAMPLE_COUNT)
+            == MakeSampledFrameFingerprint(copy.data(), copy.size(), SAMPLE_COUNT));
+    }
+
+    void TestAnyByteChangesFingerprint()
+    {
+        const auto data = MakeFrameData(BLOCK_SIZE * 10 + 5);
+        const auto fingerprint = MakeFrameFingerprint(data.data(), data.size());
+        // 包括不足一块的尾部
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            auto changed = data;
+            changed[i] ^= std::byte{1};
+            FAST_CAPTURE_TEST_CHECK(MakeFrameFingerprint(changed.data(), changed.size()) != fingerprint);
+        }
+    }
+
+    void TestPositionDependent()
+    {
+        auto data = MakeFrameData(BLOCK_SIZE * 4);
+        const auto fingerprint = MakeFrameFingerprint(data.data(), data.size());
+        for (std::size_t i = 0; i < BLOCK_SIZE; ++i)
+        {
+            std::swap(data[i], data[BLOCK_SIZE * 2 + i]);
+        }
+        FAST_CAPTURE_TEST_CHECK(MakeFrameFingerprint(data.data(), data.size()) != fingerprint);
+    }
+
+    void TestSizeChangesFingerprint()
+    {
+        // 全0的数据只有长度不同，补齐尾部的0不能让它们相同
+        const std::vector<std::byte> zeros(BLOCK_SIZE * 2);
+        FAST_CAPTURE_TEST_CHECK(MakeFrameFingerprint(zeros.data(), zeros.size()) != MakeFrameFingerprint(zeros.data(), zeros.size() - 1));
+        FAST_CAPTURE_TEST_CHECK(MakeFrameFingerprint(zeros.data(), BLOCK_SIZE) != MakeFrameFingerprint(zeros.data(), BLOCK_SIZE * 2));
+    }
+
+    void TestSampledEqualsFullForSmallFrames()
+    {
+        const auto data = MakeFrameData(BLOCK_SIZE * SAMPLE_COUNT + 3);
+        FAST_CAPTURE_TEST_CHECK(
+            MakeSampledFrameFingerprint(data.data(), data.size(), SAMPLE_COUNT) == MakeFrameFingerprint(data.data(), data.size()));
+    }
+
+    void TestSampledReadsOnlySampledBlocks()
+    {
+        const auto data = MakeFrameData(BLOCK_SIZE * SAMPLE_COUNT * 8);
+        const auto sampled_fingerprint = MakeSampledFrameFingerprint(data.data(), data.size(), SAMPLE_COUNT);
+        // 步长为8|1=9块，第0块被采样，第1块不被采样
+        auto changed = data;
+        changed[BLOCK_SIZE] ^= std::byte{1};
+        FAST_CAPTURE_TEST_CHECK(MakeSampledFrameFingerprint(changed.data(), changed.size(), SAMPLE_COUNT) == sampled_fingerprint);
+        FAST_CAPTURE_TEST_CHECK(MakeFrameFingerprint(changed.data(), changed.size()) != MakeFrameFingerprint(data.data(), data.size()));
+        changed = data;
+        changed[BLOCK_SIZE * 9 + 7] ^= std::byte{1};
+        FAST_CAPTURE_TEST_CHECK(MakeSampledFrameFingerprint(changed.data(), changed.size(), SAMPLE_COUNT) != sampled_fingerprint);
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"SameDataSameFingerprint", &TestSameDataSameFingerprint},
+        {"AnyByteChangesFingerprint", &TestAnyByteChangesFingerprint},
+        {"PositionDependent", &TestPositionDependent},
+        {"SizeChangesFingerprint", &TestSizeChangesFingerprint},
+        {"SampledEqualsFullForSmallFrames", &TestSampledEqualsFullForSmallFrames},
+        {"SampledReadsOnlySampledBlocks", &TestSampledReadsOnlySampledBlocks},
+    });
+}
@@ -0,0 +1,114 @@
+#include "../source/FastCaptureInjectDll/FramePacer.h"
+#include <cstdint>
+#include <limits>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using FAST_CAPTURE::FramePacer;
+
+    constexpr std::uint64_t SWAP_INTERVAL_US = 16000;
+    constexpr std::uint64_t FIRST_SWAP_US = 1000000;
+
+    /**
+     * @brief 以固定间隔记录交换，返回最后一次交换的时刻
+     *
+     */
+    std::uint64_t RecordSwaps(FramePacer& pacer, const std::uint32_t count)
+    {
+        auto swap_us = FIRST_SWAP_US;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            swap_us = FIRST_SWAP_US + i * SWAP_INTERVAL_US;
+            pacer.RecordSwap(swap_us);
+        }
+        return swap_us;
+    }
+
+    void TestWithoutSwaps()
+    {
+        const FramePacer pacer{};
+        FAST_CAPTURE_TEST_CHECK(pacer.GetSwapIntervalUs() == 0);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetDeadlineUs(5000, 0) == 5000 + FramePacer::DEFAULT_FRAME_CPU_BUDGET_US);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetDeadlineUs(5000, 300) == 5300);
+        FAST_CAPTURE_TEST_CHECK(
+            pacer.GetDeadlineUs(5000, FAST_CAPTURE_FRAME_CPU_BUDGET_UNLIMITED) == std::numeric_limits<std::uint64_t>::max());
+    }
+
+    void TestSwapIntervalAverage()
+    {
+        FramePacer pacer{};
+        const auto last_swap_us = RecordSwaps(pacer, 10);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetSwapIntervalUs() == SWAP_INTERVAL_US);
+        // 一次较长的间隔只按1/8的权重影响平均值
+        pacer.RecordSwap(last_swap_us + SWAP_INTERVAL_US + 8000);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetSwapIntervalUs() == SWAP_INTERVAL_US + 1000);
+    }
+
+    void TestIgnoresOutlierIntervals()
+    {
+        FramePacer pacer{};
+        const auto last_swap_us = RecordSwaps(pacer, 4);
+        // 超过MAX_SWAP_INTERVAL_US的间隔说明目标程序暂停过，不计入平均值
+        pacer.RecordSwap(last_swap_us + 1000000);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetSwapIntervalUs() == SWAP_INTERVAL_US);
+        // 时钟回退同样被忽略
+        pacer.RecordSwap(last_swap_us);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetSwapIntervalUs() == SWAP_INTERVAL_US);
+    }
+
+    void TestDeadlineInIdleWindow()
+    {
+        FramePacer pacer{};
+        const auto last_swap_us = RecordSwaps(pacer, 10);
+        const auto idle_window_end_us = last_swap_us + SWAP_INTERVAL_US / 2;
+        // 预算在空闲窗口之内时以预算为准
+        FAST_CAPTURE_TEST_CHECK(pacer.GetDeadlineUs(last_swap_us + 1000, 2000) == last_swap_us + 3000);
+        // 预算超出空闲窗口时截止到窗口结束
+        FAST_CAPTURE_TEST_CHECK(pacer.GetDeadlineUs(last_swap_us + 1000, 20000) == idle_window_end_us);
+        // 目标程序停止绘制后不再避让
+        const auto stalled_now_us = last_swap_us + SWAP_INTERVAL_US * 3;
+        FAST_CAPTURE_TEST_CHECK(pacer.GetDeadlineUs(stalled_now_us, 20000) == stalled_now_us + 20000);
+    }
+
+    void TestIdleWindows()
+    {
+        FramePacer pacer{};
+        FAST_CAPTURE_TEST_CHECK(!pacer.GetWindowSwapUs(FIRST_SWAP_US).has_value());
+        FAST_CAPTURE_TEST_CHECK(!pacer.GetNextWindowUs(FIRST_SWAP_US).has_value());
+        const auto last_swap_us = RecordSwaps(pacer, 10);
+        // 同一个窗口中的各个时刻得到相同的标识
+        FAST_CAPTURE_TEST_CHECK(pacer.GetWindowSwapUs(last_swap_us + 1000) == last_swap_us);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetWindowSwapUs(last_swap_us + SWAP_INTERVAL_US - 1) == last_swap_us);
+        // 下一个窗口从预计的下一次交换开始，错过的交换顺延一个间隔
+        FAST_CAPTURE_TEST_CHECK(pacer.GetNextWindowUs(last_swap_us) == last_swap_us + SWAP_INTERVAL_US);
+        FAST_CAPTURE_TEST_CHECK(pacer.GetNextWindowUs(last_swap_us + 1000) == last_swap_us + SWAP_INTERVAL_US);
+        FAST_CAPTURE_TEST_CHECK(
+            pacer.GetNextWindowUs(last_swap_us + SWAP_INTERVAL_US + 1000) == last_swap_us + SWAP_INTERVAL_US * 2);
+        // 目标程序停止绘制后没有空闲窗口
+        const auto stalled_now_us = last_swap_us + SWAP_INTERVAL_US * 3;
+        FAST_CAPTURE_TEST_CHECK(!pacer.GetWindowSwapUs(stalled_now_us).has_value());
+        FAST_CAPTURE_TEST_CHECK(!pacer.GetNextWindowUs(stalled_now_us).has_value());
+    }
+
+    void TestWorkFit()
+    {
+        FramePacer pacer{};
+        FAST_CAPTURE_TEST_CHECK(pacer.IsWorkFit(1000, 1000));
+        pacer.RecordWorkCost(500);
+        FAST_CAPTURE_TEST_CHECK(pacer.IsWorkFit(1000, 1500));
+        FAST_CAPTURE_TEST_CHECK(!pacer.IsWorkFit(1001, 1500));
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"WithoutSwaps", &TestWithoutSwaps},
+        {"SwapIntervalAverage", &TestSwapIntervalAverage},
+        {"IgnoresOutlierIntervals", &TestIgnoresOutlierIntervals},
+        {"DeadlineInIdleWindow", &TestDeadlineInIdleWindow},
+        {"IdleWindows", &TestIdleWindows},
+        {"WorkFit", &TestWorkFit},
+    });
+}
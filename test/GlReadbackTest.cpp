@@ -0,0 +1,438 @@
+#include "../source/FastCaptureInjectDll/GLCapture.h"
+#include "../source/FastCaptureInjectDll/PboRing.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include "../source/Utils/GLFunctions.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+
+    /**
+     * @brief 无法创建EGL上下文时的退出码，CTest据此把测试记为跳过而不是失败
+     *
+     */
+    constexpr int TEST_SKIP_RETURN_CODE = 77;
+    constexpr GLint WIDTH = 64;
+    constexpr GLint HEIGHT = 32;
+    constexpr std::size_t PBO_RING_SLOT_COUNT = 3;
+    constexpr GLfloat CLEAR_DEPTH = 0.25f;
+    constexpr GLint CLEAR_STENCIL = 0x5A;
+
+    /**
+     * @brief 只有测试需要、捕获路径不需要的函数，同样从上下文加载
+     *
+     */
+    struct TestGlFunctions
+    {
+        decltype(&::glClearColor) ClearColor{nullptr};
+        decltype(&::glClearDepth) ClearDepth{nullptr};
+        decltype(&::glClearStencil) ClearStencil{nullptr};
+        decltype(&::glClear) Clear{nullptr};
+        decltype(&::glScissor) Scissor{nullptr};
+        decltype(&::glGenTextures) GenTextures{nullptr};
+        decltype(&::glDeleteTextures) DeleteTextures{nullptr};
+        decltype(&::glTexImage2D) TexImage2D{nullptr};
+        decltype(&::glFinish) Finish{nullptr};
+    };
+
+    /**
+     * @brief 模拟目标程序的上下文（被Hook的上下文）与读回线程的上下文，两者共享纹理和栅栏。
+        两个上下文都在测试线程中轮流成为当前上下文
+     *
+     */
+    struct EglEnvironment
+    {
+        EGLDisplay display{EGL_NO_DISPLAY};
+        EGLSurface surface{EGL_NO_SURFACE};
+        EGLContext hooked_context{EGL_NO_CONTEXT};
+        EGLContext read_pixels_context{EGL_NO_CONTEXT};
+        GlFunctions hooked_gl{};
+        GlFunctions read_pixels_gl{};
+        TestGlFunctions test_gl{};
+        GLuint color_texture_id{0};
+        GLuint depth_stencil_texture_id{0};
+        GLuint draw_fbo_id{0};
+        GLuint read_fbo_id{0};
+    } environment{};
+
+    auto GetProcAddress(const char* p_name) noexcept
+    {
+        return ::eglGetProcAddress(p_name);
+    }
+
+    void MakeHookedContextCurrent()
+    {
+        ::eglMakeCurrent(environment.display, environment.surface, environment.surface, environment.hooked_context);
+        GlFunctions::SetCurrent(&environment.hooked_gl);
+    }
+
+    void MakeReadPixelsContextCurrent()
+    {
+        ::eglMakeCurrent(environment.display, EGL_NO_SURFACE, EGL_NO_SURFACE, environment.read_pixels_context);
+        GlFunctions::SetCurrent(&environment.read_pixels_gl);
+    }
+
+    /**
+     * @brief Mesa的surfaceless平台不需要显示器，软件光栅化即可运行
+     *
+     */
+    bool InitializeEgl()
+    {
+        const auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(::eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display == nullptr)
+        {
+            return false;
+        }
+        environment.display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (environment.display == EGL_NO_DISPLAY
+            || !::eglInitialize(environment.display, nullptr, nullptr)
+            || !::eglBindAPI(EGL_OPENGL_API))
+        {
+            return false;
+        }
+        const EGLint config_attributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE};
+        EGLConfig config;
+        EGLint config_count = 0;
+        if (!::eglChooseConfig(environment.display, config_attributes, &config, 1, &config_count) || config_count == 0)
+        {
+            return false;
+        }
+        const EGLint surface_attributes[] = {EGL_WIDTH, WIDTH, EGL_HEIGHT, HEIGHT, EGL_NONE};
+        environment.surface = ::eglCreatePbufferSurface(environment.display, config, surface_attributes);
+        const EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3, EGL_NONE};
+        environment.hooked_context = ::eglCreateContext(environment.display, config, EGL_NO_CONTEXT, context_attributes);
+        environment.read_pixels_context =
+            ::eglCreateContext(environment.display, config, environment.hooked_context, context_attributes);
+        if (environment.surface == EGL_NO_SURFACE
+            || environment.hooked_context == EGL_NO_CONTEXT
+            || environment.read_pixels_context == EGL_NO_CONTEXT)
+        {
+            return false;
+        }
+
+        MakeReadPixelsContextCurrent();
+        if (!Utils::IsOk(environment.read_pixels_gl.Load(&GetProcAddress)))
+        {
+            return false;
+        }
+        environment.read_pixels_gl.GenFramebuffers(1, &environment.read_fbo_id);
+
+        MakeHookedContextCurrent();
+        if (!Utils::IsOk(environment.hooked_gl.Load(&GetProcAddress)))
+        {
+            return false;
+        }
+        auto& test_gl = environment.test_gl;
+        test_gl.ClearColor = reinterpret_cast<decltype(test_gl.ClearColor)>(GetProcAddress("glClearColor"));
+        test_gl.ClearDepth = reinterpret_cast<decltype(test_gl.ClearDepth)>(GetProcAddress("glClearDepth"));
+        test_gl.ClearStencil = reinterpret_cast<decltype(test_gl.ClearStencil)>(GetProcAddress("glClearStencil"));
+        test_gl.Clear = reinterpret_cast<decltype(test_gl.Clear)>(GetProcAddress("glClear"));
+        test_gl.Scissor = reinterpret_cast<decltype(test_gl.Scissor)>(GetProcAddress("glScissor"));
+        test_gl.GenTextures = reinterpret_cast<decltype(test_gl.GenTextures)>(GetProcAddress("glGenTextures"));
+        test_gl.DeleteTextures = reinterpret_cast<decltype(test_gl.DeleteTextures)>(GetProcAddress("glDeleteTextures"));
+        test_gl.TexImage2D = reinterpret_cast<decltype(test_gl.TexImage2D)>(GetProcAddress("glTexImage2D"));
+        test_gl.Finish = reinterpret_cast<decltype(test_gl.Finish)>(GetProcAddress("glFinish"));
+        if (test_gl.ClearColor == nullptr || test_gl.ClearDepth == nullptr || test_gl.ClearStencil == nullptr
+            || test_gl.Clear == nullptr || test_gl.Scissor == nullptr || test_gl.GenTextures == nullptr
+            || test_gl.DeleteTextures == nullptr || test_gl.TexImage2D == nullptr || test_gl.Finish == nullptr)
+        {
+            return false;
+        }
+
+        // 与注入DLL相同的复制目标：被Hook的上下文中的fbo，与读回线程共享的纹理
+        const auto& gl = environment.hooked_gl;
+        test_gl.GenTextures(1, &environment.color_texture_id);
+        gl.BindTexture(GL_TEXTURE_2D, environment.color_texture_id);
+        test_gl.TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        test_gl.GenTextures(1, &environment.depth_stencil_texture_id);
+        gl.BindTexture(GL_TEXTURE_2D, environment.depth_stencil_texture_id);
+        test_gl.TexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, WIDTH, HEIGHT, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+        gl.BindTexture(GL_TEXTURE_2D, 0);
+        gl.GenFramebuffers(1, &environment.draw_fbo_id);
+        return true;
+    }
+
+    void ReleaseEgl()
+    {
+        if (environment.display == EGL_NO_DISPLAY)
+        {
+            return;
+        }
+        if (environment.read_pixels_context != EGL_NO_CONTEXT && GlFunctions::HasCurrent())
+        {
+            MakeReadPixelsContextCurrent();
+            environment.read_pixels_gl.DeleteFramebuffers(1, &environment.read_fbo_id);
+            MakeHookedContextCurrent();
+            environment.hooked_gl.DeleteFramebuffers(1, &environment.draw_fbo_id);
+            environment.test_gl.DeleteTextures(1, &environment.color_texture_id);
+            environment.test_gl.DeleteTextures(1, &environment.depth_stencil_texture_id);
+        }
+        GlFunctions::SetCurrent(nullptr);
+        ::eglMakeCurrent(environment.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        ::eglTerminate(environment.display);
+    }
+
+    /**
+     * @brief 在目标程序的默认帧缓冲中绘制：左下角的四分之一为红色，其余为蓝色，深度和模板为固定值
+     *
+     */
+    void DrawHookedFrame()
+    {
+        const auto& gl = environment.hooked_gl;
+        const auto& test_gl = environment.test_gl;
+        gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+        test_gl.ClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+        test_gl.ClearDepth(CLEAR_DEPTH);
+        test_gl.ClearStencil(CLEAR_STENCIL);
+        test_gl.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        gl.Enable(GL_SCISSOR_TEST);
+        test_gl.Scissor(0, 0, WIDTH / 2, HEIGHT / 2);
+        test_gl.ClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+        test_gl.Clear(GL_COLOR_BUFFER_BIT);
+        // 目标程序交换时裁剪测试仍然开启，只覆盖一个像素
+        test_gl.Scissor(0, 0, 1, 1);
+    }
+
+    GLsync CaptureHookedFrame()
+    {
+        GLCaptureTargets targets{};
+        targets.draw_fbo_id = environment.draw_fbo_id;
+        targets.color_texture_id = environment.color_texture_id;
+        targets.depth_stencil_texture_id = environment.depth_stencil_texture_id;
+        targets.width = WIDTH;
+        targets.height = HEIGHT;
+        return GLCapture{}(targets);
+    }
+
+    /**
+     * @brief 与读回线程相同：等待复制完成，把纹理附加到读取用的fbo上
+     *
+     */
+    void BindCapturedTextures(const GLsync fence)
+    {
+        const auto& gl = environment.read_pixels_gl;
+        gl.WaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+        gl.DeleteSync(fence);
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, environment.read_fbo_id);
+        gl.FramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, environment.color_texture_id, 0);
+        gl.FramebufferTexture2D(
+            GL_READ_FRAMEBUFFER,
+            GL_DEPTH_STENCIL_ATTACHMENT,
+            GL_TEXTURE_2D,
+            environment.depth_stencil_texture_id,
+            0);
+        gl.ReadBuffer(GL_COLOR_ATTACHMENT0);
+    }
+
+    std::uint32_t GetPixel(const std::byte* p_plane_data, const CapturePlane& plane, const GLint x, const GLint y)
+    {
+        std::uint32_t result;
+        std::memcpy(&result, p_plane_data + (static_cast<std::size_t>(y) * plane.width + x) * plane.pixel_size, sizeof(result));
+        return result;
+    }
+
+    bool IsRed(const std::uint32_t rgba)
+    {
+        const auto p_bytes = reinterpret_cast<const std::uint8_t*>(&rgba);
+        return p_bytes[0] == 0xFF && p_bytes[1] == 0 && p_bytes[2] == 0 && p_bytes[3] == 0xFF;
+    }
+
+    bool IsBlue(const std::uint32_t rgba)
+    {
+        const auto p_bytes = reinterpret_cast<const std::uint8_t*>(&rgba);
+        return p_bytes[0] == 0 && p_bytes[1] == 0 && p_bytes[2] == 0xFF && p_bytes[3] == 0xFF;
+    }
+
+    /**
+     * @brief 与读回线程一样只以0超时轮询栅栏，直到读回完成
+     *
+     */
+    template <class F>
+    bool ConsumeWhenReady(PboRing& pbo_ring, F&& consumer)
+    {
+        return Test::WaitUntil(
+            [&pbo_ring, &consumer]()
+            { return pbo_ring.ConsumeReady(consumer); });
+    }
+
+    void TestCaptureRestoresState()
+    {
+        MakeHookedContextCurrent();
+        const auto& gl = environment.hooked_gl;
+        DrawHookedFrame();
+        const auto fence = CaptureHookedFrame();
+        FAST_CAPTURE_TEST_CHECK(fence != nullptr);
+        GLint read_fbo_id = -1;
+        GLint draw_fbo_id = -1;
+        gl.GetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fbo_id);
+        gl.GetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_fbo_id);
+        FAST_CAPTURE_TEST_CHECK(read_fbo_id == 0 && draw_fbo_id == 0);
+        FAST_CAPTURE_TEST_CHECK(gl.IsEnabled(GL_SCISSOR_TEST) == GL_TRUE);
+        gl.Disable(GL_SCISSOR_TEST);
+        gl.DeleteSync(fence);
+    }
+
+    void TestReadbackColorDepthStencil()
+    {
+        MakeHookedContextCurrent();
+        DrawHookedFrame();
+        const auto fence = CaptureHookedFrame();
+        environment.hooked_gl.Disable(GL_SCISSOR_TEST);
+
+        MakeReadPixelsContextCurrent();
+        BindCapturedTextures(fence);
+        std::optional<PboRing> opt_pbo_ring{std::in_place};
+        auto& pbo_ring = opt_pbo_ring.value();
+        pbo_ring.Initialize(PBO_RING_SLOT_COUNT);
+        auto pbo_layout = MakePboFrameLayout(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_STENCIL);
+        pbo_layout.timestamp_us = 1234;
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.Pack(pbo_layout, environment.color_texture_id));
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.GetPendingCount() == 1);
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.GetOldestLayout().timestamp_us == 1234);
+
+        bool is_checked = false;
+        FAST_CAPTURE_TEST_CHECK(ConsumeWhenReady(
+            pbo_ring,
+            [&is_checked](const std::byte* p_data, const PboFrameLayout& layout)
+            {
+                const auto& color = layout.planes[FAST_CAPTURE_PLANE_COLOR];
+                const auto p_color = p_data + color.offset;
+                // PBO中的第0行是帧缓冲的最下面一行
+                FAST_CAPTURE_TEST_CHECK(IsRed(GetPixel(p_color, color, 0, 0)));
+                FAST_CAPTURE_TEST_CHECK(IsRed(GetPixel(p_color, color, WIDTH / 2 - 1, HEIGHT / 2 - 1)));
+                FAST_CAPTURE_TEST_CHECK(IsBlue(GetPixel(p_color, color, WIDTH / 2, 0)));
+                FAST_CAPTURE_TEST_CHECK(IsBlue(GetPixel(p_color, color, 0, HEIGHT - 1)));
+                FAST_CAPTURE_TEST_CHECK(IsBlue(GetPixel(p_color, color, WIDTH - 1, HEIGHT - 1)));
+
+                const auto& depth = layout.planes[FAST_CAPTURE_PLANE_DEPTH];
+                const auto depth_stencil = GetPixel(p_data + depth.offset, depth, WIDTH - 1, HEIGHT - 1);
+                const auto expected_depth = static_cast<std::uint32_t>(CLEAR_DEPTH * 0xFFFFFF + 0.5f);
+                const auto depth_value = depth_stencil >> 8;
+                FAST_CAPTURE_TEST_CHECK(depth_value + 1 >= expected_depth && depth_value <= expected_depth + 1);
+                FAST_CAPTURE_TEST_CHECK((depth_stencil & 0xFF) == static_cast<std::uint32_t>(CLEAR_STENCIL));
+                FAST_CAPTURE_TEST_CHECK(layout.timestamp_us == 1234);
+                is_checked = true;
+            }));
+        FAST_CAPTURE_TEST_CHECK(is_checked);
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.GetPendingCount() == 0);
+        // PBO必须在读回线程的上下文为当前上下文时删除
+        opt_pbo_ring.reset();
+        environment.read_pixels_gl.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    void TestReadbackColorMip()
+    {
+        MakeHookedContextCurrent();
+        DrawHookedFrame();
+        const auto fence = CaptureHookedFrame();
+        environment.hooked_gl.Disable(GL_SCISSOR_TEST);
+
+        MakeReadPixelsContextCurrent();
+        const auto& gl = environment.read_pixels_gl;
+        BindCapturedTextures(fence);
+        gl.BindTexture(GL_TEXTURE_2D, environment.color_texture_id);
+        gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1);
+        gl.GenerateMipmap(GL_TEXTURE_2D);
+        gl.BindTexture(GL_TEXTURE_2D, 0);
+        std::optional<PboRing> opt_pbo_ring{std::in_place};
+        auto& pbo_ring = opt_pbo_ring.value();
+        pbo_ring.Initialize(PBO_RING_SLOT_COUNT);
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.Pack(
+            MakePboFrameLayout(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_COLOR_MIP_1),
+            environment.color_texture_id));
+        bool is_checked = false;
+        FAST_CAPTURE_TEST_CHECK(ConsumeWhenReady(
+            pbo_ring,
+            [&is_checked](const std::byte* p_data, const PboFrameLayout& layout)
+            {
+                const auto& mip = layout.planes[FAST_CAPTURE_PLANE_COLOR_MIP_1];
+                FAST_CAPTURE_TEST_CHECK(mip.width == WIDTH / 2 && mip.height == HEIGHT / 2);
+                const auto p_mip = p_data + mip.offset;
+                FAST_CAPTURE_TEST_CHECK(IsRed(GetPixel(p_mip, mip, 0, 0)));
+                FAST_CAPTURE_TEST_CHECK(IsBlue(GetPixel(p_mip, mip, mip.width - 1, mip.height - 1)));
+                is_checked = true;
+            }));
+        FAST_CAPTURE_TEST_CHECK(is_checked);
+        opt_pbo_ring.reset();
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    void TestRingFullAndDiscard()
+    {
+        MakeHookedContextCurrent();
+        DrawHookedFrame();
+        const auto fence = CaptureHookedFrame();
+        environment.hooked_gl.Disable(GL_SCISSOR_TEST);
+
+        MakeReadPixelsContextCurrent();
+        BindCapturedTextures(fence);
+        std::optional<PboRing> opt_pbo_ring{std::in_place};
+        auto& pbo_ring = opt_pbo_ring.value();
+        pbo_ring.Initialize(PBO_RING_SLOT_COUNT);
+        auto pbo_layout = MakePboFrameLayout(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_NONE);
+        for (std::size_t i = 0; i < PBO_RING_SLOT_COUNT; ++i)
+        {
+            pbo_layout.timestamp_us = i + 1;
+            FAST_CAPTURE_TEST_CHECK(pbo_ring.Pack(pbo_layout, environment.color_texture_id));
+        }
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.IsFull());
+        // 所有槽位都在使用时丢弃新帧，而不是等待GPU
+        FAST_CAPTURE_TEST_CHECK(!pbo_ring.Pack(pbo_layout, environment.color_texture_id));
+        environment.test_gl.Finish();
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.DiscardReady());
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.GetOldestLayout().timestamp_us == 2);
+        pbo_layout.timestamp_us = PBO_RING_SLOT_COUNT + 1;
+        FAST_CAPTURE_TEST_CHECK(pbo_ring.Pack(pbo_layout, environment.color_texture_id));
+        // 按提交顺序消费
+        std::uint64_t last_timestamp_us = 0;
+        for (std::size_t i = 0; i < PBO_RING_SLOT_COUNT; ++i)
+        {
+            FAST_CAPTURE_TEST_CHECK(ConsumeWhenReady(
+                pbo_ring,
+                [&last_timestamp_us](const std::byte* p_data, const PboFrameLayout& layout)
+                {
+                    FAST_CAPTURE_TEST_CHECK(layout.timestamp_us > last_timestamp_us);
+                    FAST_CAPTURE_TEST_CHECK(IsRed(GetPixel(p_data, layout.planes[FAST_CAPTURE_PLANE_COLOR], 0, 0)));
+                    last_timestamp_us = layout.timestamp_us;
+                }));
+        }
+        FAST_CAPTURE_TEST_CHECK(last_timestamp_us == PBO_RING_SLOT_COUNT + 1);
+        opt_pbo_ring.reset();
+        environment.read_pixels_gl.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+}
+
+int main()
+{
+    if (!InitializeEgl())
+    {
+        std::printf("[SKIP] cannot create an EGL OpenGL 3.3 context\n");
+        ReleaseEgl();
+        return TEST_SKIP_RETURN_CODE;
+    }
+    const auto result = FAST_CAPTURE::Test::RunTests({
+        {"CaptureRestoresState", &TestCaptureRestoresState},
+        {"ReadbackColorDepthStencil", &TestReadbackColorDepthStencil},
+        {"ReadbackColorMip", &TestReadbackColorMip},
+        {"RingFullAndDiscard", &TestRingFullAndDiscard},
+    });
+    ReleaseEgl();
+    return result;
+}
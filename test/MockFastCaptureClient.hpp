@@ -0,0 +1,167 @@
+#ifndef FAST_CAPTURE_TEST_MOCK_FAST_CAPTURE_CLIENT_HPP
+#define FAST_CAPTURE_TEST_MOCK_FAST_CAPTURE_CLIENT_HPP
+
+#include "FastCapture.h"
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include "../source/Utils/StreamingCopy.hpp"
+#include "../source/Utils/Utils.hpp"
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Test
+    {
+        /**
+         * @brief 只在内存中保存最新一帧的客户端，用于测试构建在IFastCaptureClient之上的组件。
+            只有读取最新一帧的接口有实现，其它接口返回FAST_CAPTURE_E_INVALID_ARGUMENT。
+            读取之间互不阻塞，多个线程可以同时复制同一帧
+         *
+         */
+        class MockFastCaptureClient final : public IFastCaptureClient
+        {
+        private:
+            mutable std::shared_mutex lock_{};
+            std::uint64_t frame_index_{0};
+            std::uint64_t timestamp_us_{0};
+            std::vector<char> data_{};
+
+            static FastCaptureErrorCode MakeNotImplemented() noexcept
+            {
+                return Utils::MakeError(FAST_CAPTURE_E_INVALID_ARGUMENT);
+            }
+
+        public:
+            void PublishFrame(const std::uint64_t frame_index, const std::uint64_t timestamp_us, const std::vector<char>& data)
+            {
+                std::unique_lock lock{lock_};
+                frame_index_ = frame_index;
+                timestamp_us_ = timestamp_us;
+                data_ = data;
+            }
+
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            RequestLatestCapturePlaneSize(uint32_t, size_t* size) FAST_CAPTURE_NOEXCEPT override
+            {
+                std::shared_lock lock{lock_};
+                *size = data_.size();
+                return FastCaptureMakeSuccessValue();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            RequestLatestCaptureFrameInfo(FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT override
+            {
+                std::shared_lock lock{lock_};
+                *info = FastCaptureFrameInfo{frame_index_, 0, timestamp_us_};
+                return FastCaptureMakeSuccessValue();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            CopyLatestCapturePlaneEx(uint32_t, char* p_memory, size_t memory_size, size_t* copied_size, FastCaptureFrameInfo* info) FAST_CAPTURE_NOEXCEPT override
+            {
+                std::shared_lock lock{lock_};
+                if (memory_size < data_.size())
+                {
+                    return Utils::MakeError(FAST_CAPTURE_E_BUFFER_TOO_SMALL);
+                }
+                Utils::CopyFrameData(p_memory, data_.data(), data_.size());
+                if (copied_size != nullptr)
+                {
+                    *copied_size = data_.size();
+                }
+                if (info != nullptr)
+                {
+                    *info = FastCaptureFrameInfo{frame_index_, 0, timestamp_us_};
+                }
+                return FastCaptureMakeSuccessValue();
+            }
+
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            RequestLatestCaptureSize(size_t*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            CopyLatestCapture(char*, size_t) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            SetCaptureFlags(uint32_t) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            SetDepthRange(float, float) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            CopyLatestCapturePlane(uint32_t, char*, size_t) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            RequestLatestCapturePlaneInfo(uint32_t, FastCapturePlaneInfo*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            SetCopyFlags(uint32_t) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            WaitForNewFrame(uint32_t) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            DrainCaptureEvents(FastCaptureEvent*, size_t, size_t*, uint64_t*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            RequestCaptureCounters(FastCaptureCounters*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            SetColorOutput(const FastCaptureColorOutputDesc*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            RequestLatestColorOutputSize(size_t*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            CopyLatestColorOutput(char*, size_t, FastCaptureFrameInfo*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            SetFrameCpuBudget(uint32_t) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            SetCaptureThreadScheduling(const FastCaptureThreadSchedulingDesc*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            RequestFrameEventHandle(void**) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+            FastCaptureErrorCode FAST_CAPTURE_CALL
+            NotifyNewFrame(uint64_t, uint32_t, FastCaptureNewFrameCallback, void*) FAST_CAPTURE_NOEXCEPT override
+            {
+                return MakeNotImplemented();
+            }
+        };
+    }
+}
+
+#endif // FAST_CAPTURE_TEST_MOCK_FAST_CAPTURE_CLIENT_HPP
@@ -0,0 +1,139 @@
+#include "../source/FastCaptureInjectDll/PboRing.h"
+#include <cstdint>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+
+    constexpr GLint WIDTH = 33;
+    constexpr GLint HEIGHT = 17;
+    constexpr std::uint64_t PIXEL_COUNT = static_cast<std::uint64_t>(WIDTH) * HEIGHT;
+
+    std::uint64_t AlignPlaneSize(const std::uint64_t size)
+    {
+        return (size + CAPTURE_PLANE_ALIGNMENT - 1) / CAPTURE_PLANE_ALIGNMENT * CAPTURE_PLANE_ALIGNMENT;
+    }
+
+    void TestColorOnly()
+    {
+        const auto layout = MakePboFrameLayout(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_NONE);
+        const auto& color = layout.planes[FAST_CAPTURE_PLANE_COLOR];
+        FAST_CAPTURE_TEST_CHECK(color.offset == 0);
+        FAST_CAPTURE_TEST_CHECK(color.size == PIXEL_COUNT * CAPTURE_COLOR_PIXEL_SIZE);
+        FAST_CAPTURE_TEST_CHECK(color.gl_format == GL_RGBA && color.gl_type == GL_UNSIGNED_BYTE);
+        FAST_CAPTURE_TEST_CHECK(layout.planes[FAST_CAPTURE_PLANE_DEPTH].size == 0);
+        FAST_CAPTURE_TEST_CHECK(layout.planes[FAST_CAPTURE_PLANE_STENCIL].size == 0);
+        FAST_CAPTURE_TEST_CHECK(layout.total_size == AlignPlaneSize(color.size));
+    }
+
+    void TestDepth24CarriesStencil()
+    {
+        const auto capture_flags = FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_STENCIL;
+        const auto layout = MakePboFrameLayout(WIDTH, HEIGHT, capture_flags);
+        const auto& depth = layout.planes[FAST_CAPTURE_PLANE_DEPTH];
+        FAST_CAPTURE_TEST_CHECK(depth.gl_format == GL_DEPTH_STENCIL && depth.gl_type == GL_UNSIGNED_INT_24_8);
+        FAST_CAPTURE_TEST_CHECK(depth.size == PIXEL_COUNT * sizeof(std::uint32_t));
+        // 模板从24_8的低8位中取出，不单独读回
+        FAST_CAPTURE_TEST_CHECK(layout.planes[FAST_CAPTURE_PLANE_STENCIL].size == 0);
+        FAST_CAPTURE_TEST_CHECK(layout.capture_flags == capture_flags);
+    }
+
+    void TestDepthFloatReadsStencilSeparately()
+    {
+        const auto layout = MakePboFrameLayout(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_DEPTH_FLOAT | FAST_CAPTURE_FLAG_STENCIL);
+        const auto& depth = layout.planes[FAST_CAPTURE_PLANE_DEPTH];
+        const auto& stencil = layout.planes[FAST_CAPTURE_PLANE_STENCIL];
+        FAST_CAPTURE_TEST_CHECK(depth.gl_format == GL_DEPTH_COMPONENT && depth.gl_type == GL_FLOAT);
+        FAST_CAPTURE_TEST_CHECK(stencil.size == PIXEL_COUNT);
+        FAST_CAPTURE_TEST_CHECK(stencil.offset == depth.offset + AlignPlaneSize(depth.size));
+    }
+
+    void TestLinearDepthReadsRawDepth()
+    {
+        // PBO读回原始的24位深度，线性化在CPU上完成，因此布局与只捕获24位深度相同
+        const auto layout = MakePboFrameLayout(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_LINEAR_DEPTH);
+        FAST_CAPTURE_TEST_CHECK(layout.planes[FAST_CAPTURE_PLANE_DEPTH].gl_type == GL_UNSIGNED_INT_24_8);
+
+        CapturePlane planes[FAST_CAPTURE_PLANE_COUNT];
+        MakeCapturePlanes(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_LINEAR_DEPTH, planes);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_DEPTH].gl_type == GL_FLOAT);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_DEPTH].size == PIXEL_COUNT * sizeof(float));
+    }
+
+    void TestDepthPlaneFormat()
+    {
+        // 同为GL_FLOAT的原始深度与线性深度只能通过format区分
+        CapturePlane planes[FAST_CAPTURE_PLANE_COUNT];
+        MakeCapturePlanes(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_STENCIL, planes);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_COLOR].format == FAST_CAPTURE_PLANE_FORMAT_RGBA8);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_DEPTH].format == FAST_CAPTURE_PLANE_FORMAT_DEPTH_24_STENCIL_8);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_STENCIL].format == FAST_CAPTURE_PLANE_FORMAT_STENCIL_8);
+        MakeCapturePlanes(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_DEPTH_FLOAT, planes);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_DEPTH].format == FAST_CAPTURE_PLANE_FORMAT_DEPTH_FLOAT);
+        MakeCapturePlanes(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_DEPTH_FLOAT | FAST_CAPTURE_FLAG_LINEAR_DEPTH, planes);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_DEPTH].format == FAST_CAPTURE_PLANE_FORMAT_LINEAR_DEPTH_FLOAT);
+        MakeCapturePlanes(WIDTH, HEIGHT, FAST_CAPTURE_FLAG_LINEAR_DEPTH, planes);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_DEPTH].size == 0);
+        FAST_CAPTURE_TEST_CHECK(planes[FAST_CAPTURE_PLANE_DEPTH].format == FAST_CAPTURE_PLANE_FORMAT_UNKNOWN);
+    }
+
+    void TestDepthFormatConflict()
+    {
+        // 一个客户端要24位深度，另一个要线性深度时，发布的格式与前者需要的不同
+        const auto published_flags = FAST_CAPTURE_FLAG_DEPTH_24 | FAST_CAPTURE_FLAG_LINEAR_DEPTH;
+        FAST_CAPTURE_TEST_CHECK(GetDepthPlaneFormat(published_flags) != GetDepthPlaneFormat(FAST_CAPTURE_FLAG_DEPTH_24));
+        FAST_CAPTURE_TEST_CHECK(GetDepthPlaneFormat(published_flags) == GetDepthPlaneFormat(published_flags | FAST_CAPTURE_FLAG_STENCIL));
+        FAST_CAPTURE_TEST_CHECK(GetDepthPlaneFormat(FAST_CAPTURE_FLAG_STENCIL) == FAST_CAPTURE_PLANE_FORMAT_UNKNOWN);
+    }
+
+    void TestColorMipPlanes()
+    {
+        const auto capture_flags = FAST_CAPTURE_FLAG_COLOR_MIP_1 | FAST_CAPTURE_FLAG_COLOR_MIP_3;
+        const auto layout = MakePboFrameLayout(WIDTH, HEIGHT, capture_flags);
+        const auto& mip_1 = layout.planes[FAST_CAPTURE_PLANE_COLOR_MIP_1];
+        const auto& mip_3 = layout.planes[FAST_CAPTURE_PLANE_COLOR_MIP_3];
+        FAST_CAPTURE_TEST_CHECK(mip_1.width == WIDTH >> 1 && mip_1.height == HEIGHT >> 1 && mip_1.mip_level == 1);
+        FAST_CAPTURE_TEST_CHECK(mip_3.width == WIDTH >> 3 && mip_3.height == HEIGHT >> 3 && mip_3.mip_level == 3);
+        FAST_CAPTURE_TEST_CHECK(layout.planes[FAST_CAPTURE_PLANE_COLOR_MIP_2].size == 0);
+        FAST_CAPTURE_TEST_CHECK(GetMaxColorMipLevel(capture_flags) == 3);
+
+        // 很小的图像的mipmap至少有一个像素
+        const auto tiny_layout = MakePboFrameLayout(1, 1, capture_flags);
+        FAST_CAPTURE_TEST_CHECK(tiny_layout.planes[FAST_CAPTURE_PLANE_COLOR_MIP_3].size == CAPTURE_COLOR_PIXEL_SIZE);
+    }
+
+    void TestPlanesAreAligned()
+    {
+        const auto layout = MakePboFrameLayout(
+            WIDTH,
+            HEIGHT,
+            FAST_CAPTURE_FLAG_DEPTH_FLOAT | FAST_CAPTURE_FLAG_STENCIL | FAST_CAPTURE_FLAG_COLOR_MIP_MASK);
+        std::uint64_t end = 0;
+        for (const auto& plane : layout.planes)
+        {
+            if (plane.size == 0)
+            {
+                continue;
+            }
+            FAST_CAPTURE_TEST_CHECK(plane.offset % CAPTURE_PLANE_ALIGNMENT == 0);
+            FAST_CAPTURE_TEST_CHECK(plane.offset >= end);
+            end = plane.offset + plane.size;
+        }
+        FAST_CAPTURE_TEST_CHECK(layout.total_size == AlignPlaneSize(end));
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"ColorOnly", &TestColorOnly},
+        {"Depth24CarriesStencil", &TestDepth24CarriesStencil},
+        {"DepthFloatReadsStencilSeparately", &TestDepthFloatReadsStencilSeparately},
+        {"LinearDepthReadsRawDepth", &TestLinearDepthReadsRawDepth},
+        {"DepthPlaneFormat", &TestDepthPlaneFormat},
+        {"DepthFormatConflict", &TestDepthFormatConflict},
+        {"ColorMipPlanes", &TestColorMipPlanes},
+        {"PlanesAreAligned", &TestPlanesAreAligned},
+    });
+}
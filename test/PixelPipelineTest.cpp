@@ -0,0 +1,143 @@
+#include "../source/Utils/PixelPipeline.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE::Utils::PixelPipeline;
+
+    constexpr std::uint32_t WIDTH = 3;
+    constexpr std::uint32_t HEIGHT = 2;
+    // 源图像的行带有填充，验证内核使用row_pitch而不是紧密排列的行大小
+    constexpr std::size_t ROW_PITCH = WIDTH * 4 + 4;
+
+    /**
+     * @brief 3x2的RGBA源图像，像素(x, y)为R=0x10*y+x，G=0x80+R，B=0xF0-R，A=0x40+R
+     *
+     */
+    std::vector<std::byte> MakeSourceImage()
+    {
+        std::vector<std::byte> result(ROW_PITCH * HEIGHT, std::byte{0xEE});
+        for (std::uint32_t y = 0; y < HEIGHT; ++y)
+        {
+            for (std::uint32_t x = 0; x < WIDTH; ++x)
+            {
+                const auto r = static_cast<std::uint8_t>(0x10 * y + x);
+                auto p_pixel = result.data() + y * ROW_PITCH + x * 4;
+                p_pixel[0] = std::byte{r};
+                p_pixel[1] = static_cast<std::byte>(0x80 + r);
+                p_pixel[2] = static_cast<std::byte>(0xF0 - r);
+                p_pixel[3] = static_cast<std::byte>(0x40 + r);
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::byte> ToBytes(const std::vector<std::uint8_t>& values)
+    {
+        std::vector<std::byte> result(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            result[i] = static_cast<std::byte>(values[i]);
+        }
+        return result;
+    }
+
+    std::vector<std::byte> Convert(
+        const std::vector<std::byte>& source,
+        const PixelFormat destination_format,
+        const bool is_reversed,
+        const bool is_window,
+        const Region& region)
+    {
+        const auto convert_frame = SelectConvertFrame(PixelFormat::Rgba8, destination_format, is_reversed, is_window);
+        const auto output_width = is_window ? region.width : WIDTH;
+        const auto output_height = is_window ? region.height : HEIGHT;
+        std::vector<std::byte> result(output_width * output_height * GetPixelSize(destination_format));
+        convert_frame(Frame{source.data(), ROW_PITCH, WIDTH, HEIGHT}, region, result.data());
+        return result;
+    }
+
+    void TestFullFrameRgba()
+    {
+        const auto result = Convert(MakeSourceImage(), PixelFormat::Rgba8, false, false, {});
+        const auto golden = ToBytes({
+            0x00, 0x80, 0xF0, 0x40, 0x01, 0x81, 0xEF, 0x41, 0x02, 0x82, 0xEE, 0x42,
+            0x10, 0x90, 0xE0, 0x50, 0x11, 0x91, 0xDF, 0x51, 0x12, 0x92, 0xDE, 0x52,
+        });
+        FAST_CAPTURE_TEST_CHECK(result == golden);
+    }
+
+    void TestFullFrameBgraReversed()
+    {
+        const auto result = Convert(MakeSourceImage(), PixelFormat::Bgra8, true, false, {});
+        const auto golden = ToBytes({
+            0xE0, 0x90, 0x10, 0x50, 0xDF, 0x91, 0x11, 0x51, 0xDE, 0x92, 0x12, 0x52,
+            0xF0, 0x80, 0x00, 0x40, 0xEF, 0x81, 0x01, 0x41, 0xEE, 0x82, 0x02, 0x42,
+        });
+        FAST_CAPTURE_TEST_CHECK(result == golden);
+    }
+
+    void TestWindowRgb()
+    {
+        const auto result = Convert(MakeSourceImage(), PixelFormat::Rgb8, false, true, Region{1, 0, 2, 2});
+        const auto golden = ToBytes({
+            0x01, 0x81, 0xEF, 0x02, 0x82, 0xEE,
+            0x11, 0x91, 0xDF, 0x12, 0x92, 0xDE,
+        });
+        FAST_CAPTURE_TEST_CHECK(result == golden);
+    }
+
+    void TestWindowReversedRgb()
+    {
+        const auto result = Convert(MakeSourceImage(), PixelFormat::Rgb8, true, true, Region{2, 0, 1, 2});
+        const auto golden = ToBytes({
+            0x12, 0x92, 0xDE,
+            0x02, 0x82, 0xEE,
+        });
+        FAST_CAPTURE_TEST_CHECK(result == golden);
+    }
+
+    void TestRgbSourceFillsAlpha()
+    {
+        const std::vector<std::byte> source = ToBytes({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+        std::vector<std::byte> result(2 * 4);
+        SelectConvertFrame(PixelFormat::Rgb8, PixelFormat::Bgra8, false, false)(
+            Frame{source.data(), 6, 2, 1},
+            {},
+            result.data());
+        FAST_CAPTURE_TEST_CHECK(result == ToBytes({0x03, 0x02, 0x01, 0xFF, 0x06, 0x05, 0x04, 0xFF}));
+    }
+
+    void TestEmptyWindow()
+    {
+        const auto source = MakeSourceImage();
+        std::vector<std::byte> result(4, std::byte{0x5A});
+        SelectConvertFrame(PixelFormat::Rgba8, PixelFormat::Rgba8, true, true)(
+            Frame{source.data(), ROW_PITCH, WIDTH, HEIGHT},
+            Region{0, 0, 0, 0},
+            result.data());
+        FAST_CAPTURE_TEST_CHECK(result == std::vector<std::byte>(4, std::byte{0x5A}));
+    }
+
+    void TestInvalidFormat()
+    {
+        FAST_CAPTURE_TEST_CHECK(SelectConvertFrame(PixelFormat::Count, PixelFormat::Rgba8, false, false) == nullptr);
+        FAST_CAPTURE_TEST_CHECK(SelectConvertFrame(PixelFormat::Rgba8, PixelFormat::Count, false, false) == nullptr);
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"FullFrameRgba", &TestFullFrameRgba},
+        {"FullFrameBgraReversed", &TestFullFrameBgraReversed},
+        {"WindowRgb", &TestWindowRgb},
+        {"WindowReversedRgb", &TestWindowReversedRgb},
+        {"RgbSourceFillsAlpha", &TestRgbSourceFillsAlpha},
+        {"EmptyWindow", &TestEmptyWindow},
+        {"InvalidFormat", &TestInvalidFormat},
+    });
+}
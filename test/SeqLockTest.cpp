@@ -0,0 +1,135 @@
+#include "../source/Utils/SeqLock.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE::Utils;
+
+    constexpr auto SHORT_TIMEOUT = std::chrono::milliseconds{10};
+
+    void TestReadWithoutWriter()
+    {
+        SeqLock lock{};
+        int value = 0;
+        const auto result = ReadWithSeqLock(
+            lock,
+            SHORT_TIMEOUT,
+            []()
+            { return true; },
+            [&value]()
+            { value = 42; });
+        FAST_CAPTURE_TEST_CHECK(result == SeqLockReadResult::Ok);
+        FAST_CAPTURE_TEST_CHECK(value == 42);
+    }
+
+    void TestReadDetectsWrite()
+    {
+        SeqLock lock{};
+        const auto opt_sequence = lock.BeginRead();
+        FAST_CAPTURE_TEST_CHECK(opt_sequence.has_value());
+        {
+            auto guard = MakeSeqLockWriteGuard(lock);
+            FAST_CAPTURE_TEST_CHECK(!lock.BeginRead().has_value());
+        }
+        FAST_CAPTURE_TEST_CHECK(!lock.EndRead(opt_sequence.value()));
+        FAST_CAPTURE_TEST_CHECK(lock.GetSequence() == opt_sequence.value() + 2);
+    }
+
+    void TestTimeoutClassifiesWriter()
+    {
+        SeqLock lock{};
+        // 模拟在写入途中停住的写者
+        lock.BeginWrite();
+        auto read_count = 0;
+        const auto busy_result = ReadWithSeqLock(
+            lock,
+            SHORT_TIMEOUT,
+            []()
+            { return true; },
+            [&read_count]()
+            { ++read_count; });
+        FAST_CAPTURE_TEST_CHECK(busy_result == SeqLockReadResult::WriterBusy);
+        FAST_CAPTURE_TEST_CHECK(read_count == 0);
+        const auto dead_result = ReadWithSeqLock(
+            lock,
+            SHORT_TIMEOUT,
+            []()
+            { return false; },
+            []() {});
+        FAST_CAPTURE_TEST_CHECK(dead_result == SeqLockReadResult::WriterDead);
+    }
+
+    void TestRecoverFromDeadWriter()
+    {
+        SeqLock lock{};
+        lock.BeginWrite();
+        lock.RecoverFromDeadWriter();
+        FAST_CAPTURE_TEST_CHECK(lock.BeginRead().has_value());
+        const auto sequence = lock.GetSequence();
+        lock.RecoverFromDeadWriter();
+        FAST_CAPTURE_TEST_CHECK(lock.GetSequence() == sequence);
+    }
+
+    void TestConcurrentReadsAreConsistent()
+    {
+        constexpr std::uint64_t WRITE_COUNT = 200000;
+        SeqLock lock{};
+        // 数据本身用relaxed原子变量，只验证顺序锁的一致性，不引入数据竞争
+        std::atomic<std::uint64_t> first{0};
+        std::atomic<std::uint64_t> second{0};
+        std::atomic<bool> is_writer_done{false};
+        std::thread writer{[&]()
+                           {
+                               for (std::uint64_t i = 1; i <= WRITE_COUNT; ++i)
+                               {
+                                   auto guard = MakeSeqLockWriteGuard(lock);
+                                   first.store(i, std::memory_order_relaxed);
+                                   second.store(i, std::memory_order_relaxed);
+                               }
+                               is_writer_done.store(true, std::memory_order_release);
+                           }};
+        std::uint64_t inconsistent_count = 0;
+        std::uint64_t last_value = 0;
+        bool is_monotonic = true;
+        while (!is_writer_done.load(std::memory_order_acquire))
+        {
+            std::uint64_t read_first = 0;
+            std::uint64_t read_second = 0;
+            const auto result = ReadWithSeqLock(
+                lock,
+                std::chrono::seconds{5},
+                []()
+                { return true; },
+                [&]()
+                {
+                    read_first = first.load(std::memory_order_relaxed);
+                    read_second = second.load(std::memory_order_relaxed);
+                });
+            if (result != SeqLockReadResult::Ok)
+            {
+                continue;
+            }
+            inconsistent_count += read_first != read_second;
+            is_monotonic = is_monotonic && read_first >= last_value;
+            last_value = read_first;
+        }
+        writer.join();
+        FAST_CAPTURE_TEST_CHECK(inconsistent_count == 0);
+        FAST_CAPTURE_TEST_CHECK(is_monotonic);
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"ReadWithoutWriter", &TestReadWithoutWriter},
+        {"ReadDetectsWrite", &TestReadDetectsWrite},
+        {"TimeoutClassifiesWriter", &TestTimeoutClassifiesWriter},
+        {"RecoverFromDeadWriter", &TestRecoverFromDeadWriter},
+        {"ConcurrentReadsAreConsistent", &TestConcurrentReadsAreConsistent},
+    });
+}
@@ -0,0 +1,253 @@
+#include "../source/FastCaptureInjectDll/FastCaptureInjectDllDef.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+
+    /**
+     * @brief 放在父子进程共享的匿名映射中，代替注入DLL与客户端之间的共享内存
+     *
+     */
+    struct SharedState
+    {
+        CaptureDescriptor descriptor{};
+        std::atomic<std::uint32_t> stage{0};
+        std::atomic<std::uint64_t> iteration_count{0};
+    };
+
+    std::uint64_t GetNowMs() noexcept
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    class SharedStateMapping
+    {
+        SharedState* p_state_;
+
+    public:
+        SharedStateMapping()
+        {
+            auto* p_memory = ::mmap(nullptr, sizeof(SharedState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            p_state_ = p_memory == MAP_FAILED ? nullptr : new (p_memory) SharedState{};
+        }
+        ~SharedStateMapping()
+        {
+            if (p_state_ != nullptr)
+            {
+                p_state_->~SharedState();
+                ::munmap(p_state_, sizeof(SharedState));
+            }
+        }
+        SharedStateMapping(const SharedStateMapping&) = delete;
+        SharedStateMapping& operator=(const SharedStateMapping&) = delete;
+
+        SharedState* Get() const noexcept
+        {
+            return p_state_;
+        }
+    };
+
+    /**
+     * @brief 在子进程中执行函数，函数返回后子进程立即退出，不运行父进程的析构与atexit
+     *
+     */
+    template <class F>
+    pid_t ForkChild(F&& child_function)
+    {
+        const auto pid = ::fork();
+        if (pid == 0)
+        {
+            child_function();
+            ::_exit(0);
+        }
+        return pid;
+    }
+
+    bool KillChild(const pid_t pid)
+    {
+        int status = 0;
+        return ::kill(pid, SIGKILL) == 0 && ::waitpid(pid, &status, 0) == pid && WIFSIGNALED(status);
+    }
+
+    void TestReaderKilledMidRead()
+    {
+        SharedStateMapping mapping{};
+        auto* p_state = mapping.Get();
+        FAST_CAPTURE_TEST_CHECK(p_state != nullptr);
+        if (p_state == nullptr)
+        {
+            return;
+        }
+        auto& descriptor = p_state->descriptor;
+        const auto child_pid = ForkChild(
+            [p_state]()
+            {
+                std::uint64_t owner;
+                p_state->descriptor.RegisterSubscriber(static_cast<std::uint32_t>(::getpid()), GetNowMs(), FAST_CAPTURE_FLAG_NONE, &owner);
+                Utils::ReadWithSeqLock(
+                    p_state->descriptor.seq_lock,
+                    std::chrono::seconds{60},
+                    []()
+                    { return true; },
+                    [p_state]()
+                    {
+                        // 在读取途中停住，等待父进程杀死
+                        p_state->stage.store(1, std::memory_order_release);
+                        for (;;)
+                        {
+                            ::pause();
+                        }
+                    });
+            });
+        FAST_CAPTURE_TEST_CHECK(child_pid > 0);
+        FAST_CAPTURE_TEST_CHECK(Test::WaitUntil(
+            [p_state]()
+            { return p_state->stage.load(std::memory_order_acquire) == 1; }));
+        FAST_CAPTURE_TEST_CHECK(KillChild(child_pid));
+
+        // 写者不等待读者，读者死在读取途中不影响之后的写入和读取
+        const auto write_begin = std::chrono::steady_clock::now();
+        {
+            auto guard = Utils::MakeSeqLockWriteGuard(descriptor.seq_lock);
+            descriptor.viewport[2] = 640;
+            descriptor.viewport[3] = 480;
+        }
+        FAST_CAPTURE_TEST_CHECK(std::chrono::steady_clock::now() - write_begin < std::chrono::seconds{1});
+        GLint width = 0;
+        const auto read_result = Utils::ReadWithSeqLock(
+            descriptor.seq_lock,
+            std::chrono::milliseconds{10},
+            []()
+            { return true; },
+            [&descriptor, &width]()
+            { width = descriptor.viewport[2]; });
+        FAST_CAPTURE_TEST_CHECK(read_result == Utils::SeqLockReadResult::Ok);
+        FAST_CAPTURE_TEST_CHECK(width == 640);
+
+        // 心跳超时后回收死亡读者的槽位
+        std::uint32_t reaped_process_id = 0;
+        const auto alive_count = descriptor.ReapStaleSubscribers(
+            GetNowMs() + SUBSCRIBER_HEARTBEAT_TIMEOUT_MS + 1,
+            [&reaped_process_id](const std::uint32_t process_id)
+            { reaped_process_id = process_id; });
+        FAST_CAPTURE_TEST_CHECK(alive_count == 0);
+        FAST_CAPTURE_TEST_CHECK(reaped_process_id == static_cast<std::uint32_t>(child_pid));
+    }
+
+    void TestReaderKilledMidHeartbeat()
+    {
+        SharedStateMapping mapping{};
+        auto* p_state = mapping.Get();
+        FAST_CAPTURE_TEST_CHECK(p_state != nullptr);
+        if (p_state == nullptr)
+        {
+            return;
+        }
+        auto& descriptor = p_state->descriptor;
+        constexpr int KILL_COUNT = 50;
+        for (int i = 0; i < KILL_COUNT; ++i)
+        {
+            p_state->iteration_count.store(0, std::memory_order_relaxed);
+            const auto child_pid = ForkChild(
+                [p_state]()
+                {
+                    const auto process_id = static_cast<std::uint32_t>(::getpid());
+                    std::uint64_t owner = 0;
+                    auto index = MAX_SUBSCRIBER_COUNT;
+                    for (std::uint64_t iteration = 1;; ++iteration)
+                    {
+                        // 与客户端的KeepAlive相同：刷新失败时重新占用，偶尔主动释放
+                        if (!p_state->descriptor.RefreshSubscriber(index, owner, GetNowMs()))
+                        {
+                            index = p_state->descriptor.RegisterSubscriber(process_id, GetNowMs(), FAST_CAPTURE_FLAG_NONE, &owner);
+                        }
+                        if (iteration % 7 == 0)
+                        {
+                            p_state->descriptor.UnregisterSubscriber(index, owner);
+                        }
+                        p_state->iteration_count.store(iteration, std::memory_order_relaxed);
+                    }
+                });
+            FAST_CAPTURE_TEST_CHECK(child_pid > 0);
+            // 每次在不同的进度杀死子进程
+            const auto target_iteration = static_cast<std::uint64_t>(1 + i * 37);
+            FAST_CAPTURE_TEST_CHECK(Test::WaitUntil(
+                [p_state, target_iteration]()
+                { return p_state->iteration_count.load(std::memory_order_relaxed) >= target_iteration; }));
+            FAST_CAPTURE_TEST_CHECK(KillChild(child_pid));
+        }
+
+        // 所有死亡客户端的槽位都能被回收并重新占用
+        descriptor.ReapStaleSubscribers(
+            GetNowMs() + SUBSCRIBER_HEARTBEAT_TIMEOUT_MS + 1,
+            [](std::uint32_t) {});
+        for (std::size_t i = 0; i < MAX_SUBSCRIBER_COUNT; ++i)
+        {
+            std::uint64_t owner;
+            FAST_CAPTURE_TEST_CHECK(descriptor.RegisterSubscriber(1, GetNowMs(), FAST_CAPTURE_FLAG_NONE, &owner) != MAX_SUBSCRIBER_COUNT);
+        }
+    }
+
+    void TestReapRacesReregistration()
+    {
+        SharedStateMapping mapping{};
+        auto* p_state = mapping.Get();
+        FAST_CAPTURE_TEST_CHECK(p_state != nullptr);
+        if (p_state == nullptr)
+        {
+            return;
+        }
+        auto& descriptor = p_state->descriptor;
+        const auto child_pid = ForkChild(
+            [p_state]()
+            {
+                const auto process_id = static_cast<std::uint32_t>(::getpid());
+                for (std::uint64_t iteration = 1;; ++iteration)
+                {
+                    std::uint64_t owner;
+                    const auto index = p_state->descriptor.RegisterSubscriber(process_id, GetNowMs(), FAST_CAPTURE_FLAG_NONE, &owner);
+                    p_state->descriptor.UnregisterSubscriber(index, owner);
+                    // 被释放的槽位上留着很久以前的心跳，之后马上重新占用
+                    p_state->descriptor.subscribers[index].heartbeat_ms.store(0, std::memory_order_relaxed);
+                    p_state->iteration_count.store(iteration, std::memory_order_relaxed);
+                }
+            });
+        FAST_CAPTURE_TEST_CHECK(child_pid > 0);
+
+        // 存活的客户端一直在刷新，回收者不能回收任何一次占用
+        std::uint64_t reaped_count = 0;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{300};
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            descriptor.ReapStaleSubscribers(
+                GetNowMs(),
+                [&reaped_count](std::uint32_t)
+                { ++reaped_count; });
+        }
+        FAST_CAPTURE_TEST_CHECK(p_state->iteration_count.load(std::memory_order_relaxed) > 0);
+        FAST_CAPTURE_TEST_CHECK(KillChild(child_pid));
+        FAST_CAPTURE_TEST_CHECK(reaped_count == 0);
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"ReaderKilledMidRead", &TestReaderKilledMidRead},
+        {"ReaderKilledMidHeartbeat", &TestReaderKilledMidHeartbeat},
+        {"ReapRacesReregistration", &TestReapRacesReregistration},
+    });
+}
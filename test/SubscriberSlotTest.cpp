@@ -0,0 +1,119 @@
+#include "../source/FastCaptureInjectDll/FastCaptureInjectDllDef.h"
+#include <cstdint>
+#include <memory>
+#include "TestUtils.hpp"
+
+namespace
+{
+    using namespace FAST_CAPTURE;
+
+    constexpr std::uint32_t PROCESS_ID = 1234;
+    constexpr std::uint64_t START_MS = 100000;
+    constexpr std::uint64_t STALE_MS = START_MS + SUBSCRIBER_HEARTBEAT_TIMEOUT_MS + 1;
+
+    std::unique_ptr<CaptureDescriptor> MakeDescriptor()
+    {
+        return std::make_unique<CaptureDescriptor>();
+    }
+
+    std::size_t Reap(CaptureDescriptor& descriptor, const std::uint64_t now_ms, std::size_t* p_reaped_count = nullptr)
+    {
+        std::size_t reaped_count = 0;
+        const auto alive_count = descriptor.ReapStaleSubscribers(
+            now_ms,
+            [&reaped_count](std::uint32_t)
+            { ++reaped_count; });
+        if (p_reaped_count != nullptr)
+        {
+            *p_reaped_count = reaped_count;
+        }
+        return alive_count;
+    }
+
+    void TestSameProcessClientsAreDistinct()
+    {
+        auto p_descriptor = MakeDescriptor();
+        std::uint64_t owner_0;
+        std::uint64_t owner_1;
+        const auto index_0 = p_descriptor->RegisterSubscriber(PROCESS_ID, START_MS, FAST_CAPTURE_FLAG_NONE, &owner_0);
+        const auto index_1 = p_descriptor->RegisterSubscriber(PROCESS_ID, START_MS, FAST_CAPTURE_FLAG_NONE, &owner_1);
+        FAST_CAPTURE_TEST_CHECK(index_0 != index_1);
+
+        // 只有第二个客户端刷新了心跳，回收不能因为进程ID相同而影响它
+        FAST_CAPTURE_TEST_CHECK(p_descriptor->RefreshSubscriber(index_1, owner_1, STALE_MS));
+        std::size_t reaped_count;
+        FAST_CAPTURE_TEST_CHECK(Reap(*p_descriptor, STALE_MS, &reaped_count) == 1);
+        FAST_CAPTURE_TEST_CHECK(reaped_count == 1);
+        FAST_CAPTURE_TEST_CHECK(!p_descriptor->RefreshSubscriber(index_0, owner_0, STALE_MS));
+        FAST_CAPTURE_TEST_CHECK(p_descriptor->RefreshSubscriber(index_1, owner_1, STALE_MS));
+    }
+
+    void TestReapedClientDoesNotRefreshNewOccupant()
+    {
+        auto p_descriptor = MakeDescriptor();
+        std::uint64_t old_owner;
+        const auto old_index = p_descriptor->RegisterSubscriber(PROCESS_ID, START_MS, FAST_CAPTURE_FLAG_NONE, &old_owner);
+        Reap(*p_descriptor, STALE_MS);
+
+        // 同一进程中的另一个客户端占用了被回收的槽位
+        std::uint64_t new_owner;
+        const auto new_index = p_descriptor->RegisterSubscriber(PROCESS_ID, STALE_MS, FAST_CAPTURE_FLAG_DEPTH_24, &new_owner);
+        FAST_CAPTURE_TEST_CHECK(new_index == old_index && new_owner != old_owner);
+        FAST_CAPTURE_TEST_CHECK(!p_descriptor->RefreshSubscriber(old_index, old_owner, STALE_MS + 1000));
+        FAST_CAPTURE_TEST_CHECK(p_descriptor->subscribers[new_index].heartbeat_ms.load() == STALE_MS);
+
+        // 旧的占用者释放槽位时不能释放新的占用者
+        p_descriptor->UnregisterSubscriber(old_index, old_owner);
+        FAST_CAPTURE_TEST_CHECK(p_descriptor->subscribers[new_index].IsOccupied());
+        FAST_CAPTURE_TEST_CHECK(p_descriptor->GetSubscribedCaptureFlags() == FAST_CAPTURE_FLAG_DEPTH_24);
+        p_descriptor->UnregisterSubscriber(new_index, new_owner);
+        FAST_CAPTURE_TEST_CHECK(!p_descriptor->subscribers[new_index].IsOccupied());
+    }
+
+    void TestNewOccupantIsNotReapedWithOldHeartbeat()
+    {
+        auto p_descriptor = MakeDescriptor();
+        // 上一个占用者早已停止刷新心跳
+        p_descriptor->subscribers[0].heartbeat_ms.store(START_MS);
+        std::uint64_t owner;
+        p_descriptor->RegisterSubscriber(PROCESS_ID, STALE_MS, FAST_CAPTURE_FLAG_NONE, &owner);
+        std::size_t reaped_count;
+        FAST_CAPTURE_TEST_CHECK(Reap(*p_descriptor, STALE_MS, &reaped_count) == 1);
+        FAST_CAPTURE_TEST_CHECK(reaped_count == 0);
+    }
+
+    void TestHeartbeatAfterReaperClockIsAlive()
+    {
+        auto p_descriptor = MakeDescriptor();
+        std::uint64_t owner;
+        // 客户端在回收者取得当前时间之后才占用槽位
+        p_descriptor->RegisterSubscriber(PROCESS_ID, START_MS + 1, FAST_CAPTURE_FLAG_NONE, &owner);
+        FAST_CAPTURE_TEST_CHECK(Reap(*p_descriptor, START_MS) == 1);
+    }
+
+    void TestGenerationAdvancesOnEveryClaim()
+    {
+        auto p_descriptor = MakeDescriptor();
+        std::uint64_t previous_owner = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            std::uint64_t owner;
+            FAST_CAPTURE_TEST_CHECK(p_descriptor->RegisterSubscriber(PROCESS_ID, START_MS, FAST_CAPTURE_FLAG_NONE, &owner) == 0);
+            FAST_CAPTURE_TEST_CHECK(SubscriberSlot::GetProcessId(owner) == PROCESS_ID);
+            FAST_CAPTURE_TEST_CHECK(owner > previous_owner);
+            p_descriptor->UnregisterSubscriber(0, owner);
+            previous_owner = owner;
+        }
+    }
+}
+
+int main()
+{
+    return FAST_CAPTURE::Test::RunTests({
+        {"SameProcessClientsAreDistinct", &TestSameProcessClientsAreDistinct},
+        {"ReapedClientDoesNotRefreshNewOccupant", &TestReapedClientDoesNotRefreshNewOccupant},
+        {"NewOccupantIsNotReapedWithOldHeartbeat", &TestNewOccupantIsNotReapedWithOldHeartbeat},
+        {"HeartbeatAfterReaperClockIsAlive", &TestHeartbeatAfterReaperClockIsAlive},
+        {"GenerationAdvancesOnEveryClaim", &TestGenerationAdvancesOnEveryClaim},
+    });
+}
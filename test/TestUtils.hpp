@@ -0,0 +1,83 @@
+#ifndef FAST_CAPTURE_TEST_TEST_UTILS_HPP
+#define FAST_CAPTURE_TEST_TEST_UTILS_HPP
+
+#include "FastCaptureDef.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <thread>
+
+FAST_CAPTURE_NAMESPACE
+{
+    namespace Test
+    {
+        struct TestCase
+        {
+            const char* name;
+            void (*p_function)();
+        };
+
+        inline int& GetFailureCount() noexcept
+        {
+            static int failure_count = 0;
+            return failure_count;
+        }
+
+        inline void ReportFailure(const char* file, const int line, const char* expression) noexcept
+        {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+            ++GetFailureCount();
+        }
+
+        inline bool IsNear(const float value, const float expected, const float relative_tolerance) noexcept
+        {
+            return std::fabs(value - expected) <= relative_tolerance * std::fabs(expected);
+        }
+
+        /**
+         * @brief 轮询直到条件成立，用于等待后台线程，超时返回false
+         *
+         */
+        template <class F>
+        bool WaitUntil(F&& condition, const std::chrono::milliseconds timeout = std::chrono::milliseconds{5000})
+        {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (!condition())
+            {
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            return true;
+        }
+
+        /**
+         * @brief 依次执行所有用例，失败的检查数不为0时返回1，作为进程的退出码交给CTest
+         *
+         */
+        inline int RunTests(const std::initializer_list<TestCase> test_cases) noexcept
+        {
+            for (const auto& test_case : test_cases)
+            {
+                const auto failure_count = GetFailureCount();
+                test_case.p_function();
+                std::printf("[%s] %s\n", GetFailureCount() == failure_count ? "PASS" : "FAIL", test_case.name);
+            }
+            return GetFailureCount() == 0 ? 0 : 1;
+        }
+    }
+}
+
+#define FAST_CAPTURE_TEST_CHECK(expression)                                          \
+    do                                                                               \
+    {                                                                                \
+        if (!(expression))                                                           \
+        {                                                                            \
+            FAST_CAPTURE::Test::ReportFailure(__FILE__, __LINE__, #expression);      \
+        }                                                                            \
+    } while (false)
+
+#endif // FAST_CAPTURE_TEST_TEST_UTILS_HPP